@@ -0,0 +1,247 @@
+///////////////////////////////////////////////////////////////////////////////
+// camerapath.cpp
+// ============
+// scripted camera path - keyframes joined by a smooth spline
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CameraPath.h"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// declaration of the global variables and defines
+namespace
+{
+	/***********************************************************
+	 *  CatmullRom()
+	 *
+	 *  This function is used to interpolate between p1 and p2
+	 *  with p0 and p3 as the neighbouring points.
+	 ***********************************************************/
+	glm::vec3 CatmullRom(
+		const glm::vec3& p0,
+		const glm::vec3& p1,
+		const glm::vec3& p2,
+		const glm::vec3& p3,
+		float t)
+	{
+		float t2 = t * t;
+		float t3 = t2 * t;
+
+		return(0.5f * ((2.0f * p1) +
+			(p2 - p0) * t +
+			(2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+			(3.0f * p1 - p0 - 3.0f * p2 + p3) * t3));
+	}
+}
+
+/***********************************************************
+ *  CameraPath()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+CameraPath::CameraPath()
+{
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all the keyframes.
+ ***********************************************************/
+void CameraPath::Clear()
+{
+	m_keys.clear();
+}
+
+/***********************************************************
+ *  AddKey()
+ *
+ *  This method is used for appending a keyframe to the end
+ *  of the path.
+ ***********************************************************/
+void CameraPath::AddKey(float time, const glm::vec3& position, const glm::vec3& target)
+{
+	CAMERA_KEY key;
+	key.time = time;
+	key.position = position;
+	key.target = target;
+	m_keys.push_back(key);
+}
+
+/***********************************************************
+ *  CreateOrbit()
+ *
+ *  This method is used for building a closed orbit around
+ *  a center point at a fixed height, always looking at the
+ *  center.  The first keyframe is repeated at the end so the
+ *  path returns to where it started.
+ ***********************************************************/
+void CameraPath::CreateOrbit(const glm::vec3& center, float radius, float height, int keyCount)
+{
+	Clear();
+
+	if (keyCount < 3)
+	{
+		keyCount = 3;
+	}
+
+	for (int i = 0; i <= keyCount; i++)
+	{
+		float angle = ((float)i / (float)keyCount) * 2.0f * 3.14159265f;
+		glm::vec3 position = center + glm::vec3(
+			radius * sinf(angle),
+			height,
+			radius * cosf(angle));
+		AddKey((float)i, position, center);
+	}
+}
+
+/***********************************************************
+ *  LoadFromFile()
+ *
+ *  This method is used for reading the keyframes from a text
+ *  file.  Empty lines and lines starting with '#' are
+ *  skipped.
+ ***********************************************************/
+bool CameraPath::LoadFromFile(const char* filename)
+{
+	std::ifstream file(filename);
+	if (file.good() == false)
+	{
+		std::cout << "Could not open the camera path " << filename << std::endl;
+		return(false);
+	}
+
+	Clear();
+
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+		if ((line.empty() == true) || (line[0] == '#'))
+		{
+			continue;
+		}
+
+		std::istringstream values(line);
+		CAMERA_KEY key;
+		values >> key.time
+			>> key.position.x >> key.position.y >> key.position.z
+			>> key.target.x >> key.target.y >> key.target.z;
+		if (values.fail() == true)
+		{
+			std::cout << "Skipping line " << lineNumber << " of the camera path " << filename << std::endl;
+			continue;
+		}
+		if ((m_keys.empty() == false) && (key.time < m_keys.back().time))
+		{
+			std::cout << "Keyframes out of time order in the camera path " << filename << std::endl;
+			Clear();
+			return(false);
+		}
+		m_keys.push_back(key);
+	}
+
+	if (m_keys.empty() == true)
+	{
+		std::cout << "No keyframes in the camera path " << filename << std::endl;
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  SaveToFile()
+ *
+ *  This method is used for writing the keyframes to a text
+ *  file that LoadFromFile() reads back.
+ ***********************************************************/
+bool CameraPath::SaveToFile(const char* filename) const
+{
+	std::ofstream file(filename);
+	if (file.good() == false)
+	{
+		std::cout << "Could not write the camera path " << filename << std::endl;
+		return(false);
+	}
+
+	file << "# time px py pz tx ty tz\n";
+	for (size_t i = 0; i < m_keys.size(); i++)
+	{
+		const CAMERA_KEY& key = m_keys[i];
+		file << key.time << " "
+			<< key.position.x << " " << key.position.y << " " << key.position.z << " "
+			<< key.target.x << " " << key.target.y << " " << key.target.z << "\n";
+	}
+
+	return(file.good());
+}
+
+/***********************************************************
+ *  GetDuration()
+ *
+ *  This method is used for getting the time from the first
+ *  to the last keyframe.
+ ***********************************************************/
+float CameraPath::GetDuration() const
+{
+	if (m_keys.size() < 2)
+	{
+		return(0.0f);
+	}
+
+	return(m_keys.back().time - m_keys.front().time);
+}
+
+/***********************************************************
+ *  Evaluate()
+ *
+ *  This method is used for getting the camera pose at a
+ *  fraction of the path, where 0 is the first keyframe and
+ *  1 the last.  The end keyframes are repeated as their own
+ *  neighbours, so the spline passes through every keyframe.
+ ***********************************************************/
+bool CameraPath::Evaluate(float fraction, glm::vec3& position, glm::vec3& target) const
+{
+	if (m_keys.empty() == true)
+	{
+		return(false);
+	}
+
+	float duration = GetDuration();
+	if (duration <= 0.0f)
+	{
+		position = m_keys[0].position;
+		target = m_keys[0].target;
+		return(true);
+	}
+
+	float time = m_keys.front().time + glm::clamp(fraction, 0.0f, 1.0f) * duration;
+
+	// find the segment that contains the time
+	size_t segment = 0;
+	while ((segment + 2 < m_keys.size()) && (m_keys[segment + 1].time < time))
+	{
+		segment++;
+	}
+
+	const CAMERA_KEY& key1 = m_keys[segment];
+	const CAMERA_KEY& key2 = m_keys[segment + 1];
+	const CAMERA_KEY& key0 = (segment > 0) ? m_keys[segment - 1] : key1;
+	const CAMERA_KEY& key3 = (segment + 2 < m_keys.size()) ? m_keys[segment + 2] : key2;
+
+	float segmentTime = key2.time - key1.time;
+	float t = (segmentTime > 0.0f) ? (time - key1.time) / segmentTime : 0.0f;
+
+	position = CatmullRom(key0.position, key1.position, key2.position, key3.position, t);
+	target = CatmullRom(key0.target, key1.target, key2.target, key3.target, t);
+
+	return(true);
+}
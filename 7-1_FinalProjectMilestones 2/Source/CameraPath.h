@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////////////
+// camerapath.h
+// ============
+// scripted camera path - keyframes joined by a smooth spline
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  CameraPath
+ *
+ *  This class holds the keyframes of a camera path and
+ *  evaluates the camera pose anywhere along it with a
+ *  Catmull-Rom spline through the keyframe positions and
+ *  targets.  Paths are recorded from the interactive camera,
+ *  saved as text and replayed by the benchmark, so every run
+ *  sees the same views.
+ ***********************************************************/
+class CameraPath
+{
+public:
+	// properties for one keyframe of the path
+	struct CAMERA_KEY
+	{
+		// seconds from the start of the path
+		float time;
+		glm::vec3 position;
+		// point the camera looks at
+		glm::vec3 target;
+	};
+
+	// constructor
+	CameraPath();
+
+	// remove all the keyframes
+	void Clear();
+	// append a keyframe - keyframes must be added in time order
+	void AddKey(float time, const glm::vec3& position, const glm::vec3& target);
+	// build a closed orbit around a center point
+	void CreateOrbit(const glm::vec3& center, float radius, float height, int keyCount);
+
+	// read and write the keyframes as lines of "time px py pz tx ty tz"
+	bool LoadFromFile(const char* filename);
+	bool SaveToFile(const char* filename) const;
+
+	// camera pose at a fraction of the path between 0 and 1
+	bool Evaluate(float fraction, glm::vec3& position, glm::vec3& target) const;
+
+	int GetKeyCount() const { return (int)m_keys.size(); }
+	float GetDuration() const;
+
+private:
+	std::vector<CAMERA_KEY> m_keys;
+};
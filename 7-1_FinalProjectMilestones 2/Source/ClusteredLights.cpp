@@ -0,0 +1,280 @@
+///////////////////////////////////////////////////////////////////////////////
+// clusteredlights.cpp
+// ============
+// point lights binned into view space clusters for clustered forward shading
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ClusteredLights.h"
+#include "Frustum.h"
+
+#include <cmath>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	const char* g_ComputeShaderPath = "shaders/lightClusterComputeShader.glsl";
+
+	// must match the local size of the binning shader
+	const int g_ClusterGroupSize = 64;
+
+	// storage buffer bindings - must match the shaders
+	const GLuint POINT_LIGHT_BINDING = 4;
+	const GLuint CLUSTER_LIGHT_BINDING = 5;
+
+	// closest near plane used for the depth slices, which are
+	// spaced by the log of the depth
+	const float g_MinClusterNear = 0.01f;
+}
+
+/***********************************************************
+ *  ClusteredLights()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ClusteredLights::ClusteredLights()
+{
+	m_pUniformBuffers = NULL;
+	m_viewLocation = -1;
+	m_inverseProjectionLocation = -1;
+	m_lightCount = 0;
+	m_bLightsDirty = false;
+}
+
+/***********************************************************
+ *  ~ClusteredLights()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ClusteredLights::~ClusteredLights()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking whether the driver can
+ *  run the binning shader and give the fragment shaders
+ *  access to the light lists.
+ ***********************************************************/
+bool ClusteredLights::IsSupported()
+{
+	if (GLEW_VERSION_4_3 == GL_TRUE)
+	{
+		return(true);
+	}
+
+	return((GLEW_ARB_compute_shader == GL_TRUE) &&
+		(GLEW_ARB_shader_storage_buffer_object == GL_TRUE));
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for loading the binning shader and
+ *  creating the light buffer and the buffer of the cluster
+ *  light lists, which both have a fixed size.  False is
+ *  returned when the shader cannot be used, in which case
+ *  the scene only has the point lights of the light block.
+ ***********************************************************/
+bool ClusteredLights::Initialize(UniformBuffers* pUniformBuffers)
+{
+	if ((NULL == pUniformBuffers) || (IsSupported() == false))
+	{
+		return(false);
+	}
+	if (m_program.Load(g_ComputeShaderPath) == false)
+	{
+		std::cout << "Light binning shader not loaded, clustered lights are off" << std::endl;
+		return(false);
+	}
+
+	m_pUniformBuffers = pUniformBuffers;
+	m_pUniformBuffers->BindProgram(m_program.GetProgramID());
+	m_viewLocation = m_program.GetUniformLocation("view");
+	m_inverseProjectionLocation = m_program.GetUniformLocation("inverseProjection");
+
+	m_lightBuffer.Create();
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_lightBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, MAX_LIGHTS * sizeof(POINT_LIGHT), NULL, GL_DYNAMIC_DRAW);
+	m_lightBuffer.SetMemory(GpuMemory::BUFFERS, MAX_LIGHTS * sizeof(POINT_LIGHT));
+
+	// the light counts of all the clusters, then their index lists
+	m_clusterBuffer.Create();
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_clusterBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER,
+		(CLUSTER_COUNT + CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER) * sizeof(GLuint),
+		NULL, GL_DYNAMIC_COPY);
+	m_clusterBuffer.SetMemory(GpuMemory::BUFFERS, (CLUSTER_COUNT + CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER) * sizeof(GLuint));
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	return(true);
+}
+
+/***********************************************************
+ *  WatchFiles()
+ *
+ *  This method is used for reloading the binning shader
+ *  whenever its file is written.
+ ***********************************************************/
+void ClusteredLights::WatchFiles(HotReload* pHotReload)
+{
+	if ((NULL == pHotReload) || (m_program.GetProgramID() == 0))
+	{
+		return;
+	}
+
+	int watchIndex = pHotReload->AddWatch([this]() { ReloadShader(); });
+	pHotReload->AddFile(watchIndex, g_ComputeShaderPath);
+}
+
+/***********************************************************
+ *  ReloadShader()
+ *
+ *  This method is used for compiling the changed binning
+ *  shader and connecting it to the cluster block again.
+ ***********************************************************/
+void ClusteredLights::ReloadShader()
+{
+	if (m_program.Reload(g_ComputeShaderPath) == false)
+	{
+		return;
+	}
+
+	m_pUniformBuffers->BindProgram(m_program.GetProgramID());
+	m_viewLocation = m_program.GetUniformLocation("view");
+	m_inverseProjectionLocation = m_program.GetUniformLocation("inverseProjection");
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the binning program and
+ *  the buffers.
+ ***********************************************************/
+void ClusteredLights::Destroy()
+{
+	m_lightBuffer.Destroy();
+	m_clusterBuffer.Destroy();
+
+	m_program.Destroy();
+	m_lightCount = 0;
+}
+
+/***********************************************************
+ *  SetLights()
+ *
+ *  This method is used for replacing the lights of the
+ *  scene.  They are uploaded by the next Update(), and the
+ *  lights past MAX_LIGHTS are left out.
+ ***********************************************************/
+void ClusteredLights::SetLights(const std::vector<POINT_LIGHT>& lights)
+{
+	m_pendingLights = lights;
+	if (m_pendingLights.size() > (size_t)MAX_LIGHTS)
+	{
+		std::cout << "Only the first " << MAX_LIGHTS << " of "
+			<< m_pendingLights.size() << " point lights are used" << std::endl;
+		m_pendingLights.resize(MAX_LIGHTS);
+	}
+	m_bLightsDirty = true;
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for binning the lights into the
+ *  clusters of the passed in view.  The near and far planes
+ *  are read back out of the projection matrix, the grid is
+ *  shared through the cluster block, and the binning shader
+ *  runs once for every cluster.  The lists are finished
+ *  before any fragment shader reads them.
+ ***********************************************************/
+void ClusteredLights::Update(const glm::mat4& view, const glm::mat4& projection)
+{
+	if ((NULL == m_pUniformBuffers) || (m_program.GetProgramID() == 0))
+	{
+		return;
+	}
+
+	if (m_bLightsDirty == true)
+	{
+		m_lightCount = (int)m_pendingLights.size();
+		if (m_lightCount > 0)
+		{
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_lightBuffer);
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0,
+				m_lightCount * sizeof(POINT_LIGHT), m_pendingLights.data());
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		}
+		m_bLightsDirty = false;
+	}
+
+	if (m_lightCount == 0)
+	{
+		Disable();
+		return;
+	}
+
+	float nearPlane = 0.0f;
+	float farPlane = 0.0f;
+	Frustum::GetDepthRange(projection, nearPlane, farPlane);
+	if (nearPlane < g_MinClusterNear)
+	{
+		nearPlane = g_MinClusterNear;
+	}
+	if (farPlane <= nearPlane)
+	{
+		farPlane = nearPlane * 2.0f;
+	}
+
+	// slice = log(depth) * scale - bias
+	float logRange = std::log(farPlane / nearPlane);
+	float sliceScale = (float)GRID_Z / logRange;
+	float sliceBias = (float)GRID_Z * std::log(nearPlane) / logRange;
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	UniformBuffers::CLUSTER_DATA clusters;
+	clusters.gridSize = glm::uvec4(GRID_X, GRID_Y, GRID_Z, (GLuint)m_lightCount);
+	clusters.depthParams = glm::vec4(nearPlane, farPlane, sliceScale, sliceBias);
+	clusters.viewport = glm::vec4(
+		(float)viewport[0], (float)viewport[1], (float)viewport[2], (float)viewport[3]);
+	m_pUniformBuffers->SetClusters(clusters);
+
+	glm::mat4 inverseProjection = glm::inverse(projection);
+
+	m_program.Use();
+	glUniformMatrix4fv(m_viewLocation, 1, GL_FALSE, &view[0][0]);
+	glUniformMatrix4fv(m_inverseProjectionLocation, 1, GL_FALSE, &inverseProjection[0][0]);
+	// the buffers stay bound for the fragment shaders
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, POINT_LIGHT_BINDING, m_lightBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_LIGHT_BINDING, m_clusterBuffer);
+
+	glDispatchCompute((GLuint)((CLUSTER_COUNT + g_ClusterGroupSize - 1) / g_ClusterGroupSize), 1, 1);
+
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+/***********************************************************
+ *  Disable()
+ *
+ *  This method is used for clearing the cluster block, so
+ *  the fragment shaders skip the clustered lights.
+ ***********************************************************/
+void ClusteredLights::Disable()
+{
+	if (NULL == m_pUniformBuffers)
+	{
+		return;
+	}
+
+	UniformBuffers::CLUSTER_DATA clusters;
+	clusters.gridSize = glm::uvec4(0, 0, 0, 0);
+	clusters.depthParams = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
+	clusters.viewport = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
+	m_pUniformBuffers->SetClusters(clusters);
+}
@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+// clusteredlights.h
+// ============
+// point lights binned into view space clusters for clustered forward shading
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "UniformBuffers.h"
+#include "ComputeProgram.h"
+#include "HotReload.h"
+#include "GpuResources.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  ClusteredLights
+ *
+ *  This class lets the scene have hundreds of point lights.
+ *  The lights are kept in a storage buffer, and every frame
+ *  a compute pass splits the view frustum into a grid of
+ *  GRID_X x GRID_Y screen tiles by GRID_Z depth slices and
+ *  lists the lights whose range reaches into each cluster.
+ *  The depth slices grow with the distance, so the clusters
+ *  stay about as deep as they are wide.  A fragment shader
+ *  only shades the lights listed in its own cluster.
+ *
+ *  The grid of the frame is shared through the cluster
+ *  block, with the light count in gridSize.w, and shaders
+ *  read the lists by declaring:
+ *
+ *    layout(std430, binding = 4) readonly buffer PointLightBuffer
+ *    {
+ *        PointLight clusteredLights[];    // position in xyz, range in w
+ *    };
+ *    layout(std430, binding = 5) readonly buffer ClusterLightBuffer
+ *    {
+ *        uint clusterLightCounts[CLUSTER_COUNT];
+ *        uint clusterLightIndices[];      // MAX_LIGHTS_PER_CLUSTER each
+ *    };
+ ***********************************************************/
+class ClusteredLights
+{
+public:
+	// size of the cluster grid - must match the shaders
+	static const int GRID_X = 16;
+	static const int GRID_Y = 9;
+	static const int GRID_Z = 24;
+	static const int CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+	// lights listed per cluster - lights past the limit are left out
+	static const int MAX_LIGHTS_PER_CLUSTER = 64;
+	// lights in the light buffer
+	static const int MAX_LIGHTS = 1024;
+
+	// std430 layout of one light in the light buffer
+	struct POINT_LIGHT
+	{
+		// world position in xyz, range in w
+		glm::vec4 positionRange;
+		glm::vec4 ambient;
+		glm::vec4 diffuse;
+		glm::vec4 specular;
+	};
+
+	// constructor
+	ClusteredLights();
+	// destructor
+	~ClusteredLights();
+
+	// true when the driver supports compute shaders and storage buffers
+	static bool IsSupported();
+	// load the binning shader and create the buffers
+	bool Initialize(UniformBuffers* pUniformBuffers);
+	// reload the binning shader when its file changes
+	void WatchFiles(HotReload* pHotReload);
+
+	// replace the lights - uploaded with the next Update()
+	void SetLights(const std::vector<POINT_LIGHT>& lights);
+	// number of lights in the light buffer
+	int GetLightCount() const { return m_lightCount; }
+
+	// bin the lights into the clusters of the passed in view
+	void Update(const glm::mat4& view, const glm::mat4& projection);
+	// stop the shaders from reading the clusters
+	void Disable();
+
+private:
+	// free the buffers
+	void Destroy();
+	// compile the changed binning shader
+	void ReloadShader();
+
+	// pointer to the shared uniform buffers - holds the cluster block
+	UniformBuffers* m_pUniformBuffers;
+	ComputeProgram m_program;
+	GLint m_viewLocation;
+	GLint m_inverseProjectionLocation;
+	// lights, and the light lists of the clusters
+	GpuBuffer m_lightBuffer;
+	GpuBuffer m_clusterBuffer;
+	int m_lightCount;
+	// lights waiting to be uploaded
+	std::vector<POINT_LIGHT> m_pendingLights;
+	bool m_bLightsDirty;
+};
@@ -0,0 +1,140 @@
+///////////////////////////////////////////////////////////////////////////////
+// computeprogram.cpp
+// ============
+// shader program built from a single compute shader file
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ComputeProgram.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+/***********************************************************
+ *  ComputeProgram()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ComputeProgram::ComputeProgram()
+{
+	m_programID = 0;
+}
+
+/***********************************************************
+ *  ~ComputeProgram()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ComputeProgram::~ComputeProgram()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for compiling the compute shader in
+ *  the passed in file and linking it into a program.  The
+ *  errors of the shader compiler are written to the console
+ *  and false is returned.
+ ***********************************************************/
+bool ComputeProgram::Load(const char* filename)
+{
+	Destroy();
+
+	std::ifstream file(filename);
+	if (file.good() == false)
+	{
+		std::cout << "Compute shader " << filename << " not found" << std::endl;
+		return(false);
+	}
+
+	std::stringstream sourceStream;
+	sourceStream << file.rdbuf();
+	std::string source = sourceStream.str();
+	const char* pSource = source.c_str();
+
+	GLint success = GL_FALSE;
+	char infoLog[512];
+
+	GLuint shaderID = glCreateShader(GL_COMPUTE_SHADER);
+	glShaderSource(shaderID, 1, &pSource, NULL);
+	glCompileShader(shaderID);
+	glGetShaderiv(shaderID, GL_COMPILE_STATUS, &success);
+	if (success == GL_FALSE)
+	{
+		glGetShaderInfoLog(shaderID, sizeof(infoLog), NULL, infoLog);
+		std::cout << "Compute shader " << filename << " failed to compile: " << infoLog << std::endl;
+		glDeleteShader(shaderID);
+		return(false);
+	}
+
+	m_programID = glCreateProgram();
+	glAttachShader(m_programID, shaderID);
+	glLinkProgram(m_programID);
+	glDeleteShader(shaderID);
+
+	glGetProgramiv(m_programID, GL_LINK_STATUS, &success);
+	if (success == GL_FALSE)
+	{
+		glGetProgramInfoLog(m_programID, sizeof(infoLog), NULL, infoLog);
+		std::cout << "Compute shader " << filename << " failed to link: " << infoLog << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Reload()
+ *
+ *  This method is used for compiling a changed shader file
+ *  into a new program.  The program is only replaced once
+ *  the new one links, so the pass keeps running when the
+ *  changed shader has errors.
+ ***********************************************************/
+bool ComputeProgram::Reload(const char* filename)
+{
+	ComputeProgram program;
+	if (program.Load(filename) == false)
+	{
+		std::cout << "Compute shader " << filename << " has errors, the running program is kept" << std::endl;
+		return(false);
+	}
+
+	Destroy();
+	m_programID = program.m_programID;
+	program.m_programID = 0;
+
+	std::cout << "Reloaded compute shader " << filename << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the program.
+ ***********************************************************/
+void ComputeProgram::Destroy()
+{
+	if (m_programID != 0)
+	{
+		glDeleteProgram(m_programID);
+		m_programID = 0;
+	}
+}
+
+/***********************************************************
+ *  GetUniformLocation()
+ *
+ *  This method is used for looking up the location of a
+ *  uniform of the program.
+ ***********************************************************/
+GLint ComputeProgram::GetUniformLocation(const char* name) const
+{
+	return(glGetUniformLocation(m_programID, name));
+}
@@ -0,0 +1,44 @@
+///////////////////////////////////////////////////////////////////////////////
+// computeprogram.h
+// ============
+// shader program built from a single compute shader file
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  ComputeProgram
+ *
+ *  This class compiles a compute shader from its GLSL file
+ *  and links it into a program of its own.  ShaderManager
+ *  only builds vertex and fragment programs, so the compute
+ *  passes load their shaders with this class instead.
+ ***********************************************************/
+class ComputeProgram
+{
+public:
+	// constructor
+	ComputeProgram();
+	// destructor
+	~ComputeProgram();
+
+	// compile and link the shader file - errors go to the console
+	bool Load(const char* filename);
+	// compile the shader file again - the running program is kept
+	// when the new one has errors
+	bool Reload(const char* filename);
+	// free the program
+	void Destroy();
+
+	// make the program current for the following dispatches
+	void Use() const { glUseProgram(m_programID); }
+	// look up a uniform of the program - -1 when it is not used
+	GLint GetUniformLocation(const char* name) const;
+	GLuint GetProgramID() const { return m_programID; }
+
+private:
+	GLuint m_programID;
+};
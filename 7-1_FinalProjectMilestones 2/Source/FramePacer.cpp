@@ -0,0 +1,132 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepacer.cpp
+// ============
+// fixed-timestep updates and an optional frame rate limit for the main loop
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FramePacer.h"
+
+#include <thread>
+
+/***********************************************************
+ *  FramePacer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FramePacer::FramePacer(double updateStep)
+{
+	m_updateStep = (updateStep > 0.0) ? updateStep : (1.0 / 60.0);
+	m_accumulator = 0.0;
+	m_bHasLastFrame = false;
+	m_framePeriod = std::chrono::steady_clock::duration::zero();
+}
+
+/***********************************************************
+ *  SetFrameLimit()
+ *
+ *  This method is used for limiting the number of frames
+ *  per second.  0 removes the limit.
+ ***********************************************************/
+void FramePacer::SetFrameLimit(double framesPerSecond)
+{
+	if (framesPerSecond > 0.0)
+	{
+		m_framePeriod = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+			std::chrono::duration<double>(1.0 / framesPerSecond));
+	}
+	else
+	{
+		m_framePeriod = std::chrono::steady_clock::duration::zero();
+	}
+	m_nextFrame = std::chrono::steady_clock::now();
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for adding the time since the
+ *  previous frame and returning how many fixed updates are
+ *  due.  At most MAX_UPDATES_PER_FRAME updates are returned
+ *  and the rest of a long stall is dropped.
+ ***********************************************************/
+int FramePacer::BeginFrame()
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+	if (m_bHasLastFrame == true)
+	{
+		m_accumulator += std::chrono::duration<double>(now - m_lastFrame).count();
+	}
+	m_lastFrame = now;
+	m_bHasLastFrame = true;
+
+	int updateCount = (int)(m_accumulator / m_updateStep);
+	if (updateCount > MAX_UPDATES_PER_FRAME)
+	{
+		updateCount = MAX_UPDATES_PER_FRAME;
+		m_accumulator = (double)updateCount * m_updateStep;
+	}
+	m_accumulator -= (double)updateCount * m_updateStep;
+
+	return(updateCount);
+}
+
+/***********************************************************
+ *  GetInterpolation()
+ *
+ *  This method is used for getting how far the frame is
+ *  between the last update and the next one.
+ ***********************************************************/
+float FramePacer::GetInterpolation() const
+{
+	float interpolation = (float)(m_accumulator / m_updateStep);
+
+	if (interpolation > 1.0f)
+	{
+		interpolation = 1.0f;
+	}
+
+	return(interpolation);
+}
+
+/***********************************************************
+ *  WaitForNextFrame()
+ *
+ *  This method is used for sleeping until the next frame is
+ *  due.  The frames are due at a fixed period so small
+ *  oversleeps do not add up, but after falling behind by a
+ *  whole period the schedule starts again from now.
+ ***********************************************************/
+void FramePacer::WaitForNextFrame()
+{
+	if (m_framePeriod == std::chrono::steady_clock::duration::zero())
+	{
+		return;
+	}
+
+	m_nextFrame += m_framePeriod;
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (m_nextFrame > now)
+	{
+		std::this_thread::sleep_until(m_nextFrame);
+	}
+	else if (now - m_nextFrame > m_framePeriod)
+	{
+		m_nextFrame = now;
+	}
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used for dropping the collected time, for
+ *  example after the window was minimized.
+ ***********************************************************/
+void FramePacer::Reset()
+{
+	m_accumulator = 0.0;
+	m_bHasLastFrame = false;
+	m_nextFrame = std::chrono::steady_clock::now();
+}
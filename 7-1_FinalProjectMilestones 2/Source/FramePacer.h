@@ -0,0 +1,56 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepacer.h
+// ============
+// fixed-timestep updates and an optional frame rate limit for the main loop
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+
+/***********************************************************
+ *  FramePacer
+ *
+ *  This class drives the main loop.  The elapsed time of
+ *  every frame is collected and handed out as a whole number
+ *  of fixed update steps, and the time left over becomes the
+ *  interpolation between the last two updates for rendering.
+ *  With a frame rate limit the pacer sleeps until the next
+ *  frame is due, so the CPU and GPU idle instead of spinning.
+ ***********************************************************/
+class FramePacer
+{
+public:
+	// constructor
+	FramePacer(double updateStep);
+
+	// limit the frames per second - 0 renders as fast as possible
+	void SetFrameLimit(double framesPerSecond);
+
+	// start a frame and return the number of updates to run
+	int BeginFrame();
+	// fraction of an update step since the last update, 0 to 1
+	float GetInterpolation() const;
+	// seconds of one update step
+	double GetUpdateStep() const { return m_updateStep; }
+
+	// sleep until the next frame is due under the frame limit
+	void WaitForNextFrame();
+	// start over after a pause, without catching up on updates
+	void Reset();
+
+private:
+	// most updates run for one frame - a longer stall slows the
+	// simulation down instead of running a burst of updates
+	static const int MAX_UPDATES_PER_FRAME = 8;
+
+	double m_updateStep;
+	double m_accumulator;
+	std::chrono::steady_clock::time_point m_lastFrame;
+	bool m_bHasLastFrame;
+
+	// zero when there is no frame limit
+	std::chrono::steady_clock::duration m_framePeriod;
+	std::chrono::steady_clock::time_point m_nextFrame;
+};
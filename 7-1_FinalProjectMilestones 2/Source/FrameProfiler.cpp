@@ -0,0 +1,491 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameprofiler.cpp
+// ============
+// frame timing, GPU timer queries and per-frame render counters
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameProfiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// column names of the GPU scopes - same order as GPU_SCOPE
+	const char* g_ScopeNames[FrameProfiler::GPU_SCOPE_COUNT] =
+	{
+		"gpu_frame_ms",
+		"gpu_scene_ms",
+		"gpu_shadows_ms",
+		"gpu_depth_prepass_ms",
+		"gpu_opaque_ms",
+		"gpu_sky_ms",
+		"gpu_blended_ms"
+	};
+
+	// short names of the passes in the overlay summary
+	const char* g_PassLabels[FrameProfiler::GPU_SCOPE_COUNT] =
+	{
+		NULL,
+		NULL,
+		"shadows",
+		"depth",
+		"opaque",
+		"sky",
+		"blended"
+	};
+
+	// milliseconds between two steady clock readings
+	float ElapsedMs(
+		std::chrono::steady_clock::time_point start,
+		std::chrono::steady_clock::time_point end)
+	{
+		return(std::chrono::duration<float, std::milli>(end - start).count());
+	}
+}
+
+int FrameProfiler::s_drawCalls = 0;
+int FrameProfiler::s_uniformUpdates = 0;
+int FrameProfiler::s_textureBinds = 0;
+
+/***********************************************************
+ *  FrameProfiler()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameProfiler::FrameProfiler()
+{
+	for (int i = 0; i < QUERY_FRAMES; i++)
+	{
+		for (int scope = 0; scope < GPU_SCOPE_COUNT; scope++)
+		{
+			for (int range = 0; range < SCOPE_RANGES; range++)
+			{
+				m_frames[i].queries[scope][range][0] = 0;
+				m_frames[i].queries[scope][range][1] = 0;
+			}
+			m_frames[i].rangeCount[scope] = 0;
+			m_frames[i].bOpen[scope] = false;
+		}
+		m_frames[i].bPending = false;
+	}
+
+	m_bGpuQueries = false;
+	m_frameNumber = 0;
+	m_bInFrame = false;
+	m_bHasFrameStart = false;
+	m_historySize = HISTORY_FRAMES;
+	m_historyNext = 0;
+
+	m_lastSample.frameNumber = -1;
+	m_lastSample.frameMs = 0.0f;
+	m_lastSample.cpuMs = 0.0f;
+	for (int scope = 0; scope < GPU_SCOPE_COUNT; scope++)
+	{
+		m_lastSample.gpuMs[scope] = -1.0f;
+	}
+	m_lastSample.drawCalls = 0;
+	m_lastSample.uniformUpdates = 0;
+	m_lastSample.textureBinds = 0;
+}
+
+/***********************************************************
+ *  ~FrameProfiler()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameProfiler::~FrameProfiler()
+{
+	if (m_bGpuQueries == true)
+	{
+		for (int i = 0; i < QUERY_FRAMES; i++)
+		{
+			glDeleteQueries(GPU_SCOPE_COUNT * SCOPE_RANGES * 2, &m_frames[i].queries[0][0][0]);
+		}
+	}
+
+	if (m_csvFile.is_open() == true)
+	{
+		m_csvFile.close();
+	}
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for creating the timestamp queries of
+ *  every frame in flight.  False is returned when the driver
+ *  has no timer queries - the CPU is still measured.
+ ***********************************************************/
+bool FrameProfiler::Initialize()
+{
+	if ((GLEW_VERSION_3_3 == GL_FALSE) && (GLEW_ARB_timer_query == GL_FALSE))
+	{
+		std::cout << "Timer queries are not supported, GPU times are not measured" << std::endl;
+		return(false);
+	}
+
+	for (int i = 0; i < QUERY_FRAMES; i++)
+	{
+		glGenQueries(GPU_SCOPE_COUNT * SCOPE_RANGES * 2, &m_frames[i].queries[0][0][0]);
+	}
+	m_bGpuQueries = true;
+
+	return(true);
+}
+
+/***********************************************************
+ *  OpenCsv()
+ *
+ *  This method is used for opening a CSV file that receives
+ *  one row per frame once its GPU times are known.
+ ***********************************************************/
+bool FrameProfiler::OpenCsv(const char* filename)
+{
+	m_csvFile.open(filename, std::ios::trunc);
+	if (m_csvFile.is_open() == false)
+	{
+		std::cout << "Could not open profile file:" << filename << std::endl;
+		return(false);
+	}
+
+	m_csvFile << "frame,frame_ms,cpu_ms";
+	for (int scope = 0; scope < GPU_SCOPE_COUNT; scope++)
+	{
+		m_csvFile << "," << g_ScopeNames[scope];
+	}
+	m_csvFile << ",draw_calls,uniform_updates,texture_binds" << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting the measurements of a
+ *  frame.  The frame that used the same queries before is
+ *  collected first - by now its results are available.
+ ***********************************************************/
+void FrameProfiler::BeginFrame()
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	PENDING_FRAME& frame = m_frames[m_frameNumber % QUERY_FRAMES];
+
+	if (frame.bPending == true)
+	{
+		CollectFrame(frame);
+	}
+
+	frame.sample.frameNumber = m_frameNumber;
+	frame.sample.frameMs = (m_bHasFrameStart == true) ? ElapsedMs(m_frameStart, now) : 0.0f;
+	frame.sample.cpuMs = 0.0f;
+	for (int scope = 0; scope < GPU_SCOPE_COUNT; scope++)
+	{
+		frame.sample.gpuMs[scope] = -1.0f;
+		frame.rangeCount[scope] = 0;
+		frame.bOpen[scope] = false;
+	}
+
+	m_frameStart = now;
+	m_bHasFrameStart = true;
+	m_bInFrame = true;
+
+	s_drawCalls = 0;
+	s_uniformUpdates = 0;
+	s_textureBinds = 0;
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for finishing the measurements of a
+ *  frame.  Without GPU queries the frame is recorded now,
+ *  otherwise once its queries are read back.
+ ***********************************************************/
+void FrameProfiler::EndFrame()
+{
+	if (m_bInFrame == false)
+	{
+		return;
+	}
+
+	PENDING_FRAME& frame = m_frames[m_frameNumber % QUERY_FRAMES];
+
+	frame.sample.cpuMs = ElapsedMs(m_frameStart, std::chrono::steady_clock::now());
+	frame.sample.drawCalls = s_drawCalls;
+	frame.sample.uniformUpdates = s_uniformUpdates;
+	frame.sample.textureBinds = s_textureBinds;
+	frame.bPending = true;
+	m_bInFrame = false;
+	m_frameNumber++;
+
+	if (m_bGpuQueries == false)
+	{
+		CollectFrame(frame);
+	}
+}
+
+/***********************************************************
+ *  BeginGpuScope()
+ *
+ *  This method is used for recording the GPU time at the
+ *  start of a scope.  Timestamps are used instead of
+ *  elapsed time queries, so scopes may be nested.  Every
+ *  time a scope is entered starts a new range of it.
+ ***********************************************************/
+void FrameProfiler::BeginGpuScope(GPU_SCOPE scope)
+{
+	if ((m_bGpuQueries == false) || (m_bInFrame == false))
+	{
+		return;
+	}
+
+	PENDING_FRAME& frame = m_frames[m_frameNumber % QUERY_FRAMES];
+	if ((frame.bOpen[scope] == true) || (frame.rangeCount[scope] >= SCOPE_RANGES))
+	{
+		return;
+	}
+
+	glQueryCounter(frame.queries[scope][frame.rangeCount[scope]][0], GL_TIMESTAMP);
+	frame.bOpen[scope] = true;
+}
+
+/***********************************************************
+ *  EndGpuScope()
+ *
+ *  This method is used for recording the GPU time at the
+ *  end of a scope.
+ ***********************************************************/
+void FrameProfiler::EndGpuScope(GPU_SCOPE scope)
+{
+	if ((m_bGpuQueries == false) || (m_bInFrame == false))
+	{
+		return;
+	}
+
+	PENDING_FRAME& frame = m_frames[m_frameNumber % QUERY_FRAMES];
+	if (frame.bOpen[scope] == false)
+	{
+		return;
+	}
+
+	glQueryCounter(frame.queries[scope][frame.rangeCount[scope]][1], GL_TIMESTAMP);
+	frame.rangeCount[scope]++;
+	frame.bOpen[scope] = false;
+}
+
+/***********************************************************
+ *  Flush()
+ *
+ *  This method is used for recording the frames that still
+ *  wait on their GPU results, oldest first.  This waits for
+ *  the GPU, so it is meant for the end of a measurement.
+ ***********************************************************/
+void FrameProfiler::Flush()
+{
+	for (int i = 0; i < QUERY_FRAMES; i++)
+	{
+		PENDING_FRAME& frame = m_frames[(m_frameNumber + i) % QUERY_FRAMES];
+		if (frame.bPending == true)
+		{
+			CollectFrame(frame);
+		}
+	}
+}
+
+/***********************************************************
+ *  SetHistorySize()
+ *
+ *  This method is used for changing the number of frames in
+ *  the statistics.  The recorded frames are cleared.
+ ***********************************************************/
+void FrameProfiler::SetHistorySize(int frameCount)
+{
+	m_historySize = (frameCount > 0) ? frameCount : 1;
+	m_history.clear();
+	m_history.reserve(m_historySize);
+	m_historyNext = 0;
+}
+
+/***********************************************************
+ *  CollectFrame()
+ *
+ *  This method is used for reading the GPU times of a
+ *  pending frame and adding it to the history and the CSV
+ *  file.  The time of a scope is the sum of its ranges.
+ ***********************************************************/
+void FrameProfiler::CollectFrame(PENDING_FRAME& frame)
+{
+	for (int scope = 0; scope < GPU_SCOPE_COUNT; scope++)
+	{
+		if (frame.rangeCount[scope] > 0)
+		{
+			GLuint64 totalTime = 0;
+			for (int range = 0; range < frame.rangeCount[scope]; range++)
+			{
+				GLuint64 beginTime = 0;
+				GLuint64 endTime = 0;
+
+				glGetQueryObjectui64v(frame.queries[scope][range][0], GL_QUERY_RESULT, &beginTime);
+				glGetQueryObjectui64v(frame.queries[scope][range][1], GL_QUERY_RESULT, &endTime);
+				totalTime += endTime - beginTime;
+			}
+			frame.sample.gpuMs[scope] = (float)((double)totalTime / 1000000.0);
+			frame.rangeCount[scope] = 0;
+		}
+		frame.bOpen[scope] = false;
+	}
+	frame.bPending = false;
+
+	m_lastSample = frame.sample;
+	if ((int)m_history.size() < m_historySize)
+	{
+		m_history.push_back(frame.sample);
+	}
+	else
+	{
+		m_history[m_historyNext] = frame.sample;
+		m_historyNext = (m_historyNext + 1) % m_historySize;
+	}
+
+	if (m_csvFile.is_open() == true)
+	{
+		m_csvFile << frame.sample.frameNumber << "," << frame.sample.frameMs << "," << frame.sample.cpuMs;
+		for (int scope = 0; scope < GPU_SCOPE_COUNT; scope++)
+		{
+			m_csvFile << ",";
+			if (frame.sample.gpuMs[scope] >= 0.0f)
+			{
+				m_csvFile << frame.sample.gpuMs[scope];
+			}
+		}
+		m_csvFile << "," << frame.sample.drawCalls << "," << frame.sample.uniformUpdates << "," << frame.sample.textureBinds << "\n";
+	}
+}
+
+/***********************************************************
+ *  GetStats()
+ *
+ *  This method is used for getting the statistics over the
+ *  recent frames.  The first frame has no frame time and is
+ *  left out of the frame time statistics.
+ ***********************************************************/
+FrameProfiler::FRAME_STATS FrameProfiler::GetStats() const
+{
+	FRAME_STATS stats;
+	std::vector<float> frameTimes;
+	float cpuTotal = 0.0f;
+	float gpuTotal[GPU_SCOPE_COUNT];
+	int gpuCount[GPU_SCOPE_COUNT];
+
+	for (int scope = 0; scope < GPU_SCOPE_COUNT; scope++)
+	{
+		gpuTotal[scope] = 0.0f;
+		gpuCount[scope] = 0;
+	}
+
+	frameTimes.reserve(m_history.size());
+	for (size_t i = 0; i < m_history.size(); i++)
+	{
+		if (m_history[i].frameMs > 0.0f)
+		{
+			frameTimes.push_back(m_history[i].frameMs);
+		}
+		cpuTotal += m_history[i].cpuMs;
+		for (int scope = 0; scope < GPU_SCOPE_COUNT; scope++)
+		{
+			if (m_history[i].gpuMs[scope] >= 0.0f)
+			{
+				gpuTotal[scope] += m_history[i].gpuMs[scope];
+				gpuCount[scope]++;
+			}
+		}
+	}
+
+	stats.sampleCount = (int)frameTimes.size();
+	stats.frameMin = 0.0f;
+	stats.frameAvg = 0.0f;
+	stats.frameP50 = 0.0f;
+	stats.frameP99 = 0.0f;
+	stats.cpuAvg = (m_history.empty() == false) ? cpuTotal / (float)m_history.size() : 0.0f;
+	for (int scope = 0; scope < GPU_SCOPE_COUNT; scope++)
+	{
+		stats.gpuAvg[scope] = (gpuCount[scope] > 0) ? gpuTotal[scope] / (float)gpuCount[scope] : -1.0f;
+	}
+
+	if (frameTimes.empty() == false)
+	{
+		float frameTotal = 0.0f;
+		for (size_t i = 0; i < frameTimes.size(); i++)
+		{
+			frameTotal += frameTimes[i];
+		}
+		stats.frameAvg = frameTotal / (float)frameTimes.size();
+		stats.frameMin = *std::min_element(frameTimes.begin(), frameTimes.end());
+
+		// the median frame time
+		size_t p50Index = frameTimes.size() / 2;
+		std::nth_element(frameTimes.begin(), frameTimes.begin() + p50Index, frameTimes.end());
+		stats.frameP50 = frameTimes[p50Index];
+
+		// the frame time that 99 out of 100 frames stay below
+		size_t p99Index = (frameTimes.size() * 99) / 100;
+		if (p99Index >= frameTimes.size())
+		{
+			p99Index = frameTimes.size() - 1;
+		}
+		std::nth_element(frameTimes.begin(), frameTimes.begin() + p99Index, frameTimes.end());
+		stats.frameP99 = frameTimes[p99Index];
+	}
+
+	return(stats);
+}
+
+/***********************************************************
+ *  FormatSummary()
+ *
+ *  This method is used for formatting the statistics and the
+ *  counters of the last frame into one line of text.  The
+ *  GPU time is followed by the passes that were measured.
+ ***********************************************************/
+std::string FrameProfiler::FormatSummary() const
+{
+	FRAME_STATS stats = GetStats();
+	char gpuText[160] = "n/a";
+	char summary[320];
+
+	if (stats.gpuAvg[GPU_FRAME] >= 0.0f)
+	{
+		int length = snprintf(gpuText, sizeof(gpuText), "%.2f ms", stats.gpuAvg[GPU_FRAME]);
+		const char* separator = " (";
+		for (int scope = GPU_SHADOWS; scope < GPU_SCOPE_COUNT; scope++)
+		{
+			if ((stats.gpuAvg[scope] >= 0.0f) && (length < (int)sizeof(gpuText)))
+			{
+				length += snprintf(gpuText + length, sizeof(gpuText) - length,
+					"%s%s %.2f", separator, g_PassLabels[scope], stats.gpuAvg[scope]);
+				separator = ", ";
+			}
+		}
+		if ((separator[0] == ',') && (length < (int)sizeof(gpuText)))
+		{
+			snprintf(gpuText + length, sizeof(gpuText) - length, ")");
+		}
+	}
+
+	snprintf(summary, sizeof(summary),
+		"%.2f ms (min %.2f, p99 %.2f) | cpu %.2f ms | gpu %s | %d draws, %d uniforms, %d binds",
+		stats.frameAvg,
+		stats.frameMin,
+		stats.frameP99,
+		stats.cpuAvg,
+		gpuText,
+		m_lastSample.drawCalls,
+		m_lastSample.uniformUpdates,
+		m_lastSample.textureBinds);
+
+	return(std::string(summary));
+}
@@ -0,0 +1,148 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameprofiler.h
+// ============
+// frame timing, GPU timer queries and per-frame render counters
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  FrameProfiler
+ *
+ *  This class measures every frame.  The CPU side keeps a
+ *  rolling window of frame times for min/avg/p99, the GPU
+ *  side brackets scopes with timestamp queries that are read
+ *  back a few frames later so they never stall, and the
+ *  render code counts its draw calls, uniform updates and
+ *  texture binds through the static Count methods.  The
+ *  finished frames can be written to a CSV file.
+ ***********************************************************/
+class FrameProfiler
+{
+public:
+	// GPU scopes - scopes may be nested, and a scope entered more
+	// than once in a frame is the sum of its ranges
+	enum GPU_SCOPE
+	{
+		GPU_FRAME = 0,
+		GPU_SCENE,
+		GPU_SHADOWS,
+		GPU_DEPTH_PREPASS,
+		GPU_OPAQUE,
+		GPU_SKY,
+		GPU_BLENDED,
+		GPU_SCOPE_COUNT
+	};
+
+	// properties for the measurements of one frame
+	struct FRAME_SAMPLE
+	{
+		long long frameNumber;
+		// time from the start of the previous frame, in ms
+		float frameMs;
+		// time spent between BeginFrame() and EndFrame(), in ms
+		float cpuMs;
+		// -1 when the scope was not measured
+		float gpuMs[GPU_SCOPE_COUNT];
+		int drawCalls;
+		int uniformUpdates;
+		int textureBinds;
+	};
+
+	// properties for the rolling frame statistics, in ms
+	struct FRAME_STATS
+	{
+		float frameMin;
+		float frameAvg;
+		float frameP50;
+		float frameP99;
+		float cpuAvg;
+		float gpuAvg[GPU_SCOPE_COUNT];
+		int sampleCount;
+	};
+
+	// constructor
+	FrameProfiler();
+	// destructor
+	~FrameProfiler();
+
+	// create the GPU queries - without them only the CPU is measured
+	bool Initialize();
+	// write every measured frame as a row of a CSV file
+	bool OpenCsv(const char* filename);
+
+	// bracket the work of one frame
+	void BeginFrame();
+	void EndFrame();
+	// bracket a GPU scope within the frame
+	void BeginGpuScope(GPU_SCOPE scope);
+	void EndGpuScope(GPU_SCOPE scope);
+	// wait for the frames that still trail behind and record them
+	void Flush();
+
+	// number of frames in the statistics - a benchmark keeps all of them
+	void SetHistorySize(int frameCount);
+
+	// most recent frame with its GPU times filled in
+	const FRAME_SAMPLE& GetLastSample() const { return m_lastSample; }
+	// statistics over the recent frames
+	FRAME_STATS GetStats() const;
+	// one line summary of the statistics for an overlay
+	std::string FormatSummary() const;
+
+	// counters for the render code - reset every frame
+	static void CountDrawCall() { s_drawCalls++; }
+	static void CountUniformUpdate() { s_uniformUpdates++; }
+	static void CountTextureBind() { s_textureBinds++; }
+
+private:
+	// number of frames the GPU results trail behind
+	static const int QUERY_FRAMES = 4;
+	// default number of frames in the rolling statistics
+	static const int HISTORY_FRAMES = 240;
+	// most ranges measured for one scope in a frame - the passes
+	// run once for every view, and the ranges past it are not timed
+	static const int SCOPE_RANGES = 8;
+
+	// properties for a frame that waits on its GPU results
+	struct PENDING_FRAME
+	{
+		FRAME_SAMPLE sample;
+		// begin and end timestamp query of every range of every scope
+		GLuint queries[GPU_SCOPE_COUNT][SCOPE_RANGES][2];
+		// number of finished ranges of every scope
+		int rangeCount[GPU_SCOPE_COUNT];
+		bool bOpen[GPU_SCOPE_COUNT];
+		bool bPending;
+	};
+
+	// read the GPU results of a pending frame and record it
+	void CollectFrame(PENDING_FRAME& frame);
+
+	PENDING_FRAME m_frames[QUERY_FRAMES];
+	bool m_bGpuQueries;
+	long long m_frameNumber;
+	bool m_bInFrame;
+	std::chrono::steady_clock::time_point m_frameStart;
+	bool m_bHasFrameStart;
+
+	// rolling history of the recorded frames
+	std::vector<FRAME_SAMPLE> m_history;
+	int m_historySize;
+	int m_historyNext;
+	FRAME_SAMPLE m_lastSample;
+
+	std::ofstream m_csvFile;
+
+	static int s_drawCalls;
+	static int s_uniformUpdates;
+	static int s_textureBinds;
+};
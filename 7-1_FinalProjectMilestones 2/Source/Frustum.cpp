@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustum.cpp
+// ============
+// view frustum planes for culling objects outside of the view
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Frustum.h"
+
+#include <cmath>
+
+/***********************************************************
+ *  Frustum()
+ *
+ *  The constructor for the class - the planes start out
+ *  accepting everything.
+ ***********************************************************/
+Frustum::Frustum()
+{
+	for (int i = 0; i < PLANE_COUNT; i++)
+	{
+		m_planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+}
+
+/***********************************************************
+ *  ExtractPlanes()
+ *
+ *  This method is used for taking the six planes from the
+ *  rows of a view-projection matrix.  Each plane is scaled
+ *  to a unit normal so distances can be compared to radii.
+ ***********************************************************/
+void Frustum::ExtractPlanes(const glm::mat4& viewProjection)
+{
+	// glm matrices are stored by column, so gather the rows first
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; i++)
+	{
+		rows[i] = glm::vec4(
+			viewProjection[0][i],
+			viewProjection[1][i],
+			viewProjection[2][i],
+			viewProjection[3][i]);
+	}
+
+	m_planes[0] = rows[3] + rows[0];	// left
+	m_planes[1] = rows[3] - rows[0];	// right
+	m_planes[2] = rows[3] + rows[1];	// bottom
+	m_planes[3] = rows[3] - rows[1];	// top
+	m_planes[4] = rows[3] + rows[2];	// near
+	m_planes[5] = rows[3] - rows[2];	// far
+
+	for (int i = 0; i < PLANE_COUNT; i++)
+	{
+		float length = glm::length(glm::vec3(m_planes[i]));
+		if (length > 0.0f)
+		{
+			m_planes[i] = m_planes[i] / length;
+		}
+	}
+}
+
+/***********************************************************
+ *  GetDepthRange()
+ *
+ *  This method is used for reading the distances of the
+ *  near and far planes back out of a projection matrix.  A
+ *  perspective projection has -1 in the w row of z, an
+ *  orthographic one has 1 in the bottom right corner.
+ ***********************************************************/
+void Frustum::GetDepthRange(const glm::mat4& projection, float& nearPlane, float& farPlane)
+{
+	if (projection[3][3] == 0.0f)
+	{
+		nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+		farPlane = projection[3][2] / (projection[2][2] + 1.0f);
+	}
+	else
+	{
+		nearPlane = (projection[3][2] + 1.0f) / projection[2][2];
+		farPlane = (projection[3][2] - 1.0f) / projection[2][2];
+	}
+}
+
+/***********************************************************
+ *  IsSphereVisible()
+ *
+ *  This method is used for testing a bounding sphere against
+ *  the frustum.  False is only returned when the sphere is
+ *  completely outside of one of the planes.
+ ***********************************************************/
+bool Frustum::IsSphereVisible(const glm::vec3& center, float radius) const
+{
+	for (int i = 0; i < PLANE_COUNT; i++)
+	{
+		const glm::vec4& plane = m_planes[i];
+
+		if ((glm::dot(glm::vec3(plane), center) + plane.w) < -radius)
+		{
+			return(false);
+		}
+	}
+
+	return(true);
+}
@@ -0,0 +1,43 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustum.h
+// ============
+// view frustum planes for culling objects outside of the view
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  Frustum
+ *
+ *  This class holds the six planes of a view frustum.  The
+ *  planes are taken directly from a view-projection matrix,
+ *  which works the same for perspective and orthographic
+ *  projections.
+ ***********************************************************/
+class Frustum
+{
+public:
+	// constructor
+	Frustum();
+
+	// take the planes from the passed in view-projection matrix
+	void ExtractPlanes(const glm::mat4& viewProjection);
+	// true when any part of the sphere is inside the frustum
+	bool IsSphereVisible(const glm::vec3& center, float radius) const;
+
+	// get the near and far plane distances of a projection matrix
+	static void GetDepthRange(const glm::mat4& projection, float& nearPlane, float& farPlane);
+
+	// access the planes - xyz is the inward normal, w the distance
+	const glm::vec4& GetPlane(int planeIndex) const { return m_planes[planeIndex]; }
+
+	// number of frustum planes
+	static const int PLANE_COUNT = 6;
+
+private:
+	// left, right, bottom, top, near and far planes
+	glm::vec4 m_planes[PLANE_COUNT];
+};
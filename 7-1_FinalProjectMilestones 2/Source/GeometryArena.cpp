@@ -0,0 +1,222 @@
+///////////////////////////////////////////////////////////////////////////////
+// geometryarena.cpp
+// ============
+// one vertex buffer and one index buffer shared by every mesh
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GeometryArena.h"
+
+/***********************************************************
+ *  GeometryArena()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GeometryArena::GeometryArena()
+{
+	m_vertexCapacity = 0;
+	m_indexCapacity = 0;
+	m_vertexCount = 0;
+	m_indexCount = 0;
+}
+
+/***********************************************************
+ *  ~GeometryArena()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GeometryArena::~GeometryArena()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the vertex array and
+ *  the two buffers with room for the passed in number of
+ *  vertices and indices.  Callers that know what they will
+ *  add size the arena up front, so it never has to grow.
+ ***********************************************************/
+bool GeometryArena::Create(size_t vertexCapacity, size_t indexCapacity)
+{
+	Destroy();
+
+	if ((vertexCapacity == 0) || (indexCapacity == 0))
+	{
+		return(false);
+	}
+
+	m_vao.Create();
+	glBindVertexArray(m_vao);
+
+	m_vertexBuffer.Create();
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER,
+		vertexCapacity * sizeof(ShapeGeometry::VERTEX),
+		NULL, GL_STATIC_DRAW);
+	m_vertexBuffer.SetMemory(GpuMemory::GEOMETRY, vertexCapacity * sizeof(ShapeGeometry::VERTEX));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// the index buffer binding is part of the vertex array
+	m_indexBuffer.Create();
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+		indexCapacity * sizeof(uint32_t),
+		NULL, GL_STATIC_DRAW);
+	m_indexBuffer.SetMemory(GpuMemory::GEOMETRY, indexCapacity * sizeof(uint32_t));
+
+	glBindVertexArray(0);
+
+	m_vertexCapacity = vertexCapacity;
+	m_indexCapacity = indexCapacity;
+	AttachVertexBuffer();
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the buffers and the
+ *  vertex array.  The mesh ranges handed out are no longer
+ *  valid afterwards.
+ ***********************************************************/
+void GeometryArena::Destroy()
+{
+	m_vao.Destroy();
+	m_vertexBuffer.Destroy();
+	m_indexBuffer.Destroy();
+
+	m_vertexCapacity = 0;
+	m_indexCapacity = 0;
+	m_vertexCount = 0;
+	m_indexCount = 0;
+}
+
+/***********************************************************
+ *  AttachVertexBuffer()
+ *
+ *  This method is used for pointing the attributes of the
+ *  shared vertex layout at the current vertex buffer, with
+ *  one step per vertex.
+ ***********************************************************/
+void GeometryArena::AttachVertexBuffer()
+{
+	GLsizei vertexStride = sizeof(ShapeGeometry::VERTEX);
+
+	glBindVertexArray(m_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+
+	// per-vertex attributes
+	glEnableVertexAttribArray(POSITION_ATTRIBUTE);
+	glVertexAttribPointer(POSITION_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, vertexStride,
+		(void*)offsetof(ShapeGeometry::VERTEX, position));
+	glEnableVertexAttribArray(NORMAL_ATTRIBUTE);
+	glVertexAttribPointer(NORMAL_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, vertexStride,
+		(void*)offsetof(ShapeGeometry::VERTEX, normal));
+	glEnableVertexAttribArray(TEXTURE_ATTRIBUTE);
+	glVertexAttribPointer(TEXTURE_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, vertexStride,
+		(void*)offsetof(ShapeGeometry::VERTEX, textureCoordinate));
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  GrowBuffer()
+ *
+ *  This method is used for creating a buffer of the new size,
+ *  copying the used part of the old buffer into it on the
+ *  GPU and freeing the old buffer.  The handle holds the new
+ *  buffer afterwards.
+ ***********************************************************/
+void GeometryArena::GrowBuffer(GpuBuffer& buffer, size_t usedSize, size_t newSize)
+{
+	GpuBuffer newBuffer;
+
+	newBuffer.Create();
+	glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, newSize, NULL, GL_STATIC_DRAW);
+	newBuffer.SetMemory(GpuMemory::GEOMETRY, newSize);
+	if (usedSize > 0)
+	{
+		glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, usedSize);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	buffer = std::move(newBuffer);
+}
+
+/***********************************************************
+ *  AddMesh()
+ *
+ *  This method is used for copying the vertices and indices
+ *  of a mesh behind the meshes already in the arena and
+ *  returning where they went.  A buffer without room is
+ *  replaced with one of at least twice the size, so adding
+ *  many meshes only grows the arena a few times.
+ ***********************************************************/
+bool GeometryArena::AddMesh(const ShapeGeometry::MESH_DATA& mesh, MESH_RANGE& range)
+{
+	if ((m_vao == 0) || (mesh.vertices.empty() == true) || (mesh.indices.empty() == true))
+	{
+		return(false);
+	}
+
+	size_t vertexCount = m_vertexCount + mesh.vertices.size();
+	size_t indexCount = m_indexCount + mesh.indices.size();
+
+	if (vertexCount > m_vertexCapacity)
+	{
+		size_t capacity = m_vertexCapacity * 2;
+		if (capacity < vertexCount)
+		{
+			capacity = vertexCount;
+		}
+		GrowBuffer(m_vertexBuffer,
+			m_vertexCount * sizeof(ShapeGeometry::VERTEX),
+			capacity * sizeof(ShapeGeometry::VERTEX));
+		m_vertexCapacity = capacity;
+		AttachVertexBuffer();
+	}
+	if (indexCount > m_indexCapacity)
+	{
+		size_t capacity = m_indexCapacity * 2;
+		if (capacity < indexCount)
+		{
+			capacity = indexCount;
+		}
+		GrowBuffer(m_indexBuffer,
+			m_indexCount * sizeof(uint32_t),
+			capacity * sizeof(uint32_t));
+		m_indexCapacity = capacity;
+
+		glBindVertexArray(m_vao);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+		glBindVertexArray(0);
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_vertexBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER,
+		m_vertexCount * sizeof(ShapeGeometry::VERTEX),
+		mesh.vertices.size() * sizeof(ShapeGeometry::VERTEX),
+		mesh.vertices.data());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_indexBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER,
+		m_indexCount * sizeof(uint32_t),
+		mesh.indices.size() * sizeof(uint32_t),
+		mesh.indices.data());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	range.firstIndex = (GLuint)m_indexCount;
+	range.nIndices = (GLsizei)mesh.indices.size();
+	range.baseVertex = (GLint)m_vertexCount;
+
+	m_vertexCount = vertexCount;
+	m_indexCount = indexCount;
+
+	return(true);
+}
@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////////////
+// geometryarena.h
+// ============
+// one vertex buffer and one index buffer shared by every mesh
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShapeGeometry.h"
+#include "GpuResources.h"
+
+#include <GL/glew.h>
+
+#include <cstddef>
+
+/***********************************************************
+ *  GeometryArena
+ *
+ *  This class suballocates meshes out of one large vertex
+ *  buffer and one large index buffer with the shared vertex
+ *  layout of ShapeGeometry.  A mesh is described by where
+ *  its indices and vertices start and how many indices it
+ *  has, and its indices stay relative to its first vertex,
+ *  so meshes are added without rewriting any data.  A single
+ *  vertex array reads both buffers, so drawing any mesh of
+ *  the arena needs no state change.
+ *
+ *  Meshes can be added at any time.  When a buffer runs out
+ *  of room it is replaced with a larger one and the contents
+ *  are copied over on the GPU, while the vertex array keeps
+ *  its object ID and any attributes added to it by callers.
+ ***********************************************************/
+class GeometryArena
+{
+public:
+	// vertex attribute locations of the shared vertex layout -
+	// callers add their own attributes from FIRST_FREE_ATTRIBUTE
+	static const GLuint POSITION_ATTRIBUTE = 0;
+	static const GLuint NORMAL_ATTRIBUTE = 1;
+	static const GLuint TEXTURE_ATTRIBUTE = 2;
+	static const GLuint FIRST_FREE_ATTRIBUTE = 3;
+
+	// properties for the part of the arena holding a mesh
+	struct MESH_RANGE
+	{
+		GLuint firstIndex;
+		GLsizei nIndices;
+		GLint baseVertex;
+	};
+
+	// constructor
+	GeometryArena();
+	// destructor
+	~GeometryArena();
+
+	// create the buffers with room for the passed in counts
+	bool Create(size_t vertexCapacity, size_t indexCapacity);
+	// free the buffers and the vertex array
+	void Destroy();
+
+	// copy a mesh into the arena - grows the buffers when needed
+	bool AddMesh(const ShapeGeometry::MESH_DATA& mesh, MESH_RANGE& range);
+
+	// vertex array that reads the arena buffers
+	GLuint GetVertexArray() const { return m_vao; }
+	// number of vertices and indices in use
+	size_t GetVertexCount() const { return m_vertexCount; }
+	size_t GetIndexCount() const { return m_indexCount; }
+
+private:
+	// replace a buffer with a larger one holding the same contents
+	static void GrowBuffer(GpuBuffer& buffer, size_t usedSize, size_t newSize);
+	// point the shared vertex attributes at the vertex buffer
+	void AttachVertexBuffer();
+
+	GpuVertexArray m_vao;
+	GpuBuffer m_vertexBuffer;
+	GpuBuffer m_indexBuffer;
+	size_t m_vertexCapacity;
+	size_t m_indexCapacity;
+	size_t m_vertexCount;
+	size_t m_indexCount;
+};
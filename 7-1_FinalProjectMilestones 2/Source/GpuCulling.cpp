@@ -0,0 +1,286 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuculling.cpp
+// ============
+// frustum culling on the GPU that writes the indirect draws of the scene
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GpuCulling.h"
+
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	const char* g_ComputeShaderPath = "shaders/cullComputeShader.glsl";
+
+	// must match the local size of the culling shader
+	const int g_CullGroupSize = 64;
+
+	// storage buffer bindings - must match the culling shader
+	const GLuint OBJECT_BINDING = 0;
+	const GLuint COMMAND_BINDING = 1;
+	const GLuint INSTANCE_BINDING = 2;
+	const GLuint LOD_STATE_BINDING = 3;
+}
+
+/***********************************************************
+ *  GpuCulling()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GpuCulling::GpuCulling()
+{
+	m_planesLocation = -1;
+	m_objectCountLocation = -1;
+	m_lodViewLocation = -1;
+	m_lodSelectionLocation = -1;
+	m_lodStateOffsetLocation = -1;
+	m_lodSelection = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
+	m_objectCount = 0;
+	m_commandCount = 0;
+	m_viewCount = 1;
+}
+
+/***********************************************************
+ *  ~GpuCulling()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GpuCulling::~GpuCulling()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking whether the driver can
+ *  run the culling shader.  The culled commands are drawn
+ *  with a multi-draw, which OpenGL 4.3 has as well.
+ ***********************************************************/
+bool GpuCulling::IsSupported()
+{
+	if (GLEW_VERSION_4_3 == GL_TRUE)
+	{
+		return(true);
+	}
+
+	return((GLEW_ARB_compute_shader == GL_TRUE) &&
+		(GLEW_ARB_shader_storage_buffer_object == GL_TRUE) &&
+		(GLEW_ARB_multi_draw_indirect == GL_TRUE));
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for loading the culling shader and
+ *  creating the buffers.  False is returned when the shader
+ *  cannot be used, in which case the caller keeps culling on
+ *  the CPU.
+ ***********************************************************/
+bool GpuCulling::Initialize()
+{
+	if (IsSupported() == false)
+	{
+		return(false);
+	}
+	if (m_program.Load(g_ComputeShaderPath) == false)
+	{
+		std::cout << "Culling shader not loaded, culling stays on the CPU" << std::endl;
+		return(false);
+	}
+
+	m_planesLocation = m_program.GetUniformLocation("frustumPlanes");
+	m_objectCountLocation = m_program.GetUniformLocation("objectCount");
+	m_lodViewLocation = m_program.GetUniformLocation("lodView");
+	m_lodSelectionLocation = m_program.GetUniformLocation("lodSelection");
+	m_lodStateOffsetLocation = m_program.GetUniformLocation("lodStateOffset");
+
+	m_objectBuffer.Create();
+	m_commandTemplateBuffer.Create();
+	m_commandBuffer.Create();
+	m_instanceBuffer.Create();
+	m_lodStateBuffer.Create();
+
+	return(true);
+}
+
+/***********************************************************
+ *  WatchFiles()
+ *
+ *  This method is used for reloading the culling shader
+ *  whenever its file is written.
+ ***********************************************************/
+void GpuCulling::WatchFiles(HotReload* pHotReload)
+{
+	if ((NULL == pHotReload) || (m_program.GetProgramID() == 0))
+	{
+		return;
+	}
+
+	int watchIndex = pHotReload->AddWatch([this]() { ReloadShader(); });
+	pHotReload->AddFile(watchIndex, g_ComputeShaderPath);
+}
+
+/***********************************************************
+ *  ReloadShader()
+ *
+ *  This method is used for compiling the changed culling
+ *  shader and looking up its uniforms again.
+ ***********************************************************/
+void GpuCulling::ReloadShader()
+{
+	if (m_program.Reload(g_ComputeShaderPath) == false)
+	{
+		return;
+	}
+
+	m_planesLocation = m_program.GetUniformLocation("frustumPlanes");
+	m_objectCountLocation = m_program.GetUniformLocation("objectCount");
+	m_lodViewLocation = m_program.GetUniformLocation("lodView");
+	m_lodSelectionLocation = m_program.GetUniformLocation("lodSelection");
+	m_lodStateOffsetLocation = m_program.GetUniformLocation("lodStateOffset");
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the culling program and
+ *  all of the buffers.
+ ***********************************************************/
+void GpuCulling::Destroy()
+{
+	m_objectBuffer.Destroy();
+	m_commandTemplateBuffer.Destroy();
+	m_commandBuffer.Destroy();
+	m_instanceBuffer.Destroy();
+	m_lodStateBuffer.Destroy();
+
+	m_program.Destroy();
+	m_objectCount = 0;
+	m_commandCount = 0;
+}
+
+/***********************************************************
+ *  SetScene()
+ *
+ *  This method is used for uploading the scene objects and
+ *  the draw commands of their batches.  The instance buffer
+ *  gets room for every object at every level, since all of
+ *  them may be visible at any level, and every object starts
+ *  out at level 0 in every view.  The buffers keep their object
+ *  IDs, so vertex arrays attached to the instance buffer stay
+ *  attached.
+ ***********************************************************/
+void GpuCulling::SetScene(
+	const std::vector<CULL_OBJECT>& objects,
+	const std::vector<InstancedMeshes::DRAW_COMMAND>& commands,
+	int viewCount)
+{
+	m_objectCount = (int)objects.size();
+	m_commandCount = (int)commands.size();
+	m_viewCount = (viewCount > 1) ? viewCount : 1;
+	if ((m_objectCount == 0) || (m_commandCount == 0))
+	{
+		return;
+	}
+
+	size_t commandSize = commands.size() * sizeof(InstancedMeshes::DRAW_COMMAND);
+	size_t objectSize = objects.size() * sizeof(CULL_OBJECT);
+	size_t instanceSize = objects.size() * InstancedMeshes::LOD_COUNT * sizeof(InstancedMeshes::INSTANCE_DATA);
+	std::vector<GLuint> lodLevels(objects.size() * m_viewCount, 0);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_objectBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, objectSize, objects.data(), GL_STATIC_DRAW);
+	m_objectBuffer.SetMemory(GpuMemory::BUFFERS, objectSize);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_instanceBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, instanceSize, NULL, GL_DYNAMIC_COPY);
+	m_instanceBuffer.SetMemory(GpuMemory::GEOMETRY, instanceSize);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_lodStateBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER,
+		lodLevels.size() * sizeof(GLuint),
+		lodLevels.data(), GL_DYNAMIC_COPY);
+	m_lodStateBuffer.SetMemory(GpuMemory::BUFFERS, lodLevels.size() * sizeof(GLuint));
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_commandBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, commandSize, NULL, GL_DYNAMIC_COPY);
+	m_commandBuffer.SetMemory(GpuMemory::BUFFERS, commandSize);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_commandTemplateBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, commandSize, commands.data(), GL_STATIC_DRAW);
+	m_commandTemplateBuffer.SetMemory(GpuMemory::BUFFERS, commandSize);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+/***********************************************************
+ *  SetLodSelection()
+ *
+ *  This method is used for setting the projected sizes, as
+ *  a fraction of half the view height, below which objects
+ *  switch to the next coarser level.  An object holds on to
+ *  its level until its size is past a switch by the
+ *  hysteresis fraction, so the level does not flicker.
+ ***********************************************************/
+void GpuCulling::SetLodSelection(const float screenSizes[InstancedMeshes::LOD_COUNT - 1], float hysteresis)
+{
+	m_lodSelection = glm::vec4(screenSizes[0], screenSizes[1], hysteresis, 0.0f);
+}
+
+/***********************************************************
+ *  Cull()
+ *
+ *  This method is used for culling the scene objects on the
+ *  GPU.  The draw commands are reset from the template, the
+ *  culling shader counts the visible objects of every batch
+ *  level into its command and writes their instance values,
+ *  and a barrier makes both visible to the draws that
+ *  follow.  The projected size of an object is its radius
+ *  times lodScale over its depth, the dot product of its
+ *  center with lodDepthRow, and the level it had is the one
+ *  last chosen for the view index.
+ ***********************************************************/
+void GpuCulling::Cull(const Frustum* pFrustum, const glm::vec4& lodDepthRow, float lodScale, int viewIndex)
+{
+	if ((m_objectCount == 0) || (m_commandCount == 0))
+	{
+		return;
+	}
+
+	// planes that every sphere is inside of keep all the objects
+	glm::vec4 planes[Frustum::PLANE_COUNT];
+	for (int i = 0; i < Frustum::PLANE_COUNT; i++)
+	{
+		if (NULL != pFrustum)
+		{
+			planes[i] = pFrustum->GetPlane(i);
+		}
+		else
+		{
+			planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+	}
+
+	glBindBuffer(GL_COPY_READ_BUFFER, m_commandTemplateBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_commandBuffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+		m_commandCount * sizeof(InstancedMeshes::DRAW_COMMAND));
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	m_program.Use();
+	glUniform4fv(m_planesLocation, Frustum::PLANE_COUNT, &planes[0][0]);
+	glUniform1ui(m_objectCountLocation, (GLuint)m_objectCount);
+	glUniform4f(m_lodViewLocation, lodDepthRow.x, lodDepthRow.y, lodDepthRow.z, lodDepthRow.w);
+	glUniform4f(m_lodSelectionLocation, m_lodSelection.x, m_lodSelection.y, m_lodSelection.z, lodScale);
+	glUniform1ui(m_lodStateOffsetLocation, (GLuint)(glm::clamp(viewIndex, 0, m_viewCount - 1) * m_objectCount));
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_BINDING, m_objectBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMAND_BINDING, m_commandBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_BINDING, m_instanceBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LOD_STATE_BINDING, m_lodStateBuffer);
+
+	glDispatchCompute((GLuint)((m_objectCount + g_CullGroupSize - 1) / g_CullGroupSize), 1, 1);
+
+	// the commands are read as draw parameters, the instances as attributes
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
@@ -0,0 +1,121 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuculling.h
+// ============
+// frustum culling on the GPU that writes the indirect draws of the scene
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "InstancedMeshes.h"
+#include "Frustum.h"
+#include "ComputeProgram.h"
+#include "HotReload.h"
+#include "GpuResources.h"
+
+#include <GL/glew.h>
+
+#include <vector>
+
+/***********************************************************
+ *  GpuCulling
+ *
+ *  This class moves the frustum culling of the instanced
+ *  scene into a compute pass.  Every scene object is kept in
+ *  a storage buffer with its instance values, its bounding
+ *  sphere and the draw command of its batch, and only has
+ *  to be uploaded again after the scene changes.  Each frame
+ *  the instance counts of the draw commands are reset, one
+ *  invocation per object tests its sphere against the view
+ *  frustum, and the visible objects are packed into the
+ *  instance buffer behind the base instance of their batch.
+ *  The commands are then drawn with a multi-draw straight
+ *  from the buffer, so the CPU never touches the objects.
+ *
+ *  The pass also picks the level of detail of every visible
+ *  object from its projected size.  A batch has one command
+ *  per level, and each level packs its instances into its
+ *  own part of the instance buffer.  The chosen level of
+ *  every object is kept on the GPU for the hysteresis, once
+ *  for every view, so the views of a frame can share the
+ *  objects and commands and still keep their own levels.
+ ***********************************************************/
+class GpuCulling
+{
+public:
+	// properties for a scene object in the object buffer - the
+	// layout is the one the culling shader reads
+	struct CULL_OBJECT
+	{
+		InstancedMeshes::INSTANCE_DATA instance;
+		// center in xyz, radius in w
+		glm::vec4 boundsSphere;
+		// index of the level 0 draw command of the object's batch -
+		// the commands of the other levels follow it
+		GLuint commandIndex;
+		// number of levels of the object's shape
+		GLuint lodCount;
+		GLuint padding[2];
+	};
+
+	// constructor
+	GpuCulling();
+	// destructor
+	~GpuCulling();
+
+	// true when the driver supports compute shaders and storage buffers
+	static bool IsSupported();
+	// load the culling shader and create the buffers
+	bool Initialize();
+	// reload the culling shader when its file changes
+	void WatchFiles(HotReload* pHotReload);
+
+	// replace the scene objects and the draw commands of their batches,
+	// LOD_COUNT per batch - the base instance of a command is where its
+	// level of the batch starts, within LOD_COUNT times the object count,
+	// and the levels are kept for the passed in number of views
+	void SetScene(
+		const std::vector<CULL_OBJECT>& objects,
+		const std::vector<InstancedMeshes::DRAW_COMMAND>& commands,
+		int viewCount);
+	// the projected sizes where the levels switch, and the fraction
+	// of a size the level holds on for past its switch
+	void SetLodSelection(const float screenSizes[InstancedMeshes::LOD_COUNT - 1], float hysteresis);
+	// cull the objects and fill the draw commands - a NULL frustum keeps
+	// every object, and with a lodScale of 0 every object uses level 0
+	void Cull(const Frustum* pFrustum, const glm::vec4& lodDepthRow, float lodScale, int viewIndex);
+
+	// buffers the instanced draws read after Cull()
+	GLuint GetCommandBuffer() const { return m_commandBuffer; }
+	GLuint GetInstanceBuffer() const { return m_instanceBuffer; }
+	// number of objects and draw commands in the scene
+	int GetObjectCount() const { return m_objectCount; }
+	int GetCommandCount() const { return m_commandCount; }
+
+private:
+	// free the program and the buffers
+	void Destroy();
+	// compile the changed culling shader
+	void ReloadShader();
+
+	ComputeProgram m_program;
+	GLint m_planesLocation;
+	GLint m_objectCountLocation;
+	GLint m_lodViewLocation;
+	GLint m_lodSelectionLocation;
+	GLint m_lodStateOffsetLocation;
+	// switch sizes in x and y, hysteresis in z
+	glm::vec4 m_lodSelection;
+	// objects of the scene, read by the culling shader
+	GpuBuffer m_objectBuffer;
+	// draw commands with zero instances, copied over the commands each frame
+	GpuBuffer m_commandTemplateBuffer;
+	// draw commands and instances written by the culling shader
+	GpuBuffer m_commandBuffer;
+	GpuBuffer m_instanceBuffer;
+	// level of detail last chosen for every object in every view
+	GpuBuffer m_lodStateBuffer;
+	int m_objectCount;
+	int m_commandCount;
+	int m_viewCount;
+};
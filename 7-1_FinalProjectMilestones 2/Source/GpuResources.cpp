@@ -0,0 +1,472 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuresources.cpp
+// ============
+// owned OpenGL objects, video memory accounting and a pool of scene textures
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GpuResources.h"
+
+#include <algorithm>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// bytes, object counts and peaks of the categories - the
+	// OpenGL objects are only made and freed on the main thread
+	long long g_CategoryBytes[GpuMemory::CATEGORY_COUNT] = { 0 };
+	int g_CategoryObjects[GpuMemory::CATEGORY_COUNT] = { 0 };
+	long long g_CategoryPeaks[GpuMemory::CATEGORY_COUNT] = { 0 };
+
+	const char* g_CategoryNames[GpuMemory::CATEGORY_COUNT] =
+	{
+		"textures",
+		"geometry",
+		"buffers",
+		"renderTargets",
+		"pooledTextures"
+	};
+
+	// textures kept for reuse unless the budget is changed
+	const long long g_DefaultPoolBudget = 64LL * 1024 * 1024;
+}
+
+/***********************************************************
+ *  Add()
+ *
+ *  This method is used for counting the storage of an
+ *  object in its category.
+ ***********************************************************/
+void GpuMemory::Add(CATEGORY category, long long bytes)
+{
+	if ((category < 0) || (category >= CATEGORY_COUNT) || (bytes <= 0))
+	{
+		return;
+	}
+
+	g_CategoryBytes[category] += bytes;
+	g_CategoryObjects[category]++;
+	g_CategoryPeaks[category] = std::max(g_CategoryPeaks[category], g_CategoryBytes[category]);
+}
+
+/***********************************************************
+ *  Remove()
+ *
+ *  This method is used for no longer counting the storage
+ *  of an object that was freed or changed its size.
+ ***********************************************************/
+void GpuMemory::Remove(CATEGORY category, long long bytes)
+{
+	if ((category < 0) || (category >= CATEGORY_COUNT) || (bytes <= 0))
+	{
+		return;
+	}
+
+	g_CategoryBytes[category] -= bytes;
+	g_CategoryObjects[category]--;
+}
+
+/***********************************************************
+ *  GetBytes()
+ *
+ *  This method is used for getting the bytes currently held
+ *  by the objects of a category.
+ ***********************************************************/
+long long GpuMemory::GetBytes(CATEGORY category)
+{
+	if ((category < 0) || (category >= CATEGORY_COUNT))
+	{
+		return(0);
+	}
+
+	return(g_CategoryBytes[category]);
+}
+
+/***********************************************************
+ *  GetObjectCount()
+ *
+ *  This method is used for getting the number of objects
+ *  with storage in a category.
+ ***********************************************************/
+int GpuMemory::GetObjectCount(CATEGORY category)
+{
+	if ((category < 0) || (category >= CATEGORY_COUNT))
+	{
+		return(0);
+	}
+
+	return(g_CategoryObjects[category]);
+}
+
+/***********************************************************
+ *  GetPeakBytes()
+ *
+ *  This method is used for getting the most bytes that the
+ *  objects of a category held at one time.
+ ***********************************************************/
+long long GpuMemory::GetPeakBytes(CATEGORY category)
+{
+	if ((category < 0) || (category >= CATEGORY_COUNT))
+	{
+		return(0);
+	}
+
+	return(g_CategoryPeaks[category]);
+}
+
+/***********************************************************
+ *  GetTotalBytes()
+ *
+ *  This method is used for getting the bytes held by the
+ *  objects of all the categories together.
+ ***********************************************************/
+long long GpuMemory::GetTotalBytes()
+{
+	long long totalBytes = 0;
+
+	for (int i = 0; i < CATEGORY_COUNT; i++)
+	{
+		totalBytes += g_CategoryBytes[i];
+	}
+
+	return(totalBytes);
+}
+
+/***********************************************************
+ *  GetCategoryName()
+ *
+ *  This method is used for getting the name of a category
+ *  as it is shown in the reports.
+ ***********************************************************/
+const char* GpuMemory::GetCategoryName(CATEGORY category)
+{
+	if ((category < 0) || (category >= CATEGORY_COUNT))
+	{
+		return("unknown");
+	}
+
+	return(g_CategoryNames[category]);
+}
+
+/***********************************************************
+ *  Print()
+ *
+ *  This method is used for printing the current and peak
+ *  bytes and the number of objects of every category.
+ ***********************************************************/
+void GpuMemory::Print()
+{
+	const double megabyte = 1024.0 * 1024.0;
+
+	std::cout << "Video memory: " << (GetTotalBytes() / megabyte) << " MB" << std::endl;
+	for (int i = 0; i < CATEGORY_COUNT; i++)
+	{
+		std::cout << "  " << g_CategoryNames[i]
+			<< ": " << (g_CategoryBytes[i] / megabyte) << " MB in "
+			<< g_CategoryObjects[i] << " objects, peak "
+			<< (g_CategoryPeaks[i] / megabyte) << " MB" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  GetTextureBytes()
+ *
+ *  This method is used for getting the storage of a texture
+ *  and all of its mip levels.  Block compressed levels take
+ *  whole 4 x 4 blocks, and RGB8 is counted with the padding
+ *  the drivers add to each texel.
+ ***********************************************************/
+long long GpuMemory::GetTextureBytes(GLenum internalFormat, int width, int height, int levels)
+{
+	long long totalBytes = 0;
+
+	for (int level = 0; level < std::max(levels, 1); level++)
+	{
+		long long levelWidth = std::max(width >> level, 1);
+		long long levelHeight = std::max(height >> level, 1);
+		long long blocks = ((levelWidth + 3) / 4) * ((levelHeight + 3) / 4);
+
+		switch (internalFormat)
+		{
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+			totalBytes += blocks * 8;
+			break;
+		case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+			totalBytes += blocks * 16;
+			break;
+		case GL_RGBA16F:
+			totalBytes += levelWidth * levelHeight * 8;
+			break;
+		default:
+			// RGB8, RGBA8 and the 24 and 32 bit depth formats
+			totalBytes += levelWidth * levelHeight * 4;
+			break;
+		}
+	}
+
+	return(totalBytes);
+}
+
+/***********************************************************
+ *  GenerateGpuObject()
+ *
+ *  This function is used for creating one OpenGL object of
+ *  the passed in kind.
+ ***********************************************************/
+GLuint GenerateGpuObject(GPU_OBJECT_KIND kind)
+{
+	GLuint objectID = 0;
+
+	switch (kind)
+	{
+	case GPU_TEXTURE:
+		glGenTextures(1, &objectID);
+		break;
+	case GPU_BUFFER:
+		glGenBuffers(1, &objectID);
+		break;
+	case GPU_VERTEX_ARRAY:
+		glGenVertexArrays(1, &objectID);
+		break;
+	case GPU_FRAMEBUFFER:
+		glGenFramebuffers(1, &objectID);
+		break;
+	case GPU_RENDERBUFFER:
+		glGenRenderbuffers(1, &objectID);
+		break;
+	}
+
+	return(objectID);
+}
+
+/***********************************************************
+ *  DeleteGpuObject()
+ *
+ *  This function is used for deleting one OpenGL object of
+ *  the passed in kind.
+ ***********************************************************/
+void DeleteGpuObject(GPU_OBJECT_KIND kind, GLuint objectID)
+{
+	switch (kind)
+	{
+	case GPU_TEXTURE:
+		glDeleteTextures(1, &objectID);
+		break;
+	case GPU_BUFFER:
+		glDeleteBuffers(1, &objectID);
+		break;
+	case GPU_VERTEX_ARRAY:
+		glDeleteVertexArrays(1, &objectID);
+		break;
+	case GPU_FRAMEBUFFER:
+		glDeleteFramebuffers(1, &objectID);
+		break;
+	case GPU_RENDERBUFFER:
+		glDeleteRenderbuffers(1, &objectID);
+		break;
+	}
+}
+
+/***********************************************************
+ *  TexturePool()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TexturePool::TexturePool()
+{
+	m_pooledBytes = 0;
+	m_budgetBytes = g_DefaultPoolBudget;
+	m_reuseCount = 0;
+}
+
+/***********************************************************
+ *  ~TexturePool()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TexturePool::~TexturePool()
+{
+	Clear();
+}
+
+/***********************************************************
+ *  GetMipLevels()
+ *
+ *  This method is used for getting the number of levels of
+ *  a full mip chain down to one texel.
+ ***********************************************************/
+int TexturePool::GetMipLevels(int width, int height)
+{
+	int levels = 1;
+	int size = std::max(width, height);
+
+	while (size > 1)
+	{
+		size >>= 1;
+		levels++;
+	}
+
+	return(levels);
+}
+
+/***********************************************************
+ *  AllocateStorage()
+ *
+ *  This method is used for allocating every mip level of
+ *  the texture bound to GL_TEXTURE_2D.  The storage is
+ *  immutable when the driver has texture storage, and
+ *  otherwise each level is specified without any data.
+ ***********************************************************/
+void TexturePool::AllocateStorage(const TEXTURE_FORMAT& format)
+{
+	if ((GLEW_VERSION_4_2 == GL_TRUE) || (GLEW_ARB_texture_storage == GL_TRUE))
+	{
+		glTexStorage2D(GL_TEXTURE_2D, format.levels, format.internalFormat, format.width, format.height);
+		return;
+	}
+
+	bool bCompressed = ((format.internalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT) ||
+		(format.internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT));
+	GLenum pixelFormat = (format.internalFormat == GL_RGB8) ? GL_RGB : GL_RGBA;
+	for (int level = 0; level < format.levels; level++)
+	{
+		int levelWidth = std::max(format.width >> level, 1);
+		int levelHeight = std::max(format.height >> level, 1);
+
+		if (bCompressed == true)
+		{
+			glCompressedTexImage2D(GL_TEXTURE_2D, level, format.internalFormat, levelWidth, levelHeight, 0,
+				(GLsizei)GpuMemory::GetTextureBytes(format.internalFormat, levelWidth, levelHeight, 1), NULL);
+		}
+		else
+		{
+			glTexImage2D(GL_TEXTURE_2D, level, format.internalFormat, levelWidth, levelHeight, 0,
+				pixelFormat, GL_UNSIGNED_BYTE, NULL);
+		}
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, format.levels - 1);
+}
+
+/***********************************************************
+ *  Acquire()
+ *
+ *  This method is used for getting a texture with the passed
+ *  in storage.  The most recently kept texture of the same
+ *  storage is handed out again, and otherwise a new one is
+ *  created.  The texture is left bound to GL_TEXTURE_2D of
+ *  the active texture unit, ready for its image.
+ ***********************************************************/
+GpuTexture TexturePool::Acquire(const TEXTURE_FORMAT& format)
+{
+	GpuTexture texture;
+
+	for (size_t i = m_textures.size(); i > 0; i--)
+	{
+		const TEXTURE_FORMAT& pooled = m_textures[i - 1].format;
+		if ((pooled.internalFormat == format.internalFormat) &&
+			(pooled.width == format.width) &&
+			(pooled.height == format.height) &&
+			(pooled.levels == format.levels))
+		{
+			texture = std::move(m_textures[i - 1].texture);
+			m_textures.erase(m_textures.begin() + (i - 1));
+			m_pooledBytes -= texture.GetMemory();
+			m_reuseCount++;
+
+			glBindTexture(GL_TEXTURE_2D, texture);
+			texture.SetMemory(GpuMemory::TEXTURES, texture.GetMemory());
+			return(texture);
+		}
+	}
+
+	texture.Create();
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	// set the texture wrapping and filtering parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	AllocateStorage(format);
+	texture.SetMemory(GpuMemory::TEXTURES,
+		GpuMemory::GetTextureBytes(format.internalFormat, format.width, format.height, format.levels));
+
+	return(texture);
+}
+
+/***********************************************************
+ *  Recycle()
+ *
+ *  This method is used for taking back a texture that is no
+ *  longer shown.  Its storage is kept for the next texture
+ *  of the same format, and the handle is left empty.  A
+ *  bindless handle of the texture must no longer be
+ *  resident.
+ ***********************************************************/
+void TexturePool::Recycle(GpuTexture& texture, const TEXTURE_FORMAT& format)
+{
+	if (texture.IsValid() == false)
+	{
+		return;
+	}
+
+	POOLED_TEXTURE pooled;
+	pooled.texture = std::move(texture);
+	pooled.format = format;
+	pooled.texture.SetMemory(GpuMemory::POOLED_TEXTURES, pooled.texture.GetMemory());
+	m_pooledBytes += pooled.texture.GetMemory();
+	m_textures.push_back(std::move(pooled));
+
+	Trim();
+}
+
+/***********************************************************
+ *  SetBudget()
+ *
+ *  This method is used for setting the most bytes of the
+ *  textures kept for reuse.  0 frees every texture as soon
+ *  as it comes back.
+ ***********************************************************/
+void TexturePool::SetBudget(long long bytes)
+{
+	m_budgetBytes = std::max(bytes, 0LL);
+	Trim();
+}
+
+/***********************************************************
+ *  Trim()
+ *
+ *  This method is used for freeing the textures kept the
+ *  longest until the pool is within its budget.
+ ***********************************************************/
+void TexturePool::Trim()
+{
+	size_t freed = 0;
+
+	while ((freed < m_textures.size()) && (m_pooledBytes > m_budgetBytes))
+	{
+		m_pooledBytes -= m_textures[freed].texture.GetMemory();
+		m_textures[freed].texture.Destroy();
+		freed++;
+	}
+	if (freed > 0)
+	{
+		m_textures.erase(m_textures.begin(), m_textures.begin() + freed);
+	}
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for freeing every texture kept for
+ *  reuse.
+ ***********************************************************/
+void TexturePool::Clear()
+{
+	m_textures.clear();
+	m_pooledBytes = 0;
+}
@@ -0,0 +1,255 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuresources.h
+// ============
+// owned OpenGL objects, video memory accounting and a pool of scene textures
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <utility>
+#include <vector>
+
+/***********************************************************
+ *  GpuMemory
+ *
+ *  This class keeps count of the video memory held by the
+ *  OpenGL objects, split into categories.  The handles below
+ *  add the size of their storage when it is set and take it
+ *  away again when they are freed, so the numbers always
+ *  match the objects that are alive.  The sizes are the ones
+ *  asked for - the driver may round them up or keep copies.
+ ***********************************************************/
+class GpuMemory
+{
+public:
+	// kinds of memory that are counted on their own
+	enum CATEGORY
+	{
+		// scene textures, cube maps and placeholders
+		TEXTURES = 0,
+		// vertex, index and instance buffers
+		GEOMETRY,
+		// uniform, storage and indirect command buffers
+		BUFFERS,
+		// framebuffer attachments and shadow maps
+		RENDER_TARGETS,
+		// textures kept by the texture pool for reuse
+		POOLED_TEXTURES,
+		CATEGORY_COUNT
+	};
+
+	// count storage of an object in a category, or stop counting it
+	static void Add(CATEGORY category, long long bytes);
+	static void Remove(CATEGORY category, long long bytes);
+
+	// bytes and number of objects in a category right now
+	static long long GetBytes(CATEGORY category);
+	static int GetObjectCount(CATEGORY category);
+	// most bytes the category held at one time
+	static long long GetPeakBytes(CATEGORY category);
+	// bytes of all the categories
+	static long long GetTotalBytes();
+	// name of a category for the reports
+	static const char* GetCategoryName(CATEGORY category);
+	// print the bytes of every category
+	static void Print();
+
+	// bytes of a texture with the passed in format and mip levels
+	static long long GetTextureBytes(GLenum internalFormat, int width, int height, int levels);
+};
+
+// kinds of OpenGL objects with a handle type
+enum GPU_OBJECT_KIND
+{
+	GPU_TEXTURE = 0,
+	GPU_BUFFER,
+	GPU_VERTEX_ARRAY,
+	GPU_FRAMEBUFFER,
+	GPU_RENDERBUFFER
+};
+
+// create and delete one OpenGL object of a kind
+GLuint GenerateGpuObject(GPU_OBJECT_KIND kind);
+void DeleteGpuObject(GPU_OBJECT_KIND kind, GLuint objectID);
+
+/***********************************************************
+ *  GpuHandle
+ *
+ *  This class owns one OpenGL object and deletes it when it
+ *  goes out of scope, is destroyed or gets a new object.  A
+ *  handle can be moved but not copied, so every object has
+ *  exactly one owner.  The handle turns into the object ID
+ *  wherever OpenGL expects one.  Creating an object does not
+ *  need a context until Create() is called, so classes can
+ *  hold handles that stay empty in the modes without one.
+ ***********************************************************/
+template <GPU_OBJECT_KIND KIND>
+class GpuHandle
+{
+public:
+	// constructor - the handle starts out empty
+	GpuHandle()
+	{
+		m_objectID = 0;
+		m_category = GpuMemory::CATEGORY_COUNT;
+		m_bytes = 0;
+	}
+	// destructor - deletes the object
+	~GpuHandle()
+	{
+		Destroy();
+	}
+	// take over the object of another handle
+	GpuHandle(GpuHandle&& other) noexcept
+	{
+		m_objectID = other.m_objectID;
+		m_category = other.m_category;
+		m_bytes = other.m_bytes;
+		other.m_objectID = 0;
+		other.m_bytes = 0;
+	}
+	GpuHandle& operator=(GpuHandle&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Destroy();
+			m_objectID = other.m_objectID;
+			m_category = other.m_category;
+			m_bytes = other.m_bytes;
+			other.m_objectID = 0;
+			other.m_bytes = 0;
+		}
+		return(*this);
+	}
+	GpuHandle(const GpuHandle&) = delete;
+	GpuHandle& operator=(const GpuHandle&) = delete;
+
+	// delete the current object and create a new one
+	GLuint Create()
+	{
+		Destroy();
+		m_objectID = GenerateGpuObject(KIND);
+		return(m_objectID);
+	}
+	// delete the object and stop counting its storage
+	void Destroy()
+	{
+		if (m_objectID != 0)
+		{
+			SetMemory(m_category, 0);
+			DeleteGpuObject(KIND, m_objectID);
+			m_objectID = 0;
+		}
+	}
+
+	// count the storage of the object - replaces the last size
+	void SetMemory(GpuMemory::CATEGORY category, long long bytes)
+	{
+		if (m_bytes > 0)
+		{
+			GpuMemory::Remove(m_category, m_bytes);
+		}
+		m_category = category;
+		m_bytes = (m_objectID != 0) ? bytes : 0;
+		if (m_bytes > 0)
+		{
+			GpuMemory::Add(m_category, m_bytes);
+		}
+	}
+	// counted storage of the object
+	long long GetMemory() const { return m_bytes; }
+
+	GLuint Get() const { return m_objectID; }
+	operator GLuint() const { return m_objectID; }
+	bool IsValid() const { return (m_objectID != 0); }
+
+private:
+	GLuint m_objectID;
+	GpuMemory::CATEGORY m_category;
+	long long m_bytes;
+};
+
+// handles of the kinds of objects
+typedef GpuHandle<GPU_TEXTURE> GpuTexture;
+typedef GpuHandle<GPU_BUFFER> GpuBuffer;
+typedef GpuHandle<GPU_VERTEX_ARRAY> GpuVertexArray;
+typedef GpuHandle<GPU_FRAMEBUFFER> GpuFramebuffer;
+typedef GpuHandle<GPU_RENDERBUFFER> GpuRenderbuffer;
+
+/***********************************************************
+ *  TexturePool
+ *
+ *  This class hands out 2D textures with their storage
+ *  already allocated, and takes back the ones that are no
+ *  longer shown.  A texture that comes back is kept with
+ *  its storage, and the next request with the same format,
+ *  size and mip levels gets it instead of a new one, so
+ *  loading and unloading scenes over and over reuses the
+ *  same memory rather than making the driver allocate it
+ *  again.  The kept textures are limited by a byte budget,
+ *  and the ones kept the longest are freed first.
+ *
+ *  With GL_ARB_texture_storage the storage is immutable, so
+ *  the textures can have bindless handles, and the images
+ *  are always uploaded with glTexSubImage2D() or
+ *  glCompressedTexSubImage2D().
+ ***********************************************************/
+class TexturePool
+{
+public:
+	// storage of a texture in the pool
+	struct TEXTURE_FORMAT
+	{
+		GLenum internalFormat;
+		int width;
+		int height;
+		int levels;
+	};
+
+	// constructor
+	TexturePool();
+	// destructor
+	~TexturePool();
+
+	// get a texture with the passed in storage, reused when the
+	// pool has one - the texture repeats and filters linearly
+	GpuTexture Acquire(const TEXTURE_FORMAT& format);
+	// give a texture back to the pool for reuse
+	void Recycle(GpuTexture& texture, const TEXTURE_FORMAT& format);
+
+	// most bytes of textures kept for reuse
+	void SetBudget(long long bytes);
+	// free every texture kept for reuse
+	void Clear();
+
+	// bytes and number of textures kept for reuse
+	long long GetPooledBytes() const { return m_pooledBytes; }
+	int GetPooledCount() const { return (int)m_textures.size(); }
+	// textures handed out again rather than created
+	int GetReuseCount() const { return m_reuseCount; }
+
+	// number of mip levels of a full chain for a size
+	static int GetMipLevels(int width, int height);
+
+private:
+	// properties for a texture kept for reuse
+	struct POOLED_TEXTURE
+	{
+		GpuTexture texture;
+		TEXTURE_FORMAT format;
+	};
+
+	// allocate the storage of a new texture
+	static void AllocateStorage(const TEXTURE_FORMAT& format);
+	// free the oldest textures until the pool is under its budget
+	void Trim();
+
+	// oldest first
+	std::vector<POOLED_TEXTURE> m_textures;
+	long long m_pooledBytes;
+	long long m_budgetBytes;
+	int m_reuseCount;
+};
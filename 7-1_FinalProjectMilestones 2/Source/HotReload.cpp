@@ -0,0 +1,370 @@
+///////////////////////////////////////////////////////////////////////////////
+// hotreload.cpp
+// ============
+// watch the files of the scene and reload the ones that change while it runs
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "HotReload.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// seconds between two checks of the modification times
+	const double g_PollInterval = 0.5;
+	// longest uniform name that is copied into a reloaded program
+	const int g_MaxUniformName = 128;
+}
+
+/***********************************************************
+ *  HotReload()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+HotReload::HotReload(UniformBuffers* pUniformBuffers)
+{
+	m_pUniformBuffers = pUniformBuffers;
+	m_lastPollTime = 0.0;
+}
+
+/***********************************************************
+ *  ~HotReload()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+HotReload::~HotReload()
+{
+	m_reloads.clear();
+	m_files.clear();
+}
+
+/***********************************************************
+ *  AddWatch()
+ *
+ *  This method is used for registering the function that
+ *  reloads a resource.  The files of the resource are added
+ *  to the returned watch with AddFile().
+ ***********************************************************/
+int HotReload::AddWatch(RELOAD_FUNCTION reload)
+{
+	m_reloads.push_back(reload);
+	return((int)m_reloads.size() - 1);
+}
+
+/***********************************************************
+ *  AddFile()
+ *
+ *  This method is used for watching a file that a resource
+ *  was loaded from, starting from its current time.
+ ***********************************************************/
+void HotReload::AddFile(int watchIndex, const std::string& filename)
+{
+	if ((watchIndex < 0) || (watchIndex >= (int)m_reloads.size()))
+	{
+		return;
+	}
+
+	WATCHED_FILE file;
+	file.filename = filename;
+	file.watchIndex = watchIndex;
+	file.modifiedTime = GetModifiedTime(filename);
+	file.bChanged = false;
+	m_files.push_back(file);
+}
+
+/***********************************************************
+ *  Poll()
+ *
+ *  This method is used for checking the watched files once
+ *  every interval.  A file whose time changed is reported on
+ *  the next check that finds the same time again, and the
+ *  reload function of every watch with a reported file is
+ *  called once.
+ ***********************************************************/
+bool HotReload::Poll(double time)
+{
+	if (time - m_lastPollTime < g_PollInterval)
+	{
+		return(false);
+	}
+	m_lastPollTime = time;
+
+	std::vector<bool> reloadWatch(m_reloads.size(), false);
+	bool bReload = false;
+
+	for (size_t i = 0; i < m_files.size(); i++)
+	{
+		WATCHED_FILE& file = m_files[i];
+		time_t modifiedTime = GetModifiedTime(file.filename);
+
+		// a file that is being replaced can be missing for a moment
+		if (modifiedTime == 0)
+		{
+			continue;
+		}
+		if (modifiedTime != file.modifiedTime)
+		{
+			file.modifiedTime = modifiedTime;
+			file.bChanged = true;
+		}
+		else if (file.bChanged == true)
+		{
+			file.bChanged = false;
+			reloadWatch[file.watchIndex] = true;
+			bReload = true;
+		}
+	}
+
+	// a reload function can add watches, so only the ones that
+	// were checked are called
+	for (size_t i = 0; i < reloadWatch.size(); i++)
+	{
+		if (reloadWatch[i] == true)
+		{
+			m_reloads[i]();
+		}
+	}
+
+	return(bReload);
+}
+
+/***********************************************************
+ *  GetModifiedTime()
+ *
+ *  This method is used for getting the time a file was last
+ *  written.
+ ***********************************************************/
+time_t HotReload::GetModifiedTime(const std::string& filename)
+{
+	struct stat fileStatus;
+
+	if (stat(filename.c_str(), &fileStatus) != 0)
+	{
+		return(0);
+	}
+
+	return(fileStatus.st_mtime);
+}
+
+/***********************************************************
+ *  IsProgramLinked()
+ *
+ *  This method is used for checking whether the shaders of
+ *  a program compiled and linked without errors.
+ ***********************************************************/
+bool HotReload::IsProgramLinked(GLuint programID)
+{
+	GLint linkStatus = GL_FALSE;
+
+	if (programID == 0)
+	{
+		return(false);
+	}
+
+	glGetProgramiv(programID, GL_LINK_STATUS, &linkStatus);
+	return(linkStatus == GL_TRUE);
+}
+
+/***********************************************************
+ *  ReloadProgram()
+ *
+ *  This method is used for compiling the changed shaders of
+ *  a running program.  The shaders are first linked into a
+ *  scratch program, and only when that works is the program
+ *  of the shader manager replaced.  The new program takes
+ *  over the uniform values of the old one and is connected
+ *  to the shared blocks, so the owner only has to look up
+ *  its uniform locations again.
+ ***********************************************************/
+GLuint HotReload::ReloadProgram(
+	ShaderManager* pShaderManager,
+	const char* vertexShaderPath,
+	const char* fragmentShaderPath)
+{
+	GLint boundProgramID = 0;
+	GLint oldProgramID = 0;
+	GLint newProgramID = 0;
+
+	if (NULL == pShaderManager)
+	{
+		return(0);
+	}
+
+	glGetIntegerv(GL_CURRENT_PROGRAM, &boundProgramID);
+	pShaderManager->use();
+	glGetIntegerv(GL_CURRENT_PROGRAM, &oldProgramID);
+
+	// a shader with errors must not replace the running program -
+	// a program that did not link cannot be made current, so the
+	// current program is cleared first and stays 0 in that case
+	ShaderManager* pScratchManager = new ShaderManager();
+	pScratchManager->LoadShaders(vertexShaderPath, fragmentShaderPath);
+	glUseProgram(0);
+	pScratchManager->use();
+	glGetIntegerv(GL_CURRENT_PROGRAM, &newProgramID);
+	bool bLinked = ((newProgramID != 0) &&
+		(newProgramID != oldProgramID) &&
+		(IsProgramLinked((GLuint)newProgramID) == true));
+	glUseProgram(0);
+	if ((newProgramID != 0) && (newProgramID != oldProgramID))
+	{
+		glDeleteProgram((GLuint)newProgramID);
+	}
+	delete pScratchManager;
+
+	if (bLinked == false)
+	{
+		std::cout << "Shaders " << vertexShaderPath << " and " << fragmentShaderPath << " have errors, the running program is kept" << std::endl;
+		glUseProgram((GLuint)boundProgramID);
+		return(0);
+	}
+
+	pShaderManager->LoadShaders(vertexShaderPath, fragmentShaderPath);
+	glUseProgram(0);
+	pShaderManager->use();
+	glGetIntegerv(GL_CURRENT_PROGRAM, &newProgramID);
+	if ((newProgramID == 0) || (newProgramID == oldProgramID))
+	{
+		std::cout << "Shaders " << vertexShaderPath << " and " << fragmentShaderPath << " linked but could not be loaded again" << std::endl;
+		glUseProgram((GLuint)boundProgramID);
+		return(0);
+	}
+
+	CopyUniforms((GLuint)oldProgramID, (GLuint)newProgramID);
+	if (NULL != m_pUniformBuffers)
+	{
+		m_pUniformBuffers->BindProgram((GLuint)newProgramID);
+	}
+	if ((oldProgramID != 0) && (oldProgramID != newProgramID))
+	{
+		glDeleteProgram((GLuint)oldProgramID);
+	}
+
+	// whatever was bound before stays bound, now as the new program
+	glUseProgram((boundProgramID == oldProgramID) ? (GLuint)newProgramID : (GLuint)boundProgramID);
+
+	std::cout << "Reloaded shaders " << vertexShaderPath << " and " << fragmentShaderPath << std::endl;
+
+	return((GLuint)newProgramID);
+}
+
+/***********************************************************
+ *  CopyUniforms()
+ *
+ *  This method is used for copying the values of the plain
+ *  uniforms of one program into the uniforms of the same
+ *  name and type in another.  Values that are only set once,
+ *  such as the texture units of the samplers, are kept this
+ *  way.  Uniforms of blocks are shared and are left alone.
+ ***********************************************************/
+void HotReload::CopyUniforms(GLuint sourceID, GLuint destinationID)
+{
+	GLint uniformCount = 0;
+
+	if ((sourceID == 0) || (destinationID == 0) || (glIsProgram(sourceID) == GL_FALSE))
+	{
+		return;
+	}
+
+	glUseProgram(destinationID);
+	glGetProgramiv(sourceID, GL_ACTIVE_UNIFORMS, &uniformCount);
+
+	for (GLint i = 0; i < uniformCount; i++)
+	{
+		char name[g_MaxUniformName];
+		GLsizei nameLength = 0;
+		GLint arraySize = 0;
+		GLenum type = 0;
+		GLuint uniformIndex = (GLuint)i;
+		GLint blockIndex = -1;
+
+		glGetActiveUniform(sourceID, uniformIndex, sizeof(name), &nameLength, &arraySize, &type, name);
+		glGetActiveUniformsiv(sourceID, 1, &uniformIndex, GL_UNIFORM_BLOCK_INDEX, &blockIndex);
+		if (blockIndex != -1)
+		{
+			continue;
+		}
+
+		// arrays are reported by their first element, while every
+		// element of an array of structs is reported by its full
+		// name, such as pointLights[0].position, and kept as it is
+		size_t length = strlen(name);
+		if ((length > 3) && (strcmp(name + length - 3, "[0]") == 0))
+		{
+			name[length - 3] = '\0';
+		}
+
+		for (GLint element = 0; element < arraySize; element++)
+		{
+			char elementName[g_MaxUniformName + 16];
+			if (arraySize > 1)
+			{
+				snprintf(elementName, sizeof(elementName), "%s[%d]", name, element);
+			}
+			else
+			{
+				snprintf(elementName, sizeof(elementName), "%s", name);
+			}
+
+			GLint sourceLocation = glGetUniformLocation(sourceID, elementName);
+			GLint destinationLocation = glGetUniformLocation(destinationID, elementName);
+			if ((sourceLocation < 0) || (destinationLocation < 0))
+			{
+				continue;
+			}
+
+			GLfloat floats[16];
+			GLint ints[4];
+			GLuint uints[4];
+			switch (type)
+			{
+			case GL_FLOAT:
+				glGetUniformfv(sourceID, sourceLocation, floats);
+				glUniform1fv(destinationLocation, 1, floats);
+				break;
+			case GL_FLOAT_VEC2:
+				glGetUniformfv(sourceID, sourceLocation, floats);
+				glUniform2fv(destinationLocation, 1, floats);
+				break;
+			case GL_FLOAT_VEC3:
+				glGetUniformfv(sourceID, sourceLocation, floats);
+				glUniform3fv(destinationLocation, 1, floats);
+				break;
+			case GL_FLOAT_VEC4:
+				glGetUniformfv(sourceID, sourceLocation, floats);
+				glUniform4fv(destinationLocation, 1, floats);
+				break;
+			case GL_FLOAT_MAT3:
+				glGetUniformfv(sourceID, sourceLocation, floats);
+				glUniformMatrix3fv(destinationLocation, 1, GL_FALSE, floats);
+				break;
+			case GL_FLOAT_MAT4:
+				glGetUniformfv(sourceID, sourceLocation, floats);
+				glUniformMatrix4fv(destinationLocation, 1, GL_FALSE, floats);
+				break;
+			case GL_UNSIGNED_INT:
+				glGetUniformuiv(sourceID, sourceLocation, uints);
+				glUniform1uiv(destinationLocation, 1, uints);
+				break;
+			case GL_INT:
+			case GL_BOOL:
+			case GL_SAMPLER_2D:
+			case GL_SAMPLER_2D_ARRAY:
+			case GL_SAMPLER_2D_ARRAY_SHADOW:
+			case GL_SAMPLER_CUBE:
+				glGetUniformiv(sourceID, sourceLocation, ints);
+				glUniform1iv(destinationLocation, 1, ints);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+}
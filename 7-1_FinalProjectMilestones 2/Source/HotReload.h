@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////////////
+// hotreload.h
+// ============
+// watch the files of the scene and reload the ones that change while it runs
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "UniformBuffers.h"
+
+#include <GL/glew.h>
+
+#include <ctime>
+#include <functional>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  HotReload
+ *
+ *  This class watches the modification times of the files
+ *  that resources were loaded from.  A resource registers a
+ *  reload function together with its files, and when any of
+ *  them changes the function is called once, so only the
+ *  resources whose files changed are loaded again.  A file
+ *  is only reported once its time has stopped changing for
+ *  one poll, so a file that is still being written is not
+ *  read half way.
+ *
+ *  Shader programs are compiled into a scratch program
+ *  first, and a shader with errors leaves the running
+ *  program in place.
+ ***********************************************************/
+class HotReload
+{
+public:
+	// called when one of the files of a watch changed
+	typedef std::function<void()> RELOAD_FUNCTION;
+
+	// constructor
+	HotReload(UniformBuffers* pUniformBuffers);
+	// destructor
+	~HotReload();
+
+	// register a reload function and get the watch it belongs to
+	int AddWatch(RELOAD_FUNCTION reload);
+	// watch one more file for a watch
+	void AddFile(int watchIndex, const std::string& filename);
+	// check the files every interval and call the reload functions
+	// of the ones that changed - true when anything was reloaded
+	bool Poll(double time);
+
+	// compile the shaders into the program of a shader manager,
+	// keeping the uniform values and block bindings - the new
+	// program ID is returned, or 0 when the running one is kept
+	GLuint ReloadProgram(
+		ShaderManager* pShaderManager,
+		const char* vertexShaderPath,
+		const char* fragmentShaderPath);
+
+private:
+	// properties of a watched file
+	struct WATCHED_FILE
+	{
+		std::string filename;
+		int watchIndex;
+		time_t modifiedTime;
+		// true while the new time waits to settle
+		bool bChanged;
+	};
+
+	// get the modification time of a file - 0 when it is missing
+	static time_t GetModifiedTime(const std::string& filename);
+	// check whether a program compiled and linked
+	static bool IsProgramLinked(GLuint programID);
+	// copy the values of the uniforms two programs share
+	static void CopyUniforms(GLuint sourceID, GLuint destinationID);
+
+	// pointer to the shared uniform buffers - blocks of reloaded programs
+	UniformBuffers* m_pUniformBuffers;
+	std::vector<RELOAD_FUNCTION> m_reloads;
+	std::vector<WATCHED_FILE> m_files;
+	double m_lastPollTime;
+};
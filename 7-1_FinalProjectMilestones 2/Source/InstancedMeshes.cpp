@@ -0,0 +1,848 @@
+///////////////////////////////////////////////////////////////////////////////
+// instancedmeshes.cpp
+// ============
+// instanced drawing of the basic 3D shapes from a per-instance buffer
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "InstancedMeshes.h"
+#include "TextureResidency.h"
+#include "ShadowMaps.h"
+#include "FrameProfiler.h"
+
+#include <cstddef>
+#include <fstream>
+
+// declaration of the global variables and defines
+namespace
+{
+	const char* g_VertexShaderPath = "shaders/instancedVertexShader.glsl";
+	const char* g_FragmentShaderPath = "shaders/instancedFragmentShader.glsl";
+	// the depth pre-pass shares the empty fragment shader of the shadows
+	const char* g_DepthVertexShaderPath = "shaders/depthVertexShader.glsl";
+	const char* g_DepthFragmentShaderPath = "shaders/shadowFragmentShader.glsl";
+
+	// per-instance attribute locations, after the ones of the arena
+	// vertex layout - must match the instance shader.  The model
+	// matrix takes four locations, one per column
+	const GLuint MODEL_ATTRIBUTE = GeometryArena::FIRST_FREE_ATTRIBUTE;
+	const GLuint COLOR_ATTRIBUTE = 7;
+	const GLuint UVSCALE_ATTRIBUTE = 8;
+	const GLuint INDICES_ATTRIBUTE = 9;
+
+	// instances per stream region before the stream first grows
+	const size_t g_InitialStreamInstances = 4096;
+	// draw commands per indirect region before the stream first grows
+	const size_t g_InitialIndirectCommands = 256;
+
+	// segments around the round shapes at every level of detail
+	const int g_LodSegments[InstancedMeshes::LOD_COUNT] = { 36, 16, 8 };
+
+	// check that a shader file exists before handing it to OpenGL
+	bool FileExists(const char* filename)
+	{
+		std::ifstream file(filename);
+		return(file.good());
+	}
+}
+
+/***********************************************************
+ *  InstancedMeshes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+InstancedMeshes::InstancedMeshes()
+{
+	m_pShaderManager = NULL;
+	m_pShaderUniforms = NULL;
+	m_pDepthShaderManager = NULL;
+	m_instanceBuffer = 0;
+	m_pInstanceStream = NULL;
+	m_attachedBuffer = 0;
+	m_instanceCapacity = 0;
+	m_baseInstance = 0;
+	m_pGeometryArena = NULL;
+	m_pIndirectStream = NULL;
+	m_indirectCapacity = 0;
+	m_pIndirectCommands = NULL;
+	m_indirectCount = 0;
+
+	for (int i = 0; i < SHAPE_COUNT; i++)
+	{
+		for (int level = 0; level < LOD_COUNT; level++)
+		{
+			m_meshes[i][level].firstIndex = 0;
+			m_meshes[i][level].nIndices = 0;
+			m_meshes[i][level].baseVertex = 0;
+		}
+	}
+}
+
+/***********************************************************
+ *  ~InstancedMeshes()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+InstancedMeshes::~InstancedMeshes()
+{
+	DestroyMeshes();
+
+	if (NULL != m_pShaderUniforms)
+	{
+		delete m_pShaderUniforms;
+		m_pShaderUniforms = NULL;
+	}
+	if (NULL != m_pShaderManager)
+	{
+		delete m_pShaderManager;
+		m_pShaderManager = NULL;
+	}
+	if (NULL != m_pDepthShaderManager)
+	{
+		delete m_pDepthShaderManager;
+		m_pDepthShaderManager = NULL;
+	}
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for loading the instance shaders,
+ *  connecting them to the shared uniform blocks and creating
+ *  the meshes of all the shapes.  False is returned when the
+ *  instanced draws are not available, in which case the
+ *  caller keeps drawing one object at a time.
+ ***********************************************************/
+bool InstancedMeshes::Initialize(UniformBuffers* pUniformBuffers)
+{
+	ShapeGeometry::MESH_DATA meshData[SHAPE_COUNT][LOD_COUNT];
+
+	// drawing from an offset into the instance buffer needs OpenGL 4.2
+	if ((NULL == pUniformBuffers) || (!GLEW_VERSION_4_2))
+	{
+		return(false);
+	}
+
+	if ((FileExists(g_VertexShaderPath) == false) ||
+		(FileExists(g_FragmentShaderPath) == false))
+	{
+		std::cout << "Instance shaders not found, instanced drawing is disabled" << std::endl;
+		return(false);
+	}
+
+	m_pShaderManager = new ShaderManager();
+	m_pShaderManager->LoadShaders(g_VertexShaderPath, g_FragmentShaderPath);
+
+	m_pShaderUniforms = new ShaderUniforms(m_pShaderManager);
+	if (m_pShaderUniforms->ResolveLocations() == false)
+	{
+		return(false);
+	}
+	pUniformBuffers->BindProgram(m_pShaderUniforms->GetProgramID());
+
+	// without bindless handles the sampler reads the shared texture unit
+	m_pShaderUniforms->SetInt(ShaderUniforms::OBJECT_TEXTURE, TextureResidency::TEXTURE_UNIT);
+	// the shadow maps have a texture unit of their own
+	m_pShaderUniforms->SetInt(ShaderUniforms::SHADOW_MAP, ShadowMaps::TEXTURE_UNIT);
+
+	// the depth pre-pass is left out when its shaders are missing
+	if ((FileExists(g_DepthVertexShaderPath) == true) &&
+		(FileExists(g_DepthFragmentShaderPath) == true))
+	{
+		GLint depthProgramID = 0;
+
+		m_pDepthShaderManager = new ShaderManager();
+		m_pDepthShaderManager->LoadShaders(g_DepthVertexShaderPath, g_DepthFragmentShaderPath);
+		m_pDepthShaderManager->use();
+		glGetIntegerv(GL_CURRENT_PROGRAM, &depthProgramID);
+		if (depthProgramID != 0)
+		{
+			pUniformBuffers->BindProgram((GLuint)depthProgramID);
+		}
+		else
+		{
+			delete m_pDepthShaderManager;
+			m_pDepthShaderManager = NULL;
+		}
+		m_pShaderManager->use();
+	}
+
+	// write the instances straight into a mapped ring when possible
+	if (StreamBuffer::IsSupported() == true)
+	{
+		m_pInstanceStream = new StreamBuffer();
+		if (m_pInstanceStream->Create(g_InitialStreamInstances * sizeof(INSTANCE_DATA)) == true)
+		{
+			m_instanceBuffer = m_pInstanceStream->GetBuffer();
+			m_instanceCapacity = g_InitialStreamInstances;
+		}
+		else
+		{
+			delete m_pInstanceStream;
+			m_pInstanceStream = NULL;
+		}
+	}
+	if (NULL == m_pInstanceStream)
+	{
+		m_instanceBuffer = m_plainInstanceBuffer.Create();
+	}
+
+	// the draw commands are written into a mapped ring as well
+	if ((NULL != m_pInstanceStream) &&
+		((GLEW_VERSION_4_3 == GL_TRUE) || (GLEW_ARB_multi_draw_indirect == GL_TRUE)))
+	{
+		m_pIndirectStream = new StreamBuffer();
+		if (m_pIndirectStream->Create(g_InitialIndirectCommands * sizeof(DRAW_COMMAND)) == true)
+		{
+			m_indirectCapacity = g_InitialIndirectCommands;
+		}
+		else
+		{
+			delete m_pIndirectStream;
+			m_pIndirectStream = NULL;
+		}
+	}
+
+	// the flat shapes look the same at any size
+	ShapeGeometry::BuildPlane(meshData[SHAPE_PLANE][0]);
+	ShapeGeometry::BuildBox(meshData[SHAPE_BOX][0]);
+	ShapeGeometry::BuildPyramid3(meshData[SHAPE_PYRAMID3][0]);
+	for (int level = 0; level < LOD_COUNT; level++)
+	{
+		ShapeGeometry::BuildCone(meshData[SHAPE_CONE][level], g_LodSegments[level]);
+		ShapeGeometry::BuildCylinder(meshData[SHAPE_CYLINDER][level], g_LodSegments[level]);
+		ShapeGeometry::BuildSphere(meshData[SHAPE_SPHERE][level], g_LodSegments[level]);
+		ShapeGeometry::BuildTaperedCylinder(meshData[SHAPE_TAPERED_CYLINDER][level], g_LodSegments[level]);
+	}
+	CreateMeshes(meshData);
+
+	return(true);
+}
+
+/***********************************************************
+ *  WatchFiles()
+ *
+ *  This method is used for reloading the instance shaders
+ *  and the depth shaders whenever one of their files is
+ *  written, while the scene keeps drawing with them.
+ ***********************************************************/
+void InstancedMeshes::WatchFiles(HotReload* pHotReload)
+{
+	if ((NULL == pHotReload) || (NULL == m_pShaderManager))
+	{
+		return;
+	}
+
+	int watchIndex = pHotReload->AddWatch([this, pHotReload]() { ReloadShaders(pHotReload); });
+	pHotReload->AddFile(watchIndex, g_VertexShaderPath);
+	pHotReload->AddFile(watchIndex, g_FragmentShaderPath);
+	if (NULL != m_pDepthShaderManager)
+	{
+		pHotReload->AddFile(watchIndex, g_DepthVertexShaderPath);
+		pHotReload->AddFile(watchIndex, g_DepthFragmentShaderPath);
+	}
+}
+
+/***********************************************************
+ *  ReloadShaders()
+ *
+ *  This method is used for compiling the changed instance
+ *  shaders.  The uniform values carry over into the new
+ *  programs, so only the locations are looked up again.
+ ***********************************************************/
+void InstancedMeshes::ReloadShaders(HotReload* pHotReload)
+{
+	if (pHotReload->ReloadProgram(m_pShaderManager, g_VertexShaderPath, g_FragmentShaderPath) != 0)
+	{
+		m_pShaderUniforms->ResolveLocations();
+	}
+	if (NULL != m_pDepthShaderManager)
+	{
+		pHotReload->ReloadProgram(m_pDepthShaderManager, g_DepthVertexShaderPath, g_DepthFragmentShaderPath);
+	}
+}
+
+/***********************************************************
+ *  CreateMeshes()
+ *
+ *  This method is used for packing the vertex and index data
+ *  of all the shapes into the geometry arena, one after the
+ *  other.  Each shape level keeps the range the arena gave
+ *  it.  A level without data shares level 0.
+ ***********************************************************/
+void InstancedMeshes::CreateMeshes(const ShapeGeometry::MESH_DATA meshData[SHAPE_COUNT][LOD_COUNT])
+{
+	size_t vertexCount = 0;
+	size_t indexCount = 0;
+
+	// size the arena for all the shapes, so it is filled without growing
+	for (int i = 0; i < SHAPE_COUNT; i++)
+	{
+		for (int level = 0; level < LOD_COUNT; level++)
+		{
+			vertexCount += meshData[i][level].vertices.size();
+			indexCount += meshData[i][level].indices.size();
+		}
+	}
+
+	m_pGeometryArena = new GeometryArena();
+	m_pGeometryArena->Create(vertexCount, indexCount);
+
+	for (int i = 0; i < SHAPE_COUNT; i++)
+	{
+		for (int level = 0; level < LOD_COUNT; level++)
+		{
+			const ShapeGeometry::MESH_DATA& data = meshData[i][level];
+
+			if ((level > 0) && (data.indices.empty() == true))
+			{
+				m_meshes[i][level] = m_meshes[i][0];
+			}
+			else
+			{
+				m_pGeometryArena->AddMesh(data, m_meshes[i][level]);
+			}
+		}
+	}
+
+	AttachInstanceBuffer(m_instanceBuffer);
+}
+
+/***********************************************************
+ *  AttachInstanceBuffer()
+ *
+ *  This method is used for pointing the per-instance
+ *  attributes of the shared vertex array at the passed in
+ *  buffer, with one step per instance.
+ ***********************************************************/
+void InstancedMeshes::AttachInstanceBuffer(GLuint buffer)
+{
+	GLsizei instanceStride = sizeof(INSTANCE_DATA);
+
+	glBindVertexArray(m_pGeometryArena->GetVertexArray());
+
+	// per-instance attributes
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	for (GLuint column = 0; column < 4; column++)
+	{
+		glEnableVertexAttribArray(MODEL_ATTRIBUTE + column);
+		glVertexAttribPointer(MODEL_ATTRIBUTE + column, 4, GL_FLOAT, GL_FALSE, instanceStride,
+			(void*)(offsetof(INSTANCE_DATA, model) + (column * sizeof(glm::vec4))));
+		glVertexAttribDivisor(MODEL_ATTRIBUTE + column, 1);
+	}
+	glEnableVertexAttribArray(COLOR_ATTRIBUTE);
+	glVertexAttribPointer(COLOR_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE, instanceStride,
+		(void*)offsetof(INSTANCE_DATA, color));
+	glVertexAttribDivisor(COLOR_ATTRIBUTE, 1);
+	glEnableVertexAttribArray(UVSCALE_ATTRIBUTE);
+	glVertexAttribPointer(UVSCALE_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, instanceStride,
+		(void*)offsetof(INSTANCE_DATA, uvScale));
+	glVertexAttribDivisor(UVSCALE_ATTRIBUTE, 1);
+	// texture index and material index as integers
+	glEnableVertexAttribArray(INDICES_ATTRIBUTE);
+	glVertexAttribIPointer(INDICES_ATTRIBUTE, 2, GL_INT, instanceStride,
+		(void*)offsetof(INSTANCE_DATA, textureIndex));
+	glVertexAttribDivisor(INDICES_ATTRIBUTE, 1);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	m_attachedBuffer = buffer;
+}
+
+/***********************************************************
+ *  DestroyMeshes()
+ *
+ *  This method is used for freeing the geometry arena of the
+ *  shapes, the instance buffer and the indirect buffer.
+ ***********************************************************/
+void InstancedMeshes::DestroyMeshes()
+{
+	if (NULL != m_pGeometryArena)
+	{
+		delete m_pGeometryArena;
+		m_pGeometryArena = NULL;
+	}
+
+	if (NULL != m_pIndirectStream)
+	{
+		delete m_pIndirectStream;
+		m_pIndirectStream = NULL;
+	}
+	m_pIndirectCommands = NULL;
+	m_indirectCapacity = 0;
+	m_indirectCount = 0;
+
+	// the stream owns its buffer
+	if (NULL != m_pInstanceStream)
+	{
+		delete m_pInstanceStream;
+		m_pInstanceStream = NULL;
+	}
+	else
+	{
+		m_plainInstanceBuffer.Destroy();
+	}
+	m_instanceBuffer = 0;
+	m_instanceCapacity = 0;
+}
+
+/***********************************************************
+ *  GrowInstanceStream()
+ *
+ *  This method is used for replacing the instance stream
+ *  with a larger one once a frame has more instances than a
+ *  region holds.  The capacity at least doubles, so this
+ *  only happens a few times, and the vertex array is
+ *  attached to the new buffer.
+ ***********************************************************/
+bool InstancedMeshes::GrowInstanceStream(size_t instanceCount)
+{
+	size_t capacity = m_instanceCapacity * 2;
+	if (capacity < instanceCount)
+	{
+		capacity = instanceCount;
+	}
+
+	m_instanceCapacity = 0;
+	m_instanceBuffer = 0;
+	if (m_pInstanceStream->Create(capacity * sizeof(INSTANCE_DATA)) == false)
+	{
+		return(false);
+	}
+	m_instanceBuffer = m_pInstanceStream->GetBuffer();
+	m_instanceCapacity = capacity;
+	AttachInstanceBuffer(m_instanceBuffer);
+
+	return(true);
+}
+
+/***********************************************************
+ *  MapInstances()
+ *
+ *  This method is used for getting memory for the instance
+ *  values of the frame.  With the stream this is the next
+ *  free region of the mapped ring, so the values are written
+ *  where the GPU reads them and nothing is copied.  NULL is
+ *  returned when no memory is available.
+ ***********************************************************/
+InstancedMeshes::INSTANCE_DATA* InstancedMeshes::MapInstances(size_t instanceCount)
+{
+	if (instanceCount == 0)
+	{
+		return(NULL);
+	}
+
+	if (NULL == m_pInstanceStream)
+	{
+		m_baseInstance = 0;
+		m_stagingInstances.resize(instanceCount);
+		return(m_stagingInstances.data());
+	}
+
+	if ((instanceCount > m_instanceCapacity) &&
+		(GrowInstanceStream(instanceCount) == false))
+	{
+		return(NULL);
+	}
+
+	INSTANCE_DATA* pInstances = (INSTANCE_DATA*)m_pInstanceStream->BeginRegion();
+	m_baseInstance = (int)(m_pInstanceStream->GetRegionOffset() / sizeof(INSTANCE_DATA));
+
+	return(pInstances);
+}
+
+/***********************************************************
+ *  UnmapInstances()
+ *
+ *  This method is used for finishing the writes to the
+ *  mapped instances.  The stream is coherent and needs
+ *  nothing, the plain buffer gets the values copied in.  The
+ *  buffer only grows, and keeps its object ID, so the vertex
+ *  arrays stay attached to it.
+ ***********************************************************/
+void InstancedMeshes::UnmapInstances()
+{
+	if ((NULL != m_pInstanceStream) || (m_stagingInstances.empty() == true))
+	{
+		return;
+	}
+
+	size_t dataSize = m_stagingInstances.size() * sizeof(INSTANCE_DATA);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	if (m_stagingInstances.size() > m_instanceCapacity)
+	{
+		glBufferData(GL_ARRAY_BUFFER, dataSize, m_stagingInstances.data(), GL_DYNAMIC_DRAW);
+		m_plainInstanceBuffer.SetMemory(GpuMemory::GEOMETRY, dataSize);
+		m_instanceCapacity = m_stagingInstances.size();
+	}
+	else
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, 0, dataSize, m_stagingInstances.data());
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	m_stagingInstances.clear();
+}
+
+/***********************************************************
+ *  BeginInstancedDraws()
+ *
+ *  This method is used for switching to the instance shader
+ *  program and the shared vertex array.  The caller switches
+ *  back to its own program after the instanced draws.
+ ***********************************************************/
+void InstancedMeshes::BeginInstancedDraws()
+{
+	if (m_attachedBuffer != m_instanceBuffer)
+	{
+		AttachInstanceBuffer(m_instanceBuffer);
+	}
+
+	m_pShaderManager->use();
+	glBindVertexArray(m_pGeometryArena->GetVertexArray());
+}
+
+/***********************************************************
+ *  BeginCulledDraws()
+ *
+ *  This method is used for switching to the instance shader
+ *  program with the per-instance attributes read from the
+ *  passed in buffer.  The vertex array is only attached
+ *  again when the buffer changes.
+ ***********************************************************/
+void InstancedMeshes::BeginCulledDraws(GLuint instanceBuffer)
+{
+	if (m_attachedBuffer != instanceBuffer)
+	{
+		AttachInstanceBuffer(instanceBuffer);
+	}
+
+	m_pShaderManager->use();
+	glBindVertexArray(m_pGeometryArena->GetVertexArray());
+}
+
+/***********************************************************
+ *  BeginDepthDraws()
+ *
+ *  This method is used for switching to the shared vertex
+ *  array with the per-instance attributes read from the
+ *  passed in buffer, while keeping the current program.
+ *  Passes such as the shadow maps bind a program of their
+ *  own that reads the same attributes.
+ ***********************************************************/
+void InstancedMeshes::BeginDepthDraws(GLuint instanceBuffer)
+{
+	if (m_attachedBuffer != instanceBuffer)
+	{
+		AttachInstanceBuffer(instanceBuffer);
+	}
+
+	glBindVertexArray(m_pGeometryArena->GetVertexArray());
+}
+
+/***********************************************************
+ *  BeginDepthPrepass()
+ *
+ *  This method is used for switching the draws that follow
+ *  to the depth-only program.  The vertex array and the
+ *  instances stay as they are, so any of the draws can fill
+ *  the depth buffer first and then be issued again with the
+ *  instance shader after EndDepthPrepass().
+ ***********************************************************/
+void InstancedMeshes::BeginDepthPrepass()
+{
+	if (NULL != m_pDepthShaderManager)
+	{
+		m_pDepthShaderManager->use();
+	}
+}
+
+/***********************************************************
+ *  EndDepthPrepass()
+ *
+ *  This method is used for switching the draws that follow
+ *  back to the instance shader program.
+ ***********************************************************/
+void InstancedMeshes::EndDepthPrepass()
+{
+	m_pShaderManager->use();
+}
+
+/***********************************************************
+ *  EndInstancedDraws()
+ *
+ *  This method is used for fencing the stream regions that
+ *  the instanced draws of the frame read, after the last of
+ *  them.  The regions are not written again until the GPU
+ *  has passed the fences.
+ ***********************************************************/
+void InstancedMeshes::EndInstancedDraws()
+{
+	glBindVertexArray(0);
+
+	if (NULL != m_pInstanceStream)
+	{
+		m_pInstanceStream->EndRegion();
+	}
+	if (NULL != m_pIndirectCommands)
+	{
+		m_pIndirectStream->EndRegion();
+		m_pIndirectCommands = NULL;
+		m_indirectCount = 0;
+	}
+}
+
+/***********************************************************
+ *  UsesTextureHandles()
+ *
+ *  This method is used for checking whether the instance
+ *  shader declares the texture block, in which case it
+ *  samples through bindless handles.
+ ***********************************************************/
+bool InstancedMeshes::UsesTextureHandles() const
+{
+	if (NULL == m_pShaderUniforms)
+	{
+		return(false);
+	}
+
+	return(m_pShaderUniforms->HasBlock(UniformBuffers::TEXTURE_BLOCK));
+}
+
+/***********************************************************
+ *  MapIndirectDraws()
+ *
+ *  This method is used for getting room for up to
+ *  commandCount draw commands in the next free region of
+ *  the indirect ring.  The ring is recreated larger when a
+ *  frame needs more commands than a region holds.
+ ***********************************************************/
+bool InstancedMeshes::MapIndirectDraws(size_t commandCount)
+{
+	if ((NULL == m_pIndirectStream) || (commandCount == 0))
+	{
+		return(false);
+	}
+
+	if (commandCount > m_indirectCapacity)
+	{
+		size_t capacity = m_indirectCapacity * 2;
+		if (capacity < commandCount)
+		{
+			capacity = commandCount;
+		}
+		m_indirectCapacity = 0;
+		if (m_pIndirectStream->Create(capacity * sizeof(DRAW_COMMAND)) == false)
+		{
+			return(false);
+		}
+		m_indirectCapacity = capacity;
+	}
+
+	m_pIndirectCommands = (DRAW_COMMAND*)m_pIndirectStream->BeginRegion();
+	m_indirectCount = 0;
+
+	return(NULL != m_pIndirectCommands);
+}
+
+/***********************************************************
+ *  AddIndirectDraw()
+ *
+ *  This method is used for writing the draw command for
+ *  count copies of a shape into the mapped indirect region.
+ *  The index of the command is returned, or -1 when the
+ *  region is full or not mapped.
+ ***********************************************************/
+int InstancedMeshes::AddIndirectDraw(SHAPE_ID shape, int count, int firstInstance, int lodLevel)
+{
+	if ((NULL == m_pIndirectCommands) || (m_indirectCount >= (int)m_indirectCapacity))
+	{
+		return(-1);
+	}
+
+	const GeometryArena::MESH_RANGE& mesh = m_meshes[shape][lodLevel];
+	DRAW_COMMAND& command = m_pIndirectCommands[m_indirectCount];
+
+	command.count = (GLuint)mesh.nIndices;
+	command.instanceCount = (GLuint)count;
+	command.firstIndex = mesh.firstIndex;
+	command.baseVertex = mesh.baseVertex;
+	command.baseInstance = (GLuint)(m_baseInstance + firstInstance);
+
+	return(m_indirectCount++);
+}
+
+/***********************************************************
+ *  DrawIndirect()
+ *
+ *  This method is used for issuing a range of the recorded
+ *  draw commands with a single call.  The GPU reads the
+ *  commands from the indirect buffer, and every command
+ *  picks its instances through its base instance.
+ ***********************************************************/
+void InstancedMeshes::DrawIndirect(int firstCommand, int commandCount)
+{
+	if ((NULL == m_pIndirectCommands) || (commandCount <= 0))
+	{
+		return;
+	}
+
+	size_t offset = m_pIndirectStream->GetRegionOffset() + ((size_t)firstCommand * sizeof(DRAW_COMMAND));
+
+	DrawCommands(m_pIndirectStream->GetBuffer(), offset, commandCount);
+}
+
+/***********************************************************
+ *  GetShapeCommand()
+ *
+ *  This method is used for getting the draw command of a
+ *  shape level with no instances and a base instance of 0,
+ *  for command buffers that are filled in on the GPU.
+ ***********************************************************/
+void InstancedMeshes::GetShapeCommand(SHAPE_ID shape, int lodLevel, DRAW_COMMAND& command) const
+{
+	const GeometryArena::MESH_RANGE& mesh = m_meshes[shape][lodLevel];
+
+	command.count = (GLuint)mesh.nIndices;
+	command.instanceCount = 0;
+	command.firstIndex = mesh.firstIndex;
+	command.baseVertex = mesh.baseVertex;
+	command.baseInstance = 0;
+}
+
+/***********************************************************
+ *  GetLodCount()
+ *
+ *  This method is used for getting the number of distinct
+ *  levels of detail of a shape - 1 for the flat shapes.
+ ***********************************************************/
+int InstancedMeshes::GetLodCount(SHAPE_ID shape)
+{
+	switch (shape)
+	{
+	case SHAPE_CONE:
+	case SHAPE_CYLINDER:
+	case SHAPE_SPHERE:
+	case SHAPE_TAPERED_CYLINDER:
+		return(LOD_COUNT);
+	default:
+		return(1);
+	}
+}
+
+/***********************************************************
+ *  DrawCulled()
+ *
+ *  This method is used for issuing a range of the draw
+ *  commands in a buffer written on the GPU, between
+ *  BeginCulledDraws() and EndInstancedDraws().
+ ***********************************************************/
+void InstancedMeshes::DrawCulled(GLuint commandBuffer, int firstCommand, int commandCount)
+{
+	if ((commandBuffer == 0) || (commandCount <= 0))
+	{
+		return;
+	}
+
+	DrawCommands(commandBuffer, (size_t)firstCommand * sizeof(DRAW_COMMAND), commandCount);
+}
+
+/***********************************************************
+ *  DrawCommands()
+ *
+ *  This method is used for drawing the commands at an offset
+ *  of an indirect buffer with a single multi-draw.
+ ***********************************************************/
+void InstancedMeshes::DrawCommands(GLuint commandBuffer, size_t offset, int commandCount)
+{
+	FrameProfiler::CountDrawCall();
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+	glMultiDrawElementsIndirect(
+		GL_TRIANGLES,
+		GL_UNSIGNED_INT,
+		(const void*)offset,
+		commandCount,
+		0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+/***********************************************************
+ *  DrawInstanced()
+ *
+ *  This method is used for drawing count copies of a shape
+ *  level with one draw call.  firstInstance is the index of
+ *  the first copy among the mapped instances of the frame.
+ ***********************************************************/
+void InstancedMeshes::DrawInstanced(SHAPE_ID shape, int lodLevel, int count, int firstInstance)
+{
+	DrawBufferInstances(shape, lodLevel, count, m_baseInstance + firstInstance);
+}
+
+/***********************************************************
+ *  DrawBufferInstances()
+ *
+ *  This method is used for drawing count copies of a shape
+ *  level with one draw call, where firstInstance is the
+ *  index of the first copy in the attached instance buffer.
+ ***********************************************************/
+void InstancedMeshes::DrawBufferInstances(SHAPE_ID shape, int lodLevel, int count, int firstInstance)
+{
+	const GeometryArena::MESH_RANGE& mesh = m_meshes[shape][lodLevel];
+
+	if ((count <= 0) || (mesh.nIndices == 0))
+	{
+		return;
+	}
+
+	FrameProfiler::CountDrawCall();
+	glDrawElementsInstancedBaseVertexBaseInstance(
+		GL_TRIANGLES,
+		mesh.nIndices,
+		GL_UNSIGNED_INT,
+		(const void*)((size_t)mesh.firstIndex * sizeof(uint32_t)),
+		count,
+		mesh.baseVertex,
+		(GLuint)firstInstance);
+}
+
+/***********************************************************
+ *  Draw*MeshInstanced()
+ *
+ *  These methods are used for drawing count copies of one
+ *  of the basic shapes at a level of detail, starting at
+ *  firstInstance in the instance buffer.
+ ***********************************************************/
+void InstancedMeshes::DrawPlaneMeshInstanced(int count, int firstInstance, int lodLevel)
+{
+	DrawInstanced(SHAPE_PLANE, lodLevel, count, firstInstance);
+}
+
+void InstancedMeshes::DrawBoxMeshInstanced(int count, int firstInstance, int lodLevel)
+{
+	DrawInstanced(SHAPE_BOX, lodLevel, count, firstInstance);
+}
+
+void InstancedMeshes::DrawConeMeshInstanced(int count, int firstInstance, int lodLevel)
+{
+	DrawInstanced(SHAPE_CONE, lodLevel, count, firstInstance);
+}
+
+void InstancedMeshes::DrawCylinderMeshInstanced(int count, int firstInstance, int lodLevel)
+{
+	DrawInstanced(SHAPE_CYLINDER, lodLevel, count, firstInstance);
+}
+
+void InstancedMeshes::DrawPyramid3MeshInstanced(int count, int firstInstance, int lodLevel)
+{
+	DrawInstanced(SHAPE_PYRAMID3, lodLevel, count, firstInstance);
+}
+
+void InstancedMeshes::DrawSphereMeshInstanced(int count, int firstInstance, int lodLevel)
+{
+	DrawInstanced(SHAPE_SPHERE, lodLevel, count, firstInstance);
+}
+
+void InstancedMeshes::DrawTaperedCylinderMeshInstanced(int count, int firstInstance, int lodLevel)
+{
+	DrawInstanced(SHAPE_TAPERED_CYLINDER, lodLevel, count, firstInstance);
+}
@@ -0,0 +1,207 @@
+///////////////////////////////////////////////////////////////////////////////
+// instancedmeshes.h
+// ============
+// instanced drawing of the basic 3D shapes from a per-instance buffer
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "ShaderUniforms.h"
+#include "ShapeGeometry.h"
+#include "UniformBuffers.h"
+#include "StreamBuffer.h"
+#include "GeometryArena.h"
+#include "HotReload.h"
+#include "GpuResources.h"
+
+#include <vector>
+
+/***********************************************************
+ *  InstancedMeshes
+ *
+ *  This class draws many copies of a basic 3D shape with a
+ *  single instanced draw call.  Every copy reads its model
+ *  matrix, color, UV scale, texture index and material index
+ *  from a shared per-instance buffer, and the camera, lights
+ *  and materials come from the shared uniform blocks.
+ *
+ *  All the shapes are suballocated from one geometry arena,
+ *  with one vertex buffer, one index buffer and one vertex
+ *  array, so switching shapes costs no state change, and with GL_ARB_multi_draw_indirect a whole list
+ *  of shape draws is issued with one call from an indirect
+ *  buffer of draw commands.  The instances and the draw
+ *  commands may also come from buffers written on the GPU
+ *  by the culling pass.
+ *
+ *  The per-instance buffer is a persistently mapped ring when
+ *  the driver supports it, so the instance values of a frame
+ *  are written straight into memory the GPU reads from, and
+ *  a plain buffer that is updated by copy otherwise.
+ *
+ *  The round shapes are built at LOD_COUNT levels of detail,
+ *  from the full tessellation at level 0 down to a coarse one
+ *  for shapes that cover only a few pixels.  The flat shapes
+ *  have a single level that every level index draws.
+ *
+ *  When the shader declares the texture block, every instance
+ *  samples its own texture through a bindless handle.
+ *  Otherwise the shader reads the texture bound to the
+ *  texture unit, and callers split their draws by texture.
+ *
+ *  Any of the draws can also go through a depth-only program
+ *  first, which fills the depth buffer for a depth pre-pass
+ *  and lets the instance shader run once per visible pixel.
+ ***********************************************************/
+class InstancedMeshes
+{
+public:
+	// per-instance values read by the instance shader
+	struct INSTANCE_DATA
+	{
+		glm::mat4 model;
+		glm::vec4 color;
+		glm::vec2 uvScale;
+		// -1 when the instance is drawn with its solid color
+		int textureIndex;
+		int materialIndex;
+	};
+
+	// shapes in the shared buffers
+	enum SHAPE_ID
+	{
+		SHAPE_PLANE = 0,
+		SHAPE_BOX,
+		SHAPE_CONE,
+		SHAPE_CYLINDER,
+		SHAPE_PYRAMID3,
+		SHAPE_SPHERE,
+		SHAPE_TAPERED_CYLINDER,
+		SHAPE_COUNT
+	};
+
+	// number of levels of detail of every shape
+	static const int LOD_COUNT = 3;
+
+	// properties for one draw of the indirect buffer - the layout
+	// is the one glMultiDrawElementsIndirect reads
+	struct DRAW_COMMAND
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// constructor
+	InstancedMeshes();
+	// destructor
+	~InstancedMeshes();
+
+	// load the instance shaders and create the shape meshes
+	bool Initialize(UniformBuffers* pUniformBuffers);
+	// reload the instance and depth shaders when their files change
+	void WatchFiles(HotReload* pHotReload);
+
+	// get room for the instance values of the frame - the values
+	// are written to the returned memory before UnmapInstances()
+	INSTANCE_DATA* MapInstances(size_t instanceCount);
+	void UnmapInstances();
+	// switch to the instance shader program before the instanced draws
+	void BeginInstancedDraws();
+	// mark the end of the draws that read the mapped instances
+	void EndInstancedDraws();
+	// true when the instance shader samples through bindless handles
+	bool UsesTextureHandles() const;
+	// true when the depth-only program of the depth pre-pass is loaded
+	bool SupportsDepthPrepass() const { return (NULL != m_pDepthShaderManager); }
+	// switch the draws after a Begin call to the depth-only program,
+	// and back to the instance shader program
+	void BeginDepthPrepass();
+	void EndDepthPrepass();
+
+	// true when shape draws can be issued from the indirect buffer
+	bool SupportsIndirectDraws() const { return (NULL != m_pIndirectStream); }
+	// get room for the draw commands of the frame, after MapInstances()
+	bool MapIndirectDraws(size_t commandCount);
+	// record a draw of count copies of a shape - returns its command index
+	int AddIndirectDraw(SHAPE_ID shape, int count, int firstInstance, int lodLevel = 0);
+	// issue a range of the recorded draw commands with one call
+	void DrawIndirect(int firstCommand, int commandCount);
+
+	// get the draw command for a shape with no instances
+	void GetShapeCommand(SHAPE_ID shape, int lodLevel, DRAW_COMMAND& command) const;
+	// number of distinct levels of detail of a shape
+	static int GetLodCount(SHAPE_ID shape);
+	// like BeginInstancedDraws(), but the instances and the draw
+	// commands come from buffers written on the GPU
+	void BeginCulledDraws(GLuint instanceBuffer);
+	// issue a range of the draw commands in the passed in buffer
+	void DrawCulled(GLuint commandBuffer, int firstCommand, int commandCount);
+	// like BeginCulledDraws(), but for callers drawing with their own program
+	void BeginDepthDraws(GLuint instanceBuffer);
+	// draw count copies of a shape from the buffer of BeginDepthDraws()
+	void DrawBufferInstances(SHAPE_ID shape, int lodLevel, int count, int firstInstance);
+
+	// the arena that holds the shapes - meshes added to it can be
+	// drawn with the instanced draws as well
+	GeometryArena* GetGeometryArena() { return m_pGeometryArena; }
+
+	// draw count copies of a shape, starting at firstInstance - the
+	// draws go between BeginInstancedDraws() and EndInstancedDraws()
+	void DrawPlaneMeshInstanced(int count, int firstInstance = 0, int lodLevel = 0);
+	void DrawBoxMeshInstanced(int count, int firstInstance = 0, int lodLevel = 0);
+	void DrawConeMeshInstanced(int count, int firstInstance = 0, int lodLevel = 0);
+	void DrawCylinderMeshInstanced(int count, int firstInstance = 0, int lodLevel = 0);
+	void DrawPyramid3MeshInstanced(int count, int firstInstance = 0, int lodLevel = 0);
+	void DrawSphereMeshInstanced(int count, int firstInstance = 0, int lodLevel = 0);
+	void DrawTaperedCylinderMeshInstanced(int count, int firstInstance = 0, int lodLevel = 0);
+
+private:
+	// compile the changed instance shaders into the running program
+	void ReloadShaders(HotReload* pHotReload);
+	// shader program used for the instanced draws
+	ShaderManager* m_pShaderManager;
+	ShaderUniforms* m_pShaderUniforms;
+	// depth-only program - NULL when its shaders are not found
+	ShaderManager* m_pDepthShaderManager;
+	// shared vertex array, vertex buffer and index buffer of the shapes
+	GeometryArena* m_pGeometryArena;
+	// where every level of every shape is in the arena
+	GeometryArena::MESH_RANGE m_meshes[SHAPE_COUNT][LOD_COUNT];
+	// per-instance buffer shared by all the shapes - the stream is
+	// NULL when the plain buffer is updated by copy instead
+	GLuint m_instanceBuffer;
+	StreamBuffer* m_pInstanceStream;
+	GpuBuffer m_plainInstanceBuffer;
+	// buffer the per-instance attributes currently read from
+	GLuint m_attachedBuffer;
+	// instances that fit into the buffer, or into one stream region
+	size_t m_instanceCapacity;
+	// index of the first mapped instance within the buffer
+	int m_baseInstance;
+	// instance values waiting to be copied into the plain buffer
+	std::vector<INSTANCE_DATA> m_stagingInstances;
+
+	// draw commands of the frame - NULL without multi-draw support
+	StreamBuffer* m_pIndirectStream;
+	size_t m_indirectCapacity;
+	DRAW_COMMAND* m_pIndirectCommands;
+	int m_indirectCount;
+
+	// pack the shape data into the geometry arena - levels without
+	// data draw level 0
+	void CreateMeshes(const ShapeGeometry::MESH_DATA meshData[SHAPE_COUNT][LOD_COUNT]);
+	// point the per-instance attributes of the vertex array at a buffer
+	void AttachInstanceBuffer(GLuint buffer);
+	// replace the stream with one that holds more instances per region
+	bool GrowInstanceStream(size_t instanceCount);
+	// free the arena, the instance buffer and the indirect buffer
+	void DestroyMeshes();
+	// issue the instanced draw for a shape from the mapped instances
+	void DrawInstanced(SHAPE_ID shape, int lodLevel, int count, int firstInstance);
+	// issue the draw commands at an offset of an indirect buffer
+	void DrawCommands(GLuint commandBuffer, size_t offset, int commandCount);
+};
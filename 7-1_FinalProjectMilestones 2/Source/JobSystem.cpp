@@ -0,0 +1,245 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.cpp
+// ============
+// work-stealing thread pool for splitting per-frame CPU work across cores
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "JobSystem.h"
+
+#include <algorithm>
+
+/***********************************************************
+ *  JobSystem()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+JobSystem::JobSystem(int threadCount)
+{
+	m_queuedJobs = 0;
+	m_bStopping = false;
+
+	// the calling thread works on the jobs too
+	if (threadCount <= 0)
+	{
+		threadCount = (int)std::thread::hardware_concurrency() - 1;
+	}
+	if (threadCount < 0)
+	{
+		threadCount = 0;
+	}
+
+	for (int i = 0; i <= threadCount; i++)
+	{
+		m_queues.push_back(new WORKER_QUEUE());
+	}
+	for (int i = 0; i < threadCount; i++)
+	{
+		m_threads.push_back(std::thread(&JobSystem::WorkerLoop, this, i));
+	}
+}
+
+/***********************************************************
+ *  ~JobSystem()
+ *
+ *  The destructor for the class - stops the workers
+ ***********************************************************/
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_bStopping = true;
+	}
+	m_wakeCondition.notify_all();
+
+	for (size_t i = 0; i < m_threads.size(); i++)
+	{
+		m_threads[i].join();
+	}
+	m_threads.clear();
+
+	for (size_t i = 0; i < m_queues.size(); i++)
+	{
+		delete m_queues[i];
+	}
+	m_queues.clear();
+}
+
+/***********************************************************
+ *  GetJobCount()
+ *
+ *  This method is used for getting the number of jobs that
+ *  a range is split into.  Job n covers the items from
+ *  n * itemsPerJob up to the next job.
+ ***********************************************************/
+int JobSystem::GetJobCount(int itemCount, int itemsPerJob)
+{
+	if (itemCount <= 0)
+	{
+		return(0);
+	}
+	if (itemsPerJob <= 0)
+	{
+		return(1);
+	}
+
+	return((itemCount + itemsPerJob - 1) / itemsPerJob);
+}
+
+/***********************************************************
+ *  ParallelFor()
+ *
+ *  This method is used for splitting a range of items into
+ *  jobs of itemsPerJob items and running them on all the
+ *  threads.  The jobs are dealt out over the queues in
+ *  turn, and the call returns once every job is done.  A
+ *  range that fits into one job runs on the caller.
+ ***********************************************************/
+void JobSystem::ParallelFor(int itemCount, int itemsPerJob, const RANGE_FUNCTION& function)
+{
+	int jobCount = GetJobCount(itemCount, itemsPerJob);
+
+	if (jobCount == 0)
+	{
+		return;
+	}
+	if ((jobCount == 1) || (m_threads.empty() == true))
+	{
+		for (int i = 0; i < jobCount; i++)
+		{
+			int begin = i * itemsPerJob;
+			int end = (jobCount == 1) ? itemCount : std::min(begin + itemsPerJob, itemCount);
+			function(i, begin, end);
+		}
+		return;
+	}
+
+	std::atomic<int> remaining(jobCount);
+	for (int i = 0; i < jobCount; i++)
+	{
+		JOB job;
+		job.pFunction = &function;
+		job.jobIndex = i;
+		job.begin = i * itemsPerJob;
+		job.end = std::min(job.begin + itemsPerJob, itemCount);
+		job.pRemaining = &remaining;
+
+		WORKER_QUEUE* pQueue = m_queues[i % m_queues.size()];
+		std::lock_guard<std::mutex> lock(pQueue->mutex);
+		pQueue->jobs.push_back(job);
+	}
+
+	// counted under the wake lock, so no idle worker misses the jobs
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_queuedJobs += jobCount;
+	}
+	m_wakeCondition.notify_all();
+
+	// help with the jobs, then wait for the ones still running
+	int callerIndex = (int)m_queues.size() - 1;
+	while (remaining.load() > 0)
+	{
+		JOB job;
+		if (PopJob(callerIndex, job) == true)
+		{
+			RunJob(job);
+		}
+		else
+		{
+			std::unique_lock<std::mutex> lock(m_doneMutex);
+			while (remaining.load() > 0)
+			{
+				m_doneCondition.wait(lock);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  PopJob()
+ *
+ *  This method is used for taking the newest job of the own
+ *  queue, or when it is empty the oldest job of another
+ *  queue.  False is returned when all the queues are empty.
+ ***********************************************************/
+bool JobSystem::PopJob(int workerIndex, JOB& job)
+{
+	if (m_queuedJobs.load() <= 0)
+	{
+		return(false);
+	}
+
+	WORKER_QUEUE* pOwnQueue = m_queues[workerIndex];
+	{
+		std::lock_guard<std::mutex> lock(pOwnQueue->mutex);
+		if (pOwnQueue->jobs.empty() == false)
+		{
+			job = pOwnQueue->jobs.back();
+			pOwnQueue->jobs.pop_back();
+			m_queuedJobs--;
+			return(true);
+		}
+	}
+
+	for (size_t i = 1; i < m_queues.size(); i++)
+	{
+		WORKER_QUEUE* pQueue = m_queues[(workerIndex + i) % m_queues.size()];
+		std::lock_guard<std::mutex> lock(pQueue->mutex);
+		if (pQueue->jobs.empty() == false)
+		{
+			job = pQueue->jobs.front();
+			pQueue->jobs.pop_front();
+			m_queuedJobs--;
+			return(true);
+		}
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  RunJob()
+ *
+ *  This method is used for running a job.  The last job of
+ *  a ParallelFor() call wakes the waiting caller.
+ ***********************************************************/
+void JobSystem::RunJob(const JOB& job)
+{
+	(*job.pFunction)(job.jobIndex, job.begin, job.end);
+
+	if (--(*job.pRemaining) == 0)
+	{
+		std::lock_guard<std::mutex> lock(m_doneMutex);
+		m_doneCondition.notify_all();
+	}
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is used by each worker thread for running
+ *  jobs, and for sleeping while there are none.
+ ***********************************************************/
+void JobSystem::WorkerLoop(int workerIndex)
+{
+	while (true)
+	{
+		JOB job;
+		if (PopJob(workerIndex, job) == true)
+		{
+			RunJob(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_wakeMutex);
+		while ((m_queuedJobs.load() <= 0) && (m_bStopping == false))
+		{
+			m_wakeCondition.wait(lock);
+		}
+		if (m_bStopping == true)
+		{
+			return;
+		}
+	}
+}
@@ -0,0 +1,89 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.h
+// ============
+// work-stealing thread pool for splitting per-frame CPU work across cores
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  JobSystem
+ *
+ *  This class runs a range of items as jobs on a pool of
+ *  worker threads.  Every worker has its own job queue and
+ *  takes from the back of it, and a worker whose queue is
+ *  empty steals from the front of the others, so the work
+ *  evens out when jobs take different times.  The calling
+ *  thread works on the jobs as well until all of them are
+ *  done.  The jobs must not call OpenGL.
+ ***********************************************************/
+class JobSystem
+{
+public:
+	// function run for one job - the job index and its item range
+	typedef std::function<void(int jobIndex, int begin, int end)> RANGE_FUNCTION;
+
+	// constructor - 0 starts one thread per core besides the caller
+	JobSystem(int threadCount);
+	// destructor
+	~JobSystem();
+
+	// number of threads working on jobs, including the caller
+	int GetWorkerCount() const { return (int)m_queues.size(); }
+
+	// number of jobs that ParallelFor() splits a range into
+	static int GetJobCount(int itemCount, int itemsPerJob);
+	// run the function for every job of the range and wait for all
+	// of them - must not be called from inside a job
+	void ParallelFor(int itemCount, int itemsPerJob, const RANGE_FUNCTION& function);
+
+private:
+	// properties for a queued job
+	struct JOB
+	{
+		const RANGE_FUNCTION* pFunction;
+		int jobIndex;
+		int begin;
+		int end;
+		// jobs of the same ParallelFor() call that are not done
+		std::atomic<int>* pRemaining;
+	};
+
+	// properties for the job queue of one worker
+	struct WORKER_QUEUE
+	{
+		std::mutex mutex;
+		std::deque<JOB> jobs;
+	};
+
+	// take a job from the own queue or steal one from another
+	bool PopJob(int workerIndex, JOB& job);
+	// run a job and signal when it was the last of its call
+	void RunJob(const JOB& job);
+	// work on jobs until the job system stops
+	void WorkerLoop(int workerIndex);
+
+	// one queue per thread - the last one belongs to the caller
+	std::vector<WORKER_QUEUE*> m_queues;
+	std::vector<std::thread> m_threads;
+	// jobs in all of the queues
+	std::atomic<int> m_queuedJobs;
+
+	// guards m_bStopping and the sleeping of idle workers
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wakeCondition;
+	bool m_bStopping;
+
+	// signalled when the last job of a call is done
+	std::mutex m_doneMutex;
+	std::condition_variable m_doneCondition;
+};
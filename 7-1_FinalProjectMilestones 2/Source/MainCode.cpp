@@ -9,6 +9,10 @@
 
 #include <iostream>         // error handling and output
 #include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // strcmp
+#include <fstream>
+#include <memory>
+#include <string>
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -22,28 +26,89 @@
 #include "ViewManager.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "ShaderUniforms.h"
+#include "UniformBuffers.h"
+#include "TextureCooker.h"
+#include "SceneFile.h"
+#include "TransformBatch.h"
+#include "HotReload.h"
+#include "FrameProfiler.h"
+#include "CameraPath.h"
+#include "RenderTarget.h"
+#include "ResolutionScaler.h"
+#include "FramePacer.h"
+#include "GpuResources.h"
 
 // Namespace for declaring global variables
 namespace
 {
 	// Macro for window title
 	const char* const WINDOW_TITLE = "7-1 FinalProject and Milestones"; 
+	// shader files of the main program
+	const char* const VERTEX_SHADER_FILE = "shaders/vertexShader.glsl";
+	const char* const FRAGMENT_SHADER_FILE = "shaders/fragmentShader.glsl";
 
 	// Main GLFW window
 	GLFWwindow* g_Window = nullptr;
 
 	// scene manager object for managing the 3D scene prepare and render
-	SceneManager* g_SceneManager = nullptr;
+	std::unique_ptr<SceneManager> g_SceneManager;
 	// shader manager object for dynamic interaction with the shader code
-	ShaderManager* g_ShaderManager = nullptr;
+	std::unique_ptr<ShaderManager> g_ShaderManager;
+	// cached uniform locations of the loaded shader program
+	std::unique_ptr<ShaderUniforms> g_ShaderUniforms;
+	// uniform buffers for the camera, light and material blocks
+	std::unique_ptr<UniformBuffers> g_UniformBuffers;
 	// view manager object for managing the 3D view setup and projection to 2D
-	ViewManager* g_ViewManager = nullptr;
+	std::unique_ptr<ViewManager> g_ViewManager;
+	// frame timing and render counters
+	std::unique_ptr<FrameProfiler> g_FrameProfiler;
+	// reloads the shaders, textures and scene file when they change
+	std::unique_ptr<HotReload> g_HotReload;
+	// offscreen scene targets with MSAA and resolution scaling
+	std::unique_ptr<ResolutionScaler> g_ResolutionScaler;
+
+	// seconds between updates of the profiler overlay in the window title
+	const double OVERLAY_INTERVAL = 0.5;
+	// seconds between the keyframes of a recorded camera path
+	const double RECORD_INTERVAL = 0.25;
+	// frames rendered before the benchmark starts measuring
+	const int BENCHMARK_WARMUP_FRAMES = 30;
+	// seconds of one fixed update of the camera and input
+	const double UPDATE_STEP = 1.0 / 120.0;
+	// part of the window covered by the "--top-view" inset, and the
+	// height and half of the depth of the desk it shows
+	const glm::vec4 TOP_VIEW_VIEWPORT = glm::vec4(0.68f, 0.68f, 0.3f, 0.3f);
+	const float TOP_VIEW_HEIGHT = 40.0f;
+	const float TOP_VIEW_SIZE = 12.0f;
+	// default objects and runs of the transform benchmark
+	const int TRANSFORM_BENCHMARK_OBJECTS = 100000;
+	const int TRANSFORM_BENCHMARK_RUNS = 20;
+
+	// properties for a headless benchmark run
+	struct BENCHMARK_OPTIONS
+	{
+		bool bEnabled;
+		int frameCount;
+		int syntheticObjects;
+		int syntheticLights;
+		unsigned int seed;
+		// NULL replays the built in orbit around the scene
+		const char* cameraPathFile;
+		const char* reportFile;
+	};
 }
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
 bool InitializeGLFW();
 bool InitializeGLEW();
+int CookTextures(int fileCount, char* filenames[]);
+int CompileScenes(int fileCount, char* filenames[]);
+void InitializeGLState();
+void RenderFrame(float interpolation);
+int RunBenchmark(const BENCHMARK_OPTIONS& options);
+bool WriteBenchmarkReport(const BENCHMARK_OPTIONS& options, int width, int height);
 
 
 /***********************************************************
@@ -54,6 +119,168 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	// "--cook <image files>" cooks the textures offline and exits
+	// without opening a window
+	if ((argc > 1) && (strcmp(argv[1], "--cook") == 0))
+	{
+		return(CookTextures(argc - 2, argv + 2));
+	}
+	// "--cook-scene <scene files>" compiles the scene text files
+	if ((argc > 1) && (strcmp(argv[1], "--cook-scene") == 0))
+	{
+		return(CompileScenes(argc - 2, argv + 2));
+	}
+	// "--benchmark-transforms [<object count>]" times building the
+	// model matrices in batches against multiplying single matrices
+	if ((argc > 1) && (strcmp(argv[1], "--benchmark-transforms") == 0))
+	{
+		int objectCount = (argc > 2) ? atoi(argv[2]) : TRANSFORM_BENCHMARK_OBJECTS;
+		return((TransformBatch::RunBenchmark(objectCount, TRANSFORM_BENCHMARK_RUNS) == true) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	// "--overlay" shows the frame statistics in the window title,
+	// "--profile <file>" writes every frame to a CSV file and
+	// "--record-path <file>" saves the camera moves as a camera path,
+	// "--max-fps <n>" limits the frame rate, "--no-vsync" does not
+	// wait for the display between frames, "--cpu-culling" keeps
+	// the frustum culling off of the GPU, "--shadow-cascades <n>"
+	// splits the shadows into n cascades, with 0 turning them off,
+	// "--no-depth-prepass" shades the opaque objects without
+	// drawing their depth first, "--scene <file>" loads the scene
+	// from a scene file or compiled scene file, "--no-hot-reload"
+	// stops watching the files of the scene for changes, "--msaa <n>"
+	// renders the scene with n samples per pixel, "--render-scale <f>"
+	// renders it at a fraction of the window size and upscales it, and
+	// "--dynamic-resolution <ms>" lowers the fraction while the frames
+	// take longer than the GPU time budget, "--texture-pool <MB>"
+	// sets how much memory unloaded textures keep for reuse,
+	// "--top-view" adds an orthographic view from above as an inset,
+	// and "--instanced" draws with the instanced shaders, which the
+	// GPU culling, shadows and clustered lights need
+	bool bShowOverlay = false;
+	const char* profileFilename = NULL;
+	const char* recordFilename = NULL;
+	double frameLimit = 0.0;
+	bool bVsync = true;
+	bool bGpuCulling = true;
+	bool bInstanced = false;
+	int shadowCascades = ShadowMaps::CASCADE_COUNT;
+	bool bDepthPrepass = true;
+	const char* sceneFilename = NULL;
+	bool bHotReload = true;
+	int msaaSamples = 1;
+	float renderScale = 1.0f;
+	float frameBudget = 0.0f;
+	int texturePoolMegabytes = -1;
+	bool bTopView = false;
+
+	// "--benchmark" renders a fixed number of frames offscreen along
+	// a camera path and writes a report - see RunBenchmark()
+	BENCHMARK_OPTIONS benchmark;
+	benchmark.bEnabled = false;
+	benchmark.frameCount = 1000;
+	benchmark.syntheticObjects = 0;
+	benchmark.syntheticLights = 0;
+	benchmark.seed = 1;
+	benchmark.cameraPathFile = NULL;
+	benchmark.reportFile = "benchmark_report.json";
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--overlay") == 0)
+		{
+			bShowOverlay = true;
+		}
+		else if ((strcmp(argv[i], "--profile") == 0) && (i + 1 < argc))
+		{
+			profileFilename = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--record-path") == 0) && (i + 1 < argc))
+		{
+			recordFilename = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--max-fps") == 0) && (i + 1 < argc))
+		{
+			frameLimit = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--no-vsync") == 0)
+		{
+			bVsync = false;
+		}
+		else if (strcmp(argv[i], "--cpu-culling") == 0)
+		{
+			bGpuCulling = false;
+		}
+		else if (strcmp(argv[i], "--instanced") == 0)
+		{
+			bInstanced = true;
+		}
+		else if ((strcmp(argv[i], "--shadow-cascades") == 0) && (i + 1 < argc))
+		{
+			shadowCascades = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--no-depth-prepass") == 0)
+		{
+			bDepthPrepass = false;
+		}
+		else if ((strcmp(argv[i], "--scene") == 0) && (i + 1 < argc))
+		{
+			sceneFilename = argv[++i];
+		}
+		else if (strcmp(argv[i], "--no-hot-reload") == 0)
+		{
+			bHotReload = false;
+		}
+		else if ((strcmp(argv[i], "--msaa") == 0) && (i + 1 < argc))
+		{
+			msaaSamples = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--render-scale") == 0) && (i + 1 < argc))
+		{
+			renderScale = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--dynamic-resolution") == 0) && (i + 1 < argc))
+		{
+			frameBudget = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--texture-pool") == 0) && (i + 1 < argc))
+		{
+			texturePoolMegabytes = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--top-view") == 0)
+		{
+			bTopView = true;
+		}
+		else if (strcmp(argv[i], "--benchmark") == 0)
+		{
+			benchmark.bEnabled = true;
+		}
+		else if ((strcmp(argv[i], "--frames") == 0) && (i + 1 < argc))
+		{
+			benchmark.frameCount = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--objects") == 0) && (i + 1 < argc))
+		{
+			benchmark.syntheticObjects = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--lights") == 0) && (i + 1 < argc))
+		{
+			benchmark.syntheticLights = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--seed") == 0) && (i + 1 < argc))
+		{
+			benchmark.seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+		}
+		else if ((strcmp(argv[i], "--camera-path") == 0) && (i + 1 < argc))
+		{
+			benchmark.cameraPathFile = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--report") == 0) && (i + 1 < argc))
+		{
+			benchmark.reportFile = argv[++i];
+		}
+	}
+
 	// if GLFW fails initialization, then terminate the application
 	if (InitializeGLFW() == false)
 	{
@@ -61,13 +288,29 @@ int main(int argc, char* argv[])
 	}
 
 	// try to create a new shader manager object
-	g_ShaderManager = new ShaderManager();
+	g_ShaderManager.reset(new ShaderManager());
 	// try to create a new view manager object
-	g_ViewManager = new ViewManager(
-		g_ShaderManager);
+	g_ViewManager.reset(new ViewManager(
+		g_ShaderManager.get()));
 
-	// try to create the main display window
-	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+	// try to create the main display window - the benchmark
+	// renders offscreen and keeps the window hidden
+	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE, (benchmark.bEnabled == false));
+	if (g_Window == NULL)
+	{
+		return(EXIT_FAILURE);
+	}
+	// the inset looks straight down on the desk from the top right
+	// corner of the window
+	if (bTopView == true)
+	{
+		g_ViewManager->AddView(
+			TOP_VIEW_VIEWPORT,
+			glm::vec3(0.0f, TOP_VIEW_HEIGHT, 0.0f),
+			glm::vec3(0.0f, 0.0f, 0.0f),
+			true,
+			TOP_VIEW_SIZE);
+	}
 
 	// if GLEW fails initialization, then terminate the application
 	if (InitializeGLEW() == false)
@@ -77,58 +320,191 @@ int main(int argc, char* argv[])
 
 	// load the shader code from the external GLSL files
 	g_ShaderManager->LoadShaders(
-		"shaders/vertexShader.glsl",
-		"shaders/fragmentShader.glsl");
+		VERTEX_SHADER_FILE,
+		FRAGMENT_SHADER_FILE);
 	g_ShaderManager->use();
 
+	// look up the uniform locations once, so the render loop
+	// can set uniform values without name lookups
+	g_ShaderUniforms.reset(new ShaderUniforms(g_ShaderManager.get()));
+	g_ShaderUniforms->ResolveLocations();
+	g_ViewManager->SetShaderUniforms(g_ShaderUniforms.get());
+
+	// create the uniform buffers that are shared by all the shader
+	// programs - programs without the blocks use plain uniforms
+	g_UniformBuffers.reset(new UniformBuffers());
+	if (g_UniformBuffers->CreateBuffers() == true)
+	{
+		g_UniformBuffers->BindProgram(g_ShaderUniforms->GetProgramID());
+	}
+	g_ViewManager->SetUniformBuffers(g_UniformBuffers.get());
+
 	// try to create a new scene manager object and prepare the 3D scene
-	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager.reset(new SceneManager(
+		g_ShaderManager.get(),
+		g_ShaderUniforms.get(),
+		g_UniformBuffers.get()));
+	g_SceneManager->SetInstancingEnabled(bInstanced);
+	g_SceneManager->SetGpuCullingEnabled(bGpuCulling);
+	g_SceneManager->SetShadowCascadeCount(shadowCascades);
+	g_SceneManager->SetDepthPrepassEnabled(bDepthPrepass);
+	if (texturePoolMegabytes >= 0)
+	{
+		g_SceneManager->SetTexturePoolBudget((long long)texturePoolMegabytes * 1024 * 1024);
+	}
+	if (NULL != sceneFilename)
+	{
+		g_SceneManager->SetSceneFile(sceneFilename);
+	}
+
+	// the benchmark measures fixed content, so only a window that
+	// is being worked in watches its files
+	if ((bHotReload == true) && (benchmark.bEnabled == false))
+	{
+		g_HotReload.reset(new HotReload(g_UniformBuffers.get()));
+		int watchIndex = g_HotReload->AddWatch(
+			[]()
+			{
+				if (g_HotReload->ReloadProgram(g_ShaderManager.get(), VERTEX_SHADER_FILE, FRAGMENT_SHADER_FILE) != 0)
+				{
+					g_ShaderUniforms->ResolveLocations();
+				}
+			});
+		g_HotReload->AddFile(watchIndex, VERTEX_SHADER_FILE);
+		g_HotReload->AddFile(watchIndex, FRAGMENT_SHADER_FILE);
+		g_SceneManager->SetHotReload(g_HotReload.get());
+	}
 	g_SceneManager->PrepareScene();
+	g_SceneManager->AddSyntheticObjects(benchmark.syntheticObjects, benchmark.seed);
+	g_SceneManager->AddSyntheticLights(benchmark.syntheticLights, benchmark.seed);
+
+	// the GL state that stays the same for every frame
+	InitializeGLState();
+
+	// the benchmark measures a fixed resolution, so only a window
+	// adapts its resolution to the frame times
+	g_ResolutionScaler.reset(new ResolutionScaler());
+	g_ResolutionScaler->SetSampleCount(msaaSamples);
+	g_ResolutionScaler->SetRenderScale(renderScale);
+	if (benchmark.bEnabled == false)
+	{
+		g_ResolutionScaler->SetFrameBudget(frameBudget);
+	}
+
+	// measure every frame - GPU times need timer queries
+	g_FrameProfiler.reset(new FrameProfiler());
+	g_FrameProfiler->Initialize();
+	g_SceneManager->SetFrameProfiler(g_FrameProfiler.get());
+	if (NULL != profileFilename)
+	{
+		g_FrameProfiler->OpenCsv(profileFilename);
+	}
+	double lastOverlayTime = 0.0;
+
+	// the recorded camera path starts with the initial view
+	CameraPath recordedPath;
+	double recordStartTime = glfwGetTime();
+	double lastRecordTime = -RECORD_INTERVAL;
+
+	int exitCode = EXIT_SUCCESS;
+	if (benchmark.bEnabled == true)
+	{
+		exitCode = RunBenchmark(benchmark);
+	}
+
+	// input and the camera advance in fixed steps, the frames are
+	// rendered as often as the display and the frame limit allow
+	FramePacer framePacer(UPDATE_STEP);
+	framePacer.SetFrameLimit(frameLimit);
+	glfwSwapInterval((bVsync == true) ? 1 : 0);
 
 	// loop will keep running until the application is closed 
 	// or until an error has occurred
-	while (!glfwWindowShouldClose(g_Window))
+	while ((benchmark.bEnabled == false) && !glfwWindowShouldClose(g_Window))
 	{
-		// Enable z-depth
-		glEnable(GL_DEPTH_TEST);
+		// a minimized window shows nothing - sleep until it is restored
+		if (glfwGetWindowAttrib(g_Window, GLFW_ICONIFIED) != 0)
+		{
+			glfwWaitEvents();
+			framePacer.Reset();
+			continue;
+		}
 
-		// Clear the frame and z buffers
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		int updateCount = framePacer.BeginFrame();
+		for (int update = 0; update < updateCount; update++)
+		{
+			g_ViewManager->UpdateCamera((float)framePacer.GetUpdateStep());
+		}
 
-		// convert from 3D object space to 2D view
-		g_ViewManager->PrepareSceneView();
+		RenderFrame(framePacer.GetInterpolation());
 
-		// refresh the 3D scene
-		g_SceneManager->RenderScene();
+		// keep a keyframe of the camera every interval
+		if ((NULL != recordFilename) && (glfwGetTime() - lastRecordTime >= RECORD_INTERVAL))
+		{
+			glm::vec3 position;
+			glm::vec3 target;
+			g_ViewManager->GetCameraPose(position, target);
+			lastRecordTime = glfwGetTime();
+			recordedPath.AddKey((float)(lastRecordTime - recordStartTime), position, target);
+		}
 
+		// the statistics change too quickly to read every frame
+		if ((bShowOverlay == true) && (glfwGetTime() - lastOverlayTime >= OVERLAY_INTERVAL))
+		{
+			std::string title = std::string(WINDOW_TITLE) + " | " + g_FrameProfiler->FormatSummary();
+			if (g_ResolutionScaler->IsOffscreen() == true)
+			{
+				title += " | " + std::to_string(g_ResolutionScaler->GetRenderWidth()) +
+					"x" + std::to_string(g_ResolutionScaler->GetRenderHeight());
+			}
+			title += " | VRAM " + std::to_string(GpuMemory::GetTotalBytes() / (1024 * 1024)) + " MB";
+			glfwSetWindowTitle(g_Window, title.c_str());
+			lastOverlayTime = glfwGetTime();
+		}
 
 		// Flips the the back buffer with the front buffer every frame.
 		glfwSwapBuffers(g_Window);
 
 		// query the latest GLFW events
 		glfwPollEvents();
-	}
 
-	// clear the allocated manager objects from memory
-	if (NULL != g_SceneManager)
-	{
-		delete g_SceneManager;
-		g_SceneManager = NULL;
+		// the render loop expects the main program to be current
+		if ((NULL != g_HotReload) && (g_HotReload->Poll(glfwGetTime()) == true))
+		{
+			g_ShaderManager->use();
+		}
+
+		// give the time until the next frame back to the system
+		framePacer.WaitForNextFrame();
 	}
-	if (NULL != g_ViewManager)
+
+	if ((NULL != recordFilename) && (recordedPath.GetKeyCount() > 0))
 	{
-		delete g_ViewManager;
-		g_ViewManager = NULL;
+		recordedPath.SaveToFile(recordFilename);
 	}
-	if (NULL != g_ShaderManager)
+
+	// clear the allocated manager objects from memory while the GL
+	// context is still current, the users before what they use
+	if (NULL != g_FrameProfiler)
 	{
-		delete g_ShaderManager;
-		g_ShaderManager = NULL;
+		if ((benchmark.bEnabled == false) &&
+			((bShowOverlay == true) || (NULL != profileFilename)))
+		{
+			std::cout << "Frame statistics: " << g_FrameProfiler->FormatSummary() << std::endl;
+			GpuMemory::Print();
+		}
+		g_FrameProfiler.reset();
 	}
+	g_ResolutionScaler.reset();
+	g_SceneManager.reset();
+	g_HotReload.reset();
+	g_ViewManager.reset();
+	g_UniformBuffers.reset();
+	g_ShaderUniforms.reset();
+	g_ShaderManager.reset();
 
-	// Terminates the program successfully
-	exit(EXIT_SUCCESS); 
+	// Terminates the program
+	exit(exitCode); 
 }
 
 /***********************************************************
@@ -183,4 +559,309 @@ bool InitializeGLEW()
 	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
 
 	return(true);
-}
\ No newline at end of file
+}
+
+/***********************************************************
+ *  CookTextures()
+ *
+ *  This function is called to cook the passed in image files
+ *  into compressed textures with their full mip chains.  The
+ *  scene reads the cooked files in place of the images.
+ ***********************************************************/
+int CookTextures(int fileCount, char* filenames[])
+{
+	int failures = 0;
+
+	if (fileCount <= 0)
+	{
+		std::cout << "Usage: --cook <image file> [<image file> ...]" << std::endl;
+		return(EXIT_FAILURE);
+	}
+
+	for (int i = 0; i < fileCount; i++)
+	{
+		if (TextureCooker::CookTexture(filenames[i]) == false)
+		{
+			failures++;
+		}
+	}
+
+	return((failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/***********************************************************
+ *  CompileScenes()
+ *
+ *  This function is called to compile the passed in scene
+ *  text files into compiled scene files, which the scene
+ *  maps and reads in place.
+ ***********************************************************/
+int CompileScenes(int fileCount, char* filenames[])
+{
+	int failures = 0;
+
+	if (fileCount <= 0)
+	{
+		std::cout << "Usage: --cook-scene <scene file> [<scene file> ...]" << std::endl;
+		return(EXIT_FAILURE);
+	}
+
+	for (int i = 0; i < fileCount; i++)
+	{
+		if (SceneFile::CompileScene(filenames[i]) == false)
+		{
+			failures++;
+		}
+	}
+
+	return((failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/***********************************************************
+ *  InitializeGLState()
+ *
+ *  This function is called once to set the GL state that
+ *  does not change from frame to frame.
+ ***********************************************************/
+void InitializeGLState()
+{
+	// Enable z-depth
+	glEnable(GL_DEPTH_TEST);
+
+	// color the frame is cleared to
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+/***********************************************************
+ *  RenderFrame()
+ *
+ *  This function is called to render one frame of the scene
+ *  into the bound framebuffer, measured by the profiler.  The
+ *  interpolation places the camera between its last two
+ *  fixed updates.  The scene goes through the offscreen
+ *  targets of the resolution scaler when MSAA or scaling is
+ *  on, and the measured frames adapt a dynamic scale.  The
+ *  scene is updated once, and every view then culls and draws
+ *  it into its own part of the frame.
+ ***********************************************************/
+void RenderFrame(float interpolation)
+{
+	int width = 0;
+	int height = 0;
+
+	// the targets follow the size of the window
+	g_ViewManager->GetFramebufferSize(width, height);
+	g_ResolutionScaler->Resize(width, height);
+
+	g_FrameProfiler->BeginFrame();
+	g_FrameProfiler->BeginGpuScope(FrameProfiler::GPU_FRAME);
+
+	g_ResolutionScaler->BeginScene();
+
+	// Clear the frame and z buffers
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// convert from 3D object space to 2D view
+	g_ViewManager->PrepareSceneView(interpolation);
+
+	// objects outside of the camera view are skipped when rendering,
+	// and small objects are drawn with less detail
+	g_SceneManager->SetViewProjection(
+		g_ViewManager->GetViewMatrix(),
+		g_ViewManager->GetProjectionMatrix());
+
+	// refresh the 3D scene
+	g_FrameProfiler->BeginGpuScope(FrameProfiler::GPU_SCENE);
+	g_SceneManager->UpdateScene();
+	g_SceneManager->RenderSceneView(0);
+
+	// the other views draw the shared scene over their own part of
+	// the region the main view was drawn into
+	GLint sceneViewport[4];
+	glGetIntegerv(GL_VIEWPORT, sceneViewport);
+	for (int view = 1; view < g_ViewManager->GetViewCount(); view++)
+	{
+		int x = 0;
+		int y = 0;
+		int viewWidth = 0;
+		int viewHeight = 0;
+		g_ViewManager->GetViewport(view, sceneViewport[2], sceneViewport[3], x, y, viewWidth, viewHeight);
+		x += sceneViewport[0];
+		y += sceneViewport[1];
+
+		glViewport(x, y, viewWidth, viewHeight);
+		glEnable(GL_SCISSOR_TEST);
+		glScissor(x, y, viewWidth, viewHeight);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glDisable(GL_SCISSOR_TEST);
+
+		g_ViewManager->UseView(view);
+		g_SceneManager->SetViewProjection(
+			g_ViewManager->GetViewMatrix(),
+			g_ViewManager->GetProjectionMatrix());
+		g_SceneManager->RenderSceneView(view);
+	}
+	glViewport(sceneViewport[0], sceneViewport[1], sceneViewport[2], sceneViewport[3]);
+	g_FrameProfiler->EndGpuScope(FrameProfiler::GPU_SCENE);
+
+	// resolve and upscale into the framebuffer that was bound
+	g_ResolutionScaler->EndScene();
+
+	g_FrameProfiler->EndGpuScope(FrameProfiler::GPU_FRAME);
+	g_FrameProfiler->EndFrame();
+
+	g_ResolutionScaler->Update(g_FrameProfiler->GetLastSample());
+}
+
+/***********************************************************
+ *  RunBenchmark()
+ *
+ *  This function is called to render a fixed number of
+ *  frames into an offscreen framebuffer with vsync off.  The
+ *  camera follows the camera path from start to end over
+ *  the frames, so every run renders the same views.  All the
+ *  textures are loaded and a few frames are rendered before
+ *  the measuring starts, then the report is written.
+ ***********************************************************/
+int RunBenchmark(const BENCHMARK_OPTIONS& options)
+{
+	CameraPath cameraPath;
+	if (NULL != options.cameraPathFile)
+	{
+		if (cameraPath.LoadFromFile(options.cameraPathFile) == false)
+		{
+			return(EXIT_FAILURE);
+		}
+	}
+	else
+	{
+		cameraPath.CreateOrbit(glm::vec3(0.0f, 2.0f, 0.0f), 12.0f, 3.0f, 8);
+	}
+
+	if (options.frameCount <= 0)
+	{
+		std::cout << "The benchmark needs at least one frame" << std::endl;
+		return(EXIT_FAILURE);
+	}
+
+	int width = 0;
+	int height = 0;
+	glfwGetFramebufferSize(g_Window, &width, &height);
+
+	RenderTarget renderTarget;
+	if (renderTarget.Create(width, height) == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// present as fast as possible instead of at the display rate
+	glfwSwapInterval(0);
+
+	// textures arriving in the middle of the run would skew it
+	g_SceneManager->FinishTextureLoads();
+
+	glm::vec3 position;
+	glm::vec3 target;
+	renderTarget.Bind();
+	cameraPath.Evaluate(0.0f, position, target);
+	g_ViewManager->SetCameraPose(position, target);
+	for (int frame = 0; frame < BENCHMARK_WARMUP_FRAMES; frame++)
+	{
+		RenderFrame(1.0f);
+	}
+	g_FrameProfiler->Flush();
+	g_FrameProfiler->SetHistorySize(options.frameCount);
+
+	for (int frame = 0; frame < options.frameCount; frame++)
+	{
+		float fraction = (options.frameCount > 1) ? (float)frame / (float)(options.frameCount - 1) : 0.0f;
+		cameraPath.Evaluate(fraction, position, target);
+		g_ViewManager->SetCameraPose(position, target);
+
+		renderTarget.Bind();
+		RenderFrame(1.0f);
+
+		// nothing is presented, so hand the commands to the driver
+		glFlush();
+		glfwPollEvents();
+	}
+	g_FrameProfiler->Flush();
+
+	RenderTarget::BindDefault(width, height);
+
+	std::cout << "Benchmark: " << g_FrameProfiler->FormatSummary() << std::endl;
+	if (WriteBenchmarkReport(options, width, height) == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	return(EXIT_SUCCESS);
+}
+
+/***********************************************************
+ *  WriteBenchmarkReport()
+ *
+ *  This function is called to write the statistics of the
+ *  benchmark run as a JSON file.  GPU times that could not
+ *  be measured are written as null.
+ ***********************************************************/
+bool WriteBenchmarkReport(const BENCHMARK_OPTIONS& options, int width, int height)
+{
+	std::ofstream report(options.reportFile);
+	if (report.good() == false)
+	{
+		std::cout << "Could not write the benchmark report " << options.reportFile << std::endl;
+		return(false);
+	}
+
+	FrameProfiler::FRAME_STATS stats = g_FrameProfiler->GetStats();
+	const FrameProfiler::FRAME_SAMPLE& lastSample = g_FrameProfiler->GetLastSample();
+	const char* gpuScopeNames[FrameProfiler::GPU_SCOPE_COUNT] = { "frame", "scene", "shadows", "depthPrepass", "opaque", "sky", "blended" };
+
+	report << "{\n";
+	report << "  \"frames\": " << options.frameCount << ",\n";
+	report << "  \"width\": " << width << ",\n";
+	report << "  \"height\": " << height << ",\n";
+	report << "  \"renderScale\": " << g_ResolutionScaler->GetRenderScale() << ",\n";
+	report << "  \"msaaSamples\": " << g_ResolutionScaler->GetSampleCount() << ",\n";
+	report << "  \"instanced\": " << ((g_SceneManager->IsInstanced() == true) ? "true" : "false") << ",\n";
+	report << "  \"sceneObjects\": " << g_SceneManager->GetSceneObjectCount() << ",\n";
+	report << "  \"syntheticObjects\": " << options.syntheticObjects << ",\n";
+	report << "  \"syntheticLights\": " << options.syntheticLights << ",\n";
+	report << "  \"seed\": " << options.seed << ",\n";
+	report << "  \"cameraPath\": \"" << ((NULL != options.cameraPathFile) ? options.cameraPathFile : "orbit") << "\",\n";
+	report << "  \"measuredFrames\": " << stats.sampleCount << ",\n";
+	report << "  \"frameMs\": { \"min\": " << stats.frameMin
+		<< ", \"avg\": " << stats.frameAvg
+		<< ", \"p50\": " << stats.frameP50
+		<< ", \"p99\": " << stats.frameP99 << " },\n";
+	report << "  \"cpuMs\": { \"avg\": " << stats.cpuAvg << " },\n";
+	report << "  \"gpuMs\": {";
+	for (int scope = 0; scope < FrameProfiler::GPU_SCOPE_COUNT; scope++)
+	{
+		report << ((scope > 0) ? ", " : " ") << "\"" << gpuScopeNames[scope] << "\": ";
+		if (stats.gpuAvg[scope] >= 0.0f)
+		{
+			report << stats.gpuAvg[scope];
+		}
+		else
+		{
+			report << "null";
+		}
+	}
+	report << " },\n";
+	report << "  \"lastFrame\": { \"visibleObjects\": " << g_SceneManager->GetVisibleObjectCount()
+		<< ", \"drawCalls\": " << lastSample.drawCalls
+		<< ", \"uniformUpdates\": " << lastSample.uniformUpdates
+		<< ", \"textureBinds\": " << lastSample.textureBinds << " },\n";
+	report << "  \"videoMemory\": { \"totalBytes\": " << GpuMemory::GetTotalBytes();
+	for (int category = 0; category < GpuMemory::CATEGORY_COUNT; category++)
+	{
+		report << ", \"" << GpuMemory::GetCategoryName((GpuMemory::CATEGORY)category) << "\": "
+			<< GpuMemory::GetBytes((GpuMemory::CATEGORY)category);
+	}
+	report << " }\n";
+	report << "}\n";
+
+	return(report.good());
+}
@@ -0,0 +1,146 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.cpp
+// ============
+// read-only view of a whole file - memory mapped where the platform allows
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fstream>
+#endif
+
+/***********************************************************
+ *  MappedFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MappedFile::MappedFile()
+{
+	m_pData = NULL;
+	m_size = 0;
+	m_fileHandle = NULL;
+	m_mappingHandle = NULL;
+}
+
+/***********************************************************
+ *  ~MappedFile()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for opening a file and mapping its
+ *  whole contents for reading.
+ ***********************************************************/
+bool MappedFile::Open(const char* filename)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(
+		filename,
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		NULL,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+		NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return(false);
+	}
+
+	LARGE_INTEGER fileSize;
+	if ((GetFileSizeEx(file, &fileSize) == FALSE) || (fileSize.QuadPart == 0))
+	{
+		CloseHandle(file);
+		return(false);
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+	{
+		CloseHandle(file);
+		return(false);
+	}
+
+	void* pView = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (pView == NULL)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return(false);
+	}
+
+	m_fileHandle = file;
+	m_mappingHandle = mapping;
+	m_pData = (const unsigned char*)pView;
+	m_size = (size_t)fileSize.QuadPart;
+#else
+	std::ifstream file(filename, std::ios::binary | std::ios::ate);
+	if (file.good() == false)
+	{
+		return(false);
+	}
+
+	std::streamoff fileSize = file.tellg();
+	if (fileSize <= 0)
+	{
+		return(false);
+	}
+
+	m_contents.resize((size_t)fileSize);
+	file.seekg(0, std::ios::beg);
+	if (file.read((char*)&m_contents[0], fileSize).good() == false)
+	{
+		m_contents.clear();
+		return(false);
+	}
+
+	m_pData = &m_contents[0];
+	m_size = m_contents.size();
+#endif
+
+	return(true);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for releasing the mapped contents.
+ ***********************************************************/
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (NULL != m_pData)
+	{
+		UnmapViewOfFile(m_pData);
+	}
+	if (NULL != m_mappingHandle)
+	{
+		CloseHandle((HANDLE)m_mappingHandle);
+	}
+	if (NULL != m_fileHandle)
+	{
+		CloseHandle((HANDLE)m_fileHandle);
+	}
+#endif
+
+	m_contents.clear();
+	m_pData = NULL;
+	m_size = 0;
+	m_fileHandle = NULL;
+	m_mappingHandle = NULL;
+}
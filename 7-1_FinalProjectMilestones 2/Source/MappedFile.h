@@ -0,0 +1,50 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.h
+// ============
+// read-only view of a whole file - memory mapped where the platform allows
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/***********************************************************
+ *  MappedFile
+ *
+ *  This class gives read-only access to the contents of a
+ *  file.  On Windows the file is memory mapped, so pages are
+ *  only read when they are touched; elsewhere the file is
+ *  read into memory.
+ ***********************************************************/
+class MappedFile
+{
+public:
+	// constructor
+	MappedFile();
+	// destructor
+	~MappedFile();
+
+	// open the file and map its contents
+	bool Open(const char* filename);
+	// release the mapped contents
+	void Close();
+
+	// access the contents - NULL while no file is open
+	const unsigned char* GetData() const { return m_pData; }
+	size_t GetSize() const { return m_size; }
+
+private:
+	// a mapping can not be shared between two objects
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+	const unsigned char* m_pData;
+	size_t m_size;
+	// platform handles of the mapped file
+	void* m_fileHandle;
+	void* m_mappingHandle;
+	// contents read into memory when mapping is not available
+	std::vector<unsigned char> m_contents;
+};
@@ -0,0 +1,257 @@
+///////////////////////////////////////////////////////////////////////////////
+// materialtable.cpp
+// ============
+// keep every scene material once in a storage buffer, read by index
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MaterialTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// entries the material buffer has room for at first
+	const int g_InitialCapacity = UniformBuffers::MAX_MATERIALS;
+
+	/***********************************************************
+	 *  RoughnessFromShininess()
+	 *
+	 *  This method is used for getting the roughness that gives
+	 *  about the same highlight as a phong shininess.
+	 ***********************************************************/
+	float RoughnessFromShininess(float shininess)
+	{
+		return(std::sqrt(2.0f / (std::max(shininess, 0.0f) + 2.0f)));
+	}
+}
+
+// the entries are read with the std430 layout
+static_assert(sizeof(MaterialTable::MATERIAL_ENTRY) == 64, "MATERIAL_ENTRY must match the std430 layout");
+
+/***********************************************************
+ *  MaterialTable()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MaterialTable::MaterialTable()
+{
+	m_pUniformBuffers = NULL;
+	m_bufferCapacity = 0;
+	m_bDirty = false;
+}
+
+/***********************************************************
+ *  ~MaterialTable()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MaterialTable::~MaterialTable()
+{
+	m_buffer.Destroy();
+	m_pUniformBuffers = NULL;
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking whether the driver lets
+ *  the fragment shaders read the material buffer.
+ ***********************************************************/
+bool MaterialTable::IsSupported()
+{
+	if (GLEW_VERSION_4_3 == GL_TRUE)
+	{
+		return(true);
+	}
+
+	return(GLEW_ARB_shader_storage_buffer_object == GL_TRUE);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for creating the material buffer and
+ *  binding it to its binding point.  False is returned when
+ *  storage buffers are not supported, in which case the
+ *  materials are only copied into the material block.
+ ***********************************************************/
+bool MaterialTable::Initialize(UniformBuffers* pUniformBuffers)
+{
+	m_pUniformBuffers = pUniformBuffers;
+
+	if (IsSupported() == false)
+	{
+		return(false);
+	}
+
+	// the buffer always has room, so the shaders never read an
+	// unbound buffer before the materials are defined
+	m_bufferCapacity = g_InitialCapacity;
+	m_buffer.Create();
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, m_bufferCapacity * sizeof(MATERIAL_ENTRY), NULL, GL_STATIC_DRAW);
+	m_buffer.SetMemory(GpuMemory::BUFFERS, m_bufferCapacity * sizeof(MATERIAL_ENTRY));
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MATERIAL_BINDING, m_buffer);
+
+	return(true);
+}
+
+/***********************************************************
+ *  Reserve()
+ *
+ *  This method is used for growing the table so that it has
+ *  an entry at the passed in index.  New entries have no
+ *  texture maps and are fully opaque.
+ ***********************************************************/
+bool MaterialTable::Reserve(int materialIndex)
+{
+	if ((materialIndex < 0) || (materialIndex >= MAX_MATERIALS))
+	{
+		std::cout << "Material " << materialIndex << " is outside of the material table" << std::endl;
+		return(false);
+	}
+
+	if (materialIndex >= (int)m_materials.size())
+	{
+		MATERIAL_ENTRY entry;
+		entry.diffuseColor = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		entry.specularColor = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		entry.surface = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
+		entry.textureIndices = glm::ivec4(-1, -1, -1, -1);
+		m_materials.resize(materialIndex + 1, entry);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetMaterial()
+ *
+ *  This method is used for changing an entry of the table.
+ *  The roughness of the entry follows from the shininess,
+ *  and its texture maps are kept.
+ ***********************************************************/
+bool MaterialTable::SetMaterial(
+	int materialIndex,
+	const glm::vec3& diffuseColor,
+	const glm::vec3& specularColor,
+	float shininess)
+{
+	if (Reserve(materialIndex) == false)
+	{
+		return(false);
+	}
+
+	MATERIAL_ENTRY& entry = m_materials[materialIndex];
+	entry.diffuseColor = glm::vec4(diffuseColor, 1.0f);
+	entry.specularColor = glm::vec4(specularColor, shininess);
+	entry.surface.x = RoughnessFromShininess(shininess);
+	m_bDirty = true;
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetMaterials()
+ *
+ *  This method is used for copying the entries of a material
+ *  table in the layout of the material block, such as the one
+ *  of a scene file, into the start of the table.
+ ***********************************************************/
+bool MaterialTable::SetMaterials(const UniformBuffers::MATERIAL_DATA* pMaterials, int materialCount)
+{
+	if ((NULL == pMaterials) || (materialCount <= 0))
+	{
+		return(materialCount == 0);
+	}
+	if (Reserve(materialCount - 1) == false)
+	{
+		return(false);
+	}
+
+	for (int i = 0; i < materialCount; i++)
+	{
+		m_materials[i].diffuseColor = pMaterials[i].diffuseColor;
+		m_materials[i].specularColor = pMaterials[i].specularColor;
+		m_materials[i].surface.x = RoughnessFromShininess(pMaterials[i].specularColor.w);
+	}
+	m_bDirty = true;
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetMaterialTextures()
+ *
+ *  This method is used for setting the texture indices of
+ *  the base color, normal, roughness and metallic, and
+ *  emission maps of an entry.
+ ***********************************************************/
+bool MaterialTable::SetMaterialTextures(int materialIndex, const glm::ivec4& textureIndices)
+{
+	if (Reserve(materialIndex) == false)
+	{
+		return(false);
+	}
+
+	m_materials[materialIndex].textureIndices = textureIndices;
+	m_bDirty = true;
+
+	return(true);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for uploading the table after it
+ *  changed.  The material buffer gets new storage when the
+ *  table outgrew it, and the entries that fit are copied
+ *  into the material block as well.
+ ***********************************************************/
+void MaterialTable::Update()
+{
+	if ((m_bDirty == false) || (m_materials.empty() == true))
+	{
+		return;
+	}
+	m_bDirty = false;
+
+	int materialCount = (int)m_materials.size();
+	if (m_buffer != 0)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffer);
+		if (materialCount > m_bufferCapacity)
+		{
+			while (m_bufferCapacity < materialCount)
+			{
+				m_bufferCapacity *= 2;
+			}
+			glBufferData(GL_SHADER_STORAGE_BUFFER, m_bufferCapacity * sizeof(MATERIAL_ENTRY), NULL, GL_STATIC_DRAW);
+			m_buffer.SetMemory(GpuMemory::BUFFERS, m_bufferCapacity * sizeof(MATERIAL_ENTRY));
+		}
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, materialCount * sizeof(MATERIAL_ENTRY), &m_materials[0]);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	if (NULL == m_pUniformBuffers)
+	{
+		return;
+	}
+
+	// the programs that only declare the material block see the
+	// first entries of the table
+	UniformBuffers::MATERIAL_DATA blockMaterials[UniformBuffers::MAX_MATERIALS];
+	int blockCount = std::min(materialCount, (int)UniformBuffers::MAX_MATERIALS);
+	for (int i = 0; i < blockCount; i++)
+	{
+		blockMaterials[i].diffuseColor = m_materials[i].diffuseColor;
+		blockMaterials[i].specularColor = m_materials[i].specularColor;
+	}
+	m_pUniformBuffers->SetMaterials(blockMaterials, blockCount);
+	m_pUniformBuffers->UpdateMaterials();
+}
@@ -0,0 +1,107 @@
+///////////////////////////////////////////////////////////////////////////////
+// materialtable.h
+// ============
+// keep every scene material once in a storage buffer, read by index
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "UniformBuffers.h"
+#include "GpuResources.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  MaterialTable
+ *
+ *  This class holds the values of all the scene materials.
+ *  A draw or an instance only carries the index of its
+ *  material, so changing the material between draws does not
+ *  upload anything.  With storage buffers the whole table is
+ *  kept in a buffer that grows with the number of materials,
+ *  and shaders read it by declaring:
+ *
+ *    layout(std430, binding = 6) readonly buffer MaterialBuffer
+ *    {
+ *        MaterialEntry materialEntries[];
+ *    };
+ *
+ *  with MaterialEntry holding vec4 diffuseColor, vec4
+ *  specularColor (shininess in w), vec4 surface (roughness,
+ *  metallic, emission and opacity) and ivec4 textureIndices
+ *  (base color, normal, roughness and metallic, emission -
+ *  -1 for none).  The first MAX_MATERIALS entries are also
+ *  copied into the material block, which the instanced
+ *  fragment shader reads without storage buffers.  Any
+ *  other program that declares the block is served too.
+ ***********************************************************/
+class MaterialTable
+{
+public:
+	// binding point of the material buffer - must match the shaders
+	static const int MATERIAL_BINDING = 6;
+	// highest number of entries - the indices fit the material bits
+	// of the render queue sort keys, and a broken index cannot grow
+	// the table without end
+	static const int MAX_MATERIALS = 65535;
+
+	// std430 layout of one material in the material buffer
+	struct MATERIAL_ENTRY
+	{
+		glm::vec4 diffuseColor;
+		// shininess in w
+		glm::vec4 specularColor;
+		// roughness, metallic, emission strength and opacity
+		glm::vec4 surface;
+		// texture index of the base color, normal, roughness and
+		// metallic, and emission maps - -1 when there is none
+		glm::ivec4 textureIndices;
+	};
+
+	// constructor
+	MaterialTable();
+	// destructor
+	~MaterialTable();
+
+	// true when the driver supports storage buffers
+	static bool IsSupported();
+	// create the material buffer - without it the materials are
+	// only kept in the material block
+	bool Initialize(UniformBuffers* pUniformBuffers);
+	// true when the shaders can read the material buffer
+	bool HasStorageBuffer() const { return (m_buffer != 0); }
+
+	// change an entry of the table - uploaded by Update()
+	bool SetMaterial(
+		int materialIndex,
+		const glm::vec3& diffuseColor,
+		const glm::vec3& specularColor,
+		float shininess);
+	// replace the start of the table with entries in the layout of
+	// the material block - uploaded by Update()
+	bool SetMaterials(const UniformBuffers::MATERIAL_DATA* pMaterials, int materialCount);
+	// set the texture indices of the maps of an entry
+	bool SetMaterialTextures(int materialIndex, const glm::ivec4& textureIndices);
+	// number of entries in the table
+	int GetMaterialCount() const { return (int)m_materials.size(); }
+
+	// upload the entries that changed since the last upload
+	void Update();
+
+private:
+	// make room for an entry at the passed in index
+	bool Reserve(int materialIndex);
+
+	// pointer to the shared uniform buffers - holds the material block
+	UniformBuffers* m_pUniformBuffers;
+	// CPU copy of the table
+	std::vector<MATERIAL_ENTRY> m_materials;
+	// material buffer and the number of entries it has room for
+	GpuBuffer m_buffer;
+	int m_bufferCapacity;
+	bool m_bDirty;
+};
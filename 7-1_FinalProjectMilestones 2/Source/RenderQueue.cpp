@@ -0,0 +1,244 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.cpp
+// ============
+// sorted list of draw items - groups draws that share shader state
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <cmath>
+
+// declaration of the global variables and defines
+namespace
+{
+	// bit layout of the sort key, from the most significant bits:
+	//   blend mode (2) | mesh (14) | texture (16) | material (16) | unused (16)
+	const int BLEND_SHIFT = 62;
+	const int MESH_SHIFT = 48;
+	const int TEXTURE_SHIFT = 32;
+	const int MATERIAL_SHIFT = 16;
+
+	// depth ranges of the coarse front to back order in every
+	// doubling of the view depth
+	const float DEPTH_RANGES_PER_DOUBLING = 2.0f;
+	// depth below which everything is in the first range
+	const float MIN_RANGE_DEPTH = 1.0f;
+
+	// compare the queued draws - ties keep the submission order
+	bool CompareItems(
+		const RenderQueue::RENDER_ITEM& a,
+		const RenderQueue::RENDER_ITEM& b)
+	{
+		if (a.sortKey != b.sortKey)
+		{
+			return(a.sortKey < b.sortKey);
+		}
+		return(a.objectIndex < b.objectIndex);
+	}
+
+	// compare the view depths of draws
+	bool IsNearer(
+		const RenderQueue::DEPTH_ITEM& a,
+		const RenderQueue::DEPTH_ITEM& b)
+	{
+		return(a.depth < b.depth);
+	}
+	bool IsFarther(
+		const RenderQueue::DEPTH_ITEM& a,
+		const RenderQueue::DEPTH_ITEM& b)
+	{
+		return(a.depth > b.depth);
+	}
+
+	// coarse depth range of a draw, the same for all the draws
+	// at about the same distance
+	int GetDepthRange(float depth)
+	{
+		return((int)floorf(log2f(std::max(depth, MIN_RANGE_DEPTH)) * DEPTH_RANGES_PER_DOUBLING));
+	}
+	bool IsInNearerRange(
+		const RenderQueue::DEPTH_ITEM& a,
+		const RenderQueue::DEPTH_ITEM& b)
+	{
+		return(GetDepthRange(a.depth) < GetDepthRange(b.depth));
+	}
+}
+
+/***********************************************************
+ *  RenderQueue()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderQueue::RenderQueue()
+{
+	m_firstBlendedItem = 0;
+}
+
+/***********************************************************
+ *  ~RenderQueue()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RenderQueue::~RenderQueue()
+{
+	m_items.clear();
+}
+
+/***********************************************************
+ *  MakeSortKey()
+ *
+ *  This method is used for packing the draw state into a
+ *  sort key.  The blend mode is stored in the highest bits
+ *  so that opaque draws always come before blended draws.
+ *  Untextured draws (index -1) and draws without a material
+ *  (index -1) sort ahead of the others.
+ ***********************************************************/
+uint64_t RenderQueue::MakeSortKey(
+	BLEND_MODE blendMode,
+	int meshID,
+	int textureIndex,
+	int materialIndex)
+{
+	uint64_t sortKey = 0;
+
+	sortKey |= ((uint64_t)blendMode & 0x3) << BLEND_SHIFT;
+	sortKey |= ((uint64_t)meshID & 0x3FFF) << MESH_SHIFT;
+	sortKey |= ((uint64_t)(textureIndex + 1) & 0xFFFF) << TEXTURE_SHIFT;
+	sortKey |= ((uint64_t)(materialIndex + 1) & 0xFFFF) << MATERIAL_SHIFT;
+
+	return(sortKey);
+}
+
+/***********************************************************
+ *  GetBatchKey()
+ *
+ *  This method is used for removing the material and unused
+ *  bits from a sort key.  Consecutive draws with the same
+ *  batch key share the blend mode, mesh and texture.
+ ***********************************************************/
+uint64_t RenderQueue::GetBatchKey(uint64_t sortKey)
+{
+	return(sortKey >> TEXTURE_SHIFT);
+}
+
+/***********************************************************
+ *  GetBlendMode()
+ *
+ *  This method is used for getting the blend mode back out
+ *  of a sort key.
+ ***********************************************************/
+RenderQueue::BLEND_MODE RenderQueue::GetBlendMode(uint64_t sortKey)
+{
+	return((BLEND_MODE)((sortKey >> BLEND_SHIFT) & 0x3));
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the queued draws.
+ ***********************************************************/
+void RenderQueue::Clear()
+{
+	m_items.clear();
+	m_firstBlendedItem = 0;
+}
+
+/***********************************************************
+ *  Push()
+ *
+ *  This method is used for adding a draw to the queue.
+ ***********************************************************/
+void RenderQueue::Push(uint64_t sortKey, int objectIndex)
+{
+	RENDER_ITEM item;
+
+	item.sortKey = sortKey;
+	item.objectIndex = objectIndex;
+
+	m_items.push_back(item);
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used for making room for a number of draws
+ *  that are filled in with SetItem().
+ ***********************************************************/
+void RenderQueue::Resize(size_t itemCount)
+{
+	m_items.resize(itemCount);
+}
+
+/***********************************************************
+ *  SetItem()
+ *
+ *  This method is used for setting the draw at an index of
+ *  the queue.  The queue is not resized, so jobs may fill in
+ *  different parts of it at the same time.
+ ***********************************************************/
+void RenderQueue::SetItem(size_t itemIndex, uint64_t sortKey, int objectIndex)
+{
+	m_items[itemIndex].sortKey = sortKey;
+	m_items[itemIndex].objectIndex = objectIndex;
+}
+
+/***********************************************************
+ *  Sort()
+ *
+ *  This method is used for sorting the queued draws by
+ *  their keys and finding where the blended draws start.
+ ***********************************************************/
+void RenderQueue::Sort()
+{
+	std::sort(m_items.begin(), m_items.end(), CompareItems);
+
+	m_firstBlendedItem = m_items.size();
+	for (size_t i = 0; i < m_items.size(); i++)
+	{
+		if (GetBlendMode(m_items[i].sortKey) != BLEND_OPAQUE)
+		{
+			m_firstBlendedItem = i;
+			break;
+		}
+	}
+}
+
+/***********************************************************
+ *  SortFrontToBack()
+ *
+ *  This method is used for putting draws in order of their
+ *  view depth, nearest first.  Draws at the same depth keep
+ *  their order, so they stay grouped by shader state.
+ ***********************************************************/
+void RenderQueue::SortFrontToBack(std::vector<DEPTH_ITEM>& items)
+{
+	std::stable_sort(items.begin(), items.end(), IsNearer);
+}
+
+/***********************************************************
+ *  SortBackToFront()
+ *
+ *  This method is used for putting draws in order of their
+ *  view depth, farthest first.  Draws at the same depth keep
+ *  their order.
+ ***********************************************************/
+void RenderQueue::SortBackToFront(std::vector<DEPTH_ITEM>& items)
+{
+	std::stable_sort(items.begin(), items.end(), IsFarther);
+}
+
+/***********************************************************
+ *  SortFrontToBackCoarse()
+ *
+ *  This method is used for putting draws in order of coarse
+ *  ranges of their view depth, nearest first.  The draws of
+ *  one range keep their order, so draws passed in queue
+ *  order stay grouped by shader state within each range,
+ *  while the far ranges still come after the near ones.
+ ***********************************************************/
+void RenderQueue::SortFrontToBackCoarse(std::vector<DEPTH_ITEM>& items)
+{
+	std::stable_sort(items.begin(), items.end(), IsInNearerRange);
+}
@@ -0,0 +1,101 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.h
+// ============
+// sorted list of draw items - groups draws that share shader state
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  RenderQueue
+ *
+ *  This class collects the draw items of a frame together
+ *  with a packed sort key.  After sorting, draws that share
+ *  the same blend mode, mesh, texture and material are next
+ *  to each other so redundant shader updates can be skipped.
+ *
+ *  The blended draws always follow the opaque ones.  Within
+ *  a frame, the visible draws can also be put in order of
+ *  their distance from the camera - the opaque ones front to
+ *  back, so hidden pixels fail the depth test before they
+ *  are shaded, and the blended ones back to front, so they
+ *  cover each other correctly.
+ ***********************************************************/
+class RenderQueue
+{
+public:
+	// blend modes - opaque draws are always submitted first
+	enum BLEND_MODE
+	{
+		BLEND_OPAQUE = 0,
+		BLEND_ALPHA
+	};
+
+	// properties for a queued draw
+	struct RENDER_ITEM
+	{
+		uint64_t sortKey;
+		int objectIndex;
+	};
+
+	// properties for a draw ordered by its view depth
+	struct DEPTH_ITEM
+	{
+		float depth;
+		int objectIndex;
+	};
+
+	// constructor
+	RenderQueue();
+	// destructor
+	~RenderQueue();
+
+	// pack the draw state into a sort key
+	static uint64_t MakeSortKey(
+		BLEND_MODE blendMode,
+		int meshID,
+		int textureIndex,
+		int materialIndex);
+
+	// drop the material from a sort key - draws with the same
+	// batch key only differ in per-instance values
+	static uint64_t GetBatchKey(uint64_t sortKey);
+	// get the blend mode packed into a sort key
+	static BLEND_MODE GetBlendMode(uint64_t sortKey);
+
+	// remove all of the queued draws
+	void Clear();
+	// add a draw to the queue
+	void Push(uint64_t sortKey, int objectIndex);
+	// make room for a number of draws that are then set by index -
+	// different indices may be set from different threads
+	void Resize(size_t itemCount);
+	void SetItem(size_t itemIndex, uint64_t sortKey, int objectIndex);
+	// sort the queued draws by their keys
+	void Sort();
+	// index of the first blended draw - the end of the queue when
+	// every draw is opaque
+	size_t GetFirstBlendedItem() const { return m_firstBlendedItem; }
+
+	// order draws by their view depth - ties keep the passed in order
+	static void SortFrontToBack(std::vector<DEPTH_ITEM>& items);
+	static void SortBackToFront(std::vector<DEPTH_ITEM>& items);
+	// order draws nearest first by coarse depth ranges, which grow
+	// with the distance - within a range the passed in order is kept
+	static void SortFrontToBackCoarse(std::vector<DEPTH_ITEM>& items);
+
+	// access the queued draws
+	const std::vector<RENDER_ITEM>& GetItems() const { return m_items; }
+	size_t GetItemCount() const { return m_items.size(); }
+
+private:
+	// queued draws
+	std::vector<RENDER_ITEM> m_items;
+	// where the blended draws start after sorting
+	size_t m_firstBlendedItem;
+};
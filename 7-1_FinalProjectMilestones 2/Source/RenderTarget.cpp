@@ -0,0 +1,199 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendertarget.cpp
+// ============
+// offscreen framebuffer with color and depth attachments
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderTarget.h"
+
+#include <iostream>
+
+/***********************************************************
+ *  RenderTarget()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderTarget::RenderTarget()
+{
+	m_width = 0;
+	m_height = 0;
+	m_samples = 0;
+}
+
+/***********************************************************
+ *  ~RenderTarget()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RenderTarget::~RenderTarget()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the framebuffer with an
+ *  RGBA8 color buffer and a 24 bit depth buffer of the
+ *  passed in size.  The samples are limited to what the
+ *  driver supports.
+ ***********************************************************/
+bool RenderTarget::Create(int width, int height, int samples)
+{
+	Destroy();
+
+	if ((width <= 0) || (height <= 0))
+	{
+		return(false);
+	}
+
+	if (samples > 1)
+	{
+		int maxSamples = GetMaxSamples();
+		if (samples > maxSamples)
+		{
+			std::cout << samples << "x MSAA is not supported, using " << maxSamples << "x" << std::endl;
+			samples = maxSamples;
+		}
+	}
+	if (samples < 1)
+	{
+		samples = 1;
+	}
+
+	// storage with a sample count of 0 has the layout of a plain
+	// renderbuffer, which is what a single sample target needs
+	GLsizei storageSamples = (samples > 1) ? samples : 0;
+
+	m_colorBuffer.Create();
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, storageSamples, GL_RGBA8, width, height);
+	m_colorBuffer.SetMemory(GpuMemory::RENDER_TARGETS, (long long)width * height * 4 * samples);
+
+	m_depthBuffer.Create();
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, storageSamples, GL_DEPTH24_STENCIL8, width, height);
+	m_depthBuffer.SetMemory(GpuMemory::RENDER_TARGETS, (long long)width * height * 4 * samples);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	m_framebuffer.Create();
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Offscreen framebuffer is incomplete: 0x" << std::hex << status << std::dec << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	m_width = width;
+	m_height = height;
+	m_samples = samples;
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for releasing the framebuffer and
+ *  its attachments.
+ ***********************************************************/
+void RenderTarget::Destroy()
+{
+	m_framebuffer.Destroy();
+	m_colorBuffer.Destroy();
+	m_depthBuffer.Destroy();
+	m_width = 0;
+	m_height = 0;
+	m_samples = 0;
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for directing the following draws
+ *  into this target over its whole size.
+ ***********************************************************/
+void RenderTarget::Bind() const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glViewport(0, 0, m_width, m_height);
+}
+
+/***********************************************************
+ *  BindDefault()
+ *
+ *  This method is used for directing the following draws
+ *  into the window framebuffer again.
+ ***********************************************************/
+void RenderTarget::BindDefault(int width, int height)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, width, height);
+}
+
+/***********************************************************
+ *  BlitTo()
+ *
+ *  This method is used for copying the lower left region of
+ *  the color buffer into the lower left region of another
+ *  framebuffer, such as the window.  Regions of different
+ *  sizes are filtered, which only works for a target with
+ *  one sample.  The bound framebuffers are kept.
+ ***********************************************************/
+void RenderTarget::BlitTo(
+	GLuint framebuffer,
+	int sourceWidth, int sourceHeight,
+	int destinationWidth, int destinationHeight) const
+{
+	GLint drawFramebuffer = 0;
+	GLint readFramebuffer = 0;
+
+	if (m_framebuffer == 0)
+	{
+		return;
+	}
+
+	bool bScaled = (sourceWidth != destinationWidth) || (sourceHeight != destinationHeight);
+	if ((bScaled == true) && (m_samples > 1))
+	{
+		std::cout << "A multisampled target can not be scaled while it is resolved" << std::endl;
+		return;
+	}
+
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+	glBlitFramebuffer(
+		0, 0, sourceWidth, sourceHeight,
+		0, 0, destinationWidth, destinationHeight,
+		GL_COLOR_BUFFER_BIT,
+		(bScaled == true) ? GL_LINEAR : GL_NEAREST);
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)drawFramebuffer);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)readFramebuffer);
+}
+
+/***********************************************************
+ *  GetMaxSamples()
+ *
+ *  This method is used for getting the largest number of
+ *  samples of a multisampled renderbuffer.
+ ***********************************************************/
+int RenderTarget::GetMaxSamples()
+{
+	GLint maxSamples = 1;
+
+	glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+
+	return((maxSamples > 1) ? (int)maxSamples : 1);
+}
@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendertarget.h
+// ============
+// offscreen framebuffer with color and depth attachments
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GpuResources.h"
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  RenderTarget
+ *
+ *  This class owns a framebuffer object with a color and a
+ *  depth attachment, so the scene can be rendered without
+ *  drawing to the window.  A multisampled target has to be
+ *  resolved into a target with one sample before it can be
+ *  scaled or shown, which BlitTo() does with the same size.
+ ***********************************************************/
+class RenderTarget
+{
+public:
+	// constructor
+	RenderTarget();
+	// destructor
+	~RenderTarget();
+
+	// create the framebuffer and its attachments - more than one
+	// sample creates multisampled attachments
+	bool Create(int width, int height, int samples = 1);
+	// release the framebuffer and its attachments
+	void Destroy();
+
+	// render into this target for the following draws
+	void Bind() const;
+	// render into the window again
+	static void BindDefault(int width, int height);
+
+	// copy the color of a region into a region of another framebuffer -
+	// a multisampled target is resolved, which needs two regions of the
+	// same size, while a target with one sample can also be scaled
+	void BlitTo(
+		GLuint framebuffer,
+		int sourceWidth, int sourceHeight,
+		int destinationWidth, int destinationHeight) const;
+
+	// largest number of samples the driver supports
+	static int GetMaxSamples();
+
+	GLuint GetFramebuffer() const { return m_framebuffer; }
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+	int GetSamples() const { return m_samples; }
+
+private:
+	GpuFramebuffer m_framebuffer;
+	GpuRenderbuffer m_colorBuffer;
+	GpuRenderbuffer m_depthBuffer;
+	int m_width;
+	int m_height;
+	int m_samples;
+};
@@ -0,0 +1,307 @@
+///////////////////////////////////////////////////////////////////////////////
+// resolutionscaler.cpp
+// ============
+// render the scene offscreen at a fraction of the window size and upscale it
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ResolutionScaler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// lowest fraction of the window size the scene is rendered at
+	const float g_MinScale = 0.5f;
+	// largest change of a dynamic scale at one time
+	const float g_ScaleStep = 0.05f;
+	// frames between two changes, so the GPU times of the frames
+	// that trail behind are measured at the new scale
+	const int g_AdjustFrames = 30;
+	// weight of the latest frame in the smoothed GPU time
+	const float g_Smoothing = 0.1f;
+	// fraction of the budget a changed scale aims for
+	const float g_BudgetTarget = 0.9f;
+	// the scale only goes up while the frames stay below this
+	// fraction of the budget, so it does not go up and down
+	const float g_RaiseThreshold = 0.8f;
+}
+
+/***********************************************************
+ *  ResolutionScaler()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ResolutionScaler::ResolutionScaler()
+{
+	m_outputFramebuffer = 0;
+	m_width = 0;
+	m_height = 0;
+	m_bTargetsDirty = true;
+	m_samples = 1;
+	m_maxScale = 1.0f;
+	m_scale = 1.0f;
+	m_budgetMs = 0.0f;
+	m_averageMs = 0.0f;
+	m_framesSinceChange = 0;
+	m_lastFrameNumber = -1;
+}
+
+/***********************************************************
+ *  ~ResolutionScaler()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ResolutionScaler::~ResolutionScaler()
+{
+	m_sceneTarget.Destroy();
+	m_resolveTarget.Destroy();
+}
+
+/***********************************************************
+ *  SetSampleCount()
+ *
+ *  This method is used for setting the number of MSAA
+ *  samples of the scene target.
+ ***********************************************************/
+void ResolutionScaler::SetSampleCount(int samples)
+{
+	samples = std::max(samples, 1);
+	if (samples != m_samples)
+	{
+		m_samples = samples;
+		m_bTargetsDirty = true;
+	}
+}
+
+/***********************************************************
+ *  SetRenderScale()
+ *
+ *  This method is used for setting the fraction of the
+ *  window size the scene is rendered at.  A dynamic scale
+ *  starts from it and never goes above it.
+ ***********************************************************/
+void ResolutionScaler::SetRenderScale(float scale)
+{
+	m_maxScale = std::min(std::max(scale, g_MinScale), 1.0f);
+	m_scale = m_maxScale;
+	m_framesSinceChange = 0;
+}
+
+/***********************************************************
+ *  SetFrameBudget()
+ *
+ *  This method is used for setting the GPU time of a frame
+ *  the dynamic scale keeps to, such as 16.6 ms for 60 frames
+ *  per second.
+ ***********************************************************/
+void ResolutionScaler::SetFrameBudget(float budgetMs)
+{
+	m_budgetMs = std::max(budgetMs, 0.0f);
+	m_averageMs = 0.0f;
+	m_framesSinceChange = 0;
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used for setting the size of the window
+ *  framebuffer.  A minimized window reports a size of zero,
+ *  which keeps the targets of the last size.
+ ***********************************************************/
+void ResolutionScaler::Resize(int width, int height)
+{
+	if ((width <= 0) || (height <= 0))
+	{
+		return;
+	}
+	if ((width == m_width) && (height == m_height))
+	{
+		return;
+	}
+
+	m_width = width;
+	m_height = height;
+	m_bTargetsDirty = true;
+}
+
+/***********************************************************
+ *  IsOffscreen()
+ *
+ *  This method is used for checking whether the scene needs
+ *  the offscreen targets, or can be rendered directly into
+ *  the bound framebuffer.
+ ***********************************************************/
+bool ResolutionScaler::IsOffscreen() const
+{
+	return((m_samples > 1) || (m_maxScale < 1.0f) || (m_budgetMs > 0.0f));
+}
+
+/***********************************************************
+ *  GetRenderWidth()
+ *
+ *  This method is used for getting the width of the region
+ *  the scene is rendered into.
+ ***********************************************************/
+int ResolutionScaler::GetRenderWidth() const
+{
+	return(std::max((int)(m_width * m_scale + 0.5f), 1));
+}
+
+/***********************************************************
+ *  GetRenderHeight()
+ *
+ *  This method is used for getting the height of the region
+ *  the scene is rendered into.
+ ***********************************************************/
+int ResolutionScaler::GetRenderHeight() const
+{
+	return(std::max((int)(m_height * m_scale + 0.5f), 1));
+}
+
+/***********************************************************
+ *  CreateTargets()
+ *
+ *  This method is used for creating the scene target of the
+ *  window size, and the target it is resolved into when it
+ *  is multisampled.
+ ***********************************************************/
+bool ResolutionScaler::CreateTargets()
+{
+	m_bTargetsDirty = false;
+	m_resolveTarget.Destroy();
+
+	if (m_sceneTarget.Create(m_width, m_height, m_samples) == false)
+	{
+		std::cout << "The scene target could not be created, the scene is rendered into the window" << std::endl;
+		return(false);
+	}
+	if (m_sceneTarget.GetSamples() > 1)
+	{
+		if (m_resolveTarget.Create(m_width, m_height) == false)
+		{
+			m_sceneTarget.Destroy();
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  BeginScene()
+ *
+ *  This method is used for binding the framebuffer the scene
+ *  is rendered into, with the viewport over the scaled
+ *  region.  Without MSAA or scaling the scene is rendered
+ *  directly into the bound framebuffer over its whole size.
+ ***********************************************************/
+void ResolutionScaler::BeginScene()
+{
+	GLint outputFramebuffer = 0;
+
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &outputFramebuffer);
+	m_outputFramebuffer = (GLuint)outputFramebuffer;
+
+	if ((IsOffscreen() == true) && (m_bTargetsDirty == true))
+	{
+		CreateTargets();
+	}
+
+	if ((IsOffscreen() == false) || (m_sceneTarget.GetFramebuffer() == 0))
+	{
+		glViewport(0, 0, m_width, m_height);
+		return;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_sceneTarget.GetFramebuffer());
+	glViewport(0, 0, GetRenderWidth(), GetRenderHeight());
+}
+
+/***********************************************************
+ *  EndScene()
+ *
+ *  This method is used for showing the rendered region in
+ *  the framebuffer that was bound when the scene began.  A
+ *  multisampled scene is first resolved at the same size,
+ *  and the resolved region is then filtered up to the full
+ *  size of the output.
+ ***********************************************************/
+void ResolutionScaler::EndScene()
+{
+	if ((IsOffscreen() == false) || (m_sceneTarget.GetFramebuffer() == 0))
+	{
+		return;
+	}
+
+	int renderWidth = GetRenderWidth();
+	int renderHeight = GetRenderHeight();
+
+	if (m_sceneTarget.GetSamples() > 1)
+	{
+		m_sceneTarget.BlitTo(m_resolveTarget.GetFramebuffer(), renderWidth, renderHeight, renderWidth, renderHeight);
+		m_resolveTarget.BlitTo(m_outputFramebuffer, renderWidth, renderHeight, m_width, m_height);
+	}
+	else
+	{
+		m_sceneTarget.BlitTo(m_outputFramebuffer, renderWidth, renderHeight, m_width, m_height);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_outputFramebuffer);
+	glViewport(0, 0, m_width, m_height);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for adapting the scale to the GPU
+ *  time of a measured frame.  The GPU time grows with the
+ *  number of pixels, so the scale moves by the square root
+ *  of the ratio between the budget and the smoothed time,
+ *  limited to one step, at most once every few frames.
+ ***********************************************************/
+void ResolutionScaler::Update(const FrameProfiler::FRAME_SAMPLE& sample)
+{
+	if ((m_budgetMs <= 0.0f) || (sample.frameNumber == m_lastFrameNumber))
+	{
+		return;
+	}
+	m_lastFrameNumber = sample.frameNumber;
+
+	// frames without GPU times say nothing about the pixel cost
+	float gpuMs = sample.gpuMs[FrameProfiler::GPU_FRAME];
+	if (gpuMs < 0.0f)
+	{
+		return;
+	}
+
+	m_averageMs = (m_averageMs > 0.0f) ? (m_averageMs + (gpuMs - m_averageMs) * g_Smoothing) : gpuMs;
+	m_framesSinceChange++;
+	if (m_framesSinceChange < g_AdjustFrames)
+	{
+		return;
+	}
+
+	bool bOverBudget = (m_averageMs > m_budgetMs);
+	bool bUnderBudget = (m_averageMs < m_budgetMs * g_RaiseThreshold);
+	if ((bOverBudget == false) && (bUnderBudget == false))
+	{
+		return;
+	}
+
+	float targetScale = m_scale * std::sqrt((m_budgetMs * g_BudgetTarget) / m_averageMs);
+	targetScale = std::min(std::max(targetScale, m_scale - g_ScaleStep), m_scale + g_ScaleStep);
+	targetScale = std::min(std::max(targetScale, g_MinScale), m_maxScale);
+	if (std::fabs(targetScale - m_scale) < 0.001f)
+	{
+		return;
+	}
+
+	// expect the time of the new scale until it is measured
+	m_averageMs *= (targetScale * targetScale) / (m_scale * m_scale);
+	m_scale = targetScale;
+	m_framesSinceChange = 0;
+}
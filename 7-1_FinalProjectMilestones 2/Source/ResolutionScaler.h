@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////////////
+// resolutionscaler.h
+// ============
+// render the scene offscreen at a fraction of the window size and upscale it
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "FrameProfiler.h"
+#include "RenderTarget.h"
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  ResolutionScaler
+ *
+ *  This class decides where the scene is rendered.  With
+ *  MSAA or a render scale below one the scene goes into an
+ *  offscreen target of the window size, drawn only over the
+ *  scaled region of it, and at the end of the frame the
+ *  region is resolved and stretched over the framebuffer
+ *  that was bound before.  Drawing into a region keeps the
+ *  targets from being created again when the scale changes,
+ *  so only a resize of the window creates new ones.
+ *
+ *  With a frame budget the scale follows the measured GPU
+ *  time of the frames - it is lowered while the frames take
+ *  longer than the budget and raised again once there is
+ *  time to spare, up to the set render scale.  Without GPU
+ *  timer queries the scale stays where it is.
+ ***********************************************************/
+class ResolutionScaler
+{
+public:
+	// constructor
+	ResolutionScaler();
+	// destructor
+	~ResolutionScaler();
+
+	// samples of the scene target - 1 turns MSAA off
+	void SetSampleCount(int samples);
+	// fraction of the window size the scene is rendered at, and
+	// the most a dynamic scale goes up to
+	void SetRenderScale(float scale);
+	// GPU time of a frame in ms the scale keeps to - 0 keeps the
+	// scale fixed
+	void SetFrameBudget(float budgetMs);
+
+	// set the size of the window framebuffer - the targets are
+	// created again on the next frame when it changed
+	void Resize(int width, int height);
+
+	// bind the framebuffer and viewport the scene is rendered into
+	void BeginScene();
+	// resolve and upscale the scene into the framebuffer that was
+	// bound when the scene began
+	void EndScene();
+	// adapt the scale to a measured frame
+	void Update(const FrameProfiler::FRAME_SAMPLE& sample);
+
+	// current fraction of the window size
+	float GetRenderScale() const { return m_scale; }
+	// size the scene is rendered at
+	int GetRenderWidth() const;
+	int GetRenderHeight() const;
+	// samples of the scene target, as far as the driver supports them
+	int GetSampleCount() const { return (m_sceneTarget.GetFramebuffer() != 0) ? m_sceneTarget.GetSamples() : 1; }
+	// true when the scene is rendered offscreen
+	bool IsOffscreen() const;
+
+private:
+	// create the targets for the current window size
+	bool CreateTargets();
+
+	// multisampled or single sample target the scene is drawn into
+	RenderTarget m_sceneTarget;
+	// target the multisampled scene is resolved into before scaling
+	RenderTarget m_resolveTarget;
+	// framebuffer bound when the scene began
+	GLuint m_outputFramebuffer;
+	int m_width;
+	int m_height;
+	bool m_bTargetsDirty;
+
+	int m_samples;
+	float m_maxScale;
+	float m_scale;
+	float m_budgetMs;
+	// smoothed GPU time of the recent frames
+	float m_averageMs;
+	int m_framesSinceChange;
+	long long m_lastFrameNumber;
+};
@@ -0,0 +1,598 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.cpp
+// ============
+// scene descriptions compiled into a binary file that is read in place
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneFile.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// "SCN1" read as a little endian number
+	const uint32_t g_SceneMagic = 0x314E4353;
+	const uint32_t g_SceneVersion = 1;
+	const char* g_CompiledExtension = ".cscene";
+	// the tables holding vectors start on a 16 byte boundary
+	const size_t g_TableAlignment = 16;
+
+	// mesh names used by the object entries, in SHAPE_ID order
+	const char* g_ShapeNames[InstancedMeshes::SHAPE_COUNT] =
+	{
+		"plane",
+		"box",
+		"cone",
+		"cylinder",
+		"pyramid3",
+		"sphere",
+		"tapered_cylinder"
+	};
+
+	// read a vector of floats from a line
+	bool ReadVector(std::istringstream& line, float* pValues, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			line >> pValues[i];
+		}
+		return(line.fail() == false);
+	}
+
+	// find an entry by name in a list of names
+	uint32_t FindName(const std::vector<std::string>& names, const std::string& name)
+	{
+		for (size_t i = 0; i < names.size(); i++)
+		{
+			if (names[i] == name)
+			{
+				return((uint32_t)i);
+			}
+		}
+		return(SceneFile::NO_ENTRY);
+	}
+
+	// append a table to the compiled data and get its offset
+	uint32_t AppendTable(std::vector<unsigned char>& data, const void* pTable, size_t size)
+	{
+		while ((data.size() % g_TableAlignment) != 0)
+		{
+			data.push_back(0);
+		}
+
+		uint32_t offset = (uint32_t)data.size();
+		if (size > 0)
+		{
+			const unsigned char* pBytes = (const unsigned char*)pTable;
+			data.insert(data.end(), pBytes, pBytes + size);
+		}
+		return(offset);
+	}
+
+	// check that a table lies inside the file
+	bool IsTableInside(uint32_t offset, uint32_t count, size_t entrySize, size_t size)
+	{
+		if (((offset % 4) != 0) || (offset > size))
+		{
+			return(false);
+		}
+		return((uint64_t)count * entrySize <= (uint64_t)(size - offset));
+	}
+}
+
+/***********************************************************
+ *  SceneFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneFile::SceneFile()
+{
+	m_pData = NULL;
+	m_pHeader = NULL;
+}
+
+/***********************************************************
+ *  ~SceneFile()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneFile::~SceneFile()
+{
+	Close();
+}
+
+/***********************************************************
+ *  GetCompiledFilename()
+ *
+ *  This method is used for getting the name of the compiled
+ *  file for a scene text file - the extension is replaced.
+ ***********************************************************/
+std::string SceneFile::GetCompiledFilename(const std::string& sceneFilename)
+{
+	size_t extension = sceneFilename.find_last_of('.');
+	size_t folder = sceneFilename.find_last_of("/\\");
+
+	if ((extension == std::string::npos) ||
+		((folder != std::string::npos) && (extension < folder)))
+	{
+		return(sceneFilename + g_CompiledExtension);
+	}
+
+	return(sceneFilename.substr(0, extension) + g_CompiledExtension);
+}
+
+/***********************************************************
+ *  ParseScene()
+ *
+ *  This method is used for parsing a scene text file into
+ *  the compiled form.  Every line holds one entry:
+ *
+ *    texture <tag> <file>
+ *    material <tag> <diffuse rgb> <specular rgb> <shininess>
+ *    directional <direction xyz> <ambient> <diffuse> <specular>
+ *    light <slot> <position xyz> <ambient> <diffuse> <specular>
+ *    pointlight <position xyz> <range> <ambient> <diffuse> <specular>
+ *    skybox <+x> <-x> <+y> <-y> <+z> <-z>
+ *    object <mesh> <scale xyz> <rotation xyz> <position xyz>
+ *           <material> <texture> <uv scale> <color rgba>
+ *
+ *  Colors are rgb, "-" stands for no material or texture,
+ *  and everything after a '#' is a comment.  Textures and
+ *  materials are defined before the objects that use them.
+ ***********************************************************/
+bool SceneFile::ParseScene(const char* sceneFilename, std::vector<unsigned char>& data)
+{
+	std::ifstream file(sceneFilename);
+	if (file.good() == false)
+	{
+		std::cout << "Scene file " << sceneFilename << " not found" << std::endl;
+		return(false);
+	}
+
+	std::string strings;
+	std::vector<std::string> textureTags;
+	std::vector<std::string> materialTags;
+	std::vector<TEXTURE_ENTRY> textures;
+	std::vector<UniformBuffers::MATERIAL_DATA> materials;
+	std::vector<uint32_t> materialTagOffsets;
+	std::vector<ClusteredLights::POINT_LIGHT> pointLights;
+	std::vector<OBJECT_ENTRY> objects;
+	UniformBuffers::LIGHTS_DATA lights;
+	memset(&lights, 0, sizeof(lights));
+
+	SCENE_HEADER header;
+	memset(&header, 0, sizeof(header));
+	header.magic = g_SceneMagic;
+	header.version = g_SceneVersion;
+	for (int i = 0; i < SKY_FACE_COUNT; i++)
+	{
+		header.skyFaces[i] = NO_ENTRY;
+	}
+
+	std::string text;
+	int lineNumber = 0;
+	while (std::getline(file, text))
+	{
+		lineNumber++;
+		size_t comment = text.find('#');
+		if (comment != std::string::npos)
+		{
+			text.erase(comment);
+		}
+
+		std::istringstream line(text);
+		std::string keyword;
+		if (!(line >> keyword))
+		{
+			continue;
+		}
+
+		bool bValid = true;
+		if (keyword == "texture")
+		{
+			std::string tag;
+			std::string filename;
+			line >> tag >> filename;
+			bValid = (line.fail() == false);
+			if (bValid == true)
+			{
+				TEXTURE_ENTRY texture;
+				texture.tag = (uint32_t)strings.size();
+				strings.append(tag).push_back('\0');
+				texture.filename = (uint32_t)strings.size();
+				strings.append(filename).push_back('\0');
+				textures.push_back(texture);
+				textureTags.push_back(tag);
+			}
+		}
+		else if (keyword == "material")
+		{
+			std::string tag;
+			float values[7];
+			line >> tag;
+			bValid = ReadVector(line, values, 7);
+			if (bValid == true)
+			{
+				UniformBuffers::MATERIAL_DATA material;
+				material.diffuseColor = glm::vec4(values[0], values[1], values[2], 1.0f);
+				material.specularColor = glm::vec4(values[3], values[4], values[5], values[6]);
+				materials.push_back(material);
+				materialTagOffsets.push_back((uint32_t)strings.size());
+				strings.append(tag).push_back('\0');
+				materialTags.push_back(tag);
+			}
+		}
+		else if ((keyword == "directional") || (keyword == "light"))
+		{
+			int slot = -1;
+			if (keyword == "light")
+			{
+				line >> slot;
+			}
+			float values[12];
+			bValid = ReadVector(line, values, 12) &&
+				((keyword == "directional") || (slot >= 0)) &&
+				(slot < UniformBuffers::MAX_POINT_LIGHTS);
+			if (bValid == true)
+			{
+				// the w of the vector marks the light as active
+				UniformBuffers::LIGHT_DATA& light = (slot < 0) ?
+					lights.directionalLight : lights.pointLights[slot];
+				light.vector = glm::vec4(values[0], values[1], values[2], 1.0f);
+				light.ambient = glm::vec4(values[3], values[4], values[5], 0.0f);
+				light.diffuse = glm::vec4(values[6], values[7], values[8], 0.0f);
+				light.specular = glm::vec4(values[9], values[10], values[11], 0.0f);
+			}
+		}
+		else if (keyword == "pointlight")
+		{
+			float values[13];
+			bValid = ReadVector(line, values, 13) &&
+				(pointLights.size() < (size_t)ClusteredLights::MAX_LIGHTS);
+			if (bValid == true)
+			{
+				ClusteredLights::POINT_LIGHT light;
+				light.positionRange = glm::vec4(values[0], values[1], values[2], values[3]);
+				light.ambient = glm::vec4(values[4], values[5], values[6], 0.0f);
+				light.diffuse = glm::vec4(values[7], values[8], values[9], 0.0f);
+				light.specular = glm::vec4(values[10], values[11], values[12], 0.0f);
+				pointLights.push_back(light);
+			}
+		}
+		else if (keyword == "skybox")
+		{
+			std::string faces[SKY_FACE_COUNT];
+			for (int i = 0; i < SKY_FACE_COUNT; i++)
+			{
+				line >> faces[i];
+			}
+			bValid = (line.fail() == false);
+			for (int i = 0; (bValid == true) && (i < SKY_FACE_COUNT); i++)
+			{
+				header.skyFaces[i] = (uint32_t)strings.size();
+				strings.append(faces[i]).push_back('\0');
+			}
+		}
+		else if (keyword == "object")
+		{
+			std::string shape;
+			std::string material;
+			std::string texture;
+			float transform[9];
+			float values[6];
+
+			line >> shape;
+			bValid = ReadVector(line, transform, 9);
+			line >> material >> texture;
+			bValid = bValid && ReadVector(line, values, 6);
+
+			OBJECT_ENTRY object;
+			memset(&object, 0, sizeof(object));
+			object.shape = InstancedMeshes::SHAPE_COUNT;
+			for (int i = 0; i < InstancedMeshes::SHAPE_COUNT; i++)
+			{
+				if (shape == g_ShapeNames[i])
+				{
+					object.shape = (uint32_t)i;
+				}
+			}
+			object.material = (material == "-") ? NO_ENTRY : FindName(materialTags, material);
+			object.texture = (texture == "-") ? NO_ENTRY : FindName(textureTags, texture);
+
+			if ((bValid == true) && (object.shape == InstancedMeshes::SHAPE_COUNT))
+			{
+				std::cout << sceneFilename << "(" << lineNumber << "): unknown mesh " << shape << std::endl;
+				return(false);
+			}
+			if ((bValid == true) &&
+				(((material != "-") && (object.material == NO_ENTRY)) ||
+				((texture != "-") && (object.texture == NO_ENTRY))))
+			{
+				std::cout << sceneFilename << "(" << lineNumber << "): material or texture is not defined yet" << std::endl;
+				return(false);
+			}
+
+			object.scaleXYZ = glm::vec4(transform[0], transform[1], transform[2], 0.0f);
+			object.rotationDegrees = glm::vec4(transform[3], transform[4], transform[5], 0.0f);
+			object.positionXYZ = glm::vec4(transform[6], transform[7], transform[8], 1.0f);
+			object.uvScale = glm::vec4(values[0], values[1], 0.0f, 0.0f);
+			object.color = glm::vec4(values[2], values[3], values[4], values[5]);
+			if (bValid == true)
+			{
+				objects.push_back(object);
+			}
+		}
+		else
+		{
+			std::cout << sceneFilename << "(" << lineNumber << "): unknown entry " << keyword << std::endl;
+			return(false);
+		}
+
+		if (bValid == false)
+		{
+			std::cout << sceneFilename << "(" << lineNumber << "): " << keyword << " entry is not valid" << std::endl;
+			return(false);
+		}
+	}
+
+	if (materials.size() > (size_t)MaterialTable::MAX_MATERIALS)
+	{
+		std::cout << "Scene file " << sceneFilename << " has more than " << MaterialTable::MAX_MATERIALS << " materials" << std::endl;
+		return(false);
+	}
+
+	// the header is written again once the offsets are known
+	data.clear();
+	AppendTable(data, &header, sizeof(header));
+	header.textureCount = (uint32_t)textures.size();
+	header.textureOffset = AppendTable(data, textures.data(), textures.size() * sizeof(TEXTURE_ENTRY));
+	header.materialCount = (uint32_t)materials.size();
+	header.materialOffset = AppendTable(data, materials.data(), materials.size() * sizeof(UniformBuffers::MATERIAL_DATA));
+	header.materialTagOffset = AppendTable(data, materialTagOffsets.data(), materialTagOffsets.size() * sizeof(uint32_t));
+	header.lightOffset = AppendTable(data, &lights, sizeof(lights));
+	header.pointLightCount = (uint32_t)pointLights.size();
+	header.pointLightOffset = AppendTable(data, pointLights.data(), pointLights.size() * sizeof(ClusteredLights::POINT_LIGHT));
+	header.objectCount = (uint32_t)objects.size();
+	header.objectOffset = AppendTable(data, objects.data(), objects.size() * sizeof(OBJECT_ENTRY));
+	header.stringSize = (uint32_t)strings.size();
+	header.stringOffset = AppendTable(data, strings.data(), strings.size());
+	memcpy(&data[0], &header, sizeof(header));
+
+	return(true);
+}
+
+/***********************************************************
+ *  CompileScene()
+ *
+ *  This method is used for compiling a scene text file into
+ *  a compiled scene file next to it, which is loaded with
+ *  one mapping and no parsing.
+ ***********************************************************/
+bool SceneFile::CompileScene(const char* sceneFilename)
+{
+	std::vector<unsigned char> data;
+	if (ParseScene(sceneFilename, data) == false)
+	{
+		return(false);
+	}
+
+	std::string compiledFilename = GetCompiledFilename(sceneFilename);
+	std::ofstream file(compiledFilename.c_str(), std::ios::binary | std::ios::trunc);
+	file.write((const char*)&data[0], data.size());
+	if (file.good() == false)
+	{
+		std::cout << "Could not write compiled scene:" << compiledFilename << std::endl;
+		return(false);
+	}
+
+	const SCENE_HEADER* pHeader = (const SCENE_HEADER*)&data[0];
+	std::cout << "Compiled scene:" << compiledFilename << ", objects:" << pHeader->objectCount << ", materials:" << pHeader->materialCount << ", point lights:" << pHeader->pointLightCount << ", bytes:" << data.size() << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for opening a scene file.  A file
+ *  with the compiled extension is memory mapped and read in
+ *  place, any other file is compiled into memory.
+ ***********************************************************/
+bool SceneFile::Open(const char* filename)
+{
+	Close();
+
+	std::string name(filename);
+	if (GetCompiledFilename(name) == name)
+	{
+		if (m_file.Open(filename) == false)
+		{
+			std::cout << "Compiled scene " << filename << " not found" << std::endl;
+			return(false);
+		}
+		if (ReadHeader(m_file.GetData(), m_file.GetSize()) == false)
+		{
+			std::cout << "Compiled scene " << filename << " is not valid" << std::endl;
+			Close();
+			return(false);
+		}
+		return(true);
+	}
+
+	if (ParseScene(filename, m_compiled) == false)
+	{
+		return(false);
+	}
+	return(ReadHeader(&m_compiled[0], m_compiled.size()));
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for releasing the contents of the
+ *  file.  The tables can not be used afterwards.
+ ***********************************************************/
+void SceneFile::Close()
+{
+	m_file.Close();
+	m_compiled.clear();
+	m_pData = NULL;
+	m_pHeader = NULL;
+}
+
+/***********************************************************
+ *  ReadHeader()
+ *
+ *  This method is used for checking that the contents are a
+ *  compiled scene whose tables all lie inside the file, and
+ *  whose entries only reference strings and tables that
+ *  exist.  Nothing is copied.
+ ***********************************************************/
+bool SceneFile::ReadHeader(const unsigned char* pData, size_t size)
+{
+	if ((NULL == pData) || (size < sizeof(SCENE_HEADER)))
+	{
+		return(false);
+	}
+
+	const SCENE_HEADER* pHeader = (const SCENE_HEADER*)pData;
+	if ((pHeader->magic != g_SceneMagic) || (pHeader->version != g_SceneVersion))
+	{
+		return(false);
+	}
+	if ((IsTableInside(pHeader->textureOffset, pHeader->textureCount, sizeof(TEXTURE_ENTRY), size) == false) ||
+		(IsTableInside(pHeader->materialOffset, pHeader->materialCount, sizeof(UniformBuffers::MATERIAL_DATA), size) == false) ||
+		(IsTableInside(pHeader->materialTagOffset, pHeader->materialCount, sizeof(uint32_t), size) == false) ||
+		(IsTableInside(pHeader->lightOffset, 1, sizeof(UniformBuffers::LIGHTS_DATA), size) == false) ||
+		(IsTableInside(pHeader->pointLightOffset, pHeader->pointLightCount, sizeof(ClusteredLights::POINT_LIGHT), size) == false) ||
+		(IsTableInside(pHeader->objectOffset, pHeader->objectCount, sizeof(OBJECT_ENTRY), size) == false) ||
+		(IsTableInside(pHeader->stringOffset, pHeader->stringSize, 1, size) == false))
+	{
+		return(false);
+	}
+	if ((pHeader->materialCount > (uint32_t)MaterialTable::MAX_MATERIALS) ||
+		(pHeader->pointLightCount > (uint32_t)ClusteredLights::MAX_LIGHTS))
+	{
+		return(false);
+	}
+
+	// every string ends inside the table, so the last byte ends one
+	if ((pHeader->stringSize > 0) && (pData[pHeader->stringOffset + pHeader->stringSize - 1] != '\0'))
+	{
+		return(false);
+	}
+
+	m_pData = pData;
+	m_pHeader = pHeader;
+
+	bool bValid = true;
+	for (int i = 0; i < SKY_FACE_COUNT; i++)
+	{
+		bValid = bValid &&
+			((pHeader->skyFaces[i] == NO_ENTRY) || (pHeader->skyFaces[i] < pHeader->stringSize));
+	}
+	const TEXTURE_ENTRY* pTextures = GetTextures();
+	for (uint32_t i = 0; (bValid == true) && (i < pHeader->textureCount); i++)
+	{
+		bValid = (pTextures[i].tag < pHeader->stringSize) && (pTextures[i].filename < pHeader->stringSize);
+	}
+	const uint32_t* pMaterialTags = GetMaterialTags();
+	for (uint32_t i = 0; (bValid == true) && (i < pHeader->materialCount); i++)
+	{
+		bValid = (pMaterialTags[i] < pHeader->stringSize);
+	}
+	const OBJECT_ENTRY* pObjects = GetObjects();
+	for (uint32_t i = 0; (bValid == true) && (i < pHeader->objectCount); i++)
+	{
+		bValid = (pObjects[i].shape < (uint32_t)InstancedMeshes::SHAPE_COUNT) &&
+			((pObjects[i].texture == NO_ENTRY) || (pObjects[i].texture < pHeader->textureCount)) &&
+			((pObjects[i].material == NO_ENTRY) || (pObjects[i].material < pHeader->materialCount));
+	}
+
+	if (bValid == false)
+	{
+		m_pData = NULL;
+		m_pHeader = NULL;
+	}
+	return(bValid);
+}
+
+/***********************************************************
+ *  GetString()
+ *
+ *  This method is used for getting a string of the string
+ *  table by its offset.
+ ***********************************************************/
+const char* SceneFile::GetString(uint32_t offset) const
+{
+	return((const char*)(m_pData + m_pHeader->stringOffset + offset));
+}
+
+/***********************************************************
+ *  GetTextures()
+ *
+ *  This method is used for getting the texture table.
+ ***********************************************************/
+const SceneFile::TEXTURE_ENTRY* SceneFile::GetTextures() const
+{
+	return((const TEXTURE_ENTRY*)(m_pData + m_pHeader->textureOffset));
+}
+
+/***********************************************************
+ *  GetMaterials()
+ *
+ *  This method is used for getting the material table, in
+ *  the layout of the material block.
+ ***********************************************************/
+const UniformBuffers::MATERIAL_DATA* SceneFile::GetMaterials() const
+{
+	return((const UniformBuffers::MATERIAL_DATA*)(m_pData + m_pHeader->materialOffset));
+}
+
+/***********************************************************
+ *  GetMaterialTags()
+ *
+ *  This method is used for getting the string offsets of
+ *  the material tags.
+ ***********************************************************/
+const uint32_t* SceneFile::GetMaterialTags() const
+{
+	return((const uint32_t*)(m_pData + m_pHeader->materialTagOffset));
+}
+
+/***********************************************************
+ *  GetLights()
+ *
+ *  This method is used for getting the lights of the light
+ *  block, in its layout.
+ ***********************************************************/
+const UniformBuffers::LIGHTS_DATA& SceneFile::GetLights() const
+{
+	return(*(const UniformBuffers::LIGHTS_DATA*)(m_pData + m_pHeader->lightOffset));
+}
+
+/***********************************************************
+ *  GetPointLights()
+ *
+ *  This method is used for getting the clustered lights, in
+ *  the layout of the light storage buffer.
+ ***********************************************************/
+const ClusteredLights::POINT_LIGHT* SceneFile::GetPointLights() const
+{
+	return((const ClusteredLights::POINT_LIGHT*)(m_pData + m_pHeader->pointLightOffset));
+}
+
+/***********************************************************
+ *  GetObjects()
+ *
+ *  This method is used for getting the object table.
+ ***********************************************************/
+const SceneFile::OBJECT_ENTRY* SceneFile::GetObjects() const
+{
+	return((const OBJECT_ENTRY*)(m_pData + m_pHeader->objectOffset));
+}
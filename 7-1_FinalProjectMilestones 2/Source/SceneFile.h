@@ -0,0 +1,141 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.h
+// ============
+// scene descriptions compiled into a binary file that is read in place
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MappedFile.h"
+#include "UniformBuffers.h"
+#include "MaterialTable.h"
+#include "ClusteredLights.h"
+#include "InstancedMeshes.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  SceneFile
+ *
+ *  This class reads the textures, materials, lights and
+ *  objects of a scene from a file instead of the code.  A
+ *  scene is written as a text file with one entry per line
+ *  and compiled offline into a binary file, which holds a
+ *  header, a string table and one fixed size table for every
+ *  kind of entry.  The material table and the clustered
+ *  lights already have the layout of the GPU buffers, so the
+ *  compiled file is memory mapped and its tables are handed
+ *  to the buffers without being parsed or converted.
+ *
+ *  A text file can be opened as well, in which case it is
+ *  compiled into memory first.
+ ***********************************************************/
+class SceneFile
+{
+public:
+	// table index or string offset of an entry that is not set
+	static const uint32_t NO_ENTRY = 0xFFFFFFFF;
+	// number of faces of the sky cubemap
+	static const int SKY_FACE_COUNT = 6;
+
+	// properties at the start of a compiled scene file - every
+	// offset is in bytes from the start of the file
+	struct SCENE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t textureOffset;
+		uint32_t textureCount;
+		// MATERIAL_DATA entries, followed by a string offset with
+		// the tag of each material
+		uint32_t materialOffset;
+		uint32_t materialTagOffset;
+		uint32_t materialCount;
+		// one LIGHTS_DATA with the lights of the light block
+		uint32_t lightOffset;
+		// POINT_LIGHT entries for the clustered lights
+		uint32_t pointLightOffset;
+		uint32_t pointLightCount;
+		uint32_t objectOffset;
+		uint32_t objectCount;
+		// zero terminated strings
+		uint32_t stringOffset;
+		uint32_t stringSize;
+		// string offsets of the cubemap faces - NO_ENTRY without a sky
+		uint32_t skyFaces[SKY_FACE_COUNT];
+	};
+
+	// properties of a texture - string offsets of its tag and file
+	struct TEXTURE_ENTRY
+	{
+		uint32_t tag;
+		uint32_t filename;
+	};
+
+	// properties of an object in the scene
+	struct OBJECT_ENTRY
+	{
+		// InstancedMeshes::SHAPE_ID of the mesh
+		uint32_t shape;
+		// indices into the texture and material tables - NO_ENTRY
+		// for a solid color or no material
+		uint32_t texture;
+		uint32_t material;
+		uint32_t padding;
+		glm::vec4 color;
+		// uv scale in xy
+		glm::vec4 uvScale;
+		// xyz of the transform - w is not used
+		glm::vec4 scaleXYZ;
+		glm::vec4 rotationDegrees;
+		glm::vec4 positionXYZ;
+	};
+
+	// constructor
+	SceneFile();
+	// destructor
+	~SceneFile();
+
+	// get the compiled file name for a scene text file
+	static std::string GetCompiledFilename(const std::string& sceneFilename);
+	// compile a scene text file into a compiled file next to it
+	static bool CompileScene(const char* sceneFilename);
+
+	// open a compiled file, or compile a text file into memory
+	bool Open(const char* filename);
+	// release the contents of the file
+	void Close();
+
+	// access the tables - only valid while the file is open
+	const SCENE_HEADER& GetHeader() const { return *m_pHeader; }
+	const char* GetString(uint32_t offset) const;
+	const TEXTURE_ENTRY* GetTextures() const;
+	const UniformBuffers::MATERIAL_DATA* GetMaterials() const;
+	const uint32_t* GetMaterialTags() const;
+	const UniformBuffers::LIGHTS_DATA& GetLights() const;
+	const ClusteredLights::POINT_LIGHT* GetPointLights() const;
+	const OBJECT_ENTRY* GetObjects() const;
+
+private:
+	// a file can not be shared between two objects
+	SceneFile(const SceneFile&);
+	SceneFile& operator=(const SceneFile&);
+
+	// parse a scene text file into the compiled form
+	static bool ParseScene(const char* sceneFilename, std::vector<unsigned char>& data);
+	// check the header and the bounds of every table
+	bool ReadHeader(const unsigned char* pData, size_t size);
+
+	// mapping of a compiled file
+	MappedFile m_file;
+	// contents compiled from a text file
+	std::vector<unsigned char> m_compiled;
+	const unsigned char* m_pData;
+	const SCENE_HEADER* m_pHeader;
+};
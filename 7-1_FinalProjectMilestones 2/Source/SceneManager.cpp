@@ -16,14 +16,94 @@
 
 #include <glm/gtx/transform.hpp>
 
-// declaration of global variables
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+// declaration of the global variables and defines
 namespace
 {
-	const char* g_ModelName = "model";
-	const char* g_ColorValueName = "objectColor";
-	const char* g_TextureValueName = "objectTexture";
-	const char* g_UseTextureName = "bUseTexture";
-	const char* g_UseLightingName = "bUseLighting";
+	// decoded textures uploaded per frame - keeps frames from hitching
+	const int g_MaxTextureUploadsPerFrame = 2;
+
+	// distance between the synthetic objects of the benchmark grid
+	const float g_SyntheticSpacing = 1.5f;
+	// range of the synthetic lights, and how far past the scene
+	// objects they are spread
+	const float g_SyntheticLightRange = 3.0f;
+	const float g_SyntheticLightMargin = 2.0f;
+
+	// render queue items per job - small scenes stay on one thread
+	const int g_ItemsPerJob = 512;
+
+	// projected sizes, as a fraction of half the view height, below
+	// which an object switches to the next coarser level of detail
+	const float g_LodScreenSizes[InstancedMeshes::LOD_COUNT - 1] = { 0.25f, 0.08f };
+	// fraction past a switch size before an object changes level
+	const float g_DefaultLodHysteresis = 0.15f;
+
+	/***********************************************************
+	 *  SelectLodLevel()
+	 *
+	 *  This function is used to pick the level of detail for a
+	 *  projected size.  Every switch size moves away from the
+	 *  current level by the hysteresis fraction, so an object
+	 *  near a switch keeps its level instead of flickering.
+	 *  The culling shader picks its levels the same way.
+	 ***********************************************************/
+	int SelectLodLevel(float screenSize, int currentLevel, int levelCount, float hysteresis)
+	{
+		int level = 0;
+
+		while ((level + 1) < levelCount)
+		{
+			float threshold = g_LodScreenSizes[level];
+			if (currentLevel > level)
+			{
+				threshold *= (1.0f + hysteresis);
+			}
+			else
+			{
+				threshold *= (1.0f - hysteresis);
+			}
+
+			if (screenSize >= threshold)
+			{
+				break;
+			}
+			level++;
+		}
+
+		return(level);
+	}
+
+	/***********************************************************
+	 *  NextRandom()
+	 *
+	 *  This function is used to step a linear congruential
+	 *  generator and return a value between 0 and 1.  It gives
+	 *  the same sequence on every platform, unlike the standard
+	 *  library distributions.
+	 ***********************************************************/
+	float NextRandom(unsigned int& state)
+	{
+		state = state * 1664525u + 1013904223u;
+		return((float)(state >> 8) / 16777216.0f);
+	}
+
+	/***********************************************************
+	 *  IsBatchNearer()
+	 *
+	 *  This function is used to compare instanced batches by
+	 *  the view depth of their nearest instance.
+	 ***********************************************************/
+	bool IsBatchNearer(
+		const SceneManager::INSTANCE_BATCH& a,
+		const SceneManager::INSTANCE_BATCH& b)
+	{
+		return(a.depth < b.depth);
+	}
 }
 
 /***********************************************************
@@ -31,18 +111,59 @@ namespace
  *
  *  The constructor for the class
  ***********************************************************/
-SceneManager::SceneManager(ShaderManager *pShaderManager)
+SceneManager::SceneManager(
+	ShaderManager *pShaderManager,
+	ShaderUniforms *pShaderUniforms,
+	UniformBuffers *pUniformBuffers)
 {
 	m_pShaderManager = pShaderManager;
-	m_basicMeshes = new ShapeMeshes();
-
-	// initialize the texture collection
-	for (int i = 0; i < 16; i++)
-	{
-		m_textureIDs[i].tag = "/0";
-		m_textureIDs[i].ID = -1;
-	}
-	m_loadedTextures = 0;
+	m_pShaderUniforms = pShaderUniforms;
+	m_pUniformBuffers = pUniformBuffers;
+	m_basicMeshes.reset(new ShapeMeshes());
+
+	// textures are drawn by index, bindless when the driver allows
+	m_pTextureResidency.reset(new TextureResidency());
+	m_pTextureResidency->Initialize(m_pUniformBuffers);
+	m_pTextureLoader.reset(new TextureLoader());
+	m_indexedMaterials = 0;
+	// the materials are kept once and selected by index
+	m_pMaterialTable.reset(new MaterialTable());
+	m_pMaterialTable->Initialize(m_pUniformBuffers);
+	// cooked textures are block compressed with S3TC
+	m_pTextureLoader->SetUseCookedTextures(GLEW_EXT_texture_compression_s3tc == GL_TRUE);
+
+	m_bRenderQueueDirty = false;
+	ResetShaderState();
+	m_bInstancingEnabled = false;
+	m_bFrustumValid = false;
+	m_bCullingEnabled = true;
+	m_lodDepthRow = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	m_lodScale = 0.0f;
+	m_lodHysteresis = g_DefaultLodHysteresis;
+	m_viewDepthRow = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
+	m_visibleObjects = 0;
+	m_bDepthPrepassEnabled = true;
+	m_opaqueBatchCount = 0;
+	m_pJobSystem.reset(new JobSystem(0));
+	m_bGpuCullingEnabled = true;
+	m_bGpuSceneDirty = true;
+	m_gpuOpaqueCommands = 0;
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
+	m_viewIndex = 0;
+	m_bClusteredLightsDirty = false;
+	m_shadowCascadeCount = ShadowMaps::CASCADE_COUNT;
+	m_directionalLightDirection = glm::vec3(0.0f, -1.0f, 0.0f);
+	m_bShadowCastersDirty = true;
+	m_bEnvironmentDrawn = false;
+	m_sceneFileFirstObject = 0;
+	m_sceneFileObjectCount = 0;
+	m_sceneFileFirstLight = 0;
+	m_sceneFileLightCount = 0;
+	memset(&m_sceneFileLights, 0, sizeof(m_sceneFileLights));
+	m_pHotReload = NULL;
+	m_pFrameProfiler = NULL;
+	BuildMeshBounds();
 }
 
 /***********************************************************
@@ -52,13 +173,22 @@ SceneManager::SceneManager(ShaderManager *pShaderManager)
  ***********************************************************/
 SceneManager::~SceneManager()
 {
-	// free the allocated objects
+	// free the allocated objects - the owned ones are freed here
+	// rather than by the member destructors, in the order they need
 	m_pShaderManager = NULL;
-	if (NULL != m_basicMeshes)
-	{
-		delete m_basicMeshes;
-		m_basicMeshes = NULL;
-	}
+	m_pShaderUniforms = NULL;
+	m_pUniformBuffers = NULL;
+	m_basicMeshes.reset();
+	m_pGpuCulling.reset();
+	m_pClusteredLights.reset();
+	m_pShadowMaps.reset();
+	m_pSkybox.reset();
+	m_pInstancedMeshes.reset();
+	m_pJobSystem.reset();
+	// stop decoding before the textures are freed
+	m_pTextureLoader.reset();
+	m_pTextureResidency.reset();
+	m_pMaterialTable.reset();
 
 	// free the allocated OpenGL textures
 	DestroyGLTextures();
@@ -67,90 +197,209 @@ SceneManager::~SceneManager()
 /***********************************************************
  *  CreateGLTexture()
  *
- *  This method is used for loading textures from image files,
- *  configuring the texture mapping parameters in OpenGL,
- *  generating the mipmaps, and loading the read texture into
- *  the next available texture slot in memory.
- ***********************************************************/
-bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
-{
-	int width = 0;
-	int height = 0;
-	int colorChannels = 0;
-	GLuint textureID = 0;
-
-	// indicate to always flip images vertically when loaded
-	stbi_set_flip_vertically_on_load(true);
-
-	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
-		filename,
-		&width,
-		&height,
-		&colorChannels,
-		0);
-
-	// if the image was successfully read from the image file
-	if (image)
-	{
-		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
-
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
+ *  This method is used for creating a texture with the next
+ *  texture index and queueing its image file to be decoded
+ *  on a worker thread.  A cooked texture next to the image
+ *  file is read in its place when there is one.  The draws
+ *  show a placeholder until UpdateTextureLoads() uploads
+ *  the real image.
+ ***********************************************************/
+bool SceneManager::CreateGLTexture(const char* filename, const std::string& tag)
+{
+	// the texture object is only created once the size of the
+	// image is known
+	int textureIndex = m_pTextureResidency->AddTexture(0);
+	if (textureIndex < 0)
+	{
+		std::cout << "No texture index left for image:" << filename << std::endl;
+		return false;
+	}
+
+	// register the texture and associate it with the special tag
+	// string - the index is usable right away
+	TEXTURE_INFO texture;
+	texture.tag = tag;
+	memset(&texture.format, 0, sizeof(texture.format));
+	texture.filename = filename;
+	m_textureIDs.push_back(std::move(texture));
+	// the first texture with a tag keeps it
+	m_textureIndices.insert(std::make_pair(tag, textureIndex));
+	m_pTextureLoader->Request(filename, textureIndex);
+	WatchTexture(textureIndex);
+
+	return true;
+}
+
+/***********************************************************
+ *  WatchTexture()
+ *
+ *  This method is used for reloading a texture whenever its
+ *  image file is written.
+ ***********************************************************/
+void SceneManager::WatchTexture(int textureIndex)
+{
+	if (NULL == m_pHotReload)
+	{
+		return;
+	}
+
+	int watchIndex = m_pHotReload->AddWatch([this, textureIndex]() { ReloadTexture(textureIndex); });
+	m_pHotReload->AddFile(watchIndex, m_textureIDs[textureIndex].filename);
+}
+
+/***********************************************************
+ *  ReloadTexture()
+ *
+ *  This method is used for decoding the image file of a
+ *  texture again on a worker thread.  The draws keep the old
+ *  image until UploadGLTexture() swaps the new one in.
+ ***********************************************************/
+void SceneManager::ReloadTexture(int textureIndex)
+{
+	m_pTextureLoader->Request(m_textureIDs[textureIndex].filename, textureIndex);
+}
+
+/***********************************************************
+ *  UploadGLTexture()
+ *
+ *  This method is used for copying a decoded image into a
+ *  texture of its size from the texture pool and generating
+ *  the mipmaps, or for copying the levels of a cooked texture
+ *  as they are.  The texture then replaces the placeholder,
+ *  or the texture shown before the image was reloaded.
+ ***********************************************************/
+bool SceneManager::UploadGLTexture(TextureLoader::DECODED_IMAGE& image)
+{
+	// if the image could not be read, the placeholder is kept
+	if (NULL == image.pixels)
+	{
+		std::cout << "Could not load image:" << image.filename << std::endl;
+		return false;
+	}
+
+	std::cout << "Successfully loaded image:" << image.filename << ", width:" << image.width << ", height:" << image.height << ", channels:" << image.colorChannels << std::endl;
+
+	TexturePool::TEXTURE_FORMAT format;
+	if (NULL != image.pCookedFile)
+	{
+		format.internalFormat = image.cooked.format;
+		format.width = (int)image.cooked.mips[0].width;
+		format.height = (int)image.cooked.mips[0].height;
+		format.levels = (int)image.cooked.mips.size();
+	}
+	// if the loaded image is in RGB format, or in RGBA format,
+	// which supports transparency
+	else if ((image.colorChannels == 3) || (image.colorChannels == 4))
+	{
+		format.internalFormat = (image.colorChannels == 3) ? GL_RGB8 : GL_RGBA8;
+		format.width = image.width;
+		format.height = image.height;
+		format.levels = TexturePool::GetMipLevels(image.width, image.height);
+	}
+	else
+	{
+		std::cout << "Not implemented to handle image with " << image.colorChannels << " channels" << std::endl;
+		TextureLoader::FreeImage(image);
+		return false;
+	}
+
+	// a texture that is already shown keeps its object until the
+	// new one is filled
+	glActiveTexture(GL_TEXTURE0 + TextureResidency::TEXTURE_UNIT);
+	GpuTexture texture = m_texturePool.Acquire(format);
+	m_pTextureResidency->InvalidateBinding();
+
+	// cooked textures already hold every compressed mip level
+	if (NULL != image.pCookedFile)
+	{
+		const std::vector<TextureCooker::COOKED_MIP>& mips = image.cooked.mips;
+		for (size_t level = 0; level < mips.size(); level++)
 		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
-			return false;
+			glCompressedTexSubImage2D(
+				GL_TEXTURE_2D,
+				(GLint)level,
+				0,
+				0,
+				mips[level].width,
+				mips[level].height,
+				image.cooked.format,
+				mips[level].size,
+				image.pixels + mips[level].offset);
 		}
+	}
+	else
+	{
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width, image.height,
+			(image.colorChannels == 3) ? GL_RGB : GL_RGBA, GL_UNSIGNED_BYTE, image.pixels);
 
 		// generate the texture mipmaps for mapping textures to lower resolutions
 		glGenerateMipmap(GL_TEXTURE_2D);
+	}
 
-		// free the image data from local memory
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+	// free the image data from local memory
+	TextureLoader::FreeImage(image);
+	FinishTextureUpload(image.textureIndex, texture, format);
 
-		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
+	return true;
+}
 
-		return true;
-	}
+/***********************************************************
+ *  FinishTextureUpload()
+ *
+ *  This method is used for showing a texture once its image
+ *  is uploaded.  The texture takes the place of the one the
+ *  index showed before, which goes back to the texture pool
+ *  once its bindless handle is released.
+ ***********************************************************/
+void SceneManager::FinishTextureUpload(
+	int textureIndex,
+	GpuTexture& texture,
+	const TexturePool::TEXTURE_FORMAT& format)
+{
+	TEXTURE_INFO& textureInfo = m_textureIDs[textureIndex];
+
+	m_pTextureResidency->ReplaceTexture(textureIndex, texture);
 
-	std::cout << "Could not load image:" << filename << std::endl;
+	GpuTexture oldTexture = std::move(textureInfo.texture);
+	TexturePool::TEXTURE_FORMAT oldFormat = textureInfo.format;
+	textureInfo.texture = std::move(texture);
+	textureInfo.format = format;
+	m_texturePool.Recycle(oldTexture, oldFormat);
+}
+
+/***********************************************************
+ *  UpdateTextureLoads()
+ *
+ *  This method is used for uploading the textures that have
+ *  finished decoding.  Only a few are uploaded per frame.
+ ***********************************************************/
+void SceneManager::UpdateTextureLoads()
+{
+	TextureLoader::DECODED_IMAGE image;
+	int uploads = 0;
 
-	// Error loading the image
-	return false;
+	while ((uploads < g_MaxTextureUploadsPerFrame) &&
+		(m_pTextureLoader->PopDecoded(image) == true))
+	{
+		UploadGLTexture(image);
+		uploads++;
+	}
 }
 
 /***********************************************************
- *  BindGLTextures()
+ *  FinishTextureLoads()
  *
- *  This method is used for binding the loaded textures to
- *  OpenGL texture memory slots.  There are up to 16 slots.
+ *  This method is used for waiting on every requested
+ *  texture and uploading it, for when the scene must be
+ *  complete before the first frame.
  ***********************************************************/
-void SceneManager::BindGLTextures()
+void SceneManager::FinishTextureLoads()
 {
-	for (int i = 0; i < m_loadedTextures; i++)
+	TextureLoader::DECODED_IMAGE image;
+
+	while (m_pTextureLoader->WaitDecoded(image) == true)
 	{
-		// bind textures on corresponding texture units
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
+		UploadGLTexture(image);
 	}
 }
 
@@ -158,14 +407,19 @@ void SceneManager::BindGLTextures()
  *  DestroyGLTextures()
  *
  *  This method is used for freeing the memory in all the
- *  used texture memory slots.
+ *  used texture memory slots, and the textures the pool
+ *  kept for reuse.  The bindless handles must already be
+ *  released.
  ***********************************************************/
 void SceneManager::DestroyGLTextures()
 {
-	for (int i = 0; i < m_loadedTextures; i++)
+	for (size_t i = 0; i < m_textureIDs.size(); i++)
 	{
-		glGenTextures(1, &m_textureIDs[i].ID);
+		m_textureIDs[i].texture.Destroy();
 	}
+	m_textureIDs.clear();
+	m_textureIndices.clear();
+	m_texturePool.Clear();
 }
 
 /***********************************************************
@@ -174,50 +428,36 @@ void SceneManager::DestroyGLTextures()
  *  This method is used for getting an ID for the previously
  *  loaded texture bitmap associated with the passed in tag.
  ***********************************************************/
-int SceneManager::FindTextureID(std::string tag)
+int SceneManager::FindTextureID(const std::string& tag)
 {
 	int textureID = -1;
-	int index = 0;
-	bool bFound = false;
+	int index = FindTextureIndex(tag);
 
-	while ((index < m_loadedTextures) && (bFound == false))
+	if (index >= 0)
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureID = m_textureIDs[index].ID;
-			bFound = true;
-		}
-		else
-			index++;
+		textureID = (int)m_textureIDs[index].texture.Get();
 	}
 
 	return(textureID);
 }
 
 /***********************************************************
- *  FindTextureSlot()
+ *  FindTextureIndex()
  *
- *  This method is used for getting a slot index for the previously
+ *  This method is used for getting the index of the previously
  *  loaded texture bitmap associated with the passed in tag.
+ *  The tags are interned when the textures are created.
  ***********************************************************/
-int SceneManager::FindTextureSlot(std::string tag)
+int SceneManager::FindTextureIndex(const std::string& tag)
 {
-	int textureSlot = -1;
-	int index = 0;
-	bool bFound = false;
+	std::unordered_map<std::string, int>::const_iterator found = m_textureIndices.find(tag);
 
-	while ((index < m_loadedTextures) && (bFound == false))
+	if (found == m_textureIndices.end())
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureSlot = index;
-			bFound = true;
-		}
-		else
-			index++;
+		return(-1);
 	}
 
-	return(textureSlot);
+	return(found->second);
 }
 
 /***********************************************************
@@ -226,31 +466,62 @@ int SceneManager::FindTextureSlot(std::string tag)
  *  This method is used for getting a material from the previously
  *  defined materials list that is associated with the passed in tag.
  ***********************************************************/
-bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
+bool SceneManager::FindMaterial(const std::string& tag, OBJECT_MATERIAL& material)
 {
-	if (m_objectMaterials.size() == 0)
+	int index = FindMaterialIndex(tag);
+
+	if (index < 0)
 	{
 		return(false);
 	}
 
-	int index = 0;
-	bool bFound = false;
-	while ((index < m_objectMaterials.size()) && (bFound == false))
+	material.diffuseColor = m_objectMaterials[index].diffuseColor;
+	material.specularColor = m_objectMaterials[index].specularColor;
+	material.shininess = m_objectMaterials[index].shininess;
+
+	return(true);
+}
+
+/***********************************************************
+ *  FindMaterialIndex()
+ *
+ *  This method is used for getting the index of a material
+ *  in the previously defined materials list that is
+ *  associated with the passed in tag.  -1 is returned when
+ *  no material has the tag.
+ ***********************************************************/
+int SceneManager::FindMaterialIndex(const std::string& tag)
+{
+	// materials pushed since the last lookup still need their tags
+	if (m_indexedMaterials != m_objectMaterials.size())
 	{
-		if (m_objectMaterials[index].tag.compare(tag) == 0)
-		{
-			bFound = true;
-			material.diffuseColor = m_objectMaterials[index].diffuseColor;
-			material.specularColor = m_objectMaterials[index].specularColor;
-			material.shininess = m_objectMaterials[index].shininess;
-		}
-		else
-		{
-			index++;
-		}
+		IndexObjectMaterials();
 	}
 
-	return(true);
+	std::unordered_map<std::string, int>::const_iterator found = m_materialIndices.find(tag);
+
+	if (found == m_materialIndices.end())
+	{
+		return(-1);
+	}
+
+	return(found->second);
+}
+
+/***********************************************************
+ *  IndexObjectMaterials()
+ *
+ *  This method is used for interning the tags of the
+ *  materials added to the list since the last call.  The
+ *  first material with a tag keeps it.
+ ***********************************************************/
+void SceneManager::IndexObjectMaterials()
+{
+	for (size_t i = m_indexedMaterials; i < m_objectMaterials.size(); i++)
+	{
+		m_materialIndices.insert(std::make_pair(m_objectMaterials[i].tag, (int)i));
+	}
+	m_indexedMaterials = m_objectMaterials.size();
 }
 
 /***********************************************************
@@ -266,28 +537,48 @@ void SceneManager::SetTransformations(
 	float ZrotationDegrees,
 	glm::vec3 positionXYZ)
 {
-	// variables for this method
-	glm::mat4 modelView;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
-
-	// set the scale value in the transform buffer
-	scale = glm::scale(scaleXYZ);
-	// set the rotation values in the transform buffer
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-	// set the translation value in the transform buffer
-	translation = glm::translate(positionXYZ);
+	SetTransformMatrix(
+		BuildModelMatrix(
+			scaleXYZ,
+			XrotationDegrees,
+			YrotationDegrees,
+			ZrotationDegrees,
+			positionXYZ));
+}
 
-	modelView = translation * rotationZ * rotationY * rotationX * scale;
+/***********************************************************
+ *  BuildModelMatrix()
+ *
+ *  This method is used for building the model matrix from
+ *  the passed in transformation values.  The matrix is the
+ *  translation * rotation Z * rotation Y * rotation X *
+ *  scale, written out directly instead of multiplying a
+ *  matrix for each part.
+ ***********************************************************/
+glm::mat4 SceneManager::BuildModelMatrix(
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	return(TransformBatch::ComposeMatrix(
+		scaleXYZ,
+		glm::vec3(XrotationDegrees, YrotationDegrees, ZrotationDegrees),
+		positionXYZ));
+}
 
-	if (NULL != m_pShaderManager)
+/***********************************************************
+ *  SetTransformMatrix()
+ *
+ *  This method is used for setting an already built model
+ *  matrix into the transform buffer.
+ ***********************************************************/
+void SceneManager::SetTransformMatrix(const glm::mat4& modelView)
+{
+	if (NULL != m_pShaderUniforms)
 	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
+		m_pShaderUniforms->SetMat4(ShaderUniforms::MODEL, modelView);
 	}
 }
 
@@ -311,10 +602,10 @@ void SceneManager::SetShaderColor(
 	currentColor.b = blueColorValue;
 	currentColor.a = alphaValue;
 
-	if (NULL != m_pShaderManager)
+	if (NULL != m_pShaderUniforms)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
+		m_pShaderUniforms->SetInt(ShaderUniforms::USE_TEXTURE, false);
+		m_pShaderUniforms->SetVec4(ShaderUniforms::OBJECT_COLOR, currentColor);
 	}
 }
 
@@ -322,18 +613,25 @@ void SceneManager::SetShaderColor(
  *  SetShaderTexture()
  *
  *  This method is used for setting the texture data
- *  associated with the passed in ID into the shader.
+ *  associated with the passed in tag, or with the passed in
+ *  texture index, into the shader.  The texture is bound to
+ *  the texture unit the sampler reads.
  ***********************************************************/
 void SceneManager::SetShaderTexture(
-	std::string textureTag)
+	const std::string& textureTag)
 {
-	if (NULL != m_pShaderManager)
+	SetShaderTexture(FindTextureIndex(textureTag));
+}
+
+void SceneManager::SetShaderTexture(
+	int textureIndex)
+{
+	if (NULL != m_pShaderUniforms)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
+		m_pShaderUniforms->SetInt(ShaderUniforms::USE_TEXTURE, true);
 
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
+		m_pTextureResidency->BindTexture(textureIndex);
+		m_pShaderUniforms->SetInt(ShaderUniforms::OBJECT_TEXTURE, TextureResidency::TEXTURE_UNIT);
 	}
 }
 
@@ -345,9 +643,9 @@ void SceneManager::SetShaderTexture(
  ***********************************************************/
 void SceneManager::SetTextureUVScale(float u, float v)
 {
-	if (NULL != m_pShaderManager)
+	if (NULL != m_pShaderUniforms)
 	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
+		m_pShaderUniforms->SetVec2(ShaderUniforms::UV_SCALE, glm::vec2(u, v));
 	}
 }
 
@@ -358,400 +656,2539 @@ void SceneManager::SetTextureUVScale(float u, float v)
  *  into the shader.
  ***********************************************************/
 void SceneManager::SetShaderMaterial(
-	std::string materialTag)
+	const std::string& materialTag)
 {
-	if (m_objectMaterials.size() > 0)
+	int materialIndex = FindMaterialIndex(materialTag);
+	if (materialIndex >= 0)
 	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
-
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
-		{
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
-		}
+		SetMaterialValues(materialIndex);
 	}
 }
 
-/**************************************************************/
-/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
-/*** preparing and rendering their own 3D replicated scenes.***/
-/*** Please refer to the code in the OpenGL sample project  ***/
-/*** for assistance.                                        ***/
-/**************************************************************/
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for drawing the basic mesh of the
+ *  passed in type with the current shader settings.
+ ***********************************************************/
+void SceneManager::DrawMesh(MESH_TYPE mesh)
+{
+	FrameProfiler::CountDrawCall();
 
- /***********************************************************
-  *  LoadSceneTextures()
-  *
-  *  This method is used for preparing the 3D scene by loading
-  *  the shapes, textures in memory to support the 3D scene
-  *  rendering
-  ***********************************************************/
+	switch (mesh)
+	{
+	case MESH_PLANE:
+		m_basicMeshes->DrawPlaneMesh();
+		break;
+	case MESH_BOX:
+		m_basicMeshes->DrawBoxMesh();
+		break;
+	case MESH_CONE:
+		m_basicMeshes->DrawConeMesh();
+		break;
+	case MESH_CYLINDER:
+		m_basicMeshes->DrawCylinderMesh();
+		break;
+	case MESH_PYRAMID3:
+		m_basicMeshes->DrawPyramid3Mesh();
+		break;
+	case MESH_SPHERE:
+		m_basicMeshes->DrawSphereMesh();
+		break;
+	case MESH_TAPERED_CYLINDER:
+		m_basicMeshes->DrawTaperedCylinderMesh();
+		break;
+	default:
+		break;
+	}
+}
 
-void SceneManager::LoadSceneTextures()
+/***********************************************************
+ *  DrawMeshInstanced()
+ *
+ *  This method is used for drawing count copies of the basic
+ *  mesh of the passed in type at a level of detail with one
+ *  instanced draw call, reading firstInstance onward from
+ *  the instance buffer.
+ ***********************************************************/
+void SceneManager::DrawMeshInstanced(MESH_TYPE mesh, int count, int firstInstance, int lodLevel)
 {
-	/*** STUDENTS - add the code BELOW for loading the textures that ***/
-	/*** will be used for mapping to objects in the 3D scene. Up to  ***/
-	/*** 16 textures can be loaded per scene. Refer to the code in   ***/
-	/*** the OpenGL Sample for help.                                 ***/
+	switch (mesh)
+	{
+	case MESH_PLANE:
+		m_pInstancedMeshes->DrawPlaneMeshInstanced(count, firstInstance, lodLevel);
+		break;
+	case MESH_BOX:
+		m_pInstancedMeshes->DrawBoxMeshInstanced(count, firstInstance, lodLevel);
+		break;
+	case MESH_CONE:
+		m_pInstancedMeshes->DrawConeMeshInstanced(count, firstInstance, lodLevel);
+		break;
+	case MESH_CYLINDER:
+		m_pInstancedMeshes->DrawCylinderMeshInstanced(count, firstInstance, lodLevel);
+		break;
+	case MESH_PYRAMID3:
+		m_pInstancedMeshes->DrawPyramid3MeshInstanced(count, firstInstance, lodLevel);
+		break;
+	case MESH_SPHERE:
+		m_pInstancedMeshes->DrawSphereMeshInstanced(count, firstInstance, lodLevel);
+		break;
+	case MESH_TAPERED_CYLINDER:
+		m_pInstancedMeshes->DrawTaperedCylinderMeshInstanced(count, firstInstance, lodLevel);
+		break;
+	default:
+		break;
+	}
+}
 
-	bool bReturn = false;
+/***********************************************************
+ *  GetInstancedShape()
+ *
+ *  This method is used for getting the shape of the shared
+ *  instanced buffers that draws a basic mesh.
+ ***********************************************************/
+InstancedMeshes::SHAPE_ID SceneManager::GetInstancedShape(MESH_TYPE mesh)
+{
+	switch (mesh)
+	{
+	case MESH_PLANE:
+		return(InstancedMeshes::SHAPE_PLANE);
+	case MESH_BOX:
+		return(InstancedMeshes::SHAPE_BOX);
+	case MESH_CONE:
+		return(InstancedMeshes::SHAPE_CONE);
+	case MESH_CYLINDER:
+		return(InstancedMeshes::SHAPE_CYLINDER);
+	case MESH_PYRAMID3:
+		return(InstancedMeshes::SHAPE_PYRAMID3);
+	case MESH_TAPERED_CYLINDER:
+		return(InstancedMeshes::SHAPE_TAPERED_CYLINDER);
+	case MESH_SPHERE:
+	default:
+		return(InstancedMeshes::SHAPE_SPHERE);
+	}
+}
 
-	/**this part of the code loads the image textures from textures folder into the scene allowing
-	the floor to be ground, eraser pink texture, wood for the pencil texture, roof for the cone to 
-	be colored and nightsky for background. **/
+/***********************************************************
+ *  GetMeshType()
+ *
+ *  This method is used for getting the basic mesh that an
+ *  instanced shape draws, for objects read from a file.
+ ***********************************************************/
+SceneManager::MESH_TYPE SceneManager::GetMeshType(InstancedMeshes::SHAPE_ID shape)
+{
+	switch (shape)
+	{
+	case InstancedMeshes::SHAPE_PLANE:
+		return(MESH_PLANE);
+	case InstancedMeshes::SHAPE_BOX:
+		return(MESH_BOX);
+	case InstancedMeshes::SHAPE_CONE:
+		return(MESH_CONE);
+	case InstancedMeshes::SHAPE_CYLINDER:
+		return(MESH_CYLINDER);
+	case InstancedMeshes::SHAPE_PYRAMID3:
+		return(MESH_PYRAMID3);
+	case InstancedMeshes::SHAPE_TAPERED_CYLINDER:
+		return(MESH_TAPERED_CYLINDER);
+	case InstancedMeshes::SHAPE_SPHERE:
+	default:
+		return(MESH_SPHERE);
+	}
+}
 
-	bReturn = CreateGLTexture(
-		"textures/wood.jpg", "wood");
+/***********************************************************
+ *  UpdateModelMatrix()
+ *
+ *  This method is used for rebuilding the cached model
+ *  matrix and world space bounding sphere of an object, but
+ *  only after the object has moved.  The moved objects are
+ *  normally rebuilt together by UpdateMovedObjects() at
+ *  the start of the frame, which leaves nothing to do here.
+ ***********************************************************/
+void SceneManager::UpdateModelMatrix(SCENE_OBJECT& sceneObject)
+{
+	if (sceneObject.bDirty == false)
+	{
+		return;
+	}
 
-	bReturn = CreateGLTexture(
-		"textures/ground.jpg", "ground");
-	bReturn = CreateGLTexture(
-		"textures/eraser.jpg", "eraser");
-	bReturn = CreateGLTexture(
-		"textures/roof.jpg", "roof");
-	bReturn = CreateGLTexture(
-		"textures/nightsky.jpg", "nightsky");
-	
+	sceneObject.modelMatrix = BuildModelMatrix(
+		sceneObject.scaleXYZ,
+		sceneObject.rotationDegrees.x,
+		sceneObject.rotationDegrees.y,
+		sceneObject.rotationDegrees.z,
+		sceneObject.positionXYZ);
+	UpdateObjectBounds(sceneObject);
 
+	sceneObject.bDirty = false;
+}
 
-	// after the texture image data is loaded into memory, the
-	// loaded textures need to be bound to texture slots - there
-	// are a total of 16 available slots for scene textures
-	BindGLTextures();
+/***********************************************************
+ *  UpdateObjectBounds()
+ *
+ *  This method is used for rebuilding the world space
+ *  bounding sphere of an object from its model matrix.
+ ***********************************************************/
+void SceneManager::UpdateObjectBounds(SCENE_OBJECT& sceneObject)
+{
+	glm::vec3 localCenter;
+	float localRadius = 0.0f;
+
+	// the sphere grows with the largest scale of the three axes
+	GetMeshBounds(sceneObject.mesh, localCenter, localRadius);
+	sceneObject.boundsCenter = glm::vec3(sceneObject.modelMatrix * glm::vec4(localCenter, 1.0f));
+	sceneObject.boundsRadius = localRadius * glm::max(
+		glm::length(glm::vec3(sceneObject.modelMatrix[0])),
+		glm::max(
+			glm::length(glm::vec3(sceneObject.modelMatrix[1])),
+			glm::length(glm::vec3(sceneObject.modelMatrix[2]))));
 }
 
 /***********************************************************
- *  DefineObjectMaterials()
+ *  UpdateMovedObjects()
  *
- *  This method is used for configuring the various material
- *  settings for all of the objects within the 3D scene.
+ *  This method is used for rebuilding the model matrices of
+ *  the objects that moved since the last frame.  Their
+ *  transforms are gathered into the streams of the batch,
+ *  and jobs on all of the cores build the matrices four at
+ *  a time and update the bounding spheres.  An object that
+ *  was already rebuilt on its own, or is listed twice, is
+ *  only gathered while it is still dirty.
  ***********************************************************/
-void SceneManager::DefineObjectMaterials()
+void SceneManager::UpdateMovedObjects()
 {
-	//allows for the materials to be able to reflect light off of them. 
-	OBJECT_MATERIAL goldMaterial;
-	goldMaterial.diffuseColor = glm::vec3(0.4f, 0.4f, 0.4f);
-	goldMaterial.specularColor = glm::vec3(0.7f, 0.7f, 0.6f);
-	goldMaterial.shininess = 52.0;
-	goldMaterial.tag = "metal";
+	if (m_movedObjects.empty() == true)
+	{
+		return;
+	}
 
-	m_objectMaterials.push_back(goldMaterial);
+	size_t movedCount = 0;
+	m_transformBatch.Clear();
+	for (size_t i = 0; i < m_movedObjects.size(); i++)
+	{
+		int objectIndex = m_movedObjects[i];
+		if ((objectIndex < 0) || (objectIndex >= (int)m_sceneObjects.size()) ||
+			(m_sceneObjects[objectIndex].bDirty == false))
+		{
+			continue;
+		}
 
-	OBJECT_MATERIAL woodMaterial;
-	woodMaterial.diffuseColor = glm::vec3(0.2f, 0.2f, 0.3f);
-	woodMaterial.specularColor = glm::vec3(0.0f, 0.0f, 0.0f);
-	woodMaterial.shininess = 0.1;
-	woodMaterial.tag = "wood";
+		SCENE_OBJECT& sceneObject = m_sceneObjects[objectIndex];
+		m_transformBatch.Add(sceneObject.scaleXYZ, sceneObject.rotationDegrees, sceneObject.positionXYZ);
+		sceneObject.bDirty = false;
+		m_movedObjects[movedCount++] = objectIndex;
+	}
+	m_movedObjects.resize(movedCount);
+	m_movedMatrices.resize(movedCount);
+
+	// the job ranges are a multiple of four objects, so only the
+	// last job builds matrices one at a time
+	m_pJobSystem->ParallelFor(
+		(int)movedCount,
+		g_ItemsPerJob,
+		[this](int /*jobIndex*/, int begin, int end)
+		{
+			m_transformBatch.Compute(begin, end, &m_movedMatrices[begin]);
+			for (int i = begin; i < end; i++)
+			{
+				SCENE_OBJECT& sceneObject = m_sceneObjects[m_movedObjects[i]];
+				sceneObject.modelMatrix = m_movedMatrices[i];
+				UpdateObjectBounds(sceneObject);
+			}
+		});
+
+	m_movedObjects.clear();
+}
 
-	m_objectMaterials.push_back(woodMaterial);
+/***********************************************************
+ *  GetMeshBounds()
+ *
+ *  This method is used for getting the bounding sphere of a
+ *  basic mesh in its own local space.
+ ***********************************************************/
+void SceneManager::GetMeshBounds(MESH_TYPE mesh, glm::vec3& center, float& radius) const
+{
+	InstancedMeshes::SHAPE_ID shape = GetInstancedShape(mesh);
 
-	OBJECT_MATERIAL glassMaterial;
-	glassMaterial.diffuseColor = glm::vec3(0.2f, 0.2f, 0.2f);
-	glassMaterial.specularColor = glm::vec3(1.0f, 1.0f, 1.0f);
-	glassMaterial.shininess = 95.0;
-	glassMaterial.tag = "glass";
+	center = m_meshBoundsCenters[shape];
+	radius = m_meshBoundsRadii[shape];
 }
 
 /***********************************************************
- *  SetupSceneLights()
+ *  BuildMeshBounds()
  *
- *  This method is called to add and configure the light
- *  sources for the 3D scene.  There are up to 4 light sources.
+ *  This method is used for measuring the bounding spheres of
+ *  the basic meshes from their vertices.  The instanced
+ *  draws upload this same geometry, and ShapeGeometry builds
+ *  it with the unit sizes of ShapeMeshes, which draws the
+ *  objects one at a time but keeps its vertices private.
+ *  The coarser levels of detail only drop vertices, so they
+ *  stay inside the spheres of the full shapes.
  ***********************************************************/
-void SceneManager::SetupSceneLights()
+void SceneManager::BuildMeshBounds()
 {
-	// this line of code is NEEDED for telling the shaders to render 
-	// the 3D scene with custom lighting - to use the default rendered 
-	// lighting then comment out the following line
-	m_pShaderManager->setBoolValue(g_UseLightingName, true);
-
-	// My main directional light for high exposure daylight
-	m_pShaderManager->setVec3Value("directionalLight.direction", -0.1f, -1.0f, -0.1f);
-	m_pShaderManager->setVec3Value("directionalLight.ambient", 0.8f, 0.8f, 0.8f);    // Very bright ambient light
-	m_pShaderManager->setVec3Value("directionalLight.diffuse", 1.5f, 1.5f, 1.5f);    // Intense diffuse light
-	m_pShaderManager->setVec3Value("directionalLight.specular", 1.5f, 1.5f, 1.5f);   // High specular highlights
-	m_pShaderManager->setBoolValue("directionalLight.bActive", true);
-
-	//secondary directional light
-	m_pShaderManager->setVec3Value("directionalLight.direction", -0.1f, -1.0f, -0.1f);
-	m_pShaderManager->setVec3Value("directionalLight.ambient", 1.08f, 1.08f, 1.08f);  // ambient light
-	m_pShaderManager->setVec3Value("directionalLight.diffuse", 2.25f, 2.25f, 2.25f);  // diffuse light
-	m_pShaderManager->setVec3Value("directionalLight.specular", 1.98f, 1.98f, 1.98f); // specular highlights
-	m_pShaderManager->setBoolValue("directionalLight.bActive", true);
+	ShapeGeometry::MESH_DATA meshData[InstancedMeshes::SHAPE_COUNT];
 
-	//I wanted to add a purple color to the scene I had to make it a little darker for purple light to be seen.
-	m_pShaderManager->setVec3Value("pointLights[1].position", 5.0f, 5.0f, 3.0f);
-	m_pShaderManager->setVec3Value("pointLights[1].ambient", 0.08f, 0.0f, 0.12f);  // ambient light
-	m_pShaderManager->setVec3Value("pointLights[1].diffuse", 0.5f, 0.1f, 0.7f);    // diffuse light
-	m_pShaderManager->setVec3Value("pointLights[1].specular", 0.7f, 0.3f, 0.9f);    // specular highlights
-	m_pShaderManager->setBoolValue("pointLights[1].bActive", true);
-
-	//Last light which adds a green emrald type of color to the scene
-	m_pShaderManager->setVec3Value("pointLights[2].position", -6.0f, 5.0f, 2.0f);  // Positioned opposite purple light
-	m_pShaderManager->setVec3Value("pointLights[2].ambient", 0.0f, 0.05f, 0.05f);  // ambient
-	m_pShaderManager->setVec3Value("pointLights[2].diffuse", 0.2f, 0.8f, 0.5f);    // diffuse green
-	m_pShaderManager->setVec3Value("pointLights[2].specular", 0.3f, 1.0f, 0.6f);   // specular: bright green highlights
-	m_pShaderManager->setBoolValue("pointLights[2].bActive", true);
+	ShapeGeometry::BuildPlane(meshData[InstancedMeshes::SHAPE_PLANE]);
+	ShapeGeometry::BuildBox(meshData[InstancedMeshes::SHAPE_BOX]);
+	ShapeGeometry::BuildCone(meshData[InstancedMeshes::SHAPE_CONE]);
+	ShapeGeometry::BuildCylinder(meshData[InstancedMeshes::SHAPE_CYLINDER]);
+	ShapeGeometry::BuildPyramid3(meshData[InstancedMeshes::SHAPE_PYRAMID3]);
+	ShapeGeometry::BuildSphere(meshData[InstancedMeshes::SHAPE_SPHERE]);
+	ShapeGeometry::BuildTaperedCylinder(meshData[InstancedMeshes::SHAPE_TAPERED_CYLINDER]);
 
+	for (int shape = 0; shape < InstancedMeshes::SHAPE_COUNT; shape++)
+	{
+		ShapeGeometry::GetBounds(meshData[shape], m_meshBoundsCenters[shape], m_meshBoundsRadii[shape]);
+	}
 }
 
-
 /***********************************************************
- *  PrepareScene()
+ *  IsObjectVisible()
  *
- *  This method is used for preparing the 3D scene by loading
- *  the shapes, textures in memory to support the 3D scene 
- *  rendering
+ *  This method is used for testing the bounding sphere of an
+ *  object against the view frustum.  Everything is visible
+ *  while culling is off or no view has been set yet.
  ***********************************************************/
-void SceneManager::PrepareScene()
+bool SceneManager::IsObjectVisible(const SCENE_OBJECT& sceneObject) const
 {
-	// only one instance of a particular mesh needs to be
-	// loaded in memory no matter how many times it is drawn
-	// in the rendered 3D scene
+	if ((m_bCullingEnabled == false) || (m_bFrustumValid == false))
+	{
+		return(true);
+	}
+
+	return(m_viewFrustum.IsSphereVisible(sceneObject.boundsCenter, sceneObject.boundsRadius));
+}
+
+/***********************************************************
+ *  SelectObjectLod()
+ *
+ *  This method is used for picking the level of detail of an
+ *  object from the projected size of its bounding sphere.
+ *  Objects use level 0 until a view has been set.
+ ***********************************************************/
+int SceneManager::SelectObjectLod(const SCENE_OBJECT& sceneObject) const
+{
+	int levelCount = InstancedMeshes::GetLodCount(GetInstancedShape(sceneObject.mesh));
+
+	if ((m_bFrustumValid == false) || (levelCount <= 1))
+	{
+		return(0);
+	}
+
+	float depth = glm::max(glm::dot(m_lodDepthRow, glm::vec4(sceneObject.boundsCenter, 1.0f)), 0.0001f);
+
+	return(SelectLodLevel(
+		(sceneObject.boundsRadius * m_lodScale) / depth,
+		sceneObject.lodLevels[m_viewIndex],
+		levelCount,
+		m_lodHysteresis));
+}
+
+/***********************************************************
+ *  GetViewDepth()
+ *
+ *  This method is used for getting the distance of the
+ *  center of an object in front of the camera, which orders
+ *  the draws of the frame.  Every object is at depth 0, and
+ *  keeps its queue order, until a view has been set.
+ ***********************************************************/
+float SceneManager::GetViewDepth(const SCENE_OBJECT& sceneObject) const
+{
+	return(glm::dot(m_viewDepthRow, glm::vec4(sceneObject.boundsCenter, 1.0f)));
+}
+
+/***********************************************************
+ *  GetInstanceData()
+ *
+ *  This method is used for copying the values an object is
+ *  drawn with into the values of an instance.
+ ***********************************************************/
+void SceneManager::GetInstanceData(const SCENE_OBJECT& sceneObject, InstancedMeshes::INSTANCE_DATA& instance)
+{
+	instance.model = sceneObject.modelMatrix;
+	instance.color = sceneObject.color;
+	instance.uvScale = sceneObject.uvScale;
+	instance.textureIndex = sceneObject.textureIndex;
+	instance.materialIndex = sceneObject.materialIndex;
+}
+
+/***********************************************************
+ *  SetViewProjection()
+ *
+ *  This method is used for setting the view and projection
+ *  of the view being rendered.  Objects outside of the frustum
+ *  are skipped by RenderSceneView(), and the projection decides
+ *  how large the objects appear for their level of detail -
+ *  the depth is w of the projected center, which is the
+ *  view distance in perspective and 1 in orthographic.
+ *  The draws are ordered by the distance along the view
+ *  direction, which both projections have.  The point
+ *  lights are binned into the clusters of the same view.
+ ***********************************************************/
+void SceneManager::SetViewProjection(const glm::mat4& view, const glm::mat4& projection)
+{
+	glm::mat4 viewProjection = projection * view;
+
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
+
+	m_viewFrustum.ExtractPlanes(viewProjection);
+	m_lodDepthRow = glm::vec4(
+		viewProjection[0][3],
+		viewProjection[1][3],
+		viewProjection[2][3],
+		viewProjection[3][3]);
+	m_lodScale = projection[1][1];
+	// the camera looks down -z in view space
+	m_viewDepthRow = glm::vec4(-view[0][2], -view[1][2], -view[2][2], -view[3][2]);
+	m_bFrustumValid = true;
+}
+
+/***********************************************************
+ *  AddSceneObject()
+ *
+ *  This method is used for adding an object to the retained
+ *  scene.  The object is drawn every frame by RenderScene()
+ *  and its model matrix is built on the first draw.  The
+ *  index of the new object is returned.
+ ***********************************************************/
+int SceneManager::AddSceneObject(
+	MESH_TYPE mesh,
+	glm::vec3 scaleXYZ,
+	glm::vec3 rotationDegrees,
+	glm::vec3 positionXYZ,
+	std::string materialTag,
+	std::string textureTag,
+	glm::vec2 uvScale,
+	glm::vec4 color)
+{
+	SCENE_OBJECT sceneObject;
+
+	sceneObject.mesh = mesh;
+	sceneObject.materialTag = materialTag;
+	sceneObject.textureTag = textureTag;
+	sceneObject.uvScale = uvScale;
+	sceneObject.color = color;
+	sceneObject.scaleXYZ = scaleXYZ;
+	sceneObject.rotationDegrees = rotationDegrees;
+	sceneObject.positionXYZ = positionXYZ;
+	sceneObject.modelMatrix = glm::mat4(1.0f);
+	sceneObject.boundsCenter = positionXYZ;
+	sceneObject.boundsRadius = 0.0f;
+	sceneObject.bDirty = true;
+	sceneObject.textureIndex = -1;
+	sceneObject.materialIndex = -1;
+	for (int view = 0; view < MAX_VIEWS; view++)
+	{
+		sceneObject.lodLevels[view] = 0;
+	}
+
+	m_sceneObjects.push_back(sceneObject);
+	m_movedObjects.push_back((int)m_sceneObjects.size() - 1);
+	m_bRenderQueueDirty = true;
+
+	return((int)m_sceneObjects.size() - 1);
+}
+
+/***********************************************************
+ *  SetObjectTransform()
+ *
+ *  This method is used for moving an object in the retained
+ *  scene.  The cached model matrix is rebuilt on the next
+ *  call to RenderScene(), with GPU culling the objects on
+ *  the GPU are uploaded again, and the shadow maps are
+ *  drawn again.
+ ***********************************************************/
+void SceneManager::SetObjectTransform(
+	int objectIndex,
+	glm::vec3 scaleXYZ,
+	glm::vec3 rotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	if ((objectIndex < 0) || (objectIndex >= (int)m_sceneObjects.size()))
+	{
+		return;
+	}
+
+	SCENE_OBJECT& sceneObject = m_sceneObjects[objectIndex];
+	if (sceneObject.bDirty == false)
+	{
+		m_movedObjects.push_back(objectIndex);
+	}
+	sceneObject.scaleXYZ = scaleXYZ;
+	sceneObject.rotationDegrees = rotationDegrees;
+	sceneObject.positionXYZ = positionXYZ;
+	sceneObject.bDirty = true;
+	m_bGpuSceneDirty = true;
+	m_bShadowCastersDirty = true;
+}
+
+/***********************************************************
+ *  AddSyntheticObjects()
+ *
+ *  This method is used for adding a square grid of basic
+ *  shapes around the origin, for measuring how rendering
+ *  scales with the object count.  The meshes, rotations,
+ *  scales, materials and textures are picked from the seed,
+ *  so the same count and seed always build the same scene.
+ *  The defined materials and loaded textures are reused.
+ ***********************************************************/
+void SceneManager::AddSyntheticObjects(int objectCount, unsigned int seed)
+{
+	if (objectCount <= 0)
+	{
+		return;
+	}
+
+	unsigned int state = seed;
+	int gridSize = (int)ceil(sqrt((double)objectCount));
+	float gridOffset = 0.5f * (float)(gridSize - 1) * g_SyntheticSpacing;
+
+	m_sceneObjects.reserve(m_sceneObjects.size() + objectCount);
+
+	for (int i = 0; i < objectCount; i++)
+	{
+		int column = i % gridSize;
+		int row = i / gridSize;
+
+		MESH_TYPE mesh = (MESH_TYPE)((int)(NextRandom(state) * (float)MESH_COUNT) % MESH_COUNT);
+		glm::vec3 rotation(
+			NextRandom(state) * 360.0f,
+			NextRandom(state) * 360.0f,
+			NextRandom(state) * 360.0f);
+		float scale = 0.3f + NextRandom(state) * 0.4f;
+		glm::vec3 position(
+			(float)column * g_SyntheticSpacing - gridOffset,
+			1.0f,
+			(float)row * g_SyntheticSpacing - gridOffset);
+
+		std::string materialTag;
+		if (m_objectMaterials.empty() == false)
+		{
+			materialTag = m_objectMaterials[(size_t)(NextRandom(state) * (float)m_objectMaterials.size()) % m_objectMaterials.size()].tag;
+		}
+
+		// half of the objects are textured, the others use a color
+		std::string textureTag;
+		glm::vec4 color(NextRandom(state), NextRandom(state), NextRandom(state), 1.0f);
+		if ((m_textureIDs.empty() == false) && (NextRandom(state) < 0.5f))
+		{
+			textureTag = m_textureIDs[(size_t)(NextRandom(state) * (float)m_textureIDs.size()) % m_textureIDs.size()].tag;
+		}
+
+		AddSceneObject(
+			mesh,
+			glm::vec3(scale, scale, scale),
+			rotation,
+			position,
+			materialTag,
+			textureTag,
+			glm::vec2(1.0f, 1.0f),
+			color);
+	}
+}
+
+/***********************************************************
+ *  AddPointLight()
+ *
+ *  This method is used for adding a point light past the
+ *  few lights of the light block.  The light fades out to
+ *  nothing at its range, and only the fragments within the
+ *  range pay for it, so any number of these lights can be
+ *  added.  They are only drawn by the instanced path when
+ *  the driver supports clustered lights.
+ ***********************************************************/
+void SceneManager::AddPointLight(
+	glm::vec3 position,
+	float range,
+	glm::vec3 ambient,
+	glm::vec3 diffuse,
+	glm::vec3 specular)
+{
+	if ((int)m_clusteredLights.size() >= ClusteredLights::MAX_LIGHTS)
+	{
+		std::cout << "Point light not added - the limit is " << ClusteredLights::MAX_LIGHTS << std::endl;
+		return;
+	}
+
+	ClusteredLights::POINT_LIGHT light;
+	light.positionRange = glm::vec4(position, range);
+	light.ambient = glm::vec4(ambient, 0.0f);
+	light.diffuse = glm::vec4(diffuse, 0.0f);
+	light.specular = glm::vec4(specular, 0.0f);
+
+	m_clusteredLights.push_back(light);
+	m_bClusteredLightsDirty = true;
+}
+
+/***********************************************************
+ *  AddSyntheticLights()
+ *
+ *  This method is used for adding colored point lights at
+ *  random spots above the scene objects, for measuring how
+ *  rendering scales with the light count.  Like the
+ *  synthetic objects, the same count and seed always add
+ *  the same lights.
+ ***********************************************************/
+void SceneManager::AddSyntheticLights(int lightCount, unsigned int seed)
+{
+	if (lightCount <= 0)
+	{
+		return;
+	}
+
+	// the lights cover the area of the objects on the ground
+	glm::vec2 areaMin(-g_SyntheticLightMargin, -g_SyntheticLightMargin);
+	glm::vec2 areaMax(g_SyntheticLightMargin, g_SyntheticLightMargin);
+	for (size_t i = 0; i < m_sceneObjects.size(); i++)
+	{
+		glm::vec2 position(m_sceneObjects[i].positionXYZ.x, m_sceneObjects[i].positionXYZ.z);
+		areaMin = glm::min(areaMin, position - g_SyntheticLightMargin);
+		areaMax = glm::max(areaMax, position + g_SyntheticLightMargin);
+	}
+
+	// a different sequence than the objects of the same seed
+	unsigned int state = seed ^ 0x9E3779B9u;
+
+	for (int i = 0; i < lightCount; i++)
+	{
+		glm::vec3 position(
+			areaMin.x + NextRandom(state) * (areaMax.x - areaMin.x),
+			0.5f + NextRandom(state) * 2.5f,
+			areaMin.y + NextRandom(state) * (areaMax.y - areaMin.y));
+		glm::vec3 color(NextRandom(state), NextRandom(state), NextRandom(state));
+
+		AddPointLight(
+			position,
+			g_SyntheticLightRange,
+			color * 0.02f,
+			color * 2.0f,
+			color);
+	}
+}
+
+/***********************************************************
+ *  BuildRenderQueue()
+ *
+ *  This method is used for resolving the texture and material
+ *  tags of every scene object and sorting the objects into
+ *  the render queue by their shader state.  This only needs
+ *  to happen again after objects are added to the scene.
+ *  The sort keys are built by jobs on all of the cores.
+ ***********************************************************/
+void SceneManager::BuildRenderQueue()
+{
+	// the lookups below only read the tag maps, so they are safe
+	// to run from the jobs once the materials are interned
+	IndexObjectMaterials();
+	m_renderQueue.Clear();
+	m_renderQueue.Resize(m_sceneObjects.size());
+
+	m_pJobSystem->ParallelFor(
+		(int)m_sceneObjects.size(),
+		g_ItemsPerJob,
+		[this](int /*jobIndex*/, int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				SCENE_OBJECT& sceneObject = m_sceneObjects[i];
+				RenderQueue::BLEND_MODE blendMode = RenderQueue::BLEND_OPAQUE;
+
+				sceneObject.textureIndex = -1;
+				if (sceneObject.textureTag.empty() == false)
+				{
+					sceneObject.textureIndex = FindTextureIndex(sceneObject.textureTag);
+				}
+				sceneObject.materialIndex = FindMaterialIndex(sceneObject.materialTag);
+
+				// translucent colors must be drawn after all the opaque objects
+				if (sceneObject.color.a < 1.0f)
+				{
+					blendMode = RenderQueue::BLEND_ALPHA;
+				}
+
+				m_renderQueue.SetItem(
+					i,
+					RenderQueue::MakeSortKey(
+						blendMode,
+						sceneObject.mesh,
+						sceneObject.textureIndex,
+						sceneObject.materialIndex),
+					i);
+			}
+		});
+
+	m_renderQueue.Sort();
+	m_bRenderQueueDirty = false;
+	m_bGpuSceneDirty = true;
+	m_bShadowCastersDirty = true;
+}
+
+/***********************************************************
+ *  ResetShaderState()
+ *
+ *  This method is used for forgetting the shader values set
+ *  by the previous queued draw, so that the next draw sends
+ *  all of its values.
+ ***********************************************************/
+void SceneManager::ResetShaderState()
+{
+	m_shaderState.useTexture = -1;
+	m_shaderState.textureIndex = -2;
+	m_shaderState.materialIndex = -2;
+	m_shaderState.uvScale = glm::vec2(-FLT_MAX, -FLT_MAX);
+	m_shaderState.color = glm::vec4(-1.0f, -1.0f, -1.0f, -1.0f);
+}
+
+/***********************************************************
+ *  ApplyObjectState()
+ *
+ *  This method is used for setting the material, texture,
+ *  color and UV scale of the passed in object into the
+ *  shader.  Only the values that differ from the previous
+ *  queued draw are sent.  An object whose texture tag did
+ *  not resolve is drawn with its color instead.
+ ***********************************************************/
+void SceneManager::ApplyObjectState(const SCENE_OBJECT& sceneObject)
+{
+	if (NULL == m_pShaderUniforms)
+	{
+		return;
+	}
+
+	int useTexture = (sceneObject.textureIndex >= 0) ? 1 : 0;
+
+	// every draw would repeat it, so a missing tag is reported once
+	if ((useTexture == 0) &&
+		(sceneObject.textureTag.empty() == false) &&
+		(m_missingTextureTags.insert(sceneObject.textureTag).second == true))
+	{
+		std::cout << "No texture loaded for tag:" << sceneObject.textureTag << ", the object color is used" << std::endl;
+	}
+
+	if ((sceneObject.materialIndex >= 0) &&
+		(m_shaderState.materialIndex != sceneObject.materialIndex))
+	{
+		SetMaterialValues(sceneObject.materialIndex);
+		m_shaderState.materialIndex = sceneObject.materialIndex;
+	}
+
+	if (m_shaderState.useTexture != useTexture)
+	{
+		m_pShaderUniforms->SetInt(ShaderUniforms::USE_TEXTURE, useTexture);
+		m_shaderState.useTexture = useTexture;
+	}
+
+	if (useTexture == 1)
+	{
+		if (m_shaderState.textureIndex != sceneObject.textureIndex)
+		{
+			// the sampler always reads the one texture unit
+			if (m_shaderState.textureIndex == -2)
+			{
+				m_pShaderUniforms->SetInt(ShaderUniforms::OBJECT_TEXTURE, TextureResidency::TEXTURE_UNIT);
+			}
+			m_pTextureResidency->BindTexture(sceneObject.textureIndex);
+			m_shaderState.textureIndex = sceneObject.textureIndex;
+		}
+	}
+	else if (m_shaderState.color != sceneObject.color)
+	{
+		m_pShaderUniforms->SetVec4(ShaderUniforms::OBJECT_COLOR, sceneObject.color);
+		m_shaderState.color = sceneObject.color;
+	}
+
+	if (m_shaderState.uvScale != sceneObject.uvScale)
+	{
+		m_pShaderUniforms->SetVec2(ShaderUniforms::UV_SCALE, sceneObject.uvScale);
+		m_shaderState.uvScale = sceneObject.uvScale;
+	}
+}
+
+/***********************************************************
+ *  SetDirectionalLight()
+ *
+ *  This method is used for setting the directional light
+ *  into the light block when the shader declares it, or
+ *  into the individual light uniforms otherwise.
+ ***********************************************************/
+void SceneManager::SetDirectionalLight(
+	glm::vec3 direction,
+	glm::vec3 ambient,
+	glm::vec3 diffuse,
+	glm::vec3 specular)
+{
+	// the light block is always kept current for the programs sharing it
+	if (NULL != m_pUniformBuffers)
+	{
+		m_pUniformBuffers->SetDirectionalLight(direction, ambient, diffuse, specular, true);
+	}
+	m_directionalLightDirection = direction;
+	if (NULL != m_pShadowMaps)
+	{
+		m_pShadowMaps->SetLightDirection(direction);
+	}
+	if (m_pShaderUniforms->HasBlock(UniformBuffers::LIGHT_BLOCK) == true)
+	{
+		return;
+	}
+
+	m_pShaderUniforms->SetVec3(ShaderUniforms::DIRECTIONAL_LIGHT_DIRECTION, direction);
+	m_pShaderUniforms->SetVec3(ShaderUniforms::DIRECTIONAL_LIGHT_AMBIENT, ambient);
+	m_pShaderUniforms->SetVec3(ShaderUniforms::DIRECTIONAL_LIGHT_DIFFUSE, diffuse);
+	m_pShaderUniforms->SetVec3(ShaderUniforms::DIRECTIONAL_LIGHT_SPECULAR, specular);
+	m_pShaderUniforms->SetBool(ShaderUniforms::DIRECTIONAL_LIGHT_ACTIVE, true);
+}
+
+/***********************************************************
+ *  SetPointLight()
+ *
+ *  This method is used for setting one of the point lights
+ *  into the light block when the shader declares it, or
+ *  into the individual light uniforms otherwise.
+ ***********************************************************/
+void SceneManager::SetPointLight(
+	int lightIndex,
+	glm::vec3 position,
+	glm::vec3 ambient,
+	glm::vec3 diffuse,
+	glm::vec3 specular)
+{
+	if ((lightIndex < 0) || (lightIndex >= ShaderUniforms::MAX_POINT_LIGHTS))
+	{
+		std::cout << "Point light " << lightIndex << " is not supported by the shaders" << std::endl;
+		return;
+	}
+
+	// the light block is always kept current for the programs sharing it
+	if (NULL != m_pUniformBuffers)
+	{
+		m_pUniformBuffers->SetPointLight(lightIndex, position, ambient, diffuse, specular, true);
+	}
+	if (m_pShaderUniforms->HasBlock(UniformBuffers::LIGHT_BLOCK) == true)
+	{
+		return;
+	}
+
+	m_pShaderUniforms->SetVec3(ShaderUniforms::PointLight(lightIndex, ShaderUniforms::POINT_LIGHT_POSITION), position);
+	m_pShaderUniforms->SetVec3(ShaderUniforms::PointLight(lightIndex, ShaderUniforms::POINT_LIGHT_AMBIENT), ambient);
+	m_pShaderUniforms->SetVec3(ShaderUniforms::PointLight(lightIndex, ShaderUniforms::POINT_LIGHT_DIFFUSE), diffuse);
+	m_pShaderUniforms->SetVec3(ShaderUniforms::PointLight(lightIndex, ShaderUniforms::POINT_LIGHT_SPECULAR), specular);
+	m_pShaderUniforms->SetBool(ShaderUniforms::PointLight(lightIndex, ShaderUniforms::POINT_LIGHT_ACTIVE), true);
+}
+
+/***********************************************************
+ *  UploadObjectMaterials()
+ *
+ *  This method is used for interning the tags of the defined
+ *  materials and copying them into the material table, so
+ *  that a draw only needs to set the index of its material.
+ ***********************************************************/
+void SceneManager::UploadObjectMaterials()
+{
+	IndexObjectMaterials();
+
+	for (int i = 0; i < (int)m_objectMaterials.size(); i++)
+	{
+		m_pMaterialTable->SetMaterial(
+			i,
+			m_objectMaterials[i].diffuseColor,
+			m_objectMaterials[i].specularColor,
+			m_objectMaterials[i].shininess);
+	}
+	m_pMaterialTable->Update();
+}
+
+/***********************************************************
+ *  LoadSceneFile()
+ *
+ *  This method is used for loading a scene file in place of
+ *  the textures, materials, lights and objects defined in
+ *  the code.  A compiled file is mapped and read in place.
+ *  The material table is copied into the material buffer
+ *  without conversion, the clustered lights are filled
+ *  with one copy, and the tags are only made into strings
+ *  once per table entry.  False is returned when the file
+ *  can not be used.
+ ***********************************************************/
+bool SceneManager::LoadSceneFile(const char* filename)
+{
+	SceneFile sceneFile;
+	if (sceneFile.Open(filename) == false)
+	{
+		std::cout << "Scene file " << filename << " not loaded, the scene of the code is used" << std::endl;
+		return(false);
+	}
+
+	// the objects and clustered lights of the file are kept together,
+	// so a reload can find them again
+	m_sceneFileFirstObject = (int)m_sceneObjects.size();
+	m_sceneFileObjectCount = 0;
+	m_sceneFileFirstLight = (int)m_clusteredLights.size();
+	m_sceneFileLightCount = 0;
+	memset(&m_sceneFileLights, 0, sizeof(m_sceneFileLights));
+
+	ApplySceneFile(sceneFile);
+
+	const SceneFile::SCENE_HEADER& header = sceneFile.GetHeader();
+	std::cout << "Loaded scene file:" << filename << ", objects:" << header.objectCount << ", materials:" << header.materialCount << ", point lights:" << header.pointLightCount << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  ReloadSceneFile()
+ *
+ *  This method is used for loading the scene file again
+ *  after it changed.  Only what differs from the running
+ *  scene is replaced, and a file that can not be read
+ *  leaves the scene as it is.
+ ***********************************************************/
+void SceneManager::ReloadSceneFile()
+{
+	SceneFile sceneFile;
+	if (sceneFile.Open(m_sceneFilename.c_str()) == false)
+	{
+		std::cout << "Scene file " << m_sceneFilename << " not reloaded, the running scene is kept" << std::endl;
+		return;
+	}
+
+	ApplySceneFile(sceneFile);
+	std::cout << "Reloaded scene file:" << m_sceneFilename << std::endl;
+}
+
+/***********************************************************
+ *  ApplySceneFile()
+ *
+ *  This method is used for bringing the scene in line with
+ *  a scene file.  Textures and materials are matched by tag
+ *  and lights by slot, so only new or changed entries are
+ *  loaded and uploaded.  The objects of the file are updated
+ *  in place while their number stays the same - otherwise
+ *  they are replaced as a whole.
+ ***********************************************************/
+void SceneManager::ApplySceneFile(const SceneFile& sceneFile)
+{
+	const SceneFile::SCENE_HEADER& header = sceneFile.GetHeader();
+
+	const SceneFile::TEXTURE_ENTRY* pTextures = sceneFile.GetTextures();
+	std::vector<std::string> textureTags(header.textureCount);
+	for (uint32_t i = 0; i < header.textureCount; i++)
+	{
+		const char* filename = sceneFile.GetString(pTextures[i].filename);
+		textureTags[i] = sceneFile.GetString(pTextures[i].tag);
+
+		int textureIndex = FindTextureIndex(textureTags[i]);
+		if (textureIndex < 0)
+		{
+			CreateGLTexture(filename, textureTags[i]);
+		}
+		else if (m_textureIDs[textureIndex].filename != filename)
+		{
+			m_textureIDs[textureIndex].filename = filename;
+			WatchTexture(textureIndex);
+			ReloadTexture(textureIndex);
+		}
+	}
+	if ((NULL != m_pSkybox) && (header.skyFaces[0] != SceneFile::NO_ENTRY))
+	{
+		const char* skyFaces[Skybox::FACE_COUNT];
+		bool bChanged = (m_pSkybox->IsLoaded() == false);
+		for (int i = 0; i < Skybox::FACE_COUNT; i++)
+		{
+			skyFaces[i] = sceneFile.GetString(header.skyFaces[i]);
+			bChanged = bChanged || (m_pSkybox->GetFaceFilename(i) != skyFaces[i]);
+		}
+		if (bChanged == true)
+		{
+			m_pSkybox->LoadCubemap(skyFaces);
+		}
+	}
+
+	// the material table is already in the layout of the material
+	// block, so a scene without materials takes it as it is
+	bool bFirstMaterials = m_objectMaterials.empty();
+	const UniformBuffers::MATERIAL_DATA* pMaterials = sceneFile.GetMaterials();
+	const uint32_t* pMaterialTags = sceneFile.GetMaterialTags();
+	std::vector<std::string> materialTags(header.materialCount);
+	for (uint32_t i = 0; i < header.materialCount; i++)
+	{
+		OBJECT_MATERIAL material;
+		material.diffuseColor = glm::vec3(pMaterials[i].diffuseColor);
+		material.specularColor = glm::vec3(pMaterials[i].specularColor);
+		material.shininess = pMaterials[i].specularColor.w;
+		material.tag = sceneFile.GetString(pMaterialTags[i]);
+		materialTags[i] = material.tag;
+
+		int materialIndex = FindMaterialIndex(material.tag);
+		if (materialIndex < 0)
+		{
+			m_objectMaterials.push_back(material);
+			IndexObjectMaterials();
+			materialIndex = (int)m_objectMaterials.size() - 1;
+		}
+		else if ((m_objectMaterials[materialIndex].diffuseColor == material.diffuseColor) &&
+			(m_objectMaterials[materialIndex].specularColor == material.specularColor) &&
+			(m_objectMaterials[materialIndex].shininess == material.shininess))
+		{
+			continue;
+		}
+		else
+		{
+			m_objectMaterials[materialIndex] = material;
+		}
+
+		if (bFirstMaterials == false)
+		{
+			m_pMaterialTable->SetMaterial(
+				materialIndex,
+				material.diffuseColor,
+				material.specularColor,
+				material.shininess);
+		}
+	}
+	if ((bFirstMaterials == true) &&
+		(m_objectMaterials.size() == (size_t)header.materialCount))
+	{
+		m_pMaterialTable->SetMaterials(pMaterials, (int)header.materialCount);
+	}
+	m_pMaterialTable->Update();
+
+	ApplySceneLights(sceneFile.GetLights());
+
+	// the clustered lights are already in the layout of the light buffer
+	const ClusteredLights::POINT_LIGHT* pPointLights = sceneFile.GetPointLights();
+	int pointLightCount = (int)header.pointLightCount;
+	// the lights added by the code after the file lights are kept, so
+	// only as many file lights as there is room for are added
+	int freeLightCount = ClusteredLights::MAX_LIGHTS -
+		((int)m_clusteredLights.size() - m_sceneFileLightCount);
+	if (pointLightCount > freeLightCount)
+	{
+		std::cout << "Only " << freeLightCount << " of the " << pointLightCount
+			<< " point lights of the scene file are used - the limit is "
+			<< ClusteredLights::MAX_LIGHTS << std::endl;
+		pointLightCount = freeLightCount;
+	}
+	if ((pointLightCount != m_sceneFileLightCount) ||
+		((pointLightCount > 0) && (memcmp(&m_clusteredLights[m_sceneFileFirstLight], pPointLights,
+			pointLightCount * sizeof(ClusteredLights::POINT_LIGHT)) != 0)))
+	{
+		m_clusteredLights.erase(
+			m_clusteredLights.begin() + m_sceneFileFirstLight,
+			m_clusteredLights.begin() + m_sceneFileFirstLight + m_sceneFileLightCount);
+		m_clusteredLights.insert(
+			m_clusteredLights.begin() + m_sceneFileFirstLight,
+			pPointLights,
+			pPointLights + pointLightCount);
+		m_sceneFileLightCount = pointLightCount;
+		m_bClusteredLightsDirty = true;
+	}
+
+	const SceneFile::OBJECT_ENTRY* pObjects = sceneFile.GetObjects();
+	std::string noTag;
+	int objectCount = (int)header.objectCount;
+	if (objectCount != m_sceneFileObjectCount)
+	{
+		// the objects after the ones of the file move down, and the
+		// file objects are added again at the end
+		m_sceneObjects.erase(
+			m_sceneObjects.begin() + m_sceneFileFirstObject,
+			m_sceneObjects.begin() + m_sceneFileFirstObject + m_sceneFileObjectCount);
+		// the moved objects after them have new indices
+		m_movedObjects.clear();
+		for (size_t i = 0; i < m_sceneObjects.size(); i++)
+		{
+			if (m_sceneObjects[i].bDirty == true)
+			{
+				m_movedObjects.push_back((int)i);
+			}
+		}
+		m_sceneFileFirstObject = (int)m_sceneObjects.size();
+		m_sceneFileObjectCount = objectCount;
+		m_sceneObjects.reserve(m_sceneObjects.size() + objectCount);
+		for (int i = 0; i < objectCount; i++)
+		{
+			const SceneFile::OBJECT_ENTRY& object = pObjects[i];
+			AddSceneObject(
+				GetMeshType((InstancedMeshes::SHAPE_ID)object.shape),
+				glm::vec3(object.scaleXYZ),
+				glm::vec3(object.rotationDegrees),
+				glm::vec3(object.positionXYZ),
+				(object.material == SceneFile::NO_ENTRY) ? noTag : materialTags[object.material],
+				(object.texture == SceneFile::NO_ENTRY) ? noTag : textureTags[object.texture],
+				glm::vec2(object.uvScale.x, object.uvScale.y),
+				object.color);
+		}
+		// the queue holds the old object indices even when the file
+		// has no objects left to add
+		m_bRenderQueueDirty = true;
+		m_bGpuSceneDirty = true;
+		m_bShadowCastersDirty = true;
+		return;
+	}
+
+	for (int i = 0; i < objectCount; i++)
+	{
+		const SceneFile::OBJECT_ENTRY& object = pObjects[i];
+		SCENE_OBJECT& sceneObject = m_sceneObjects[m_sceneFileFirstObject + i];
+		MESH_TYPE mesh = GetMeshType((InstancedMeshes::SHAPE_ID)object.shape);
+		const std::string& materialTag = (object.material == SceneFile::NO_ENTRY) ? noTag : materialTags[object.material];
+		const std::string& textureTag = (object.texture == SceneFile::NO_ENTRY) ? noTag : textureTags[object.texture];
+		glm::vec2 uvScale(object.uvScale.x, object.uvScale.y);
+
+		// a new mesh, material, texture or color sorts differently
+		if ((sceneObject.mesh != mesh) ||
+			(sceneObject.materialTag != materialTag) ||
+			(sceneObject.textureTag != textureTag) ||
+			(sceneObject.uvScale != uvScale) ||
+			(sceneObject.color != object.color))
+		{
+			sceneObject.mesh = mesh;
+			sceneObject.materialTag = materialTag;
+			sceneObject.textureTag = textureTag;
+			sceneObject.uvScale = uvScale;
+			sceneObject.color = object.color;
+			if (sceneObject.bDirty == false)
+			{
+				m_movedObjects.push_back(m_sceneFileFirstObject + i);
+			}
+			sceneObject.bDirty = true;
+			m_bRenderQueueDirty = true;
+			m_bShadowCastersDirty = true;
+		}
+
+		if ((sceneObject.scaleXYZ != glm::vec3(object.scaleXYZ)) ||
+			(sceneObject.rotationDegrees != glm::vec3(object.rotationDegrees)) ||
+			(sceneObject.positionXYZ != glm::vec3(object.positionXYZ)))
+		{
+			SetObjectTransform(
+				m_sceneFileFirstObject + i,
+				glm::vec3(object.scaleXYZ),
+				glm::vec3(object.rotationDegrees),
+				glm::vec3(object.positionXYZ));
+		}
+	}
+}
+
+/***********************************************************
+ *  ApplySceneLights()
+ *
+ *  This method is used for setting the lights of the light
+ *  block from a scene file - an active light has 1.0 in w.
+ *  Lights that are the same as the last time are left
+ *  alone, so the shadows are only drawn again when the
+ *  directional light changed.
+ ***********************************************************/
+void SceneManager::ApplySceneLights(const UniformBuffers::LIGHTS_DATA& lights)
+{
+	m_pShaderUniforms->SetBool(ShaderUniforms::USE_LIGHTING, true);
+
+	const UniformBuffers::LIGHT_DATA& directional = lights.directionalLight;
+	if ((directional.vector.w != 0.0f) &&
+		(memcmp(&directional, &m_sceneFileLights.directionalLight, sizeof(directional)) != 0))
+	{
+		SetDirectionalLight(
+			glm::vec3(directional.vector),
+			glm::vec3(directional.ambient),
+			glm::vec3(directional.diffuse),
+			glm::vec3(directional.specular));
+	}
+
+	for (int i = 0; i < UniformBuffers::MAX_POINT_LIGHTS; i++)
+	{
+		const UniformBuffers::LIGHT_DATA& light = lights.pointLights[i];
+		if (memcmp(&light, &m_sceneFileLights.pointLights[i], sizeof(light)) == 0)
+		{
+			continue;
+		}
+
+		if (light.vector.w != 0.0f)
+		{
+			SetPointLight(
+				i,
+				glm::vec3(light.vector),
+				glm::vec3(light.ambient),
+				glm::vec3(light.diffuse),
+				glm::vec3(light.specular));
+		}
+		else
+		{
+			// the light was taken out of the file
+			if (NULL != m_pUniformBuffers)
+			{
+				m_pUniformBuffers->SetPointLight(
+					i,
+					glm::vec3(light.vector),
+					glm::vec3(light.ambient),
+					glm::vec3(light.diffuse),
+					glm::vec3(light.specular),
+					false);
+			}
+			if (m_pShaderUniforms->HasBlock(UniformBuffers::LIGHT_BLOCK) == false)
+			{
+				m_pShaderUniforms->SetBool(ShaderUniforms::PointLight(i, ShaderUniforms::POINT_LIGHT_ACTIVE), false);
+			}
+		}
+	}
+
+	m_sceneFileLights = lights;
+}
+
+/***********************************************************
+ *  WatchFiles()
+ *
+ *  This method is used for reloading the shaders of every
+ *  pass and the scene file whenever their files are written,
+ *  while the scene keeps rendering.  The textures watch
+ *  their images as they are created.
+ ***********************************************************/
+void SceneManager::WatchFiles(bool bWatchSceneFile)
+{
+	if (NULL == m_pHotReload)
+	{
+		return;
+	}
+
+	if (NULL != m_pInstancedMeshes)
+	{
+		m_pInstancedMeshes->WatchFiles(m_pHotReload);
+	}
+	if (NULL != m_pGpuCulling)
+	{
+		m_pGpuCulling->WatchFiles(m_pHotReload);
+	}
+	if (NULL != m_pClusteredLights)
+	{
+		m_pClusteredLights->WatchFiles(m_pHotReload);
+	}
+	if (NULL != m_pShadowMaps)
+	{
+		m_pShadowMaps->WatchFiles(m_pHotReload);
+	}
+	if (NULL != m_pSkybox)
+	{
+		m_pSkybox->WatchFiles(m_pHotReload);
+	}
+
+	// only a scene that came from a file can be reloaded - edit the
+	// text file rather than the compiled one while iterating
+	if (bWatchSceneFile == true)
+	{
+		int watchIndex = m_pHotReload->AddWatch([this]() { ReloadSceneFile(); });
+		m_pHotReload->AddFile(watchIndex, m_sceneFilename);
+	}
+}
+
+/***********************************************************
+ *  SetMaterialValues()
+ *
+ *  This method is used for selecting the material with the
+ *  passed in index for the next draw - by index when the
+ *  material block holds it, or by its values otherwise.
+ ***********************************************************/
+void SceneManager::SetMaterialValues(int materialIndex)
+{
+	// the block only holds the first entries of the material table
+	if ((m_pShaderUniforms->HasBlock(UniformBuffers::MATERIAL_BLOCK) == true) &&
+		(materialIndex < UniformBuffers::MAX_MATERIALS))
+	{
+		m_pShaderUniforms->SetInt(ShaderUniforms::MATERIAL_INDEX, materialIndex);
+		return;
+	}
+
+	const OBJECT_MATERIAL& material = m_objectMaterials[materialIndex];
+	m_pShaderUniforms->SetVec3(ShaderUniforms::MATERIAL_DIFFUSE_COLOR, material.diffuseColor);
+	m_pShaderUniforms->SetVec3(ShaderUniforms::MATERIAL_SPECULAR_COLOR, material.specularColor);
+	m_pShaderUniforms->SetFloat(ShaderUniforms::MATERIAL_SHININESS, material.shininess);
+}
+
+/***********************************************************
+ *  RenderSceneInstanced()
+ *
+ *  This method is used for rendering the queued objects from
+ *  the passed in item on in instanced batches.  Consecutive
+ *  opaque objects with the same mesh and texture form one
+ *  batch, and the batches are drawn front to back by their
+ *  nearest instance.  The blended objects are put in order
+ *  over the whole frame, farthest first, and drawn in a pass
+ *  of their own.  All instance values of the frame are
+ *  uploaded at once, and each batch is drawn with a single
+ *  draw call.  With bindless textures and multi-draw support,
+ *  each pass is drawn with one call, and the opaque batches
+ *  can fill the depth buffer in a pre-pass first.
+ ***********************************************************/
+void SceneManager::RenderSceneInstanced(size_t firstItem)
+{
+	RecordDrawLists(true, firstItem);
+
+	// join the lists in queue order - a batch that was split at
+	// the end of a job's range continues in the next list
+	int instanceCount = 0;
+	m_instanceBatches.clear();
+	for (size_t i = 0; i < m_drawLists.size(); i++)
+	{
+		DRAW_LIST& drawList = m_drawLists[i];
+		drawList.firstInstance = instanceCount;
+
+		for (size_t j = 0; j < drawList.batches.size(); j++)
+		{
+			INSTANCE_BATCH batch = drawList.batches[j];
+			batch.firstInstance += drawList.firstInstance;
+
+			if ((m_instanceBatches.empty() == false) &&
+				(m_instanceBatches.back().batchKey == batch.batchKey) &&
+				(m_instanceBatches.back().lodLevel == batch.lodLevel))
+			{
+				m_instanceBatches.back().instanceCount += batch.instanceCount;
+				m_instanceBatches.back().depth = glm::min(m_instanceBatches.back().depth, batch.depth);
+			}
+			else
+			{
+				m_instanceBatches.push_back(batch);
+			}
+		}
+		instanceCount += (int)drawList.instances.size();
+	}
+
+	// the nearest batches hide the most, so they are drawn first
+	std::stable_sort(m_instanceBatches.begin(), m_instanceBatches.end(), IsBatchNearer);
+	m_opaqueBatchCount = (int)m_instanceBatches.size();
+
+	SortBlendedObjects();
+	AddBlendedBatches(instanceCount);
+	int opaqueInstances = instanceCount;
+	instanceCount += (int)m_blendedInstances.size();
+	m_visibleObjects += instanceCount;
+
+	if (instanceCount == 0)
+	{
+		return;
+	}
+
+	// the jobs copy their instance values straight into the mapped
+	// instance buffer, each list to its own part of it
+	InstancedMeshes::INSTANCE_DATA* pInstances = m_pInstancedMeshes->MapInstances(instanceCount);
+	if (NULL == pInstances)
+	{
+		m_instanceBatches.clear();
+		m_opaqueBatchCount = 0;
+	}
+	else
+	{
+		m_pJobSystem->ParallelFor(
+			(int)m_drawLists.size(),
+			1,
+			[this, pInstances](int jobIndex, int /*begin*/, int /*end*/)
+			{
+				const DRAW_LIST& drawList = m_drawLists[jobIndex];
+				if (drawList.instances.empty() == false)
+				{
+					memcpy(
+						pInstances + drawList.firstInstance,
+						drawList.instances.data(),
+						drawList.instances.size() * sizeof(InstancedMeshes::INSTANCE_DATA));
+				}
+			});
+		if (m_blendedInstances.empty() == false)
+		{
+			memcpy(
+				pInstances + opaqueInstances,
+				m_blendedInstances.data(),
+				m_blendedInstances.size() * sizeof(InstancedMeshes::INSTANCE_DATA));
+		}
+		m_pInstancedMeshes->UnmapInstances();
+	}
+
+	// with bindless handles every instance finds its own texture,
+	// otherwise the texture of each batch is bound before its draw
+	bool bBindTextures = ((m_pTextureResidency->IsBindless() == false) ||
+		(m_pInstancedMeshes->UsesTextureHandles() == false));
+
+	m_pInstancedMeshes->BeginInstancedDraws();
+
+	// a multi-draw cannot bind a texture between its draws, so it
+	// needs every instance to find its own texture
+	bool bIndirect = ((bBindTextures == false) && (RecordIndirectDraws() == true));
+	int batchCount = (int)m_instanceBatches.size();
+
+	// the depth does not need any texture
+	bool bDepthWritten = false;
+	if ((m_bDepthPrepassEnabled == true) &&
+		(m_pInstancedMeshes->SupportsDepthPrepass() == true) &&
+		(m_opaqueBatchCount > 0))
+	{
+		BeginGpuScope(FrameProfiler::GPU_DEPTH_PREPASS);
+		BeginDepthPrepass();
+		DrawInstanceBatches(0, m_opaqueBatchCount, bIndirect, false);
+		EndGpuScope(FrameProfiler::GPU_DEPTH_PREPASS);
+		bDepthWritten = true;
+	}
+
+	BeginOpaquePass(bDepthWritten);
+	if (m_opaqueBatchCount > 0)
+	{
+		BeginGpuScope(FrameProfiler::GPU_OPAQUE);
+		DrawInstanceBatches(0, m_opaqueBatchCount, bIndirect, bBindTextures);
+		EndGpuScope(FrameProfiler::GPU_OPAQUE);
+	}
+	if (RenderEnvironment() == true)
+	{
+		m_pInstancedMeshes->BeginInstancedDraws();
+	}
+	if (m_opaqueBatchCount < batchCount)
+	{
+		BeginGpuScope(FrameProfiler::GPU_BLENDED);
+		BeginBlendedPass();
+		DrawInstanceBatches(m_opaqueBatchCount, batchCount, bIndirect, bBindTextures);
+		EndGpuScope(FrameProfiler::GPU_BLENDED);
+	}
+	EndScenePasses();
+
+	m_pInstancedMeshes->EndInstancedDraws();
+
+	// switch back to the scene shader program
+	m_pShaderManager->use();
+}
+
+/***********************************************************
+ *  RecordIndirectDraws()
+ *
+ *  This method is used for writing a draw command for every
+ *  batch of the frame into the indirect buffer, so that each
+ *  pass is drawn with one multi-draw.  The CPU cost no
+ *  longer grows with the number of batches.  False is
+ *  returned when multi-draws are not available.
+ ***********************************************************/
+bool SceneManager::RecordIndirectDraws()
+{
+	if ((m_pInstancedMeshes->SupportsIndirectDraws() == false) ||
+		(m_pInstancedMeshes->MapIndirectDraws(m_instanceBatches.size()) == false))
+	{
+		return(false);
+	}
+
+	for (size_t i = 0; i < m_instanceBatches.size(); i++)
+	{
+		const INSTANCE_BATCH& batch = m_instanceBatches[i];
+
+		m_pInstancedMeshes->AddIndirectDraw(
+			GetInstancedShape(batch.mesh),
+			batch.instanceCount,
+			batch.firstInstance,
+			batch.lodLevel);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  DrawInstanceBatches()
+ *
+ *  This method is used for drawing a range of the batches of
+ *  the frame, with one multi-draw from the recorded draw
+ *  commands or with one draw call per batch.
+ ***********************************************************/
+void SceneManager::DrawInstanceBatches(int firstBatch, int endBatch, bool bIndirect, bool bBindTextures)
+{
+	if (bIndirect == true)
+	{
+		m_pInstancedMeshes->DrawIndirect(firstBatch, endBatch - firstBatch);
+		return;
+	}
+
+	for (int i = firstBatch; i < endBatch; i++)
+	{
+		if ((bBindTextures == true) && (m_instanceBatches[i].textureIndex >= 0))
+		{
+			m_pTextureResidency->BindTexture(m_instanceBatches[i].textureIndex);
+		}
+		DrawMeshInstanced(
+			m_instanceBatches[i].mesh,
+			m_instanceBatches[i].instanceCount,
+			m_instanceBatches[i].firstInstance,
+			m_instanceBatches[i].lodLevel);
+	}
+}
+
+/***********************************************************
+ *  RecordDrawLists()
+ *
+ *  This method is used for splitting the render queue, from
+ *  the passed in item on, into ranges and recording the
+ *  draws of every range as a job.  Each job only touches the
+ *  objects of its own range and writes its own draw list, so
+ *  the jobs share nothing and the GL thread submits the
+ *  lists in order afterwards.
+ ***********************************************************/
+void SceneManager::RecordDrawLists(bool bInstanced, size_t firstItem)
+{
+	int itemCount = 0;
+	if (firstItem < m_renderQueue.GetItemCount())
+	{
+		itemCount = (int)(m_renderQueue.GetItemCount() - firstItem);
+	}
+
+	m_drawLists.resize(JobSystem::GetJobCount(itemCount, g_ItemsPerJob));
+	m_pJobSystem->ParallelFor(
+		itemCount,
+		g_ItemsPerJob,
+		[this, bInstanced, firstItem](int jobIndex, int begin, int end)
+		{
+			RecordDrawList(m_drawLists[jobIndex], (int)firstItem + begin, (int)firstItem + end, bInstanced);
+		});
+}
+
+/***********************************************************
+ *  RecordDrawList()
+ *
+ *  This method is used for rebuilding the model matrices of
+ *  the moved objects in a range of the render queue, culling
+ *  the range against the view and recording the visible
+ *  objects with their view depth.  Instanced objects also
+ *  pick their level of detail, and the opaque objects of a
+ *  batch are regrouped by level.  The blended objects are
+ *  only collected, since they are put in order over the
+ *  whole frame.  No OpenGL calls are made, so this runs on
+ *  any thread.
+ ***********************************************************/
+void SceneManager::RecordDrawList(DRAW_LIST& drawList, int begin, int end, bool bInstanced)
+{
+	const std::vector<RenderQueue::RENDER_ITEM>& items = m_renderQueue.GetItems();
+	INSTANCE_BATCH batch;
+	bool bInBatch = false;
+
+	drawList.objects.clear();
+	drawList.instances.clear();
+	drawList.batches.clear();
+	drawList.blendedObjects.clear();
+	drawList.firstInstance = 0;
+
+	for (int i = begin; i < end; i++)
+	{
+		SCENE_OBJECT& sceneObject = m_sceneObjects[items[i].objectIndex];
+
+		// rebuild the cached model matrix only after the object has moved,
+		// and skip objects outside of the view before any other work
+		UpdateModelMatrix(sceneObject);
+		if (IsObjectVisible(sceneObject) == false)
+		{
+			continue;
+		}
+
+		RenderQueue::DEPTH_ITEM depthItem;
+		depthItem.depth = GetViewDepth(sceneObject);
+		depthItem.objectIndex = items[i].objectIndex;
+
+		if (bInstanced == true)
+		{
+			sceneObject.lodLevels[m_viewIndex] = SelectObjectLod(sceneObject);
+		}
+
+		if (RenderQueue::GetBlendMode(items[i].sortKey) != RenderQueue::BLEND_OPAQUE)
+		{
+			drawList.blendedObjects.push_back(depthItem);
+			continue;
+		}
+
+		if (bInstanced == false)
+		{
+			drawList.objects.push_back(depthItem);
+			continue;
+		}
+
+		// start a new batch when the mesh or texture changes
+		uint64_t batchKey = RenderQueue::GetBatchKey(items[i].sortKey);
+		if ((bInBatch == true) && (batch.batchKey != batchKey))
+		{
+			FlushLodBatches(drawList, batch);
+			bInBatch = false;
+		}
+		if (bInBatch == false)
+		{
+			batch.mesh = sceneObject.mesh;
+			batch.textureIndex = sceneObject.textureIndex;
+			batch.firstInstance = 0;
+			batch.instanceCount = 0;
+			batch.batchKey = batchKey;
+			batch.blendMode = RenderQueue::BLEND_OPAQUE;
+			batch.lodLevel = 0;
+			batch.depth = 0.0f;
+			bInBatch = true;
+		}
+
+		drawList.lodObjects[sceneObject.lodLevels[m_viewIndex]].push_back(depthItem);
+	}
+
+	if (bInBatch == true)
+	{
+		FlushLodBatches(drawList, batch);
+	}
+}
+
+/***********************************************************
+ *  FlushLodBatches()
+ *
+ *  This method is used for moving the objects that a batch
+ *  collected for each level of detail into the draw list as
+ *  instances, nearest first, with one batch per level that
+ *  has instances.
+ ***********************************************************/
+void SceneManager::FlushLodBatches(DRAW_LIST& drawList, const INSTANCE_BATCH& batch)
+{
+	for (int level = 0; level < InstancedMeshes::LOD_COUNT; level++)
+	{
+		std::vector<RenderQueue::DEPTH_ITEM>& lodObjects = drawList.lodObjects[level];
+		if (lodObjects.empty() == true)
+		{
+			continue;
+		}
+
+		RenderQueue::SortFrontToBack(lodObjects);
+
+		INSTANCE_BATCH lodBatch = batch;
+		lodBatch.firstInstance = (int)drawList.instances.size();
+		lodBatch.instanceCount = (int)lodObjects.size();
+		lodBatch.lodLevel = level;
+		lodBatch.depth = lodObjects[0].depth;
+		drawList.batches.push_back(lodBatch);
+
+		for (size_t i = 0; i < lodObjects.size(); i++)
+		{
+			InstancedMeshes::INSTANCE_DATA instance;
+			GetInstanceData(m_sceneObjects[lodObjects[i].objectIndex], instance);
+			drawList.instances.push_back(instance);
+		}
+		lodObjects.clear();
+	}
+}
+
+/***********************************************************
+ *  SortBlendedObjects()
+ *
+ *  This method is used for joining the blended objects that
+ *  the jobs recorded and putting them in order of their view
+ *  depth, farthest first, so that every blended object is
+ *  drawn over the ones behind it.
+ ***********************************************************/
+void SceneManager::SortBlendedObjects()
+{
+	m_blendedOrder.clear();
+	for (size_t i = 0; i < m_drawLists.size(); i++)
+	{
+		const std::vector<RenderQueue::DEPTH_ITEM>& blendedObjects = m_drawLists[i].blendedObjects;
+		m_blendedOrder.insert(m_blendedOrder.end(), blendedObjects.begin(), blendedObjects.end());
+	}
+
+	RenderQueue::SortBackToFront(m_blendedOrder);
+}
+
+/***********************************************************
+ *  AddBlendedBatches()
+ *
+ *  This method is used for adding the sorted blended objects
+ *  as batches after the opaque ones, with their instances
+ *  starting at the passed in instance.  Only neighbours in
+ *  the depth order with the same mesh, texture and level of
+ *  detail share a batch, so the order is kept.
+ ***********************************************************/
+void SceneManager::AddBlendedBatches(int firstInstance)
+{
+	m_blendedInstances.clear();
+	for (size_t i = 0; i < m_blendedOrder.size(); i++)
+	{
+		const SCENE_OBJECT& sceneObject = m_sceneObjects[m_blendedOrder[i].objectIndex];
+
+		InstancedMeshes::INSTANCE_DATA instance;
+		GetInstanceData(sceneObject, instance);
+		m_blendedInstances.push_back(instance);
+
+		if ((m_instanceBatches.size() > (size_t)m_opaqueBatchCount) &&
+			(m_instanceBatches.back().mesh == sceneObject.mesh) &&
+			(m_instanceBatches.back().textureIndex == sceneObject.textureIndex) &&
+			(m_instanceBatches.back().lodLevel == sceneObject.lodLevels[m_viewIndex]))
+		{
+			m_instanceBatches.back().instanceCount++;
+			continue;
+		}
+
+		INSTANCE_BATCH batch;
+		batch.mesh = sceneObject.mesh;
+		batch.textureIndex = sceneObject.textureIndex;
+		batch.firstInstance = firstInstance + (int)i;
+		batch.instanceCount = 1;
+		batch.batchKey = RenderQueue::GetBatchKey(RenderQueue::MakeSortKey(
+			RenderQueue::BLEND_ALPHA,
+			sceneObject.mesh,
+			sceneObject.textureIndex,
+			sceneObject.materialIndex));
+		batch.blendMode = RenderQueue::BLEND_ALPHA;
+		batch.lodLevel = sceneObject.lodLevels[m_viewIndex];
+		batch.depth = m_blendedOrder[i].depth;
+		m_instanceBatches.push_back(batch);
+	}
+}
+
+/***********************************************************
+ *  DrawSceneObjects()
+ *
+ *  This method is used for drawing visible objects one at a
+ *  time in the passed in order.  Only the shader values that
+ *  change between draws are sent.
+ ***********************************************************/
+void SceneManager::DrawSceneObjects(const std::vector<RenderQueue::DEPTH_ITEM>& objects)
+{
+	for (size_t i = 0; i < objects.size(); i++)
+	{
+		const SCENE_OBJECT& sceneObject = m_sceneObjects[objects[i].objectIndex];
+		m_visibleObjects++;
+
+		// set the transformations into memory to be used on the drawn meshes
+		SetTransformMatrix(sceneObject.modelMatrix);
+		ApplyObjectState(sceneObject);
+
+		// draw the mesh with transformation values
+		DrawMesh(sceneObject.mesh);
+	}
+}
+
+/***********************************************************
+ *  BeginDepthPrepass()
+ *
+ *  This method is used for drawing only the depth of the
+ *  opaque objects with the depth-only program, so the
+ *  opaque pass that follows shades every pixel only once.
+ ***********************************************************/
+void SceneManager::BeginDepthPrepass()
+{
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
+	glDisable(GL_BLEND);
+	m_pInstancedMeshes->BeginDepthPrepass();
+}
+
+/***********************************************************
+ *  BeginOpaquePass()
+ *
+ *  This method is used for drawing the opaque objects
+ *  without blending.  After a depth pre-pass the depth
+ *  buffer already holds the nearest surfaces, so it is only
+ *  tested against, and the equal depths pass.
+ ***********************************************************/
+void SceneManager::BeginOpaquePass(bool bDepthWritten)
+{
+	glDisable(GL_BLEND);
+	if (bDepthWritten == true)
+	{
+		m_pInstancedMeshes->EndDepthPrepass();
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		glDepthMask(GL_FALSE);
+		glDepthFunc(GL_LEQUAL);
+	}
+}
+
+/***********************************************************
+ *  BeginBlendedPass()
+ *
+ *  This method is used for drawing the blended objects over
+ *  the opaque ones.  They are tested against the depth but
+ *  do not write it, so the blended objects behind one
+ *  another all show.
+ ***********************************************************/
+void SceneManager::BeginBlendedPass()
+{
+	glEnable(GL_BLEND);
+	glDepthMask(GL_FALSE);
+}
+
+/***********************************************************
+ *  EndScenePasses()
+ *
+ *  This method is used for setting back the depth state the
+ *  frame started with, which the buffer clears of the next
+ *  frame need.
+ ***********************************************************/
+void SceneManager::EndScenePasses()
+{
+	glDisable(GL_BLEND);
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
+}
+
+/***********************************************************
+ *  RenderEnvironment()
+ *
+ *  This method is used for drawing the sky once per view,
+ *  after the opaque objects and before the blended ones,
+ *  which show the sky behind them.  An orthographic view
+ *  has no directions to look the sky up with, so its
+ *  background stays clear.  True is returned when the sky
+ *  was drawn, which leaves the sky program in use.
+ ***********************************************************/
+bool SceneManager::RenderEnvironment()
+{
+	if ((NULL == m_pSkybox) || (m_bEnvironmentDrawn == true))
+	{
+		return(false);
+	}
+	m_bEnvironmentDrawn = true;
+
+	// the last row of a perspective projection is (0, 0, -1, 0)
+	if (m_projectionMatrix[3][3] != 0.0f)
+	{
+		return(false);
+	}
+
+	BeginGpuScope(FrameProfiler::GPU_SKY);
+	m_pSkybox->Render();
+	EndGpuScope(FrameProfiler::GPU_SKY);
+	return(true);
+}
+
+/***********************************************************
+ *  BeginGpuScope()
+ *
+ *  This method is used for starting the GPU time of a pass
+ *  when the frame profiler is set.
+ ***********************************************************/
+void SceneManager::BeginGpuScope(FrameProfiler::GPU_SCOPE scope)
+{
+	if (NULL != m_pFrameProfiler)
+	{
+		m_pFrameProfiler->BeginGpuScope(scope);
+	}
+}
+
+/***********************************************************
+ *  EndGpuScope()
+ *
+ *  This method is used for ending the GPU time of a pass
+ *  when the frame profiler is set.
+ ***********************************************************/
+void SceneManager::EndGpuScope(FrameProfiler::GPU_SCOPE scope)
+{
+	if (NULL != m_pFrameProfiler)
+	{
+		m_pFrameProfiler->EndGpuScope(scope);
+	}
+}
+
+/***********************************************************
+ *  RenderSceneGpuCulled()
+ *
+ *  This method is used for culling and drawing the queued
+ *  opaque objects without any per-object work on the CPU.
+ *  The culling pass tests every object against the view and
+ *  writes the draw commands, which are drawn with one
+ *  multi-draw, after another one into the depth buffer when
+ *  the depth pre-pass is on.  The order of the culled draws
+ *  is not known, so the blended objects are sorted and drawn
+ *  from the CPU after them.  False is returned when the pass
+ *  is not available, in which case the jobs cull on the CPU.
+ ***********************************************************/
+bool SceneManager::RenderSceneGpuCulled()
+{
+	// a multi-draw cannot bind a texture between its draws
+	if ((NULL == m_pGpuCulling) || (m_bGpuCullingEnabled == false) ||
+		(m_pTextureResidency->IsBindless() == false) ||
+		(m_pInstancedMeshes->UsesTextureHandles() == false))
+	{
+		return(false);
+	}
+
+	if (m_bGpuSceneDirty == true)
+	{
+		UploadGpuScene();
+	}
+
+	const Frustum* pFrustum = NULL;
+	if ((m_bCullingEnabled == true) && (m_bFrustumValid == true))
+	{
+		pFrustum = &m_viewFrustum;
+	}
+	m_pGpuCulling->SetLodSelection(g_LodScreenSizes, m_lodHysteresis);
+	m_pGpuCulling->Cull(
+		pFrustum,
+		m_lodDepthRow,
+		(m_bFrustumValid == true) ? m_lodScale : 0.0f,
+		m_viewIndex);
+
+	GLuint commandBuffer = m_pGpuCulling->GetCommandBuffer();
+
+	m_pInstancedMeshes->BeginCulledDraws(m_pGpuCulling->GetInstanceBuffer());
+
+	bool bDepthWritten = false;
+	if ((m_bDepthPrepassEnabled == true) &&
+		(m_pInstancedMeshes->SupportsDepthPrepass() == true))
+	{
+		BeginGpuScope(FrameProfiler::GPU_DEPTH_PREPASS);
+		BeginDepthPrepass();
+		m_pInstancedMeshes->DrawCulled(commandBuffer, 0, m_gpuOpaqueCommands);
+		EndGpuScope(FrameProfiler::GPU_DEPTH_PREPASS);
+		bDepthWritten = true;
+	}
 
+	BeginGpuScope(FrameProfiler::GPU_OPAQUE);
+	BeginOpaquePass(bDepthWritten);
+	m_pInstancedMeshes->DrawCulled(commandBuffer, 0, m_gpuOpaqueCommands);
+	EndGpuScope(FrameProfiler::GPU_OPAQUE);
+	EndScenePasses();
+	m_pInstancedMeshes->EndInstancedDraws();
+	RenderEnvironment();
 
-	//very important to prepare scene we need to load the scene texture to get images to load!
-	LoadSceneTextures();
+	// the blended objects follow the opaque ones in the queue
+	RenderSceneInstanced(m_renderQueue.GetFirstBlendedItem());
 
-	// define the materials for objects in the scene
-	DefineObjectMaterials();
-	// add and define the light sources for the scene
-	SetupSceneLights();
+	// the visible count stays on the GPU - reading it back would stall
+	m_visibleObjects += m_pGpuCulling->GetObjectCount();
 
-	//loads the shapes needed for the scene
-	m_basicMeshes->LoadPlaneMesh(); //for ground and nightsky backgroung
-	m_basicMeshes->LoadCylinderMesh(); //for pencil
-	m_basicMeshes->LoadConeMesh(); //for cone roof on top of box
-	m_basicMeshes->LoadBoxMesh();    // For the box
-	m_basicMeshes->LoadSphereMesh(); // For the ball
-	m_basicMeshes->LoadPyramid3Mesh(); // For the pyramid
-	m_basicMeshes->LoadTaperedCylinderMesh(); //for cylinder 
+	// switch back to the scene shader program
+	m_pShaderManager->use();
+
+	return(true);
 }
 
 /***********************************************************
- *  RenderScene()
+ *  UploadGpuScene()
  *
- *  This method is used for rendering the 3D scene by 
- *  transforming and drawing the basic 3D shapes
+ *  This method is used for uploading every queued opaque
+ *  object to the culling pass, in queue order, with a draw
+ *  command for every level of each batch.  A command has
+ *  room for all the objects of its batch, starting at the
+ *  batch's first position in the queue within the part of
+ *  the instance buffer for its level.  This only happens
+ *  again after the scene has changed.
  ***********************************************************/
-void SceneManager::RenderScene()
+void SceneManager::UploadGpuScene()
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
-
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
-	/******************************************************************/
-	
-
-	// This section is part of designing the floor of the scene
+	const std::vector<RenderQueue::RENDER_ITEM>& items = m_renderQueue.GetItems();
+	size_t opaqueCount = m_renderQueue.GetFirstBlendedItem();
+	std::vector<GpuCulling::CULL_OBJECT> objects(opaqueCount);
+	std::vector<InstancedMeshes::DRAW_COMMAND> commands;
+
+	// the moved objects rebuild their matrices on all the cores
+	m_pJobSystem->ParallelFor(
+		(int)opaqueCount,
+		g_ItemsPerJob,
+		[this, &items, &objects](int /*jobIndex*/, int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				SCENE_OBJECT& sceneObject = m_sceneObjects[items[i].objectIndex];
+				GpuCulling::CULL_OBJECT& object = objects[i];
+
+				UpdateModelMatrix(sceneObject);
+				GetInstanceData(sceneObject, object.instance);
+				object.boundsSphere = glm::vec4(sceneObject.boundsCenter, sceneObject.boundsRadius);
+				object.commandIndex = 0;
+				object.lodCount = (GLuint)InstancedMeshes::GetLodCount(GetInstancedShape(sceneObject.mesh));
+				object.padding[0] = 0;
+				object.padding[1] = 0;
+			}
+		});
+
+	uint64_t batchKey = 0;
+	for (size_t i = 0; i < opaqueCount; i++)
+	{
+		uint64_t itemBatchKey = RenderQueue::GetBatchKey(items[i].sortKey);
 
-	//for the floor mesh 
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(35.0f, 1.0f, 15.0f);
+		if ((commands.empty() == true) || (itemBatchKey != batchKey))
+		{
+			InstancedMeshes::SHAPE_ID shape = GetInstancedShape(m_sceneObjects[items[i].objectIndex].mesh);
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+			for (int level = 0; level < InstancedMeshes::LOD_COUNT; level++)
+			{
+				InstancedMeshes::DRAW_COMMAND command;
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
+				m_pInstancedMeshes->GetShapeCommand(shape, level, command);
+				command.baseInstance = (GLuint)((level * opaqueCount) + i);
+				commands.push_back(command);
+			}
+			batchKey = itemBatchKey;
+		}
+		objects[i].commandIndex = (GLuint)(commands.size() - InstancedMeshes::LOD_COUNT);
+	}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	m_pGpuCulling->SetScene(objects, commands, MAX_VIEWS);
+	m_gpuOpaqueCommands = (int)commands.size();
+	m_bGpuSceneDirty = false;
+}
 
-	//SetShaderColor(211/255.0, 211/255.0, 211/255.0, 1);
+/***********************************************************
+ *  SetShadowCascadeCount()
+ *
+ *  This method is used for choosing how many cascades the
+ *  shadows of the directional light use.  The count is kept
+ *  for shadow maps that are created later.
+ ***********************************************************/
+void SceneManager::SetShadowCascadeCount(int cascadeCount)
+{
+	m_shadowCascadeCount = cascadeCount;
+	if (NULL != m_pShadowMaps)
+	{
+		m_pShadowMaps->SetCascadeCount(cascadeCount);
+	}
+}
 
-	//Applies texture of ground to the floor and shade material wood for light reflecting off of it. 
-	SetShaderMaterial("wood"); 
-	SetShaderTexture("ground");
-	SetTextureUVScale(2.0, 2.0);
+/***********************************************************
+ *  RenderShadowMaps()
+ *
+ *  This method is used for drawing the shadow cascades of
+ *  the frame.  Nothing is drawn while the cascades and the
+ *  casters stay where they were.  Otherwise the opaque
+ *  objects of the render queue are gathered as casters, in
+ *  queue order so the shapes come in runs, and the shadow
+ *  maps cull them per cascade.
+ ***********************************************************/
+void SceneManager::RenderShadowMaps()
+{
+	if (NULL == m_pShadowMaps)
+	{
+		return;
+	}
 
+	if (m_bShadowCastersDirty == true)
+	{
+		m_pShadowMaps->Invalidate();
+		m_bShadowCastersDirty = false;
+	}
+	if (m_pShadowMaps->UpdateCascades(m_viewMatrix, m_projectionMatrix) == false)
+	{
+		return;
+	}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
-	/****************************************************************/
+	const std::vector<RenderQueue::RENDER_ITEM>& items = m_renderQueue.GetItems();
 
-	//for the pencil cylander shape mesh 
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.3f, 3.0f, 0.3f);
+	// translucent objects follow the opaque ones and cast no shadow
+	m_shadowCasters.clear();
+	for (size_t i = 0; i < m_renderQueue.GetFirstBlendedItem(); i++)
+	{
+		SCENE_OBJECT& sceneObject = m_sceneObjects[items[i].objectIndex];
+		UpdateModelMatrix(sceneObject);
+
+		ShadowMaps::CASTER caster;
+		caster.shape = GetInstancedShape(sceneObject.mesh);
+		caster.model = sceneObject.modelMatrix;
+		caster.center = sceneObject.boundsCenter;
+		caster.radius = sceneObject.boundsRadius;
+		m_shadowCasters.push_back(caster);
+	}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 90.0f;
+	BeginGpuScope(FrameProfiler::GPU_SHADOWS);
+	m_pShadowMaps->Render(m_shadowCasters);
+	EndGpuScope(FrameProfiler::GPU_SHADOWS);
+}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.5f, 1.5f, 3.5f);
+/**************************************************************/
+/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
+/*** preparing and rendering their own 3D replicated scenes.***/
+/*** Please refer to the code in the OpenGL sample project  ***/
+/*** for assistance.                                        ***/
+/**************************************************************/
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+ /***********************************************************
+  *  LoadSceneTextures()
+  *
+  *  This method is used for preparing the 3D scene by loading
+  *  the shapes, textures in memory to support the 3D scene
+  *  rendering
+  ***********************************************************/
 
-	//SetShaderColor(160/255.0, 82 / 255.0, 45 / 255.0, 1);
+void SceneManager::LoadSceneTextures()
+{
+	/*** STUDENTS - add the code BELOW for loading the textures that ***/
+	/*** will be used for mapping to objects in the 3D scene. Any    ***/
+	/*** number of textures can be loaded per scene. Refer to the    ***/
+	/*** code in the OpenGL Sample for help.                       ***/
 
-	//Applies wood texture and shading to the pencil. 
-	SetShaderTexture("wood");
-	SetTextureUVScale(0.5, 0.5);
-	SetShaderMaterial("wood");
+	bool bReturn = false;
 
+	/**this part of the code loads the image textures from textures folder into the scene allowing
+	the floor to be ground, eraser pink texture, wood for the pencil texture, roof for the cone to 
+	be colored and nightsky for background. **/
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawCylinderMesh();
-	/****************************************************************/
+	bReturn = CreateGLTexture(
+		"textures/wood.jpg", "wood");
 
-// For vertical backdrop plane (background wall)
+	bReturn = CreateGLTexture(
+		"textures/ground.jpg", "ground");
+	bReturn = CreateGLTexture(
+		"textures/eraser.jpg", "eraser");
+	bReturn = CreateGLTexture(
+		"textures/roof.jpg", "roof");
+	bReturn = CreateGLTexture(
+		"textures/nightsky.jpg", "nightsky");
 
-	scaleXYZ = glm::vec3(35.0f, 15.0f, 20.0f);
+	// the night sky surrounds the scene as the environment cubemap,
+	// with the same image on every face
+	if (NULL != m_pSkybox)
+	{
+		const char* skyFaces[Skybox::FACE_COUNT] =
+		{
+			"textures/nightsky.jpg", "textures/nightsky.jpg",
+			"textures/nightsky.jpg", "textures/nightsky.jpg",
+			"textures/nightsky.jpg", "textures/nightsky.jpg"
+		};
+		bReturn = m_pSkybox->LoadCubemap(skyFaces);
+	}
 
-	XrotationDegrees = -90.0f; // Lets the plane cover the background
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	// the textures are referenced by index, so they do not need
+	// to be bound to texture slots here - any number of textures
+	// can be loaded for the scene
+}
 
-	// Push it back behind the scene
-	positionXYZ = glm::vec3(0.0f, 19.0f, -15.0f); 
+/***********************************************************
+ *  DefineObjectMaterials()
+ *
+ *  This method is used for configuring the various material
+ *  settings for all of the objects within the 3D scene.
+ ***********************************************************/
+void SceneManager::DefineObjectMaterials()
+{
+	//allows for the materials to be able to reflect light off of them. 
+	OBJECT_MATERIAL goldMaterial;
+	goldMaterial.diffuseColor = glm::vec3(0.4f, 0.4f, 0.4f);
+	goldMaterial.specularColor = glm::vec3(0.7f, 0.7f, 0.6f);
+	goldMaterial.shininess = 52.0;
+	goldMaterial.tag = "metal";
 
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	m_objectMaterials.push_back(goldMaterial);
 
-	//night sky background for the scene!
-	SetShaderTexture("nightsky");
-	SetTextureUVScale(1, 1);
+	OBJECT_MATERIAL woodMaterial;
+	woodMaterial.diffuseColor = glm::vec3(0.2f, 0.2f, 0.3f);
+	woodMaterial.specularColor = glm::vec3(0.0f, 0.0f, 0.0f);
+	woodMaterial.shininess = 0.1;
+	woodMaterial.tag = "wood";
 
-	m_basicMeshes->DrawPlaneMesh();
+	m_objectMaterials.push_back(woodMaterial);
 
-	//for the pencil tip shape mesh 
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.3f, 0.5f, 0.3f);
+	OBJECT_MATERIAL glassMaterial;
+	glassMaterial.diffuseColor = glm::vec3(0.2f, 0.2f, 0.2f);
+	glassMaterial.specularColor = glm::vec3(1.0f, 1.0f, 1.0f);
+	glassMaterial.shininess = 95.0;
+	glassMaterial.tag = "glass";
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 90.0f;
+	m_objectMaterials.push_back(glassMaterial);
+}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-2.5f, 1.5f, 3.5f);
+/***********************************************************
+ *  SetupSceneLights()
+ *
+ *  This method is called to add and configure the light
+ *  sources for the 3D scene.  There are up to 4 light sources.
+ ***********************************************************/
+void SceneManager::SetupSceneLights()
+{
+	// this line of code is NEEDED for telling the shaders to render 
+	// the 3D scene with custom lighting - to use the default rendered 
+	// lighting then comment out the following line
+	m_pShaderUniforms->SetBool(ShaderUniforms::USE_LIGHTING, true);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// My main directional light for high exposure daylight - there
+	// is only one directional light, so these are its final values
+	SetDirectionalLight(
+		glm::vec3(-0.1f, -1.0f, -0.1f),
+		glm::vec3(1.08f, 1.08f, 1.08f),  // Very bright ambient light
+		glm::vec3(2.25f, 2.25f, 2.25f),  // Intense diffuse light
+		glm::vec3(1.98f, 1.98f, 1.98f)); // High specular highlights
 
-	SetShaderMaterial("metal");
-	SetTextureUVScale(1, 1);
-	SetShaderColor(0.196f, 0.196f, 0.196f, 1.0f);
+	//I wanted to add a purple color to the scene I had to make it a little darker for purple light to be seen.
+	SetPointLight(
+		1,
+		glm::vec3(5.0f, 5.0f, 3.0f),
+		glm::vec3(0.08f, 0.0f, 0.12f),   // ambient light
+		glm::vec3(0.5f, 0.1f, 0.7f),     // diffuse light
+		glm::vec3(0.7f, 0.3f, 0.9f));    // specular highlights
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawConeMesh();
+	//Last light which adds a green emrald type of color to the scene
+	SetPointLight(
+		2,
+		glm::vec3(-6.0f, 5.0f, 2.0f),    // Positioned opposite purple light
+		glm::vec3(0.0f, 0.05f, 0.05f),   // ambient
+		glm::vec3(0.2f, 0.8f, 0.5f),     // diffuse green
+		glm::vec3(0.3f, 1.0f, 0.6f));    // specular: bright green highlights
+}
 
-	/****************************************************************/
-	//for the pencil eraser shape mesh 
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.3f, 0.5f, 0.3f);
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 90.0f;
+/***********************************************************
+ *  DefineSceneObjects()
+ *
+ *  This method is used for defining the retained objects
+ *  that make up the 3D scene.  Each object is described
+ *  once here and then drawn by RenderScene() every frame.
+ ***********************************************************/
+void SceneManager::DefineSceneObjects()
+{
+	// This section is part of designing the floor of the scene
+	//Applies texture of ground to the floor and shade material wood for light reflecting off of it. 
+	AddSceneObject(
+		MESH_PLANE,
+		glm::vec3(35.0f, 1.0f, 15.0f),
+		glm::vec3(0.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 0.0f),
+		"wood", "ground",
+		glm::vec2(2.0f, 2.0f),
+		glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(1.0f, 1.5f, 3.5f);
+	//for the pencil cylander shape mesh 
+	//Applies wood texture and shading to the pencil. 
+	AddSceneObject(
+		MESH_CYLINDER,
+		glm::vec3(0.3f, 3.0f, 0.3f),
+		glm::vec3(0.0f, 0.0f, 90.0f),
+		glm::vec3(0.5f, 1.5f, 3.5f),
+		"wood", "wood",
+		glm::vec2(0.5f, 0.5f),
+		glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+
+	// For vertical backdrop plane (background wall)
+	// Lets the plane cover the background and pushes it back behind the scene
+	//night sky background for the scene - only needed without the skybox
+	if (NULL == m_pSkybox)
+	{
+		AddSceneObject(
+			MESH_PLANE,
+			glm::vec3(35.0f, 15.0f, 20.0f),
+			glm::vec3(-90.0f, 0.0f, 0.0f),
+			glm::vec3(0.0f, 19.0f, -15.0f),
+			"wood", "nightsky",
+			glm::vec2(1.0f, 1.0f),
+			glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+	}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	//for the pencil tip shape mesh 
+	AddSceneObject(
+		MESH_CONE,
+		glm::vec3(0.3f, 0.5f, 0.3f),
+		glm::vec3(0.0f, 0.0f, 90.0f),
+		glm::vec3(-2.5f, 1.5f, 3.5f),
+		"metal", "",
+		glm::vec2(1.0f, 1.0f),
+		glm::vec4(0.196f, 0.196f, 0.196f, 1.0f));
 
-	//SetShaderColor(255 / 255.0, 105 / 255.0, 97 / 255.0, 1);
+	//for the pencil eraser shape mesh 
 	//pink eraser texture and shading for light
-	SetShaderTexture("eraser");
-	SetTextureUVScale(0.5, 0.5);
-
-	// draw the mesh with transformation values
-	//SetShaderMaterial("glass");
-	m_basicMeshes->DrawCylinderMesh();
-	/****************************************************************/
+	AddSceneObject(
+		MESH_CYLINDER,
+		glm::vec3(0.3f, 0.5f, 0.3f),
+		glm::vec3(0.0f, 0.0f, 90.0f),
+		glm::vec3(1.0f, 1.5f, 3.5f),
+		"metal", "eraser",
+		glm::vec2(0.5f, 0.5f),
+		glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
 
 	// Draw the box (cube)
-	scaleXYZ = glm::vec3(2.0f, 2.0f, 2.0f); 
-	positionXYZ = glm::vec3(-7.0f, 1.0f, 0.0f); 
-	SetTransformations(scaleXYZ, 0.0f, 66.0f, 0.0f, positionXYZ);
-	SetShaderColor(0.18f, 0.45f, 0.28f, 1.0f);
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(
+		MESH_BOX,
+		glm::vec3(2.0f, 2.0f, 2.0f),
+		glm::vec3(0.0f, 66.0f, 0.0f),
+		glm::vec3(-7.0f, 1.0f, 0.0f),
+		"metal", "",
+		glm::vec2(1.0f, 1.0f),
+		glm::vec4(0.18f, 0.45f, 0.28f, 1.0f));
 
 	// Draw the cone on top of the box  - placed on top of the box 2.0 to adjust it upward above box
-	scaleXYZ = glm::vec3(1.0f, 2.0f, 1.0f); 
-	positionXYZ = glm::vec3(-7.0f, 2.0f, 0.0f); 
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ);
-	
 	//adds the roof texture to the box
-	SetShaderTexture("roof");
-	SetTextureUVScale(.5, .5);
+	AddSceneObject(
+		MESH_CONE,
+		glm::vec3(1.0f, 2.0f, 1.0f),
+		glm::vec3(0.0f, 0.0f, 0.0f),
+		glm::vec3(-7.0f, 2.0f, 0.0f),
+		"metal", "roof",
+		glm::vec2(0.5f, 0.5f),
+		glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
 
-	m_basicMeshes->DrawConeMesh();
-	/****************************************************************/
 	// Sphere (ball) 
-	scaleXYZ = glm::vec3(2.05, 2.05f, 2.05f); 
-	positionXYZ = glm::vec3(4.0f, 2.2f, 0.0f); 
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ);
-	SetShaderColor(0.35f, 0.55f, 0.85f, 1.0f); // Blue color
-	m_basicMeshes->DrawSphereMesh();
-
 	//I left the ball alone with now texture to demonstrate the light in the scene
+	AddSceneObject(
+		MESH_SPHERE,
+		glm::vec3(2.05f, 2.05f, 2.05f),
+		glm::vec3(0.0f, 0.0f, 0.0f),
+		glm::vec3(4.0f, 2.2f, 0.0f),
+		"metal", "",
+		glm::vec2(1.0f, 1.0f),
+		glm::vec4(0.35f, 0.55f, 0.85f, 1.0f)); // Blue color
 
-
-	/****************************************************************/
 	// Pyramid 
-	scaleXYZ = glm::vec3(4.0f, 7.0f, 4.0f); 
-	positionXYZ = glm::vec3(9.0f, 3.5f, 0.0f); 
-	SetTransformations(scaleXYZ, 0.0f, 25.0f, 0.0f, positionXYZ);
-	SetShaderColor(0.74f, 0.62f, 0.36f, 1.0f);  // Light golden sand color to show lights
-	m_basicMeshes->DrawPyramid3Mesh();
-
-	/****************************************************************/
+	AddSceneObject(
+		MESH_PYRAMID3,
+		glm::vec3(4.0f, 7.0f, 4.0f),
+		glm::vec3(0.0f, 25.0f, 0.0f),
+		glm::vec3(9.0f, 3.5f, 0.0f),
+		"metal", "",
+		glm::vec2(1.0f, 1.0f),
+		glm::vec4(0.74f, 0.62f, 0.36f, 1.0f));  // Light golden sand color to show lights
 
 	//This part is the last object I designed in my project which was the cylinder I wanted it positioned in the back and to show lights too
-	scaleXYZ = glm::vec3(1.8f, 3.7f, 1.8f);  
-	positionXYZ = glm::vec3(-3.0f, 0.75f, -2.25f); 
+	AddSceneObject(
+		MESH_TAPERED_CYLINDER,
+		glm::vec3(1.8f, 3.7f, 1.8f),
+		glm::vec3(0.0f, 15.0f, 0.0f),
+		glm::vec3(-3.0f, 0.75f, -2.25f),
+		"metal", "",
+		glm::vec2(1.0f, 1.0f),
+		glm::vec4(0.65f, 0.18f, 0.22f, 1.0f));
+}
 
-	
-	SetTransformations(
-		scaleXYZ,
-		0.0f,    
-		15.0f,   
-		0.0f,    
-		positionXYZ
-	);
-	SetShaderColor(0.65f, 0.18f, 0.22f, 1.0f);
+/***********************************************************
+ *  PrepareScene()
+ *
+ *  This method is used for preparing the 3D scene by loading
+ *  the shapes, textures in memory to support the 3D scene 
+ *  rendering
+ ***********************************************************/
+void SceneManager::PrepareScene()
+{
+	// only one instance of a particular mesh needs to be
+	// loaded in memory no matter how many times it is drawn
+	// in the rendered 3D scene
+
+
+	// the environment pass draws the sky in place of a backdrop,
+	// once the cubemap is loaded with the scene textures
+	m_pSkybox.reset(new Skybox());
+	if (m_pSkybox->Initialize(m_pUniformBuffers) == false)
+	{
+		m_pSkybox.reset();
+	}
+
+	// a scene file replaces the textures, materials, lights and
+	// objects defined below
+	bool bSceneFileLoaded = false;
+	if (m_sceneFilename.empty() == false)
+	{
+		bSceneFileLoaded = LoadSceneFile(m_sceneFilename.c_str());
+	}
+
+	if (bSceneFileLoaded == false)
+	{
+		//very important to prepare scene we need to load the scene texture to get images to load!
+		LoadSceneTextures();
+
+		// define the materials for objects in the scene
+		DefineObjectMaterials();
+		UploadObjectMaterials();
+		// add and define the light sources for the scene
+		SetupSceneLights();
+	}
+	if ((NULL != m_pSkybox) && (m_pSkybox->IsLoaded() == false))
+	{
+		m_pSkybox.reset();
+	}
+
+	//loads the shapes needed for the scene
+	m_basicMeshes->LoadPlaneMesh(); //for ground and nightsky backgroung
+	m_basicMeshes->LoadCylinderMesh(); //for pencil
+	m_basicMeshes->LoadConeMesh(); //for cone roof on top of box
+	m_basicMeshes->LoadBoxMesh();    // For the box
+	m_basicMeshes->LoadSphereMesh(); // For the ball
+	m_basicMeshes->LoadPyramid3Mesh(); // For the pyramid
+	m_basicMeshes->LoadTaperedCylinderMesh(); //for cylinder 
+
+	// the objects are only described once - RenderScene() draws
+	// them every frame from the retained list
+	if (bSceneFileLoaded == false)
+	{
+		DefineSceneObjects();
+	}
+
+	// the instanced path draws all copies of a shape with one draw
+	// call - without it the objects are drawn one at a time with the
+	// scene shader, which stays the default since the instanced shaders
+	// do not have its lighting toggle
+	if (m_bInstancingEnabled == true)
+	{
+		m_pInstancedMeshes.reset(new InstancedMeshes());
+		if (m_pInstancedMeshes->Initialize(m_pUniformBuffers) == false)
+		{
+			m_pInstancedMeshes.reset();
+		}
+	}
+
+	// the culling pass writes the commands that the multi-draws read
+	if ((NULL != m_pInstancedMeshes) &&
+		(m_pInstancedMeshes->SupportsIndirectDraws() == true) &&
+		(GpuCulling::IsSupported() == true))
+	{
+		m_pGpuCulling.reset(new GpuCulling());
+		if (m_pGpuCulling->Initialize() == false)
+		{
+			m_pGpuCulling.reset();
+		}
+	}
+
+	// the instanced shader shades the point lights of its cluster
+	if ((NULL != m_pInstancedMeshes) &&
+		(ClusteredLights::IsSupported() == true))
+	{
+		m_pClusteredLights.reset(new ClusteredLights());
+		if (m_pClusteredLights->Initialize(m_pUniformBuffers) == false)
+		{
+			m_pClusteredLights.reset();
+		}
+	}
+
+	// the instanced shader reads the shadows of the directional light
+	if ((NULL != m_pInstancedMeshes) &&
+		(ShadowMaps::IsSupported() == true))
+	{
+		m_pShadowMaps.reset(new ShadowMaps());
+		if (m_pShadowMaps->Initialize(m_pUniformBuffers, m_pInstancedMeshes.get()) == false)
+		{
+			m_pShadowMaps.reset();
+		}
+		else
+		{
+			m_pShadowMaps->SetLightDirection(m_directionalLightDirection);
+			m_pShadowMaps->SetCascadeCount(m_shadowCascadeCount);
+		}
+	}
+
+	WatchFiles(bSceneFileLoaded);
+	m_pShaderManager->use();
+}
+
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering the 3D scene by 
+ *  drawing the retained scene objects, the opaque ones
+ *  front to back and then the blended ones back to front.
+ *  The model matrix of an object is only rebuilt when the
+ *  object is dirty, and only the shader values that change
+ *  between draws are sent.  By default the objects are
+ *  drawn one at a time with the scene shader - the
+ *  instanced draws, the GPU culling, the clustered lights
+ *  and the shadows need SetInstancingEnabled().
+ ***********************************************************/
+void SceneManager::RenderScene()
+{
+	UpdateScene();
+	RenderSceneView(0);
+}
+
+/***********************************************************
+ *  UpdateScene()
+ *
+ *  This method is used for the work of a frame that all of
+ *  its views share - the uploads, the render queue, the
+ *  moved objects, the lights, and the clustered lights and
+ *  shadow maps when the instanced path is on.  Every
+ *  view of the frame then only culls and draws the shared
+ *  queue and buffers.  The shadow cascades are fitted to the
+ *  view that is set, which is the one of the main camera.
+ ***********************************************************/
+void SceneManager::UpdateScene()
+{
+	// textures decoded since the last frame replace their placeholders
+	UpdateTextureLoads();
+	if (NULL != m_pUniformBuffers)
+	{
+		m_pUniformBuffers->UpdateTextureHandles();
+	}
+
+	if (m_bRenderQueueDirty == true)
+	{
+		BuildRenderQueue();
+	}
+	// the moved objects are rebuilt together before any culling
+	UpdateMovedObjects();
+	m_visibleObjects = 0;
+
+	// the light block is only uploaded after a light has changed
+	if (NULL != m_pUniformBuffers)
+	{
+		m_pUniformBuffers->UpdateLights();
+	}
+
+	if (NULL == m_pInstancedMeshes)
+	{
+		return;
+	}
+
+	if ((NULL != m_pClusteredLights) && (m_bClusteredLightsDirty == true))
+	{
+		m_pClusteredLights->SetLights(m_clusteredLights);
+		m_bClusteredLightsDirty = false;
+	}
+	RenderShadowMaps();
+}
+
+/***********************************************************
+ *  RenderSceneView()
+ *
+ *  This method is used for culling and drawing the scene
+ *  from the view and projection set last, into the viewport
+ *  that is set.  The levels of detail are picked with the
+ *  ones the view index chose in the previous frame, so the
+ *  views do not undo each other's hysteresis.  UpdateScene()
+ *  must have been called for the frame.  Without the
+ *  instanced path, which SetInstancingEnabled() turns on,
+ *  the objects are culled on the CPU and drawn one at a
+ *  time with the scene shader.
+ ***********************************************************/
+void SceneManager::RenderSceneView(int viewIndex)
+{
+	m_viewIndex = glm::clamp(viewIndex, 0, MAX_VIEWS - 1);
+	m_bEnvironmentDrawn = false;
 
-	m_basicMeshes->DrawTaperedCylinderMesh();
+	// with the instanced path turned on and available, every copy of
+	// a shape is drawn with one call, and the culling and the draw
+	// commands can be done on the GPU
+	if (NULL != m_pInstancedMeshes)
+	{
+		// the point lights are binned into the clusters of the view
+		// before the draws that shade them
+		if (NULL != m_pClusteredLights)
+		{
+			m_pClusteredLights->Update(m_viewMatrix, m_projectionMatrix);
+		}
+
+		if (RenderSceneGpuCulled() == false)
+		{
+			RenderSceneInstanced(0);
+		}
+		// a frame without any instances still has the sky
+		if (RenderEnvironment() == true)
+		{
+			m_pShaderManager->use();
+		}
+		return;
+	}
+
+	// the matrices and culling are done by jobs before any draw
+	RecordDrawLists(false, 0);
+
+	// there is no depth pre-pass here, since the depth-only program
+	// is one of the instanced ones, so the opaque objects go nearest
+	// first by depth ranges - the hidden pixels mostly fail the depth
+	// test, and each range keeps the queue order of the shader state
+	m_opaqueOrder.clear();
+	for (size_t i = 0; i < m_drawLists.size(); i++)
+	{
+		const std::vector<RenderQueue::DEPTH_ITEM>& objects = m_drawLists[i].objects;
+		m_opaqueOrder.insert(m_opaqueOrder.end(), objects.begin(), objects.end());
+	}
+	RenderQueue::SortFrontToBackCoarse(m_opaqueOrder);
+	SortBlendedObjects();
+
+	// the first draw of every view sets the full shader state
+	ResetShaderState();
 
+	BeginGpuScope(FrameProfiler::GPU_OPAQUE);
+	BeginOpaquePass(false);
+	DrawSceneObjects(m_opaqueOrder);
+	EndGpuScope(FrameProfiler::GPU_OPAQUE);
+	if (RenderEnvironment() == true)
+	{
+		m_pShaderManager->use();
+	}
+	BeginGpuScope(FrameProfiler::GPU_BLENDED);
+	BeginBlendedPass();
+	DrawSceneObjects(m_blendedOrder);
+	EndGpuScope(FrameProfiler::GPU_BLENDED);
+	EndScenePasses();
 }
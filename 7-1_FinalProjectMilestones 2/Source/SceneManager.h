@@ -10,9 +10,30 @@
 #pragma once
 
 #include "ShaderManager.h"
+#include "ShaderUniforms.h"
+#include "UniformBuffers.h"
 #include "ShapeMeshes.h"
+#include "RenderQueue.h"
+#include "InstancedMeshes.h"
+#include "GpuCulling.h"
+#include "ClusteredLights.h"
+#include "ShadowMaps.h"
+#include "Skybox.h"
+#include "SceneFile.h"
+#include "HotReload.h"
+#include "Frustum.h"
+#include "TextureLoader.h"
+#include "TextureResidency.h"
+#include "MaterialTable.h"
+#include "GpuResources.h"
+#include "FrameProfiler.h"
+#include "JobSystem.h"
+#include "TransformBatch.h"
 
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 /***********************************************************
@@ -25,15 +46,26 @@ class SceneManager
 {
 public:
 	// constructor
-	SceneManager(ShaderManager* pShaderManager);
+	SceneManager(
+		ShaderManager* pShaderManager,
+		ShaderUniforms* pShaderUniforms,
+		UniformBuffers* pUniformBuffers);
 	// destructor
 	~SceneManager();
 
+	// number of views that keep their own levels of detail - the
+	// views past the last one share its levels
+	static const int MAX_VIEWS = 4;
+
 	// properties for loaded texture access
 	struct TEXTURE_INFO
 	{
 		std::string tag;
-		uint32_t ID;
+		// empty until the first image is uploaded
+		GpuTexture texture;
+		TexturePool::TEXTURE_FORMAT format;
+		// image file the texture is loaded from
+		std::string filename;
 	};
 
 	// properties for object materials
@@ -45,29 +77,231 @@ public:
 		std::string tag;
 	};
 
+	// basic shape meshes that can be drawn for a scene object
+	enum MESH_TYPE
+	{
+		MESH_PLANE = 0,
+		MESH_BOX,
+		MESH_CONE,
+		MESH_CYLINDER,
+		MESH_PYRAMID3,
+		MESH_SPHERE,
+		MESH_TAPERED_CYLINDER,
+		MESH_COUNT
+	};
+
+	// properties for a retained object in the 3D scene
+	struct SCENE_OBJECT
+	{
+		MESH_TYPE mesh;
+		std::string materialTag;
+		// empty when the object is drawn with a solid color
+		std::string textureTag;
+		glm::vec2 uvScale;
+		glm::vec4 color;
+		glm::vec3 scaleXYZ;
+		glm::vec3 rotationDegrees;
+		glm::vec3 positionXYZ;
+		// cached model matrix, rebuilt only when bDirty is set
+		glm::mat4 modelMatrix;
+		// world space bounding sphere, rebuilt with the model matrix
+		glm::vec3 boundsCenter;
+		float boundsRadius;
+		bool bDirty;
+		// texture index and material index resolved from the tags
+		int textureIndex;
+		int materialIndex;
+		// level of detail the object was last drawn with in each view
+		int lodLevels[MAX_VIEWS];
+	};
+
+	// consecutive queued draws that are drawn with one instanced call
+	struct INSTANCE_BATCH
+	{
+		MESH_TYPE mesh;
+		int textureIndex;
+		int firstInstance;
+		int instanceCount;
+		// render queue batch key shared by the instances
+		uint64_t batchKey;
+		RenderQueue::BLEND_MODE blendMode;
+		int lodLevel;
+		// view depth of the nearest instance
+		float depth;
+	};
+
+	// draws recorded by a job for one range of the render queue -
+	// only one of the two opaque forms is filled, depending on the path
+	struct DRAW_LIST
+	{
+		// visible opaque objects in queue order, for single draws
+		std::vector<RenderQueue::DEPTH_ITEM> objects;
+		// per-instance values and batches of the opaque objects, for
+		// instanced draws - the first instance of a batch is relative
+		// to the list
+		std::vector<InstancedMeshes::INSTANCE_DATA> instances;
+		std::vector<INSTANCE_BATCH> batches;
+		// where the instances of the list start in the frame
+		int firstInstance;
+		// objects of the current batch sorted by level of detail
+		std::vector<RenderQueue::DEPTH_ITEM> lodObjects[InstancedMeshes::LOD_COUNT];
+		// visible blended objects, put in order over the whole frame
+		std::vector<RenderQueue::DEPTH_ITEM> blendedObjects;
+	};
+
+	// shader values most recently set by the render queue -
+	// negative values mean the shader value is unknown
+	struct SHADER_STATE
+	{
+		int useTexture;
+		int textureIndex;
+		int materialIndex;
+		glm::vec2 uvScale;
+		glm::vec4 color;
+	};
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
-	// pointer to basic shapes object
-	ShapeMeshes* m_basicMeshes;
-	// total number of loaded textures
-	int m_loadedTextures;
-	// loaded textures info
-	TEXTURE_INFO m_textureIDs[16];
+	// pointer to cached shader uniform locations
+	ShaderUniforms* m_pShaderUniforms;
+	// pointer to the shared uniform buffer objects
+	UniformBuffers* m_pUniformBuffers;
+	// basic shapes object
+	std::unique_ptr<ShapeMeshes> m_basicMeshes;
+	// loaded textures info - the position is the texture index
+	std::vector<TEXTURE_INFO> m_textureIDs;
+	// texture index of every texture tag
+	std::unordered_map<std::string, int> m_textureIndices;
+	// makes the textures available to the draws by index
+	std::unique_ptr<TextureResidency> m_pTextureResidency;
+	// keeps the storage of replaced textures for the next ones
+	TexturePool m_texturePool;
+	// decodes the texture image files off of the main thread
+	std::unique_ptr<TextureLoader> m_pTextureLoader;
 	// defined object materials
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// material index of every material tag, and the number of
+	// materials whose tags have been interned
+	std::unordered_map<std::string, int> m_materialIndices;
+	size_t m_indexedMaterials;
+	// values of every material, read by the draws by index
+	std::unique_ptr<MaterialTable> m_pMaterialTable;
+	// retained objects that make up the 3D scene
+	std::vector<SCENE_OBJECT> m_sceneObjects;
+	// local space bounding sphere of every basic shape
+	glm::vec3 m_meshBoundsCenters[InstancedMeshes::SHAPE_COUNT];
+	float m_meshBoundsRadii[InstancedMeshes::SHAPE_COUNT];
+	// scene objects sorted by their shader state
+	RenderQueue m_renderQueue;
+	// true when objects were added since the queue was sorted
+	bool m_bRenderQueueDirty;
+	// shader values set by the previous queued draw
+	SHADER_STATE m_shaderState;
+	// texture tags that did not resolve and were already reported
+	std::unordered_set<std::string> m_missingTextureTags;
+	// instanced drawing of the basic shapes - NULL when unavailable
+	// or not enabled
+	std::unique_ptr<InstancedMeshes> m_pInstancedMeshes;
+	// whether PrepareScene() creates the instanced path
+	bool m_bInstancingEnabled;
+	// instanced batches of the current frame
+	std::vector<INSTANCE_BATCH> m_instanceBatches;
+	// frustum of the current view, used to skip hidden objects
+	Frustum m_viewFrustum;
+	bool m_bFrustumValid;
+	bool m_bCullingEnabled;
+	// depth of a point is its dot product with the depth row, and its
+	// projected size its radius times the scale over the depth
+	glm::vec4 m_lodDepthRow;
+	float m_lodScale;
+	float m_lodHysteresis;
+	// view depth of a point is its dot product with the depth row
+	glm::vec4 m_viewDepthRow;
+	// number of objects that passed culling in the last frame
+	int m_visibleObjects;
+	// fill the depth buffer before the opaque objects are shaded
+	bool m_bDepthPrepassEnabled;
+	// visible objects of the frame in the order they are drawn
+	std::vector<RenderQueue::DEPTH_ITEM> m_opaqueOrder;
+	std::vector<RenderQueue::DEPTH_ITEM> m_blendedOrder;
+	// instances of the blended batches, which follow the opaque ones
+	std::vector<InstancedMeshes::INSTANCE_DATA> m_blendedInstances;
+	// number of leading opaque batches of the frame
+	int m_opaqueBatchCount;
+	// splits the per-frame CPU work over the cores
+	std::unique_ptr<JobSystem> m_pJobSystem;
+	// draws recorded by the jobs of the current frame, in queue order
+	std::vector<DRAW_LIST> m_drawLists;
+	// objects that moved since the last frame, with their transforms
+	// and the matrices built from them in one batch
+	std::vector<int> m_movedObjects;
+	TransformBatch m_transformBatch;
+	std::vector<glm::mat4> m_movedMatrices;
+	// culling and draw commands on the GPU - NULL when unavailable
+	std::unique_ptr<GpuCulling> m_pGpuCulling;
+	bool m_bGpuCullingEnabled;
+	// true when the objects on the GPU are out of date
+	bool m_bGpuSceneDirty;
+	// number of draw commands on the GPU - only the opaque objects
+	// are culled there
+	int m_gpuOpaqueCommands;
+	// view and projection of the current frame
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+	// view whose levels of detail the current draws use
+	int m_viewIndex;
+	// point lights binned into clusters - NULL when unavailable
+	std::unique_ptr<ClusteredLights> m_pClusteredLights;
+	// point lights beyond the light block, and whether they changed
+	std::vector<ClusteredLights::POINT_LIGHT> m_clusteredLights;
+	bool m_bClusteredLightsDirty;
+	// shadows of the directional light - NULL when unavailable
+	std::unique_ptr<ShadowMaps> m_pShadowMaps;
+	int m_shadowCascadeCount;
+	glm::vec3 m_directionalLightDirection;
+	// casters gathered from the render queue, and whether any moved
+	std::vector<ShadowMaps::CASTER> m_shadowCasters;
+	bool m_bShadowCastersDirty;
+	// environment drawn behind the scene - NULL when unavailable,
+	// in which case the scene has a backdrop plane
+	std::unique_ptr<Skybox> m_pSkybox;
+	// true once the environment has been drawn in the current view
+	bool m_bEnvironmentDrawn;
+	// scene file loaded in place of the scene defined in the code -
+	// empty for the scene of the code
+	std::string m_sceneFilename;
+	// objects, clustered lights and light block lights of the scene file
+	int m_sceneFileFirstObject;
+	int m_sceneFileObjectCount;
+	int m_sceneFileFirstLight;
+	int m_sceneFileLightCount;
+	UniformBuffers::LIGHTS_DATA m_sceneFileLights;
+	// watches the files of the scene - NULL when nothing is reloaded
+	HotReload* m_pHotReload;
+	// times the passes on the GPU - NULL when they are not measured
+	FrameProfiler* m_pFrameProfiler;
 
 	// load texture images and convert to OpenGL texture data
-	bool CreateGLTexture(const char* filename, std::string tag);
-	// bind loaded OpenGL textures to slots in memory
-	void BindGLTextures();
+	bool CreateGLTexture(const char* filename, const std::string& tag);
+	// reload a texture when its image file changes
+	void WatchTexture(int textureIndex);
+	// decode the image file of a texture again and replace it
+	void ReloadTexture(int textureIndex);
+	// copy a decoded image into the texture of its index
+	bool UploadGLTexture(TextureLoader::DECODED_IMAGE& image);
+	// show a texture once its image is uploaded into a texture object
+	void FinishTextureUpload(int textureIndex, GpuTexture& texture, const TexturePool::TEXTURE_FORMAT& format);
 	// free the loaded OpenGL textures
 	void DestroyGLTextures();
 	// find a loaded texture by tag
-	int FindTextureID(std::string tag);
-	int FindTextureSlot(std::string tag);
+	int FindTextureID(const std::string& tag);
+	int FindTextureIndex(const std::string& tag);
 	// find a defined material by tag
-	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	bool FindMaterial(const std::string& tag, OBJECT_MATERIAL& material);
+	int FindMaterialIndex(const std::string& tag);
+	// intern the tags of newly defined materials
+	void IndexObjectMaterials();
 
 	// set the transformation values 
 	// into the transform buffer
@@ -78,6 +312,88 @@ private:
 		float ZrotationDegrees,
 		glm::vec3 positionXYZ);
 
+	// build the model matrix from the transformation values
+	glm::mat4 BuildModelMatrix(
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+
+	// set an already built model matrix into the transform buffer
+	void SetTransformMatrix(const glm::mat4& modelView);
+
+	// draw the basic mesh of the passed in type
+	void DrawMesh(MESH_TYPE mesh);
+	// draw copies of the basic mesh of the passed in type with one call
+	void DrawMeshInstanced(MESH_TYPE mesh, int count, int firstInstance, int lodLevel);
+	// get the instanced shape that draws a basic mesh
+	static InstancedMeshes::SHAPE_ID GetInstancedShape(MESH_TYPE mesh);
+	// get the basic mesh drawn by an instanced shape
+	static MESH_TYPE GetMeshType(InstancedMeshes::SHAPE_ID shape);
+	// write a draw command for every batch of the frame
+	bool RecordIndirectDraws();
+	// draw a range of the batches of the frame
+	void DrawInstanceBatches(int firstBatch, int endBatch, bool bIndirect, bool bBindTextures);
+	// rebuild the cached model matrix of an object if it moved
+	void UpdateModelMatrix(SCENE_OBJECT& sceneObject);
+	// rebuild the model matrices of all the moved objects at once
+	void UpdateMovedObjects();
+	// rebuild the bounding sphere of an object from its model matrix
+	void UpdateObjectBounds(SCENE_OBJECT& sceneObject);
+	// get the local space bounding sphere of a basic mesh
+	void GetMeshBounds(MESH_TYPE mesh, glm::vec3& center, float& radius) const;
+	// measure the bounding spheres of the generated basic shapes
+	void BuildMeshBounds();
+	// true when the object is inside the current view frustum
+	bool IsObjectVisible(const SCENE_OBJECT& sceneObject) const;
+	// pick the level of detail of an object from its projected size
+	int SelectObjectLod(const SCENE_OBJECT& sceneObject) const;
+	// distance of an object in front of the camera
+	float GetViewDepth(const SCENE_OBJECT& sceneObject) const;
+	// copy the values of an object drawn as an instance
+	static void GetInstanceData(const SCENE_OBJECT& sceneObject, InstancedMeshes::INSTANCE_DATA& instance);
+	// render the queued objects from an item on in instanced batches
+	void RenderSceneInstanced(size_t firstItem);
+	// update, cull and record the queued objects from an item on
+	void RecordDrawLists(bool bInstanced, size_t firstItem);
+	// record the draws of one range of the render queue
+	void RecordDrawList(DRAW_LIST& drawList, int begin, int end, bool bInstanced);
+	// add a batch for every level of detail of the current batch
+	void FlushLodBatches(DRAW_LIST& drawList, const INSTANCE_BATCH& batch);
+	// put the recorded blended objects in order, farthest first
+	void SortBlendedObjects();
+	// add the sorted blended objects as batches after the opaque ones
+	void AddBlendedBatches(int firstInstance);
+	// draw objects one at a time in the passed in order
+	void DrawSceneObjects(const std::vector<RenderQueue::DEPTH_ITEM>& objects);
+	// cull and draw the queued objects with the GPU culling pass
+	bool RenderSceneGpuCulled();
+	// upload the queued objects and their batches to the GPU culling pass
+	void UploadGpuScene();
+	// draw the shadow cascades that changed since the last frame
+	void RenderShadowMaps();
+
+	// set the OpenGL state of the passes of the frame - the blended
+	// pass neither writes depth nor lets the opaque pass blend
+	void BeginDepthPrepass();
+	void BeginOpaquePass(bool bDepthWritten);
+	void BeginBlendedPass();
+	void EndScenePasses();
+	// draw the environment into the pixels no opaque object covers -
+	// true when it was drawn and the program was switched
+	bool RenderEnvironment();
+	// bracket a pass with a GPU scope of the frame profiler
+	void BeginGpuScope(FrameProfiler::GPU_SCOPE scope);
+	void EndGpuScope(FrameProfiler::GPU_SCOPE scope);
+
+	// resolve the object tags and sort the objects into the render queue
+	void BuildRenderQueue();
+	// forget the shader values set by the previous queued draw
+	void ResetShaderState();
+	// set the shader values of an object that differ from the previous draw
+	void ApplyObjectState(const SCENE_OBJECT& sceneObject);
+
 	// set the color values into the shader
 	void SetShaderColor(
 		float redColorValue,
@@ -87,7 +403,9 @@ private:
 
 	// set the texture data into the shader
 	void SetShaderTexture(
-		std::string textureTag);
+		const std::string& textureTag);
+	void SetShaderTexture(
+		int textureIndex);
 
 	// set the UV scale for the texture mapping
 	void SetTextureUVScale(
@@ -95,18 +413,126 @@ private:
 
 	// set the object material into the shader
 	void SetShaderMaterial(
-		std::string materialTag);
+		const std::string& materialTag);
+	// select a defined material by index for the next draw
+	void SetMaterialValues(int materialIndex);
+	// copy the defined materials into the material block
+	void UploadObjectMaterials();
+	// load the textures, materials, lights and objects of a scene file
+	bool LoadSceneFile(const char* filename);
+	// load the scene file again after it changed
+	void ReloadSceneFile();
+	// add or update what differs between the scene and a scene file
+	void ApplySceneFile(const SceneFile& sceneFile);
+	void ApplySceneLights(const UniformBuffers::LIGHTS_DATA& lights);
+	// reload the shaders, textures and scene file when they change
+	void WatchFiles(bool bWatchSceneFile);
+
+	// set the light values into the light block or the shader
+	void SetDirectionalLight(
+		glm::vec3 direction,
+		glm::vec3 ambient,
+		glm::vec3 diffuse,
+		glm::vec3 specular);
+	void SetPointLight(
+		int lightIndex,
+		glm::vec3 position,
+		glm::vec3 ambient,
+		glm::vec3 diffuse,
+		glm::vec3 specular);
 
 public:
 
 	// prepare the 3D scene for rendering
 	void PrepareScene();
-	// render the objects in the 3D scene
+	// render the objects in the 3D scene from a single view
 	void RenderScene();
+	// update what all the views of a frame share - once per frame,
+	// after the view of the main camera has been set
+	void UpdateScene();
+	// render the scene from the view set last into the current
+	// viewport, with the levels of detail kept for the view index
+	void RenderSceneView(int viewIndex);
+
+	// upload the textures that have finished decoding
+	void UpdateTextureLoads();
+	// wait for every requested texture and upload it
+	void FinishTextureLoads();
+
+	// set the view and projection used for culling and levels of detail
+	void SetViewProjection(const glm::mat4& view, const glm::mat4& projection);
+	// fraction past a switch size before the level of detail changes
+	void SetLodHysteresis(float hysteresis) { m_lodHysteresis = hysteresis; }
+	// turn frustum culling on or off
+	void SetCullingEnabled(bool bEnabled) { m_bCullingEnabled = bEnabled; }
+	// draw with the instanced shaders instead of the scene shader - off
+	// by default, and set before PrepareScene().  Their lighting is close
+	// to the scene shader's but not the same, and the GPU culling, shadows
+	// and clustered lights are only drawn by them
+	void SetInstancingEnabled(bool bEnabled) { m_bInstancingEnabled = bEnabled; }
+	// whether the scene is drawn by the instanced path
+	bool IsInstanced() const { return (NULL != m_pInstancedMeshes); }
+	// cull on the GPU when the driver allows - on by default, and only
+	// used by the instanced draws
+	void SetGpuCullingEnabled(bool bEnabled) { m_bGpuCullingEnabled = bEnabled; }
+	// number of shadow cascades - 1 is a single shadow map, 0 is no
+	// shadows, and only the instanced draws have shadows
+	void SetShadowCascadeCount(int cascadeCount);
+	// draw the depth of the opaque objects before shading them - on
+	// by default, and only used by the instanced draws
+	void SetDepthPrepassEnabled(bool bEnabled) { m_bDepthPrepassEnabled = bEnabled; }
+	// load the scene from a scene file instead of the code - set
+	// before PrepareScene(), and the code is used when it fails
+	void SetSceneFile(const std::string& filename) { m_sceneFilename = filename; }
+	// reload the files of the scene when they change - set before
+	// PrepareScene(), and polled by the caller
+	void SetHotReload(HotReload* pHotReload) { m_pHotReload = pHotReload; }
+	// time the shadow, depth, opaque, sky and blended passes
+	void SetFrameProfiler(FrameProfiler* pFrameProfiler) { m_pFrameProfiler = pFrameProfiler; }
+	// most bytes of replaced textures kept for reuse by new ones
+	void SetTexturePoolBudget(long long bytes) { m_texturePool.SetBudget(bytes); }
+	// number of objects drawn in the last frame, over all of its
+	// views - with GPU culling the count is not read back, and every
+	// object is counted
+	int GetVisibleObjectCount() const { return m_visibleObjects; }
+
+	// add an object to the retained scene and return its index
+	int AddSceneObject(
+		MESH_TYPE mesh,
+		glm::vec3 scaleXYZ,
+		glm::vec3 rotationDegrees,
+		glm::vec3 positionXYZ,
+		std::string materialTag,
+		std::string textureTag,
+		glm::vec2 uvScale,
+		glm::vec4 color);
+	// move an object in the retained scene - marks it dirty
+	void SetObjectTransform(
+		int objectIndex,
+		glm::vec3 scaleXYZ,
+		glm::vec3 rotationDegrees,
+		glm::vec3 positionXYZ);
+	// add a repeatable grid of basic shapes for benchmarking
+	void AddSyntheticObjects(int objectCount, unsigned int seed);
+	// add a point light that only lights the objects within its range
+	void AddPointLight(
+		glm::vec3 position,
+		float range,
+		glm::vec3 ambient,
+		glm::vec3 diffuse,
+		glm::vec3 specular);
+	// add repeatable colored point lights over the scene for benchmarking
+	void AddSyntheticLights(int lightCount, unsigned int seed);
+	// number of point lights added with AddPointLight()
+	int GetPointLightCount() const { return (int)m_clusteredLights.size(); }
+	// number of objects in the retained scene
+	int GetSceneObjectCount() const { return (int)m_sceneObjects.size(); }
 
 	// load all of the needed textures before rendering
 	void LoadSceneTextures();
 	void DefineObjectMaterials();
+	// define the retained objects that make up the scene
+	void DefineSceneObjects();
 	// add and define the light sources before rendering
 	void SetupSceneLights();
 
@@ -0,0 +1,214 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderuniforms.cpp
+// ============
+// cached uniform locations for the loaded shader program
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderUniforms.h"
+#include "FrameProfiler.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstdio>
+
+// declaration of the global variables and defines
+namespace
+{
+	// uniform names of the fixed handles - same order as UNIFORM_ID
+	const char* g_UniformNames[ShaderUniforms::POINT_LIGHT_FIRST] =
+	{
+		"model",
+		"view",
+		"projection",
+		"viewPosition",
+		"objectColor",
+		"objectTexture",
+		"bUseTexture",
+		"bUseLighting",
+		"UVscale",
+		"material.diffuseColor",
+		"material.specularColor",
+		"material.shininess",
+		"materialIndex",
+		"directionalLight.direction",
+		"directionalLight.ambient",
+		"directionalLight.diffuse",
+		"directionalLight.specular",
+		"directionalLight.bActive",
+		"shadowMap"
+	};
+
+	// uniform field names of every point light - same order as POINT_LIGHT_FIELD
+	const char* g_PointLightFieldNames[ShaderUniforms::POINT_LIGHT_FIELD_COUNT] =
+	{
+		"position",
+		"ambient",
+		"diffuse",
+		"specular",
+		"bActive"
+	};
+}
+
+/***********************************************************
+ *  ShaderUniforms()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShaderUniforms::ShaderUniforms(ShaderManager* pShaderManager)
+{
+	m_pShaderManager = pShaderManager;
+	m_programID = 0;
+
+	// unresolved uniforms are ignored by OpenGL
+	for (int i = 0; i < UNIFORM_COUNT; i++)
+	{
+		m_locations[i] = -1;
+	}
+	for (int i = 0; i < UniformBuffers::BLOCK_COUNT; i++)
+	{
+		m_bHasBlock[i] = false;
+	}
+}
+
+/***********************************************************
+ *  ~ShaderUniforms()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShaderUniforms::~ShaderUniforms()
+{
+	m_pShaderManager = NULL;
+}
+
+/***********************************************************
+ *  ResolveLocations()
+ *
+ *  This method is used for looking up the location of every
+ *  uniform handle in the shader program.  It needs to be
+ *  called once after the shaders have been loaded.
+ ***********************************************************/
+bool ShaderUniforms::ResolveLocations()
+{
+	GLint programID = 0;
+	char uniformName[64];
+
+	if (NULL == m_pShaderManager)
+	{
+		return(false);
+	}
+
+	// the locations are resolved against the bound program
+	m_pShaderManager->use();
+	glGetIntegerv(GL_CURRENT_PROGRAM, &programID);
+	if (programID == 0)
+	{
+		std::cout << "Could not resolve uniforms, no shader program is loaded" << std::endl;
+		return(false);
+	}
+	m_programID = (GLuint)programID;
+
+	for (int i = 0; i < POINT_LIGHT_FIRST; i++)
+	{
+		m_locations[i] = glGetUniformLocation(programID, g_UniformNames[i]);
+	}
+
+	for (int light = 0; light < MAX_POINT_LIGHTS; light++)
+	{
+		for (int field = 0; field < POINT_LIGHT_FIELD_COUNT; field++)
+		{
+			snprintf(uniformName, sizeof(uniformName), "pointLights[%d].%s",
+				light, g_PointLightFieldNames[field]);
+			m_locations[PointLight(light, (POINT_LIGHT_FIELD)field)] =
+				glGetUniformLocation(programID, uniformName);
+		}
+	}
+
+	for (int i = 0; i < UniformBuffers::BLOCK_COUNT; i++)
+	{
+		m_bHasBlock[i] = (glGetUniformBlockIndex(programID,
+			UniformBuffers::GetBlockName((UniformBuffers::BLOCK_ID)i)) != GL_INVALID_INDEX);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  PointLight()
+ *
+ *  This method is used for getting the handle of a field of
+ *  the point light with the passed in index.
+ ***********************************************************/
+ShaderUniforms::UNIFORM_ID ShaderUniforms::PointLight(
+	int lightIndex,
+	POINT_LIGHT_FIELD field)
+{
+	return((UNIFORM_ID)(POINT_LIGHT_FIRST + (lightIndex * POINT_LIGHT_FIELD_COUNT) + field));
+}
+
+/***********************************************************
+ *  SetBool() / SetInt() / SetFloat()
+ *
+ *  These methods are used for setting scalar uniform values
+ *  through their cached locations.
+ ***********************************************************/
+void ShaderUniforms::SetBool(UNIFORM_ID uniform, bool value) const
+{
+	glUniform1i(m_locations[uniform], (int)value);
+	FrameProfiler::CountUniformUpdate();
+}
+
+void ShaderUniforms::SetInt(UNIFORM_ID uniform, int value) const
+{
+	glUniform1i(m_locations[uniform], value);
+	FrameProfiler::CountUniformUpdate();
+}
+
+void ShaderUniforms::SetFloat(UNIFORM_ID uniform, float value) const
+{
+	glUniform1f(m_locations[uniform], value);
+	FrameProfiler::CountUniformUpdate();
+}
+
+/***********************************************************
+ *  SetIntArray()
+ *
+ *  This method is used for setting an array of integer or
+ *  sampler uniform values through the cached location of
+ *  the first element.
+ ***********************************************************/
+void ShaderUniforms::SetIntArray(UNIFORM_ID uniform, const int* values, int count) const
+{
+	glUniform1iv(m_locations[uniform], count, values);
+	FrameProfiler::CountUniformUpdate();
+}
+
+/***********************************************************
+ *  SetVec2() / SetVec3() / SetVec4() / SetMat4()
+ *
+ *  These methods are used for setting vector and matrix
+ *  uniform values through their cached locations.
+ ***********************************************************/
+void ShaderUniforms::SetVec2(UNIFORM_ID uniform, const glm::vec2& value) const
+{
+	glUniform2fv(m_locations[uniform], 1, glm::value_ptr(value));
+	FrameProfiler::CountUniformUpdate();
+}
+
+void ShaderUniforms::SetVec3(UNIFORM_ID uniform, const glm::vec3& value) const
+{
+	glUniform3fv(m_locations[uniform], 1, glm::value_ptr(value));
+	FrameProfiler::CountUniformUpdate();
+}
+
+void ShaderUniforms::SetVec4(UNIFORM_ID uniform, const glm::vec4& value) const
+{
+	glUniform4fv(m_locations[uniform], 1, glm::value_ptr(value));
+	FrameProfiler::CountUniformUpdate();
+}
+
+void ShaderUniforms::SetMat4(UNIFORM_ID uniform, const glm::mat4& value) const
+{
+	glUniformMatrix4fv(m_locations[uniform], 1, GL_FALSE, glm::value_ptr(value));
+	FrameProfiler::CountUniformUpdate();
+}
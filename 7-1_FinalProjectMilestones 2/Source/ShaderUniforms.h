@@ -0,0 +1,102 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderuniforms.h
+// ============
+// cached uniform locations for the loaded shader program
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "UniformBuffers.h"
+
+/***********************************************************
+ *  ShaderUniforms
+ *
+ *  This class looks up the location of every uniform used
+ *  by the scene once, after the shaders are loaded, so that
+ *  the per-frame code can set uniform values by handle
+ *  instead of by name.
+ ***********************************************************/
+class ShaderUniforms
+{
+public:
+	// maximum number of point lights supported by the shaders
+	static const int MAX_POINT_LIGHTS = 4;
+
+	// uniform fields of every point light
+	enum POINT_LIGHT_FIELD
+	{
+		POINT_LIGHT_POSITION = 0,
+		POINT_LIGHT_AMBIENT,
+		POINT_LIGHT_DIFFUSE,
+		POINT_LIGHT_SPECULAR,
+		POINT_LIGHT_ACTIVE,
+		POINT_LIGHT_FIELD_COUNT
+	};
+
+	// handles for the uniforms used by the scene
+	enum UNIFORM_ID
+	{
+		MODEL = 0,
+		VIEW,
+		PROJECTION,
+		VIEW_POSITION,
+		OBJECT_COLOR,
+		OBJECT_TEXTURE,
+		USE_TEXTURE,
+		USE_LIGHTING,
+		UV_SCALE,
+		MATERIAL_DIFFUSE_COLOR,
+		MATERIAL_SPECULAR_COLOR,
+		MATERIAL_SHININESS,
+		MATERIAL_INDEX,
+		DIRECTIONAL_LIGHT_DIRECTION,
+		DIRECTIONAL_LIGHT_AMBIENT,
+		DIRECTIONAL_LIGHT_DIFFUSE,
+		DIRECTIONAL_LIGHT_SPECULAR,
+		DIRECTIONAL_LIGHT_ACTIVE,
+		SHADOW_MAP,
+		// followed by POINT_LIGHT_FIELD_COUNT handles per point light
+		POINT_LIGHT_FIRST,
+		UNIFORM_COUNT = POINT_LIGHT_FIRST + (MAX_POINT_LIGHTS * POINT_LIGHT_FIELD_COUNT)
+	};
+
+	// constructor
+	ShaderUniforms(ShaderManager* pShaderManager);
+	// destructor
+	~ShaderUniforms();
+
+	// look up the uniform locations in the loaded shader program
+	bool ResolveLocations();
+
+	// get the handle of a point light field
+	static UNIFORM_ID PointLight(int lightIndex, POINT_LIGHT_FIELD field);
+
+	// get the program the locations were resolved against
+	GLuint GetProgramID() const { return m_programID; }
+	// get the cached location behind a handle
+	GLint GetLocation(UNIFORM_ID uniform) const { return m_locations[uniform]; }
+	// true when the program declares the passed in uniform block
+	bool HasBlock(UniformBuffers::BLOCK_ID block) const { return m_bHasBlock[block]; }
+
+	// set uniform values by handle
+	void SetBool(UNIFORM_ID uniform, bool value) const;
+	void SetInt(UNIFORM_ID uniform, int value) const;
+	void SetFloat(UNIFORM_ID uniform, float value) const;
+	void SetVec2(UNIFORM_ID uniform, const glm::vec2& value) const;
+	void SetVec3(UNIFORM_ID uniform, const glm::vec3& value) const;
+	void SetVec4(UNIFORM_ID uniform, const glm::vec4& value) const;
+	void SetMat4(UNIFORM_ID uniform, const glm::mat4& value) const;
+	void SetIntArray(UNIFORM_ID uniform, const int* values, int count) const;
+
+private:
+	// pointer to shader manager object
+	ShaderManager* m_pShaderManager;
+	// program the locations were resolved against
+	GLuint m_programID;
+	// cached uniform locations, indexed by handle
+	GLint m_locations[UNIFORM_COUNT];
+	// which shared uniform blocks the program declares
+	bool m_bHasBlock[UniformBuffers::BLOCK_COUNT];
+};
@@ -0,0 +1,610 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowmaps.cpp
+// ============
+// cascaded shadow maps for the directional light
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShadowMaps.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	const char* g_VertexShaderPath = "shaders/shadowVertexShader.glsl";
+	const char* g_FragmentShaderPath = "shaders/shadowFragmentShader.glsl";
+
+	// view distance covered by the cascades - the 35 x 15 floor of
+	// the scene fits with room to spare
+	const float g_DefaultShadowDistance = 40.0f;
+	// blend between evenly spaced splits and splits that grow with
+	// the distance - 1 is only growing
+	const float g_SplitBlend = 0.75f;
+	// a cascade covers a little more than its slice of the view, so
+	// it can move in steps instead of with every camera move
+	const float g_CascadePadding = 1.1f;
+	const float g_CascadeStepTexels = 64.0f;
+	// how far towards the light the casters of a cascade are found
+	const float g_CasterReach = 100.0f;
+	// depth offset of the casters and of the compared depth
+	const float g_PolygonOffsetFactor = 2.0f;
+	const float g_PolygonOffsetUnits = 4.0f;
+	const float g_DepthBias = 0.0005f;
+	// closest near plane used for splitting the view
+	const float g_MinShadowNear = 0.01f;
+
+	// check that a shader file exists before handing it to OpenGL
+	bool FileExists(const char* filename)
+	{
+		std::ifstream file(filename);
+		return(file.good());
+	}
+}
+
+/***********************************************************
+ *  ShadowMaps()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShadowMaps::ShadowMaps()
+{
+	m_pUniformBuffers = NULL;
+	m_pInstancedMeshes = NULL;
+	m_pShaderManager = NULL;
+	m_lightViewProjectionLocation = -1;
+	m_instanceCapacity = 0;
+	m_lightDirection = glm::vec3(0.0f, -1.0f, 0.0f);
+	m_cascadeCount = CASCADE_COUNT;
+	m_shadowDistance = g_DefaultShadowDistance;
+	m_renderedCascades = 0;
+
+	for (int i = 0; i < CASCADE_COUNT; i++)
+	{
+		m_cascadeMatrices[i] = glm::mat4(1.0f);
+		m_cascadeSplits[i] = 0.0f;
+		m_bCascadeDirty[i] = true;
+	}
+}
+
+/***********************************************************
+ *  ~ShadowMaps()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShadowMaps::~ShadowMaps()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking whether the driver can
+ *  allocate the depth texture array with immutable storage,
+ *  which OpenGL 4.2 has.
+ ***********************************************************/
+bool ShadowMaps::IsSupported()
+{
+	return(GLEW_VERSION_4_2 == GL_TRUE);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for loading the depth shader and
+ *  creating the depth texture array, its framebuffer and the
+ *  caster instance buffer.  The shadow maps stay bound to
+ *  their own texture unit, where the instance shader reads
+ *  them.  False is returned when shadows are not available,
+ *  in which case the scene is drawn without them.
+ ***********************************************************/
+bool ShadowMaps::Initialize(UniformBuffers* pUniformBuffers, InstancedMeshes* pInstancedMeshes)
+{
+	GLint programID = 0;
+
+	if ((NULL == pUniformBuffers) || (NULL == pInstancedMeshes) || (IsSupported() == false))
+	{
+		return(false);
+	}
+
+	if ((FileExists(g_VertexShaderPath) == false) ||
+		(FileExists(g_FragmentShaderPath) == false))
+	{
+		std::cout << "Shadow shaders not found, shadows are disabled" << std::endl;
+		return(false);
+	}
+
+	m_pShaderManager = new ShaderManager();
+	m_pShaderManager->LoadShaders(g_VertexShaderPath, g_FragmentShaderPath);
+	m_pShaderManager->use();
+	glGetIntegerv(GL_CURRENT_PROGRAM, &programID);
+	if (programID == 0)
+	{
+		std::cout << "Shadow shaders could not be loaded, shadows are disabled" << std::endl;
+		return(false);
+	}
+	m_lightViewProjectionLocation = glGetUniformLocation(programID, "lightViewProjection");
+
+	// the hardware compares the depths and filters the results
+	m_depthTexture.Create();
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_depthTexture);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_DEPTH_COMPONENT24, MAP_SIZE, MAP_SIZE, CASCADE_COUNT);
+	m_depthTexture.SetMemory(GpuMemory::RENDER_TARGETS,
+		GpuMemory::GetTextureBytes(GL_DEPTH_COMPONENT24, MAP_SIZE, MAP_SIZE, 1) * CASCADE_COUNT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	// everything outside of a shadow map is lit
+	float borderColor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	m_framebuffer.Create();
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_depthTexture, 0, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Shadow map framebuffer is incomplete, shadows are disabled" << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	m_instanceBuffer.Create();
+
+	glActiveTexture(GL_TEXTURE0 + TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_depthTexture);
+	glActiveTexture(GL_TEXTURE0);
+
+	m_pUniformBuffers = pUniformBuffers;
+	m_pInstancedMeshes = pInstancedMeshes;
+	Invalidate();
+
+	return(true);
+}
+
+/***********************************************************
+ *  WatchFiles()
+ *
+ *  This method is used for reloading the depth shaders of
+ *  the cascades whenever one of their files is written.
+ ***********************************************************/
+void ShadowMaps::WatchFiles(HotReload* pHotReload)
+{
+	if ((NULL == pHotReload) || (NULL == m_pShaderManager))
+	{
+		return;
+	}
+
+	int watchIndex = pHotReload->AddWatch([this, pHotReload]() { ReloadShaders(pHotReload); });
+	pHotReload->AddFile(watchIndex, g_VertexShaderPath);
+	pHotReload->AddFile(watchIndex, g_FragmentShaderPath);
+}
+
+/***********************************************************
+ *  ReloadShaders()
+ *
+ *  This method is used for compiling the changed depth
+ *  shaders.  Every cascade is drawn again with them.
+ ***********************************************************/
+void ShadowMaps::ReloadShaders(HotReload* pHotReload)
+{
+	GLuint programID = pHotReload->ReloadProgram(m_pShaderManager, g_VertexShaderPath, g_FragmentShaderPath);
+	if (programID == 0)
+	{
+		return;
+	}
+
+	m_lightViewProjectionLocation = glGetUniformLocation(programID, "lightViewProjection");
+	Invalidate();
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the shadow maps, the
+ *  instance buffer and the depth program.
+ ***********************************************************/
+void ShadowMaps::Destroy()
+{
+	m_framebuffer.Destroy();
+	m_depthTexture.Destroy();
+	m_instanceBuffer.Destroy();
+	m_instanceCapacity = 0;
+
+	if (NULL != m_pShaderManager)
+	{
+		delete m_pShaderManager;
+		m_pShaderManager = NULL;
+	}
+}
+
+/***********************************************************
+ *  SetLightDirection()
+ *
+ *  This method is used for setting the direction the light
+ *  shines in.  Every cascade is drawn again when it turns.
+ ***********************************************************/
+void ShadowMaps::SetLightDirection(const glm::vec3& direction)
+{
+	if (glm::length(direction) <= 0.0f)
+	{
+		return;
+	}
+
+	glm::vec3 lightDirection = glm::normalize(direction);
+	if (lightDirection != m_lightDirection)
+	{
+		m_lightDirection = lightDirection;
+		Invalidate();
+	}
+}
+
+/***********************************************************
+ *  SetCascadeCount()
+ *
+ *  This method is used for choosing how many cascades split
+ *  the view.  A single cascade is a plain shadow map over
+ *  the shadow distance, and 0 turns the shadows off.
+ ***********************************************************/
+void ShadowMaps::SetCascadeCount(int cascadeCount)
+{
+	if (cascadeCount < 0)
+	{
+		cascadeCount = 0;
+	}
+	if (cascadeCount > CASCADE_COUNT)
+	{
+		cascadeCount = CASCADE_COUNT;
+	}
+
+	m_cascadeCount = cascadeCount;
+	Invalidate();
+	if (NULL != m_pUniformBuffers)
+	{
+		UploadCascades();
+	}
+}
+
+/***********************************************************
+ *  SetShadowDistance()
+ *
+ *  This method is used for setting how far into the view
+ *  the shadows reach.  Shorter distances give sharper
+ *  shadows with the same shadow maps.
+ ***********************************************************/
+void ShadowMaps::SetShadowDistance(float distance)
+{
+	if (distance > 0.0f)
+	{
+		m_shadowDistance = distance;
+		Invalidate();
+	}
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used for marking every cascade to be
+ *  drawn again, after the casters have changed.
+ ***********************************************************/
+void ShadowMaps::Invalidate()
+{
+	for (int i = 0; i < CASCADE_COUNT; i++)
+	{
+		m_bCascadeDirty[i] = true;
+	}
+}
+
+/***********************************************************
+ *  FitCascade()
+ *
+ *  This method is used for fitting the light matrix of a
+ *  cascade around the part of the view between two depths.
+ *  The cascade is a cube around the bounding sphere of the
+ *  slice, so its size does not change as the camera turns,
+ *  and its center snaps to steps of g_CascadeStepTexels
+ *  texels in light space, which keeps the shadow edges
+ *  still and the matrix the same between the steps.  The
+ *  padding keeps the slice inside the cube between steps.
+ ***********************************************************/
+void ShadowMaps::FitCascade(
+	const glm::mat4& inverseView,
+	const glm::mat4& inverseProjection,
+	float nearDepth,
+	float farDepth,
+	glm::mat4& lightMatrix,
+	glm::mat4& casterMatrix) const
+{
+	glm::vec3 corners[8];
+	glm::vec3 center(0.0f, 0.0f, 0.0f);
+
+	// the edges of the view run from its near plane to its far plane,
+	// and the slice is where they cross the two depths
+	for (int i = 0; i < 4; i++)
+	{
+		float x = ((i & 1) == 0) ? -1.0f : 1.0f;
+		float y = ((i & 2) == 0) ? -1.0f : 1.0f;
+		glm::vec4 nearPoint = inverseProjection * glm::vec4(x, y, -1.0f, 1.0f);
+		glm::vec4 farPoint = inverseProjection * glm::vec4(x, y, 1.0f, 1.0f);
+		glm::vec3 edgeStart = glm::vec3(nearPoint) / nearPoint.w;
+		glm::vec3 edgeEnd = glm::vec3(farPoint) / farPoint.w;
+		glm::vec3 edge = edgeEnd - edgeStart;
+
+		glm::vec3 front = edgeStart + edge * ((-nearDepth - edgeStart.z) / edge.z);
+		glm::vec3 back = edgeStart + edge * ((-farDepth - edgeStart.z) / edge.z);
+		corners[i] = glm::vec3(inverseView * glm::vec4(front, 1.0f));
+		corners[i + 4] = glm::vec3(inverseView * glm::vec4(back, 1.0f));
+		center += corners[i] + corners[i + 4];
+	}
+	center = center / 8.0f;
+
+	float radius = 0.0f;
+	for (int i = 0; i < 8; i++)
+	{
+		radius = glm::max(radius, glm::length(corners[i] - center));
+	}
+	// rounding hides the float noise of the corners
+	radius = std::ceil(radius * 16.0f) / 16.0f * g_CascadePadding;
+
+	// a light shining almost straight down needs another up vector
+	glm::vec3 up(0.0f, 1.0f, 0.0f);
+	if (std::fabs(m_lightDirection.y) > 0.99f)
+	{
+		up = glm::vec3(0.0f, 0.0f, 1.0f);
+	}
+	glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), m_lightDirection, up);
+
+	float step = (2.0f * radius / (float)MAP_SIZE) * g_CascadeStepTexels;
+	glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(center, 1.0f));
+	lightCenter.x = std::floor(lightCenter.x / step) * step;
+	lightCenter.y = std::floor(lightCenter.y / step) * step;
+	lightCenter.z = std::floor(lightCenter.z / step) * step;
+
+	// the light looks down -z, so the planes are at -z
+	float left = lightCenter.x - radius;
+	float right = lightCenter.x + radius;
+	float bottom = lightCenter.y - radius;
+	float top = lightCenter.y + radius;
+	float nearPlane = -lightCenter.z - radius;
+	float farPlane = -lightCenter.z + radius;
+
+	lightMatrix = glm::ortho(left, right, bottom, top, nearPlane, farPlane) * lightView;
+	casterMatrix = glm::ortho(left, right, bottom, top, nearPlane - g_CasterReach, farPlane) * lightView;
+}
+
+/***********************************************************
+ *  UpdateCascades()
+ *
+ *  This method is used for splitting the view of the frame
+ *  into the cascades and fitting each of them.  A cascade
+ *  whose matrix changed is marked to be drawn again, and
+ *  true is returned when any cascade needs drawing.
+ ***********************************************************/
+bool ShadowMaps::UpdateCascades(const glm::mat4& view, const glm::mat4& projection)
+{
+	float nearPlane = 0.0f;
+	float farPlane = 0.0f;
+
+	m_renderedCascades = 0;
+	if ((NULL == m_pUniformBuffers) || (m_cascadeCount == 0))
+	{
+		return(false);
+	}
+
+	Frustum::GetDepthRange(projection, nearPlane, farPlane);
+	nearPlane = glm::max(nearPlane, g_MinShadowNear);
+	farPlane = glm::min(farPlane, m_shadowDistance);
+	if (farPlane <= nearPlane)
+	{
+		return(false);
+	}
+
+	glm::mat4 inverseView = glm::inverse(view);
+	glm::mat4 inverseProjection = glm::inverse(projection);
+	float sliceNear = nearPlane;
+	bool bNeedsRender = false;
+
+	for (int i = 0; i < m_cascadeCount; i++)
+	{
+		float fraction = (float)(i + 1) / (float)m_cascadeCount;
+		float growingSplit = nearPlane * std::pow(farPlane / nearPlane, fraction);
+		float evenSplit = nearPlane + (farPlane - nearPlane) * fraction;
+		float sliceFar = g_SplitBlend * growingSplit + (1.0f - g_SplitBlend) * evenSplit;
+
+		glm::mat4 lightMatrix;
+		glm::mat4 casterMatrix;
+		FitCascade(inverseView, inverseProjection, sliceNear, sliceFar, lightMatrix, casterMatrix);
+
+		if (lightMatrix != m_cascadeMatrices[i])
+		{
+			m_cascadeMatrices[i] = lightMatrix;
+			m_casterVolumes[i].ExtractPlanes(casterMatrix);
+			m_bCascadeDirty[i] = true;
+		}
+		m_cascadeSplits[i] = sliceFar;
+		bNeedsRender = (bNeedsRender || m_bCascadeDirty[i]);
+
+		sliceNear = sliceFar;
+	}
+
+	// the split depths follow the view every frame, even when no
+	// cascade has to be drawn again
+	UploadCascades();
+
+	return(bNeedsRender);
+}
+
+/***********************************************************
+ *  UploadCascades()
+ *
+ *  This method is used for writing the cascades into the
+ *  shadow block, with the matrices turned from light clip
+ *  space into shadow map coordinates and depths.
+ ***********************************************************/
+void ShadowMaps::UploadCascades()
+{
+	UniformBuffers::SHADOW_DATA shadows;
+
+	// clip space runs from -1 to 1, the shadow maps from 0 to 1
+	glm::mat4 textureMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(0.5f, 0.5f, 0.5f)) *
+		glm::scale(glm::mat4(1.0f), glm::vec3(0.5f, 0.5f, 0.5f));
+
+	for (int i = 0; i < UniformBuffers::MAX_SHADOW_CASCADES; i++)
+	{
+		shadows.cascadeMatrices[i] = glm::mat4(1.0f);
+		shadows.cascadeSplits[i] = 0.0f;
+	}
+	for (int i = 0; i < m_cascadeCount; i++)
+	{
+		shadows.cascadeMatrices[i] = textureMatrix * m_cascadeMatrices[i];
+		shadows.cascadeSplits[i] = m_cascadeSplits[i];
+	}
+	shadows.params = glm::vec4((float)m_cascadeCount, g_DepthBias, 1.0f / (float)MAP_SIZE, 0.0f);
+
+	m_pUniformBuffers->SetShadows(shadows);
+}
+
+/***********************************************************
+ *  Render()
+ *
+ *  This method is used for drawing the casters into every
+ *  cascade that is marked.  The casters are culled against
+ *  each cascade and written into the caster buffer, where
+ *  runs of the same shape become one instanced draw.  The
+ *  casters are expected in render queue order, so the runs
+ *  are long.  The framebuffer and viewport of the caller
+ *  are restored afterwards.
+ ***********************************************************/
+void ShadowMaps::Render(const std::vector<CASTER>& casters)
+{
+	int firstDraw[CASCADE_COUNT + 1];
+
+	m_renderedCascades = 0;
+	if ((NULL == m_pInstancedMeshes) || (m_cascadeCount == 0))
+	{
+		return;
+	}
+
+	m_instances.clear();
+	m_draws.clear();
+	for (int i = 0; i < m_cascadeCount; i++)
+	{
+		firstDraw[i] = (int)m_draws.size();
+		if (m_bCascadeDirty[i] == false)
+		{
+			continue;
+		}
+
+		for (size_t j = 0; j < casters.size(); j++)
+		{
+			const CASTER& caster = casters[j];
+			if (m_casterVolumes[i].IsSphereVisible(caster.center, caster.radius) == false)
+			{
+				continue;
+			}
+
+			// the farther cascades use the coarser levels of detail
+			int lodLevel = glm::min(i, InstancedMeshes::GetLodCount(caster.shape) - 1);
+			if ((m_draws.size() > (size_t)firstDraw[i]) &&
+				(m_draws.back().shape == caster.shape) &&
+				(m_draws.back().lodLevel == lodLevel))
+			{
+				m_draws.back().instanceCount++;
+			}
+			else
+			{
+				CASTER_DRAW draw;
+				draw.shape = caster.shape;
+				draw.lodLevel = lodLevel;
+				draw.firstInstance = (int)m_instances.size();
+				draw.instanceCount = 1;
+				m_draws.push_back(draw);
+			}
+
+			InstancedMeshes::INSTANCE_DATA instance;
+			instance.model = caster.model;
+			instance.color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+			instance.uvScale = glm::vec2(1.0f, 1.0f);
+			instance.textureIndex = -1;
+			instance.materialIndex = 0;
+			m_instances.push_back(instance);
+		}
+	}
+	firstDraw[m_cascadeCount] = (int)m_draws.size();
+
+	// the buffer only grows, and keeps its object ID
+	if (m_instances.empty() == false)
+	{
+		size_t dataSize = m_instances.size() * sizeof(InstancedMeshes::INSTANCE_DATA);
+
+		glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+		if (m_instances.size() > m_instanceCapacity)
+		{
+			glBufferData(GL_ARRAY_BUFFER, dataSize, m_instances.data(), GL_DYNAMIC_DRAW);
+			m_instanceBuffer.SetMemory(GpuMemory::GEOMETRY, dataSize);
+			m_instanceCapacity = m_instances.size();
+		}
+		else
+		{
+			glBufferSubData(GL_ARRAY_BUFFER, 0, dataSize, m_instances.data());
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	GLint viewport[4];
+	GLint drawFramebuffer = 0;
+	GLint readFramebuffer = 0;
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glViewport(0, 0, MAP_SIZE, MAP_SIZE);
+	// casters in front of the near plane are flattened onto it
+	glEnable(GL_DEPTH_CLAMP);
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(g_PolygonOffsetFactor, g_PolygonOffsetUnits);
+
+	m_pShaderManager->use();
+	m_pInstancedMeshes->BeginDepthDraws(m_instanceBuffer);
+
+	for (int i = 0; i < m_cascadeCount; i++)
+	{
+		if (m_bCascadeDirty[i] == false)
+		{
+			continue;
+		}
+
+		glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_depthTexture, 0, i);
+		glClear(GL_DEPTH_BUFFER_BIT);
+		glUniformMatrix4fv(m_lightViewProjectionLocation, 1, GL_FALSE, &m_cascadeMatrices[i][0][0]);
+
+		for (int j = firstDraw[i]; j < firstDraw[i + 1]; j++)
+		{
+			const CASTER_DRAW& draw = m_draws[j];
+			m_pInstancedMeshes->DrawBufferInstances(draw.shape, draw.lodLevel, draw.instanceCount, draw.firstInstance);
+		}
+
+		m_bCascadeDirty[i] = false;
+		m_renderedCascades++;
+	}
+
+	glBindVertexArray(0);
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glDisable(GL_DEPTH_CLAMP);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)drawFramebuffer);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)readFramebuffer);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
@@ -0,0 +1,148 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowmaps.h
+// ============
+// cascaded shadow maps for the directional light
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "InstancedMeshes.h"
+#include "UniformBuffers.h"
+#include "Frustum.h"
+#include "HotReload.h"
+#include "GpuResources.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  ShadowMaps
+ *
+ *  This class renders the depth of the scene as seen from
+ *  the directional light into one layer of a depth texture
+ *  array per cascade.  The view is split by depth into up
+ *  to CASCADE_COUNT ranges, the near ones small and sharp
+ *  and the far ones covering more ground with the same
+ *  number of texels, and every cascade is fit around its
+ *  part of the view.  The matrices and split depths are
+ *  shared through the shadow block, and a fragment shader
+ *  compares its depth against the cascade it falls into.
+ *
+ *  The cascades only move in steps of many texels, and a
+ *  cascade is only drawn again when its matrix moves, the
+ *  light turns or a caster moves, so a still scene with a
+ *  slowly moving camera hardly ever pays for the shadows.
+ *  Each cascade draws only the casters in its own volume,
+ *  with a depth-only shader and coarser levels of detail in
+ *  the farther cascades.  Casters between the light and a
+ *  cascade are clamped onto its near plane, so the depth
+ *  range of a cascade stays tight.
+ ***********************************************************/
+class ShadowMaps
+{
+public:
+	// maximum number of cascades - at most MAX_SHADOW_CASCADES
+	static const int CASCADE_COUNT = 3;
+	// width and height of every shadow map in texels
+	static const int MAP_SIZE = 2048;
+	// the texture unit the shadow maps stay bound to
+	static const int TEXTURE_UNIT = 1;
+
+	// properties for an object that casts a shadow
+	struct CASTER
+	{
+		InstancedMeshes::SHAPE_ID shape;
+		glm::mat4 model;
+		// world space bounding sphere
+		glm::vec3 center;
+		float radius;
+	};
+
+	// constructor
+	ShadowMaps();
+	// destructor
+	~ShadowMaps();
+
+	// true when the driver supports the depth texture array
+	static bool IsSupported();
+	// load the depth shader and create the shadow maps
+	bool Initialize(UniformBuffers* pUniformBuffers, InstancedMeshes* pInstancedMeshes);
+	// reload the depth shaders when their files change
+	void WatchFiles(HotReload* pHotReload);
+
+	// set the direction the light shines in - redraws every cascade
+	void SetLightDirection(const glm::vec3& direction);
+	// use fewer cascades - 1 is a single shadow map, 0 turns shadows off
+	void SetCascadeCount(int cascadeCount);
+	int GetCascadeCount() const { return m_cascadeCount; }
+	// view distance the shadows reach out to
+	void SetShadowDistance(float distance);
+
+	// fit the cascades to the view - true when any of them needs drawing
+	bool UpdateCascades(const glm::mat4& view, const glm::mat4& projection);
+	// redraw every cascade, after a caster has moved
+	void Invalidate();
+	// draw the casters into the cascades that changed
+	void Render(const std::vector<CASTER>& casters);
+	// number of cascades drawn in the last frame
+	int GetRenderedCascadeCount() const { return m_renderedCascades; }
+
+private:
+	// properties for consecutive casters of a shape drawn with one call
+	struct CASTER_DRAW
+	{
+		InstancedMeshes::SHAPE_ID shape;
+		int lodLevel;
+		int firstInstance;
+		int instanceCount;
+	};
+
+	// fit the light matrix of one cascade around a slice of the view,
+	// along with the volume its casters are culled against
+	void FitCascade(
+		const glm::mat4& inverseView,
+		const glm::mat4& inverseProjection,
+		float nearDepth,
+		float farDepth,
+		glm::mat4& lightMatrix,
+		glm::mat4& casterMatrix) const;
+	// upload the cascades into the shadow block
+	void UploadCascades();
+	// compile the changed depth shaders and redraw every cascade
+	void ReloadShaders(HotReload* pHotReload);
+	// free the shadow maps and the depth program
+	void Destroy();
+
+	// pointer to the shared uniform buffers - holds the shadow block
+	UniformBuffers* m_pUniformBuffers;
+	// instanced shapes and their vertex array
+	InstancedMeshes* m_pInstancedMeshes;
+	// depth-only program for the instanced shapes
+	ShaderManager* m_pShaderManager;
+	GLint m_lightViewProjectionLocation;
+	// depth texture array with a layer per cascade, and its framebuffer
+	GpuTexture m_depthTexture;
+	GpuFramebuffer m_framebuffer;
+	// instances of the casters drawn into the cascades
+	GpuBuffer m_instanceBuffer;
+	size_t m_instanceCapacity;
+	std::vector<InstancedMeshes::INSTANCE_DATA> m_instances;
+	std::vector<CASTER_DRAW> m_draws;
+
+	glm::vec3 m_lightDirection;
+	int m_cascadeCount;
+	float m_shadowDistance;
+	// world to light clip space of every cascade, and the view
+	// depth where it ends
+	glm::mat4 m_cascadeMatrices[CASCADE_COUNT];
+	float m_cascadeSplits[CASCADE_COUNT];
+	// casters of every cascade are culled against a volume that
+	// reaches back towards the light
+	Frustum m_casterVolumes[CASCADE_COUNT];
+	// true when the cascade must be drawn again
+	bool m_bCascadeDirty[CASCADE_COUNT];
+	int m_renderedCascades;
+};
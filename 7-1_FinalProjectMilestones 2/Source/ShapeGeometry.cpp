@@ -0,0 +1,353 @@
+///////////////////////////////////////////////////////////////////////////////
+// shapegeometry.cpp
+// ============
+// vertex and index data for the basic 3D shapes
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShapeGeometry.h"
+
+#include <cmath>
+
+// declaration of the global variables and defines
+namespace
+{
+	const float PI = 3.14159265358979f;
+}
+
+/***********************************************************
+ *  AddVertex()
+ *
+ *  This method is used for adding a single vertex to the
+ *  mesh data and returning its index.
+ ***********************************************************/
+uint32_t ShapeGeometry::AddVertex(
+	MESH_DATA& mesh,
+	glm::vec3 position,
+	glm::vec3 normal,
+	glm::vec2 textureCoordinate)
+{
+	VERTEX vertex;
+
+	vertex.position = position;
+	vertex.normal = normal;
+	vertex.textureCoordinate = textureCoordinate;
+	mesh.vertices.push_back(vertex);
+
+	return((uint32_t)mesh.vertices.size() - 1);
+}
+
+/***********************************************************
+ *  AddQuad()
+ *
+ *  This method is used for adding a flat quad with the
+ *  corners in counter-clockwise order.
+ ***********************************************************/
+void ShapeGeometry::AddQuad(MESH_DATA& mesh, glm::vec3 a, glm::vec3 b, glm::vec3 c, glm::vec3 d)
+{
+	glm::vec3 normal = glm::normalize(glm::cross(b - a, c - a));
+
+	uint32_t i0 = AddVertex(mesh, a, normal, glm::vec2(0.0f, 0.0f));
+	uint32_t i1 = AddVertex(mesh, b, normal, glm::vec2(1.0f, 0.0f));
+	uint32_t i2 = AddVertex(mesh, c, normal, glm::vec2(1.0f, 1.0f));
+	uint32_t i3 = AddVertex(mesh, d, normal, glm::vec2(0.0f, 1.0f));
+
+	mesh.indices.push_back(i0);
+	mesh.indices.push_back(i1);
+	mesh.indices.push_back(i2);
+	mesh.indices.push_back(i0);
+	mesh.indices.push_back(i2);
+	mesh.indices.push_back(i3);
+}
+
+/***********************************************************
+ *  AddTriangle()
+ *
+ *  This method is used for adding a flat triangle with the
+ *  corners in counter-clockwise order.
+ ***********************************************************/
+void ShapeGeometry::AddTriangle(MESH_DATA& mesh, glm::vec3 a, glm::vec3 b, glm::vec3 c)
+{
+	glm::vec3 normal = glm::normalize(glm::cross(b - a, c - a));
+
+	mesh.indices.push_back(AddVertex(mesh, a, normal, glm::vec2(0.0f, 0.0f)));
+	mesh.indices.push_back(AddVertex(mesh, b, normal, glm::vec2(1.0f, 0.0f)));
+	mesh.indices.push_back(AddVertex(mesh, c, normal, glm::vec2(0.5f, 1.0f)));
+}
+
+/***********************************************************
+ *  AddRevolvedSide()
+ *
+ *  This method is used for adding the side of a shape that
+ *  is revolved around the Y axis from Y = 0 to Y = 1.  The
+ *  texture wraps once around the side.
+ ***********************************************************/
+void ShapeGeometry::AddRevolvedSide(
+	MESH_DATA& mesh,
+	int segments,
+	float bottomRadius,
+	float topRadius)
+{
+	uint32_t first = (uint32_t)mesh.vertices.size();
+	// the normal leans up or down by the slope of the side
+	float slope = bottomRadius - topRadius;
+
+	for (int i = 0; i <= segments; i++)
+	{
+		float u = (float)i / (float)segments;
+		float angle = u * 2.0f * PI;
+		float x = cosf(angle);
+		float z = -sinf(angle);
+		glm::vec3 normal = glm::normalize(glm::vec3(x, slope, z));
+
+		AddVertex(mesh, glm::vec3(x * bottomRadius, 0.0f, z * bottomRadius), normal, glm::vec2(u, 0.0f));
+		AddVertex(mesh, glm::vec3(x * topRadius, 1.0f, z * topRadius), normal, glm::vec2(u, 1.0f));
+	}
+
+	for (int i = 0; i < segments; i++)
+	{
+		uint32_t bottom = first + (i * 2);
+
+		mesh.indices.push_back(bottom);
+		mesh.indices.push_back(bottom + 2);
+		mesh.indices.push_back(bottom + 1);
+		mesh.indices.push_back(bottom + 1);
+		mesh.indices.push_back(bottom + 2);
+		mesh.indices.push_back(bottom + 3);
+	}
+}
+
+/***********************************************************
+ *  AddCap()
+ *
+ *  This method is used for adding a flat disc at the passed
+ *  in height, facing up or down.
+ ***********************************************************/
+void ShapeGeometry::AddCap(
+	MESH_DATA& mesh,
+	int segments,
+	float radius,
+	float y,
+	bool bFacingUp)
+{
+	glm::vec3 normal = glm::vec3(0.0f, bFacingUp ? 1.0f : -1.0f, 0.0f);
+	uint32_t center = AddVertex(mesh, glm::vec3(0.0f, y, 0.0f), normal, glm::vec2(0.5f, 0.5f));
+
+	for (int i = 0; i <= segments; i++)
+	{
+		float angle = ((float)i / (float)segments) * 2.0f * PI;
+		float x = cosf(angle);
+		float z = -sinf(angle);
+
+		AddVertex(mesh, glm::vec3(x * radius, y, z * radius), normal,
+			glm::vec2(0.5f + (x * 0.5f), 0.5f + (z * 0.5f)));
+	}
+
+	for (int i = 0; i < segments; i++)
+	{
+		uint32_t rim = center + 1 + i;
+
+		mesh.indices.push_back(center);
+		if (bFacingUp == true)
+		{
+			mesh.indices.push_back(rim);
+			mesh.indices.push_back(rim + 1);
+		}
+		else
+		{
+			mesh.indices.push_back(rim + 1);
+			mesh.indices.push_back(rim);
+		}
+	}
+}
+
+/***********************************************************
+ *  BuildPlane()
+ *
+ *  This method is used for building a 2 x 2 plane in XZ
+ *  that faces up the Y axis.
+ ***********************************************************/
+void ShapeGeometry::BuildPlane(MESH_DATA& mesh)
+{
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	AddQuad(mesh,
+		glm::vec3(-1.0f, 0.0f, 1.0f),
+		glm::vec3(1.0f, 0.0f, 1.0f),
+		glm::vec3(1.0f, 0.0f, -1.0f),
+		glm::vec3(-1.0f, 0.0f, -1.0f));
+}
+
+/***********************************************************
+ *  BuildBox()
+ *
+ *  This method is used for building a centered unit box
+ *  with one flat normal per face.
+ ***********************************************************/
+void ShapeGeometry::BuildBox(MESH_DATA& mesh)
+{
+	const float h = 0.5f;
+
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	// front and back
+	AddQuad(mesh, glm::vec3(-h, -h, h), glm::vec3(h, -h, h), glm::vec3(h, h, h), glm::vec3(-h, h, h));
+	AddQuad(mesh, glm::vec3(h, -h, -h), glm::vec3(-h, -h, -h), glm::vec3(-h, h, -h), glm::vec3(h, h, -h));
+	// right and left
+	AddQuad(mesh, glm::vec3(h, -h, h), glm::vec3(h, -h, -h), glm::vec3(h, h, -h), glm::vec3(h, h, h));
+	AddQuad(mesh, glm::vec3(-h, -h, -h), glm::vec3(-h, -h, h), glm::vec3(-h, h, h), glm::vec3(-h, h, -h));
+	// top and bottom
+	AddQuad(mesh, glm::vec3(-h, h, h), glm::vec3(h, h, h), glm::vec3(h, h, -h), glm::vec3(-h, h, -h));
+	AddQuad(mesh, glm::vec3(-h, -h, -h), glm::vec3(h, -h, -h), glm::vec3(h, -h, h), glm::vec3(-h, -h, h));
+}
+
+/***********************************************************
+ *  BuildPyramid3()
+ *
+ *  This method is used for building a centered three sided
+ *  pyramid with its apex up the Y axis.
+ ***********************************************************/
+void ShapeGeometry::BuildPyramid3(MESH_DATA& mesh)
+{
+	glm::vec3 apex = glm::vec3(0.0f, 0.5f, 0.0f);
+	glm::vec3 front = glm::vec3(0.0f, -0.5f, 0.5f);
+	glm::vec3 right = glm::vec3(0.5f, -0.5f, -0.5f);
+	glm::vec3 left = glm::vec3(-0.5f, -0.5f, -0.5f);
+
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	AddTriangle(mesh, left, front, apex);
+	AddTriangle(mesh, front, right, apex);
+	AddTriangle(mesh, right, left, apex);
+	AddTriangle(mesh, left, right, front);
+}
+
+/***********************************************************
+ *  BuildCylinder()
+ *
+ *  This method is used for building a cylinder with radius
+ *  1 from Y = 0 to Y = 1, including both caps.
+ ***********************************************************/
+void ShapeGeometry::BuildCylinder(MESH_DATA& mesh, int segments)
+{
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	AddRevolvedSide(mesh, segments, 1.0f, 1.0f);
+	AddCap(mesh, segments, 1.0f, 1.0f, true);
+	AddCap(mesh, segments, 1.0f, 0.0f, false);
+}
+
+/***********************************************************
+ *  BuildCone()
+ *
+ *  This method is used for building a cone with base radius
+ *  1 at Y = 0 and its tip at Y = 1, including the base.
+ ***********************************************************/
+void ShapeGeometry::BuildCone(MESH_DATA& mesh, int segments)
+{
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	AddRevolvedSide(mesh, segments, 1.0f, 0.0f);
+	AddCap(mesh, segments, 1.0f, 0.0f, false);
+}
+
+/***********************************************************
+ *  BuildTaperedCylinder()
+ *
+ *  This method is used for building a cylinder that tapers
+ *  from radius 1 at Y = 0 to radius 0.5 at Y = 1.
+ ***********************************************************/
+void ShapeGeometry::BuildTaperedCylinder(MESH_DATA& mesh, int segments)
+{
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	AddRevolvedSide(mesh, segments, 1.0f, 0.5f);
+	AddCap(mesh, segments, 0.5f, 1.0f, true);
+	AddCap(mesh, segments, 1.0f, 0.0f, false);
+}
+
+/***********************************************************
+ *  BuildSphere()
+ *
+ *  This method is used for building a centered sphere with
+ *  radius 1.  Half as many rings as segments are used.
+ ***********************************************************/
+void ShapeGeometry::BuildSphere(MESH_DATA& mesh, int segments)
+{
+	int rings = (segments / 2 > 2) ? (segments / 2) : 2;
+
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	for (int ring = 0; ring <= rings; ring++)
+	{
+		float v = (float)ring / (float)rings;
+		float phi = v * PI;
+
+		for (int i = 0; i <= segments; i++)
+		{
+			float u = (float)i / (float)segments;
+			float theta = u * 2.0f * PI;
+			glm::vec3 position = glm::vec3(
+				sinf(phi) * cosf(theta),
+				-cosf(phi),
+				-sinf(phi) * sinf(theta));
+
+			AddVertex(mesh, position, position, glm::vec2(u, v));
+		}
+	}
+
+	for (int ring = 0; ring < rings; ring++)
+	{
+		for (int i = 0; i < segments; i++)
+		{
+			uint32_t a = (ring * (segments + 1)) + i;
+			uint32_t b = a + segments + 1;
+
+			mesh.indices.push_back(a);
+			mesh.indices.push_back(a + 1);
+			mesh.indices.push_back(b);
+			mesh.indices.push_back(b);
+			mesh.indices.push_back(a + 1);
+			mesh.indices.push_back(b + 1);
+		}
+	}
+}
+
+/***********************************************************
+ *  GetBounds()
+ *
+ *  This method is used for getting a bounding sphere of the
+ *  mesh data.  The sphere is centered in the box around the
+ *  vertices, and reaches the vertex furthest from there.
+ ***********************************************************/
+void ShapeGeometry::GetBounds(const MESH_DATA& mesh, glm::vec3& center, float& radius)
+{
+	center = glm::vec3(0.0f, 0.0f, 0.0f);
+	radius = 0.0f;
+
+	if (mesh.vertices.empty() == true)
+	{
+		return;
+	}
+
+	glm::vec3 minimum = mesh.vertices[0].position;
+	glm::vec3 maximum = mesh.vertices[0].position;
+	for (size_t i = 1; i < mesh.vertices.size(); i++)
+	{
+		minimum = glm::min(minimum, mesh.vertices[i].position);
+		maximum = glm::max(maximum, mesh.vertices[i].position);
+	}
+	center = (minimum + maximum) * 0.5f;
+
+	for (size_t i = 0; i < mesh.vertices.size(); i++)
+	{
+		radius = glm::max(radius, glm::length(mesh.vertices[i].position - center));
+	}
+}
@@ -0,0 +1,87 @@
+///////////////////////////////////////////////////////////////////////////////
+// shapegeometry.h
+// ============
+// vertex and index data for the basic 3D shapes
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  ShapeGeometry
+ *
+ *  This class generates the vertex and index data of the
+ *  basic 3D shapes with the same unit sizes as ShapeMeshes,
+ *  so that the same transformations place them identically:
+ *
+ *    plane             - 2 x 2 in XZ, centered, facing +Y
+ *    box               - 1 x 1 x 1, centered
+ *    cylinder / cone   - radius 1, from Y = 0 up to Y = 1
+ *    tapered cylinder  - radius 1 at Y = 0, 0.5 at Y = 1
+ *    pyramid3          - 1 x 1 x 1 three sided, centered
+ *    sphere            - radius 1, centered
+ *
+ *  The data is kept in CPU memory so callers can choose how
+ *  to upload it.
+ ***********************************************************/
+class ShapeGeometry
+{
+public:
+	// interleaved vertex layout - position, normal, texture coordinate
+	struct VERTEX
+	{
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 textureCoordinate;
+	};
+
+	// generated shape data
+	struct MESH_DATA
+	{
+		std::vector<VERTEX> vertices;
+		std::vector<uint32_t> indices;
+	};
+
+	// default number of segments around the round shapes
+	static const int DEFAULT_SEGMENTS = 36;
+
+	// build the data for the basic shapes
+	static void BuildPlane(MESH_DATA& mesh);
+	static void BuildBox(MESH_DATA& mesh);
+	static void BuildPyramid3(MESH_DATA& mesh);
+	static void BuildCylinder(MESH_DATA& mesh, int segments = DEFAULT_SEGMENTS);
+	static void BuildCone(MESH_DATA& mesh, int segments = DEFAULT_SEGMENTS);
+	static void BuildTaperedCylinder(MESH_DATA& mesh, int segments = DEFAULT_SEGMENTS);
+	static void BuildSphere(MESH_DATA& mesh, int segments = DEFAULT_SEGMENTS);
+	// sphere around the center of the box that holds the vertices
+	static void GetBounds(const MESH_DATA& mesh, glm::vec3& center, float& radius);
+
+private:
+	// add a single vertex and return its index
+	static uint32_t AddVertex(
+		MESH_DATA& mesh,
+		glm::vec3 position,
+		glm::vec3 normal,
+		glm::vec2 textureCoordinate);
+	// add a flat quad or triangle with one face normal
+	static void AddQuad(MESH_DATA& mesh, glm::vec3 a, glm::vec3 b, glm::vec3 c, glm::vec3 d);
+	static void AddTriangle(MESH_DATA& mesh, glm::vec3 a, glm::vec3 b, glm::vec3 c);
+	// add the side of a shape revolved around the Y axis
+	static void AddRevolvedSide(
+		MESH_DATA& mesh,
+		int segments,
+		float bottomRadius,
+		float topRadius);
+	// add a flat disc cap at the passed in height
+	static void AddCap(
+		MESH_DATA& mesh,
+		int segments,
+		float radius,
+		float y,
+		bool bFacingUp);
+};
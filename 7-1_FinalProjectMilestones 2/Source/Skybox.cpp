@@ -0,0 +1,362 @@
+///////////////////////////////////////////////////////////////////////////////
+// skybox.cpp
+// ============
+// environment cubemap drawn behind the scene on the far plane
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Skybox.h"
+#include "FrameProfiler.h"
+#include "stb_image.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// declaration of the global variables and defines
+namespace
+{
+	const char* g_VertexShaderPath = "shaders/skyboxVertexShader.glsl";
+	const char* g_FragmentShaderPath = "shaders/skyboxFragmentShader.glsl";
+
+	// corners of the unit cube around the camera
+	const GLfloat g_CubeVertices[] =
+	{
+		-1.0f, -1.0f, -1.0f,
+		 1.0f, -1.0f, -1.0f,
+		 1.0f,  1.0f, -1.0f,
+		-1.0f,  1.0f, -1.0f,
+		-1.0f, -1.0f,  1.0f,
+		 1.0f, -1.0f,  1.0f,
+		 1.0f,  1.0f,  1.0f,
+		-1.0f,  1.0f,  1.0f
+	};
+
+	// two triangles for each face of the cube
+	const GLubyte g_CubeIndices[] =
+	{
+		0, 1, 2,  2, 3, 0,
+		4, 6, 5,  6, 4, 7,
+		0, 3, 7,  7, 4, 0,
+		1, 5, 6,  6, 2, 1,
+		3, 2, 6,  6, 7, 3,
+		0, 4, 5,  5, 1, 0
+	};
+	const GLsizei g_CubeIndexCount = sizeof(g_CubeIndices) / sizeof(g_CubeIndices[0]);
+
+	// check that a shader file exists before handing it to OpenGL
+	bool FileExists(const char* filename)
+	{
+		std::ifstream file(filename);
+		return(file.good());
+	}
+
+	// turn the rows of an image upside down
+	void FlipRows(unsigned char* pixels, int width, int height, int colorChannels)
+	{
+		size_t rowSize = (size_t)width * colorChannels;
+		std::vector<unsigned char> row(rowSize);
+
+		for (int y = 0; y < height / 2; y++)
+		{
+			unsigned char* pTop = pixels + (y * rowSize);
+			unsigned char* pBottom = pixels + ((height - 1 - y) * rowSize);
+
+			memcpy(row.data(), pTop, rowSize);
+			memcpy(pTop, pBottom, rowSize);
+			memcpy(pBottom, row.data(), rowSize);
+		}
+	}
+}
+
+/***********************************************************
+ *  Skybox()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+Skybox::Skybox()
+{
+	m_pShaderManager = NULL;
+}
+
+/***********************************************************
+ *  ~Skybox()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+Skybox::~Skybox()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for loading the sky shader and
+ *  creating the cube it is drawn on.  False is returned when
+ *  the shader cannot be used, in which case the scene keeps
+ *  its backdrop.
+ ***********************************************************/
+bool Skybox::Initialize(UniformBuffers* pUniformBuffers)
+{
+	GLint programID = 0;
+
+	if (NULL == pUniformBuffers)
+	{
+		return(false);
+	}
+
+	if ((FileExists(g_VertexShaderPath) == false) ||
+		(FileExists(g_FragmentShaderPath) == false))
+	{
+		std::cout << "Skybox shaders not found, the skybox is disabled" << std::endl;
+		return(false);
+	}
+
+	m_pShaderManager = new ShaderManager();
+	m_pShaderManager->LoadShaders(g_VertexShaderPath, g_FragmentShaderPath);
+	m_pShaderManager->use();
+	glGetIntegerv(GL_CURRENT_PROGRAM, &programID);
+	if (programID == 0)
+	{
+		std::cout << "Skybox shaders could not be loaded, the skybox is disabled" << std::endl;
+		return(false);
+	}
+	pUniformBuffers->BindProgram((GLuint)programID);
+	glUniform1i(glGetUniformLocation(programID, "environmentMap"), TEXTURE_UNIT);
+
+	m_vertexArray.Create();
+	glBindVertexArray(m_vertexArray);
+
+	m_vertexBuffer.Create();
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(g_CubeVertices), g_CubeVertices, GL_STATIC_DRAW);
+	m_vertexBuffer.SetMemory(GpuMemory::GEOMETRY, sizeof(g_CubeVertices));
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (void*)0);
+
+	m_indexBuffer.Create();
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(g_CubeIndices), g_CubeIndices, GL_STATIC_DRAW);
+	m_indexBuffer.SetMemory(GpuMemory::GEOMETRY, sizeof(g_CubeIndices));
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// the faces are filtered across their edges
+	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
+	return(true);
+}
+
+/***********************************************************
+ *  LoadCubemap()
+ *
+ *  This method is used for loading the six face images into
+ *  the cubemap, which then stays bound to its own texture
+ *  unit.  Every face must have the same size, and a file
+ *  named for several faces is decoded once for all of them.
+ *  False is returned when a face cannot be read, in which
+ *  case no sky is drawn.
+ ***********************************************************/
+bool Skybox::LoadCubemap(const char* faceFilenames[FACE_COUNT])
+{
+	if (NULL == m_pShaderManager)
+	{
+		return(false);
+	}
+
+	GpuTexture cubemap;
+	cubemap.Create();
+	glActiveTexture(GL_TEXTURE0 + TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+
+	// the texture loaders share the flag that flips the 2D textures
+	// for OpenGL, so the faces are decoded the same way and turned
+	// back, since the faces of a cubemap start at the top row
+	stbi_set_flip_vertically_on_load(true);
+
+	// the face that first named each file owns its decoded pixels
+	unsigned char* facePixels[FACE_COUNT] = { NULL };
+	int faceWidths[FACE_COUNT] = { 0 };
+	int faceHeights[FACE_COUNT] = { 0 };
+	bool bOwnsPixels[FACE_COUNT] = { false };
+
+	bool bLoaded = true;
+	long long cubemapBytes = 0;
+	for (int face = 0; face < FACE_COUNT; face++)
+	{
+		int source = 0;
+		while ((source < face) &&
+			(strcmp(faceFilenames[source], faceFilenames[face]) != 0))
+		{
+			source++;
+		}
+
+		if (source < face)
+		{
+			facePixels[face] = facePixels[source];
+			faceWidths[face] = faceWidths[source];
+			faceHeights[face] = faceHeights[source];
+		}
+		else
+		{
+			int colorChannels = 0;
+			facePixels[face] = stbi_load(faceFilenames[face], &faceWidths[face], &faceHeights[face], &colorChannels, 3);
+			if (NULL == facePixels[face])
+			{
+				std::cout << "Could not load skybox face:" << faceFilenames[face] << std::endl;
+				bLoaded = false;
+				break;
+			}
+			bOwnsPixels[face] = true;
+			FlipRows(facePixels[face], faceWidths[face], faceHeights[face], 3);
+		}
+
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGB8, faceWidths[face], faceHeights[face], 0, GL_RGB, GL_UNSIGNED_BYTE, facePixels[face]);
+		cubemapBytes += GpuMemory::GetTextureBytes(GL_RGB8, faceWidths[face], faceHeights[face], 1);
+	}
+
+	for (int face = 0; face < FACE_COUNT; face++)
+	{
+		if (bOwnsPixels[face] == true)
+		{
+			stbi_image_free(facePixels[face]);
+		}
+	}
+
+	if (bLoaded == false)
+	{
+		// the cubemap that was loaded before stays in use
+		glBindTexture(GL_TEXTURE_CUBE_MAP, m_cubemap);
+		cubemap.Destroy();
+		glActiveTexture(GL_TEXTURE0);
+		return(false);
+	}
+
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glActiveTexture(GL_TEXTURE0);
+
+	// the cubemap that was loaded before is freed here
+	cubemap.SetMemory(GpuMemory::TEXTURES, cubemapBytes);
+	m_cubemap = std::move(cubemap);
+	for (int face = 0; face < FACE_COUNT; face++)
+	{
+		m_faceFilenames[face] = faceFilenames[face];
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  WatchFiles()
+ *
+ *  This method is used for reloading the sky shaders, and
+ *  the cubemap once it is loaded, whenever one of their
+ *  files is written.
+ ***********************************************************/
+void Skybox::WatchFiles(HotReload* pHotReload)
+{
+	if ((NULL == pHotReload) || (NULL == m_pShaderManager))
+	{
+		return;
+	}
+
+	int watchIndex = pHotReload->AddWatch([this, pHotReload]() { ReloadShaders(pHotReload); });
+	pHotReload->AddFile(watchIndex, g_VertexShaderPath);
+	pHotReload->AddFile(watchIndex, g_FragmentShaderPath);
+
+	if (m_cubemap != 0)
+	{
+		watchIndex = pHotReload->AddWatch([this]() { ReloadCubemap(); });
+		for (int face = 0; face < FACE_COUNT; face++)
+		{
+			pHotReload->AddFile(watchIndex, m_faceFilenames[face]);
+		}
+	}
+}
+
+/***********************************************************
+ *  ReloadShaders()
+ *
+ *  This method is used for compiling the changed sky
+ *  shaders - the sampler keeps its texture unit.
+ ***********************************************************/
+void Skybox::ReloadShaders(HotReload* pHotReload)
+{
+	pHotReload->ReloadProgram(m_pShaderManager, g_VertexShaderPath, g_FragmentShaderPath);
+}
+
+/***********************************************************
+ *  ReloadCubemap()
+ *
+ *  This method is used for loading the faces again after
+ *  one of them changed.  The old cubemap is only replaced
+ *  once every face has loaded.
+ ***********************************************************/
+void Skybox::ReloadCubemap()
+{
+	std::string faceFilenames[FACE_COUNT];
+	const char* faces[FACE_COUNT];
+
+	for (int face = 0; face < FACE_COUNT; face++)
+	{
+		faceFilenames[face] = m_faceFilenames[face];
+		faces[face] = faceFilenames[face].c_str();
+	}
+	LoadCubemap(faces);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the cube, the cubemap and
+ *  the sky program.
+ ***********************************************************/
+void Skybox::Destroy()
+{
+	m_cubemap.Destroy();
+	m_indexBuffer.Destroy();
+	m_vertexBuffer.Destroy();
+	m_vertexArray.Destroy();
+
+	if (NULL != m_pShaderManager)
+	{
+		delete m_pShaderManager;
+		m_pShaderManager = NULL;
+	}
+}
+
+/***********************************************************
+ *  Render()
+ *
+ *  This method is used for drawing the sky with one draw of
+ *  the cube.  The sky is on the far plane, which the cleared
+ *  depth buffer holds wherever nothing was drawn, so the
+ *  depth test passes equal depths and the depth is not
+ *  written.  The sky program stays in use afterwards.
+ ***********************************************************/
+void Skybox::Render()
+{
+	if (m_cubemap == 0)
+	{
+		return;
+	}
+
+	glDepthFunc(GL_LEQUAL);
+	glDepthMask(GL_FALSE);
+
+	m_pShaderManager->use();
+	glBindVertexArray(m_vertexArray);
+	glDrawElements(GL_TRIANGLES, g_CubeIndexCount, GL_UNSIGNED_BYTE, (void*)0);
+	FrameProfiler::CountDrawCall();
+	glBindVertexArray(0);
+
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
+}
@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////////////
+// skybox.h
+// ============
+// environment cubemap drawn behind the scene on the far plane
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "UniformBuffers.h"
+#include "HotReload.h"
+#include "GpuResources.h"
+
+#include <GL/glew.h>
+
+#include <string>
+
+/***********************************************************
+ *  Skybox
+ *
+ *  This class draws the environment around the scene from a
+ *  cubemap, with a small shader of its own that does no
+ *  lighting.  The sky follows the rotation of the camera but
+ *  never its position, so it stays infinitely far away and
+ *  is there in every direction the camera turns.
+ *
+ *  It is drawn after the opaque objects, at the depth of the
+ *  far plane with the depth test set to pass equal depths,
+ *  so only the pixels that no object covers are shaded.
+ ***********************************************************/
+class Skybox
+{
+public:
+	// faces of the cubemap in the order OpenGL numbers them -
+	// +x, -x, +y, -y, +z, -z
+	static const int FACE_COUNT = 6;
+	// the texture unit the cubemap stays bound to
+	static const int TEXTURE_UNIT = 2;
+
+	// constructor
+	Skybox();
+	// destructor
+	~Skybox();
+
+	// load the sky shader and create the cube it is drawn on
+	bool Initialize(UniformBuffers* pUniformBuffers);
+	// load the six face images into the cubemap
+	bool LoadCubemap(const char* faceFilenames[FACE_COUNT]);
+	// reload the sky shaders and the faces when their files change
+	void WatchFiles(HotReload* pHotReload);
+	// true when the cubemap has been loaded
+	bool IsLoaded() const { return (m_cubemap != 0); }
+	// image a face of the cubemap was loaded from
+	const std::string& GetFaceFilename(int face) const { return m_faceFilenames[face]; }
+
+	// draw the sky behind everything drawn so far
+	void Render();
+
+private:
+	// free the cube, the cubemap and the sky program
+	void Destroy();
+	// compile the changed sky shaders
+	void ReloadShaders(HotReload* pHotReload);
+	// load the faces of the cubemap again
+	void ReloadCubemap();
+
+	// sky program - reads the camera block
+	ShaderManager* m_pShaderManager;
+	// unit cube around the camera
+	GpuVertexArray m_vertexArray;
+	GpuBuffer m_vertexBuffer;
+	GpuBuffer m_indexBuffer;
+	GpuTexture m_cubemap;
+	// images the faces were loaded from
+	std::string m_faceFilenames[FACE_COUNT];
+};
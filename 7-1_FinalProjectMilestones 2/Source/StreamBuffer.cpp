@@ -0,0 +1,198 @@
+///////////////////////////////////////////////////////////////////////////////
+// streambuffer.cpp
+// ============
+// persistently mapped ring buffer for streaming per-frame data to the GPU
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "StreamBuffer.h"
+
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// the mapping stays valid while the GPU reads the buffer, and
+	// writes become visible to the GPU without explicit flushes
+	const GLbitfield g_MapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	// nanoseconds per wait on a fence before checking it again
+	const GLuint64 g_FenceTimeout = 1000000;
+}
+
+/***********************************************************
+ *  StreamBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+StreamBuffer::StreamBuffer()
+{
+	m_pMapped = NULL;
+	m_regionSize = 0;
+	m_region = 0;
+	m_bInRegion = false;
+
+	for (int i = 0; i < REGION_COUNT; i++)
+	{
+		m_fences[i] = NULL;
+	}
+}
+
+/***********************************************************
+ *  ~StreamBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+StreamBuffer::~StreamBuffer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking for immutable buffer
+ *  storage, which persistent mapping needs.
+ ***********************************************************/
+bool StreamBuffer::IsSupported()
+{
+	return((GLEW_VERSION_4_4 == GL_TRUE) || (GLEW_ARB_buffer_storage == GL_TRUE));
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the buffer and mapping
+ *  all of it for writing.  An existing buffer is released
+ *  first, after the GPU is done with it.
+ ***********************************************************/
+bool StreamBuffer::Create(size_t regionSize)
+{
+	Destroy();
+
+	if ((regionSize == 0) || (IsSupported() == false))
+	{
+		return(false);
+	}
+
+	GLsizeiptr bufferSize = (GLsizeiptr)(regionSize * REGION_COUNT);
+
+	m_buffer.Create();
+	glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+	glBufferStorage(GL_ARRAY_BUFFER, bufferSize, NULL, g_MapFlags);
+	m_buffer.SetMemory(GpuMemory::GEOMETRY, bufferSize);
+	m_pMapped = (unsigned char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, bufferSize, g_MapFlags);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if (NULL == m_pMapped)
+	{
+		std::cout << "Could not map the stream buffer" << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	m_regionSize = regionSize;
+	m_region = 0;
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for waiting until the GPU has read
+ *  every region and releasing the buffer.
+ ***********************************************************/
+void StreamBuffer::Destroy()
+{
+	for (int i = 0; i < REGION_COUNT; i++)
+	{
+		WaitForFence(m_fences[i]);
+	}
+
+	if ((m_buffer != 0) && (NULL != m_pMapped))
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	m_buffer.Destroy();
+
+	m_pMapped = NULL;
+	m_regionSize = 0;
+	m_region = 0;
+	m_bInRegion = false;
+}
+
+/***********************************************************
+ *  BeginRegion()
+ *
+ *  This method is used for moving to the next region and
+ *  returning its mapped memory.  When the GPU still reads
+ *  the region from REGION_COUNT uses ago, this waits for it.
+ ***********************************************************/
+void* StreamBuffer::BeginRegion()
+{
+	if (NULL == m_pMapped)
+	{
+		return(NULL);
+	}
+
+	// a region that was never fenced is simply written again
+	if (m_bInRegion == false)
+	{
+		m_region = (m_region + 1) % REGION_COUNT;
+	}
+	WaitForFence(m_fences[m_region]);
+	m_bInRegion = true;
+
+	return(m_pMapped + GetRegionOffset());
+}
+
+/***********************************************************
+ *  EndRegion()
+ *
+ *  This method is used for fencing the current region after
+ *  the commands that read it have been issued.
+ ***********************************************************/
+void StreamBuffer::EndRegion()
+{
+	if ((NULL == m_pMapped) || (m_bInRegion == false))
+	{
+		return;
+	}
+
+	m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_bInRegion = false;
+}
+
+/***********************************************************
+ *  WaitForFence()
+ *
+ *  This method is used for blocking until the GPU has passed
+ *  a fence.  The first wait flushes the commands, so the
+ *  fence is sure to be reached.
+ ***********************************************************/
+void StreamBuffer::WaitForFence(GLsync& fence)
+{
+	if (NULL == fence)
+	{
+		return;
+	}
+
+	GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	while (true)
+	{
+		GLenum result = glClientWaitSync(fence, waitFlags, g_FenceTimeout);
+		if ((result == GL_ALREADY_SIGNALED) ||
+			(result == GL_CONDITION_SATISFIED) ||
+			(result == GL_WAIT_FAILED))
+		{
+			break;
+		}
+		waitFlags = 0;
+	}
+
+	glDeleteSync(fence);
+	fence = NULL;
+}
@@ -0,0 +1,67 @@
+///////////////////////////////////////////////////////////////////////////////
+// streambuffer.h
+// ============
+// persistently mapped ring buffer for streaming per-frame data to the GPU
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GpuResources.h"
+
+#include <GL/glew.h>
+
+#include <cstddef>
+
+/***********************************************************
+ *  StreamBuffer
+ *
+ *  This class owns a buffer that stays mapped for its whole
+ *  life.  The buffer is split into REGION_COUNT regions that
+ *  are used in turn: the CPU writes the data of a frame
+ *  straight into one region while the GPU still reads the
+ *  regions of the previous frames.  A fence after the draws
+ *  of a region tells when the region may be written again,
+ *  so the CPU only waits when it gets a whole ring ahead.
+ ***********************************************************/
+class StreamBuffer
+{
+public:
+	// number of regions - one written, the others in flight
+	static const int REGION_COUNT = 3;
+
+	// constructor
+	StreamBuffer();
+	// destructor
+	~StreamBuffer();
+
+	// true when the driver supports persistently mapped buffers
+	static bool IsSupported();
+
+	// create the buffer with REGION_COUNT regions of the passed in size
+	bool Create(size_t regionSize);
+	// wait for the GPU and release the buffer
+	void Destroy();
+
+	// wait until the next region is free and return it for writing
+	void* BeginRegion();
+	// fence the current region once the draws reading it are issued
+	void EndRegion();
+
+	GLuint GetBuffer() const { return m_buffer; }
+	size_t GetRegionSize() const { return m_regionSize; }
+	// byte offset of the region returned by BeginRegion()
+	size_t GetRegionOffset() const { return (size_t)m_region * m_regionSize; }
+
+private:
+	// block until a fence is signalled and delete it
+	static void WaitForFence(GLsync& fence);
+
+	GpuBuffer m_buffer;
+	unsigned char* m_pMapped;
+	size_t m_regionSize;
+	int m_region;
+	bool m_bInRegion;
+	// fence of each region - NULL when the region is free
+	GLsync m_fences[REGION_COUNT];
+};
@@ -0,0 +1,456 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecooker.cpp
+// ============
+// offline cooking of image files into compressed textures with mip chains
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureCooker.h"
+
+#include "stb_image.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// "CTX1" read as a little endian number
+	const uint32_t g_CookedMagic = 0x31585443;
+	const uint32_t g_CookedVersion = 1;
+	const char* g_CookedExtension = ".ctex";
+	// more levels than any texture up to 65536 texels wide can have
+	const uint32_t g_MaxMipLevels = 17;
+
+	// pack an 8 bit per channel color into 5:6:5 bits
+	uint16_t PackColor565(int red, int green, int blue)
+	{
+		return((uint16_t)(((red >> 3) << 11) | ((green >> 2) << 5) | (blue >> 3)));
+	}
+
+	// expand a 5:6:5 color back to 8 bits per channel
+	void UnpackColor565(uint16_t color, int* pRGB)
+	{
+		int red = (color >> 11) & 0x1F;
+		int green = (color >> 5) & 0x3F;
+		int blue = color & 0x1F;
+
+		pRGB[0] = (red << 3) | (red >> 2);
+		pRGB[1] = (green << 2) | (green >> 4);
+		pRGB[2] = (blue << 3) | (blue >> 2);
+	}
+}
+
+/***********************************************************
+ *  GetCookedFilename()
+ *
+ *  This method is used for getting the name of the cooked
+ *  file for an image file - the extension is replaced.
+ ***********************************************************/
+std::string TextureCooker::GetCookedFilename(const std::string& imageFilename)
+{
+	size_t extension = imageFilename.find_last_of('.');
+	size_t folder = imageFilename.find_last_of("/\\");
+
+	if ((extension == std::string::npos) ||
+		((folder != std::string::npos) && (extension < folder)))
+	{
+		return(imageFilename + g_CookedExtension);
+	}
+
+	return(imageFilename.substr(0, extension) + g_CookedExtension);
+}
+
+/***********************************************************
+ *  GetCompressedSize()
+ *
+ *  This method is used for getting the byte size of a mip
+ *  level.  Partial blocks at the edges take a whole block.
+ ***********************************************************/
+uint32_t TextureCooker::GetCompressedSize(uint32_t format, uint32_t width, uint32_t height)
+{
+	uint32_t blockBytes = (format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ? 16 : 8;
+	return(((width + 3) / 4) * ((height + 3) / 4) * blockBytes);
+}
+
+/***********************************************************
+ *  BuildNextMip()
+ *
+ *  This method is used for halving an RGBA image with a 2x2
+ *  box filter.  Odd edges repeat their last texel.
+ ***********************************************************/
+void TextureCooker::BuildNextMip(
+	const std::vector<unsigned char>& source,
+	int width,
+	int height,
+	std::vector<unsigned char>& destination)
+{
+	int mipWidth = (width > 1) ? width / 2 : 1;
+	int mipHeight = (height > 1) ? height / 2 : 1;
+
+	destination.resize((size_t)mipWidth * mipHeight * 4);
+
+	for (int y = 0; y < mipHeight; y++)
+	{
+		int y0 = y * 2;
+		int y1 = (y0 + 1 < height) ? y0 + 1 : y0;
+
+		for (int x = 0; x < mipWidth; x++)
+		{
+			int x0 = x * 2;
+			int x1 = (x0 + 1 < width) ? x0 + 1 : x0;
+
+			for (int channel = 0; channel < 4; channel++)
+			{
+				int sum =
+					source[((size_t)y0 * width + x0) * 4 + channel] +
+					source[((size_t)y0 * width + x1) * 4 + channel] +
+					source[((size_t)y1 * width + x0) * 4 + channel] +
+					source[((size_t)y1 * width + x1) * 4 + channel];
+				destination[((size_t)y * mipWidth + x) * 4 + channel] = (unsigned char)((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  EncodeColorBlock()
+ *
+ *  This method is used for compressing the color of 16 RGBA
+ *  texels into an 8 byte BC1 block.  The end points are the
+ *  corners of the color bounding box, pulled in slightly,
+ *  and each texel picks the nearest of the four colors.
+ ***********************************************************/
+void TextureCooker::EncodeColorBlock(const unsigned char* pTexels, unsigned char* pBlock)
+{
+	int minColor[3] = { 255, 255, 255 };
+	int maxColor[3] = { 0, 0, 0 };
+
+	for (int i = 0; i < 16; i++)
+	{
+		for (int channel = 0; channel < 3; channel++)
+		{
+			int value = pTexels[i * 4 + channel];
+			if (value < minColor[channel]) minColor[channel] = value;
+			if (value > maxColor[channel]) maxColor[channel] = value;
+		}
+	}
+
+	// pulling the corners in by 1/16 lowers the average error
+	for (int channel = 0; channel < 3; channel++)
+	{
+		int inset = (maxColor[channel] - minColor[channel]) >> 4;
+		minColor[channel] += inset;
+		maxColor[channel] -= inset;
+	}
+
+	// the larger end point first selects the four color mode
+	uint16_t color0 = PackColor565(maxColor[0], maxColor[1], maxColor[2]);
+	uint16_t color1 = PackColor565(minColor[0], minColor[1], minColor[2]);
+
+	int palette[4][3];
+	UnpackColor565(color0, palette[0]);
+	UnpackColor565(color1, palette[1]);
+	for (int channel = 0; channel < 3; channel++)
+	{
+		palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+		palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+	}
+
+	uint32_t indices = 0;
+	if (color0 != color1)
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			int bestIndex = 0;
+			int bestDistance = 0x7FFFFFFF;
+
+			for (int entry = 0; entry < 4; entry++)
+			{
+				int distance = 0;
+				for (int channel = 0; channel < 3; channel++)
+				{
+					int delta = pTexels[i * 4 + channel] - palette[entry][channel];
+					distance += delta * delta;
+				}
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestIndex = entry;
+				}
+			}
+			indices |= (uint32_t)bestIndex << (i * 2);
+		}
+	}
+
+	pBlock[0] = (unsigned char)(color0 & 0xFF);
+	pBlock[1] = (unsigned char)(color0 >> 8);
+	pBlock[2] = (unsigned char)(color1 & 0xFF);
+	pBlock[3] = (unsigned char)(color1 >> 8);
+	pBlock[4] = (unsigned char)(indices & 0xFF);
+	pBlock[5] = (unsigned char)((indices >> 8) & 0xFF);
+	pBlock[6] = (unsigned char)((indices >> 16) & 0xFF);
+	pBlock[7] = (unsigned char)(indices >> 24);
+}
+
+/***********************************************************
+ *  EncodeAlphaBlock()
+ *
+ *  This method is used for compressing the alpha of 16 RGBA
+ *  texels into the 8 byte alpha half of a BC3 block, using
+ *  the eight value mode between the lowest and highest alpha.
+ ***********************************************************/
+void TextureCooker::EncodeAlphaBlock(const unsigned char* pTexels, unsigned char* pBlock)
+{
+	int alpha0 = 0;
+	int alpha1 = 255;
+
+	for (int i = 0; i < 16; i++)
+	{
+		int value = pTexels[i * 4 + 3];
+		if (value > alpha0) alpha0 = value;
+		if (value < alpha1) alpha1 = value;
+	}
+
+	int palette[8];
+	palette[0] = alpha0;
+	palette[1] = alpha1;
+	for (int entry = 2; entry < 8; entry++)
+	{
+		palette[entry] = ((8 - entry) * alpha0 + (entry - 1) * alpha1) / 7;
+	}
+
+	uint64_t indices = 0;
+	if (alpha0 != alpha1)
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			int bestIndex = 0;
+			int bestDistance = 256;
+
+			for (int entry = 0; entry < 8; entry++)
+			{
+				int distance = pTexels[i * 4 + 3] - palette[entry];
+				if (distance < 0) distance = -distance;
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestIndex = entry;
+				}
+			}
+			indices |= (uint64_t)bestIndex << (i * 3);
+		}
+	}
+
+	pBlock[0] = (unsigned char)alpha0;
+	pBlock[1] = (unsigned char)alpha1;
+	for (int i = 0; i < 6; i++)
+	{
+		pBlock[2 + i] = (unsigned char)((indices >> (i * 8)) & 0xFF);
+	}
+}
+
+/***********************************************************
+ *  CompressImage()
+ *
+ *  This method is used for compressing a whole RGBA image
+ *  into BC1 or BC3 blocks.  Blocks that hang over the edge
+ *  repeat the last row and column of texels.
+ ***********************************************************/
+void TextureCooker::CompressImage(
+	const std::vector<unsigned char>& rgba,
+	int width,
+	int height,
+	bool bAlpha,
+	std::vector<unsigned char>& output)
+{
+	int blocksWide = (width + 3) / 4;
+	int blocksHigh = (height + 3) / 4;
+	int blockBytes = (bAlpha == true) ? 16 : 8;
+	unsigned char texels[64];
+
+	output.resize((size_t)blocksWide * blocksHigh * blockBytes);
+
+	for (int blockY = 0; blockY < blocksHigh; blockY++)
+	{
+		for (int blockX = 0; blockX < blocksWide; blockX++)
+		{
+			// gather the 4x4 texels of the block
+			for (int y = 0; y < 4; y++)
+			{
+				int sourceY = blockY * 4 + y;
+				if (sourceY >= height) sourceY = height - 1;
+
+				for (int x = 0; x < 4; x++)
+				{
+					int sourceX = blockX * 4 + x;
+					if (sourceX >= width) sourceX = width - 1;
+
+					memcpy(&texels[(y * 4 + x) * 4], &rgba[((size_t)sourceY * width + sourceX) * 4], 4);
+				}
+			}
+
+			unsigned char* pBlock = &output[((size_t)blockY * blocksWide + blockX) * blockBytes];
+			if (bAlpha == true)
+			{
+				EncodeAlphaBlock(texels, pBlock);
+				pBlock += 8;
+			}
+			EncodeColorBlock(texels, pBlock);
+		}
+	}
+}
+
+/***********************************************************
+ *  CookTexture()
+ *
+ *  This method is used for cooking an image file into a
+ *  cooked texture file with the same name and the cooked
+ *  extension.  Every mip level down to 1x1 is built and
+ *  compressed, so nothing is left to do at load time.
+ ***********************************************************/
+bool TextureCooker::CookTexture(const char* imageFilename)
+{
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
+
+	// cooked textures are flipped the same way as loaded images
+	stbi_set_flip_vertically_on_load(true);
+
+	// always read four channels so every level has the same layout
+	unsigned char* image = stbi_load(imageFilename, &width, &height, &colorChannels, 4);
+	if (NULL == image)
+	{
+		std::cout << "Could not load image:" << imageFilename << std::endl;
+		return(false);
+	}
+
+	bool bAlpha = (colorChannels == 4);
+	std::vector<unsigned char> level(image, image + (size_t)width * height * 4);
+	stbi_image_free(image);
+
+	COOKED_HEADER header;
+	header.magic = g_CookedMagic;
+	header.version = g_CookedVersion;
+	header.format = (bAlpha == true) ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	header.width = (uint32_t)width;
+	header.height = (uint32_t)height;
+	header.mipCount = 0;
+
+	std::vector<COOKED_MIP> mips;
+	std::vector<unsigned char> data;
+	std::vector<unsigned char> compressed;
+	std::vector<unsigned char> nextLevel;
+	int mipWidth = width;
+	int mipHeight = height;
+
+	while (true)
+	{
+		CompressImage(level, mipWidth, mipHeight, bAlpha, compressed);
+
+		COOKED_MIP mip;
+		mip.width = (uint32_t)mipWidth;
+		mip.height = (uint32_t)mipHeight;
+		mip.offset = (uint32_t)data.size();
+		mip.size = (uint32_t)compressed.size();
+		mips.push_back(mip);
+		data.insert(data.end(), compressed.begin(), compressed.end());
+
+		if ((mipWidth == 1) && (mipHeight == 1))
+		{
+			break;
+		}
+
+		BuildNextMip(level, mipWidth, mipHeight, nextLevel);
+		level.swap(nextLevel);
+		mipWidth = (mipWidth > 1) ? mipWidth / 2 : 1;
+		mipHeight = (mipHeight > 1) ? mipHeight / 2 : 1;
+	}
+
+	// the level offsets are stored from the start of the file
+	header.mipCount = (uint32_t)mips.size();
+	uint32_t dataStart = (uint32_t)(sizeof(COOKED_HEADER) + mips.size() * sizeof(COOKED_MIP));
+	for (size_t i = 0; i < mips.size(); i++)
+	{
+		mips[i].offset += dataStart;
+	}
+
+	std::string cookedFilename = GetCookedFilename(imageFilename);
+	std::ofstream file(cookedFilename.c_str(), std::ios::binary | std::ios::trunc);
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)&mips[0], mips.size() * sizeof(COOKED_MIP));
+	file.write((const char*)&data[0], data.size());
+	if (file.good() == false)
+	{
+		std::cout << "Could not write cooked texture:" << cookedFilename << std::endl;
+		return(false);
+	}
+
+	std::cout << "Cooked texture:" << cookedFilename << ", width:" << width << ", height:" << height << ", mips:" << header.mipCount << ", bytes:" << data.size() << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  ReadCookedTexture()
+ *
+ *  This method is used for checking the contents of a cooked
+ *  file and reading its mip table.  The texel data is not
+ *  copied - the mip offsets point into the passed in data.
+ ***********************************************************/
+bool TextureCooker::ReadCookedTexture(
+	const unsigned char* pData,
+	size_t size,
+	COOKED_TEXTURE& texture)
+{
+	COOKED_HEADER header;
+
+	if ((NULL == pData) || (size < sizeof(COOKED_HEADER)))
+	{
+		return(false);
+	}
+
+	memcpy(&header, pData, sizeof(header));
+	if ((header.magic != g_CookedMagic) ||
+		(header.version != g_CookedVersion) ||
+		(header.mipCount == 0) ||
+		(header.mipCount > g_MaxMipLevels))
+	{
+		return(false);
+	}
+	if ((header.format != GL_COMPRESSED_RGB_S3TC_DXT1_EXT) &&
+		(header.format != GL_COMPRESSED_RGBA_S3TC_DXT5_EXT))
+	{
+		return(false);
+	}
+
+	size_t tableEnd = sizeof(COOKED_HEADER) + header.mipCount * sizeof(COOKED_MIP);
+	if (size < tableEnd)
+	{
+		return(false);
+	}
+
+	texture.format = header.format;
+	texture.width = header.width;
+	texture.height = header.height;
+	texture.mips.resize(header.mipCount);
+	memcpy(&texture.mips[0], pData + sizeof(COOKED_HEADER), header.mipCount * sizeof(COOKED_MIP));
+
+	// every level must lie inside of the file and have its full size
+	for (size_t i = 0; i < texture.mips.size(); i++)
+	{
+		const COOKED_MIP& mip = texture.mips[i];
+
+		if ((mip.width == 0) || (mip.height == 0) ||
+			(mip.offset < tableEnd) ||
+			(mip.size != GetCompressedSize(header.format, mip.width, mip.height)) ||
+			((size_t)mip.offset + mip.size > size))
+		{
+			return(false);
+		}
+	}
+
+	return(true);
+}
@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecooker.h
+// ============
+// offline cooking of image files into compressed textures with mip chains
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  TextureCooker
+ *
+ *  This class turns image files into cooked texture files.
+ *  A cooked file holds the whole mip chain already block
+ *  compressed - BC1 for opaque images and BC3 for images
+ *  with alpha - so it can be handed to
+ *  glCompressedTexImage2D() without any decoding.
+ ***********************************************************/
+class TextureCooker
+{
+public:
+	// properties at the start of a cooked texture file
+	struct COOKED_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		// GL_COMPRESSED_RGB_S3TC_DXT1_EXT or GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+		uint32_t format;
+		uint32_t width;
+		uint32_t height;
+		uint32_t mipCount;
+	};
+
+	// properties of one mip level - follows the header once per level
+	struct COOKED_MIP
+	{
+		uint32_t width;
+		uint32_t height;
+		// byte offset from the start of the file
+		uint32_t offset;
+		uint32_t size;
+	};
+
+	// properties of a cooked texture read back from a file
+	struct COOKED_TEXTURE
+	{
+		uint32_t format;
+		uint32_t width;
+		uint32_t height;
+		std::vector<COOKED_MIP> mips;
+	};
+
+	// get the cooked file name for an image file
+	static std::string GetCookedFilename(const std::string& imageFilename);
+	// cook an image file into a cooked texture file next to it
+	static bool CookTexture(const char* imageFilename);
+	// check the contents of a cooked file and read its mip levels
+	static bool ReadCookedTexture(
+		const unsigned char* pData,
+		size_t size,
+		COOKED_TEXTURE& texture);
+
+private:
+	// get the byte size of a compressed mip level
+	static uint32_t GetCompressedSize(uint32_t format, uint32_t width, uint32_t height);
+	// halve an RGBA image with a box filter
+	static void BuildNextMip(
+		const std::vector<unsigned char>& source,
+		int width,
+		int height,
+		std::vector<unsigned char>& destination);
+	// compress an RGBA image into 4x4 blocks
+	static void CompressImage(
+		const std::vector<unsigned char>& rgba,
+		int width,
+		int height,
+		bool bAlpha,
+		std::vector<unsigned char>& output);
+	// compress the color of one 4x4 block of RGBA texels
+	static void EncodeColorBlock(const unsigned char* pTexels, unsigned char* pBlock);
+	// compress the alpha of one 4x4 block of RGBA texels
+	static void EncodeAlphaBlock(const unsigned char* pTexels, unsigned char* pBlock);
+};
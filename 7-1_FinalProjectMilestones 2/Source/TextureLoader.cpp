@@ -0,0 +1,288 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.cpp
+// ============
+// decode texture image files on worker threads
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureLoader.h"
+
+#include "stb_image.h"
+
+#include <cstddef>
+
+// declaration of the global variables and defines
+namespace
+{
+	// decoding is mostly disk and CPU bound, a few workers are enough
+	const unsigned int g_MaxWorkers = 4;
+	// stride for touching the pages of a mapped file
+	const size_t g_PageSize = 4096;
+}
+
+/***********************************************************
+ *  TextureLoader()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureLoader::TextureLoader()
+{
+	m_pendingCount = 0;
+	m_bStopping = false;
+	m_bUseCooked = false;
+}
+
+/***********************************************************
+ *  ~TextureLoader()
+ *
+ *  The destructor for the class - stops the workers and
+ *  frees any images that were never taken.
+ ***********************************************************/
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+		m_requests.clear();
+	}
+	m_requestReady.notify_all();
+
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+	m_workers.clear();
+
+	while (m_decoded.empty() == false)
+	{
+		FreeImage(m_decoded.front());
+		m_decoded.pop_front();
+	}
+}
+
+/***********************************************************
+ *  StartWorkers()
+ *
+ *  This method is used for starting the worker threads.  The
+ *  stb_image flip setting is global, so it is set once here
+ *  before any worker starts decoding.
+ ***********************************************************/
+void TextureLoader::StartWorkers()
+{
+	unsigned int workerCount = std::thread::hardware_concurrency();
+
+	// leave one core for the main thread
+	if (workerCount > 1)
+	{
+		workerCount--;
+	}
+	if (workerCount < 1)
+	{
+		workerCount = 1;
+	}
+	if (workerCount > g_MaxWorkers)
+	{
+		workerCount = g_MaxWorkers;
+	}
+
+	// indicate to always flip images vertically when loaded
+	stbi_set_flip_vertically_on_load(true);
+
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		m_workers.push_back(std::thread(&TextureLoader::WorkerLoop, this));
+	}
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is used by each worker thread for decoding
+ *  queued image files until the loader is stopped.
+ ***********************************************************/
+void TextureLoader::WorkerLoop()
+{
+	while (true)
+	{
+		LOAD_REQUEST request;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while ((m_requests.empty() == true) && (m_bStopping == false))
+			{
+				m_requestReady.wait(lock);
+			}
+			if (m_bStopping == true)
+			{
+				return;
+			}
+			request = m_requests.front();
+			m_requests.pop_front();
+		}
+
+		// decode outside of the lock so the workers run in parallel
+		DECODED_IMAGE image;
+		image.filename = request.filename;
+		image.textureIndex = request.textureIndex;
+		image.width = 0;
+		image.height = 0;
+		image.colorChannels = 0;
+		image.pixels = NULL;
+		image.pCookedFile = NULL;
+
+		// the image file is only decoded when there is no cooked texture
+		if ((m_bUseCooked == false) || (LoadCookedTexture(image) == false))
+		{
+			image.pixels = stbi_load(
+				request.filename.c_str(),
+				&image.width,
+				&image.height,
+				&image.colorChannels,
+				0);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_decoded.push_back(image);
+		}
+		m_imageReady.notify_all();
+	}
+}
+
+/***********************************************************
+ *  LoadCookedTexture()
+ *
+ *  This method is used for mapping the cooked texture of an
+ *  image file.  Its pages are touched here, so the upload on
+ *  the main thread does not wait on the disk.
+ ***********************************************************/
+bool TextureLoader::LoadCookedTexture(DECODED_IMAGE& image)
+{
+	std::string cookedFilename = TextureCooker::GetCookedFilename(image.filename);
+	MappedFile* pFile = new MappedFile();
+
+	if ((pFile->Open(cookedFilename.c_str()) == false) ||
+		(TextureCooker::ReadCookedTexture(pFile->GetData(), pFile->GetSize(), image.cooked) == false))
+	{
+		delete pFile;
+		return(false);
+	}
+
+	volatile unsigned char touched = 0;
+	for (size_t offset = 0; offset < pFile->GetSize(); offset += g_PageSize)
+	{
+		touched = touched + pFile->GetData()[offset];
+	}
+
+	image.filename = cookedFilename;
+	image.width = (int)image.cooked.width;
+	image.height = (int)image.cooked.height;
+	image.colorChannels = (image.cooked.format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ? 4 : 3;
+	image.pixels = (unsigned char*)pFile->GetData();
+	image.pCookedFile = pFile;
+
+	return(true);
+}
+
+/***********************************************************
+ *  Request()
+ *
+ *  This method is used for queueing an image file to be
+ *  decoded for the passed in texture index.
+ ***********************************************************/
+void TextureLoader::Request(const std::string& filename, int textureIndex)
+{
+	if (m_workers.empty() == true)
+	{
+		StartWorkers();
+	}
+
+	LOAD_REQUEST request;
+	request.filename = filename;
+	request.textureIndex = textureIndex;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_requests.push_back(request);
+		m_pendingCount++;
+	}
+	m_requestReady.notify_one();
+}
+
+/***********************************************************
+ *  PopDecoded()
+ *
+ *  This method is used for taking the next decoded image
+ *  without waiting.  False is returned when none is ready.
+ ***********************************************************/
+bool TextureLoader::PopDecoded(DECODED_IMAGE& image)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_decoded.empty() == true)
+	{
+		return(false);
+	}
+
+	image = m_decoded.front();
+	m_decoded.pop_front();
+	m_pendingCount--;
+
+	return(true);
+}
+
+/***********************************************************
+ *  WaitDecoded()
+ *
+ *  This method is used for waiting on the next decoded
+ *  image.  False is returned when nothing is pending.
+ ***********************************************************/
+bool TextureLoader::WaitDecoded(DECODED_IMAGE& image)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while ((m_decoded.empty() == true) && (m_pendingCount > 0))
+	{
+		m_imageReady.wait(lock);
+	}
+	if (m_decoded.empty() == true)
+	{
+		return(false);
+	}
+
+	image = m_decoded.front();
+	m_decoded.pop_front();
+	m_pendingCount--;
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetPendingCount()
+ *
+ *  This method is used for getting the number of requested
+ *  images that have not been taken yet.
+ ***********************************************************/
+int TextureLoader::GetPendingCount()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return(m_pendingCount);
+}
+
+/***********************************************************
+ *  FreeImage()
+ *
+ *  This method is used for freeing the pixels of a decoded
+ *  image once they have been uploaded.
+ ***********************************************************/
+void TextureLoader::FreeImage(DECODED_IMAGE& image)
+{
+	if (NULL != image.pCookedFile)
+	{
+		delete image.pCookedFile;
+		image.pCookedFile = NULL;
+	}
+	else if (NULL != image.pixels)
+	{
+		stbi_image_free(image.pixels);
+	}
+	image.pixels = NULL;
+}
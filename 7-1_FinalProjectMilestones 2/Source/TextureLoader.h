@@ -0,0 +1,98 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.h
+// ============
+// decode texture image files on worker threads
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MappedFile.h"
+#include "TextureCooker.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  TextureLoader
+ *
+ *  This class decodes image files on a small pool of worker
+ *  threads.  It never calls OpenGL - the decoded pixels are
+ *  handed back to the thread that owns the GL context, which
+ *  uploads them and then frees the image.
+ ***********************************************************/
+class TextureLoader
+{
+public:
+	// properties for a decoded image waiting to be uploaded
+	struct DECODED_IMAGE
+	{
+		std::string filename;
+		int textureIndex;
+		int width;
+		int height;
+		int colorChannels;
+		// NULL when the image file could not be decoded
+		unsigned char* pixels;
+		// set for a cooked texture - pixels then points into the
+		// mapped file and the mip levels are already compressed
+		MappedFile* pCookedFile;
+		TextureCooker::COOKED_TEXTURE cooked;
+	};
+
+	// constructor
+	TextureLoader();
+	// destructor
+	~TextureLoader();
+
+	// read cooked textures in place of image files when they exist -
+	// has to be set before the first request
+	void SetUseCookedTextures(bool bUseCooked) { m_bUseCooked = bUseCooked; }
+
+	// queue an image file to be decoded for a texture index
+	void Request(const std::string& filename, int textureIndex);
+	// take a decoded image without waiting - false when none are ready
+	bool PopDecoded(DECODED_IMAGE& image);
+	// wait for the next decoded image - false when nothing is pending
+	bool WaitDecoded(DECODED_IMAGE& image);
+	// number of requested images that have not been taken yet
+	int GetPendingCount();
+
+	// free the pixels of a decoded image
+	static void FreeImage(DECODED_IMAGE& image);
+
+private:
+	// properties for a queued image file
+	struct LOAD_REQUEST
+	{
+		std::string filename;
+		int textureIndex;
+	};
+
+	// worker threads, started by the first request
+	std::vector<std::thread> m_workers;
+	// guards all of the members below
+	std::mutex m_mutex;
+	// signalled when a request is queued or the loader stops
+	std::condition_variable m_requestReady;
+	// signalled when an image has been decoded
+	std::condition_variable m_imageReady;
+	std::deque<LOAD_REQUEST> m_requests;
+	std::deque<DECODED_IMAGE> m_decoded;
+	// requested images that have not been taken yet
+	int m_pendingCount;
+	bool m_bStopping;
+	// only read from the workers once they have started
+	bool m_bUseCooked;
+
+	// start the worker threads
+	void StartWorkers();
+	// decode queued requests until the loader stops
+	void WorkerLoop();
+	// map the cooked texture of an image file - false when it has none
+	bool LoadCookedTexture(DECODED_IMAGE& image);
+};
@@ -0,0 +1,215 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureresidency.cpp
+// ============
+// make scene textures available to the draws by index - bindless or bound
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureResidency.h"
+#include "FrameProfiler.h"
+
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// grey shown on an object until its real texture arrives
+	const unsigned char g_PlaceholderPixel[4] = { 128, 128, 128, 255 };
+}
+
+/***********************************************************
+ *  TextureResidency()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureResidency::TextureResidency()
+{
+	m_pUniformBuffers = NULL;
+	m_placeholderHandle = 0;
+	m_bBindless = false;
+	m_boundTextureID = 0;
+}
+
+/***********************************************************
+ *  ~TextureResidency()
+ *
+ *  The destructor for the class - the handles are released
+ *  here, the registered textures belong to the caller.
+ ***********************************************************/
+TextureResidency::~TextureResidency()
+{
+	for (size_t i = 0; i < m_textures.size(); i++)
+	{
+		if (m_textures[i].handle != 0)
+		{
+			glMakeTextureHandleNonResidentARB(m_textures[i].handle);
+		}
+	}
+	m_textures.clear();
+
+	if (m_placeholderHandle != 0)
+	{
+		glMakeTextureHandleNonResidentARB(m_placeholderHandle);
+		m_placeholderHandle = 0;
+	}
+	m_placeholderID.Destroy();
+	m_pUniformBuffers = NULL;
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for creating the placeholder texture
+ *  and for choosing bindless handles when the driver and the
+ *  uniform buffers support them.
+ ***********************************************************/
+void TextureResidency::Initialize(UniformBuffers* pUniformBuffers)
+{
+	m_pUniformBuffers = pUniformBuffers;
+	m_bBindless = ((NULL != pUniformBuffers) && (GLEW_ARB_bindless_texture == GL_TRUE));
+
+	m_placeholderID.Create();
+	glBindTexture(GL_TEXTURE_2D, m_placeholderID);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, g_PlaceholderPixel);
+	m_placeholderID.SetMemory(GpuMemory::TEXTURES, sizeof(g_PlaceholderPixel));
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	if (m_bBindless == true)
+	{
+		m_placeholderHandle = glGetTextureHandleARB(m_placeholderID);
+		glMakeTextureHandleResidentARB(m_placeholderHandle);
+	}
+}
+
+/***********************************************************
+ *  AddTexture()
+ *
+ *  This method is used for registering a texture that is
+ *  still loading.  Its index shows the placeholder until
+ *  SetTextureReady() is called.  -1 is returned when the
+ *  bindless table is full.
+ ***********************************************************/
+int TextureResidency::AddTexture(GLuint textureID)
+{
+	int textureIndex = (int)m_textures.size();
+
+	if ((m_bBindless == true) &&
+		(m_pUniformBuffers->SetTextureHandle(textureIndex, m_placeholderHandle) == false))
+	{
+		return(-1);
+	}
+
+	RESIDENT_TEXTURE texture;
+	texture.textureID = textureID;
+	texture.handle = 0;
+	texture.bReady = false;
+	m_textures.push_back(texture);
+
+	return(textureIndex);
+}
+
+/***********************************************************
+ *  SetTextureReady()
+ *
+ *  This method is used for marking a texture as finished.
+ *  A bindless handle makes the texture immutable, so it is
+ *  only created once the final image and mipmaps are in.
+ ***********************************************************/
+void TextureResidency::SetTextureReady(int textureIndex)
+{
+	if ((textureIndex < 0) || (textureIndex >= (int)m_textures.size()))
+	{
+		return;
+	}
+
+	RESIDENT_TEXTURE& texture = m_textures[textureIndex];
+	if (texture.bReady == true)
+	{
+		return;
+	}
+	texture.bReady = true;
+
+	if (m_bBindless == true)
+	{
+		texture.handle = glGetTextureHandleARB(texture.textureID);
+		glMakeTextureHandleResidentARB(texture.handle);
+		m_pUniformBuffers->SetTextureHandle(textureIndex, texture.handle);
+	}
+}
+
+/***********************************************************
+ *  IsTextureReady()
+ *
+ *  This method is used for checking whether a texture shows
+ *  its final image rather than the placeholder.
+ ***********************************************************/
+bool TextureResidency::IsTextureReady(int textureIndex) const
+{
+	if ((textureIndex < 0) || (textureIndex >= (int)m_textures.size()))
+	{
+		return(false);
+	}
+
+	return(m_textures[textureIndex].bReady);
+}
+
+/***********************************************************
+ *  ReplaceTexture()
+ *
+ *  This method is used for switching a texture index over
+ *  to a new texture object that already holds its image.
+ *  The storage of a texture with a bindless handle can not
+ *  change, so a reloaded image goes into a new object, and
+ *  the handle of the old one is released here.
+ ***********************************************************/
+void TextureResidency::ReplaceTexture(int textureIndex, GLuint textureID)
+{
+	if ((textureIndex < 0) || (textureIndex >= (int)m_textures.size()))
+	{
+		return;
+	}
+
+	RESIDENT_TEXTURE& texture = m_textures[textureIndex];
+	if (texture.handle != 0)
+	{
+		glMakeTextureHandleNonResidentARB(texture.handle);
+		texture.handle = 0;
+	}
+	if (m_boundTextureID == texture.textureID)
+	{
+		m_boundTextureID = 0;
+	}
+
+	texture.textureID = textureID;
+	texture.bReady = false;
+	SetTextureReady(textureIndex);
+}
+
+/***********************************************************
+ *  BindTexture()
+ *
+ *  This method is used for binding a texture to the texture
+ *  unit for the following draws.  Textures that are still
+ *  loading bind the placeholder, and binding the texture
+ *  that is already bound does nothing.
+ ***********************************************************/
+void TextureResidency::BindTexture(int textureIndex)
+{
+	GLuint textureID = m_placeholderID;
+
+	if ((textureIndex >= 0) && (textureIndex < (int)m_textures.size()) &&
+		(m_textures[textureIndex].bReady == true))
+	{
+		textureID = m_textures[textureIndex].textureID;
+	}
+
+	if (textureID != m_boundTextureID)
+	{
+		glActiveTexture(GL_TEXTURE0 + TEXTURE_UNIT);
+		glBindTexture(GL_TEXTURE_2D, textureID);
+		m_boundTextureID = textureID;
+		FrameProfiler::CountTextureBind();
+	}
+}
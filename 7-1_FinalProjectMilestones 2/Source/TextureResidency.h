@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureresidency.h
+// ============
+// make scene textures available to the draws by index - bindless or bound
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "UniformBuffers.h"
+#include "GpuResources.h"
+
+#include <GL/glew.h>
+
+#include <vector>
+
+/***********************************************************
+ *  TextureResidency
+ *
+ *  This class keeps track of every scene texture by index.
+ *  With GL_ARB_bindless_texture each finished texture gets a
+ *  resident handle in the texture block, so shaders that
+ *  declare the block sample any texture without a binding.
+ *  Shaders without the block get the texture of a draw bound
+ *  to a single texture unit on demand.  Textures that are
+ *  still loading show a shared placeholder in both cases.
+ ***********************************************************/
+class TextureResidency
+{
+public:
+	// the texture unit used for bound textures
+	static const int TEXTURE_UNIT = 0;
+
+	// constructor
+	TextureResidency();
+	// destructor
+	~TextureResidency();
+
+	// create the placeholder and choose between bindless and bound
+	void Initialize(UniformBuffers* pUniformBuffers);
+	// true when finished textures have bindless handles
+	bool IsBindless() const { return m_bBindless; }
+
+	// register a texture that is still loading - returns its index
+	int AddTexture(GLuint textureID);
+	// the final image of a texture has been uploaded
+	void SetTextureReady(int textureIndex);
+	// true once the final image of a texture has been uploaded
+	bool IsTextureReady(int textureIndex) const;
+	// use a new texture object for a ready texture, after its file
+	// changed - the caller frees the old texture object
+	void ReplaceTexture(int textureIndex, GLuint textureID);
+	// number of registered textures
+	int GetTextureCount() const { return (int)m_textures.size(); }
+
+	// bind a texture, or the placeholder, to the texture unit
+	void BindTexture(int textureIndex);
+	// forget the bound texture after other code changed the binding
+	void InvalidateBinding() { m_boundTextureID = 0; }
+
+private:
+	// properties for a registered texture
+	struct RESIDENT_TEXTURE
+	{
+		GLuint textureID;
+		// 0 until the texture is ready and bindless is in use
+		GLuint64 handle;
+		bool bReady;
+	};
+
+	// pointer to the shared uniform buffers - holds the handles
+	UniformBuffers* m_pUniformBuffers;
+	std::vector<RESIDENT_TEXTURE> m_textures;
+	// one pixel texture shown while a texture is loading
+	GpuTexture m_placeholderID;
+	GLuint64 m_placeholderHandle;
+	bool m_bBindless;
+	// texture currently bound to the texture unit
+	GLuint m_boundTextureID;
+};
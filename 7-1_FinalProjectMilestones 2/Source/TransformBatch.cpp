@@ -0,0 +1,495 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformbatch.cpp
+// ============
+// build the model matrices of many objects at once with SIMD instructions
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransformBatch.h"
+
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+// SSE2 is always there on x64 and is the default for x86 builds,
+// while AVX would need the whole project built for it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define TRANSFORM_BATCH_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define TRANSFORM_BATCH_NEON
+#endif
+
+// declaration of the global variables and defines
+namespace
+{
+	const float g_DegreesToRadians = 3.14159265358979f / 180.0f;
+
+#if defined(TRANSFORM_BATCH_SSE2)
+	const char* const g_InstructionSet = "SSE2";
+#elif defined(TRANSFORM_BATCH_NEON)
+	const char* const g_InstructionSet = "NEON";
+#else
+	const char* const g_InstructionSet = "scalar";
+#endif
+
+#if defined(TRANSFORM_BATCH_SSE2) || defined(TRANSFORM_BATCH_NEON)
+	// number of objects built at a time
+	const int g_LaneCount = 4;
+
+	// pi / 2 split into three parts, so that subtracting whole
+	// quarter turns keeps the precision of the remainder
+	const float g_TwoOverPi = 0.636619772367581f;
+	const float g_HalfPi1 = 1.5703125f;
+	const float g_HalfPi2 = 4.837512969970703125e-4f;
+	const float g_HalfPi3 = 7.54978995489188216e-8f;
+	// polynomials of sin and cos between -pi / 4 and pi / 4
+	const float g_Sin1 = -1.6666654611e-1f;
+	const float g_Sin2 = 8.3321608736e-3f;
+	const float g_Sin3 = -1.9515295891e-4f;
+	const float g_Cos1 = 4.166664568298827e-2f;
+	const float g_Cos2 = -1.388731625493765e-3f;
+	const float g_Cos3 = 2.443315711809948e-5f;
+#endif
+
+#if defined(TRANSFORM_BATCH_SSE2)
+	// four lanes of floats and integers
+	typedef __m128 FLOAT4;
+	typedef __m128i INT4;
+
+	inline FLOAT4 Load4(const float* pValues) { return _mm_loadu_ps(pValues); }
+	inline void Store4(float* pValues, FLOAT4 value) { _mm_storeu_ps(pValues, value); }
+	inline FLOAT4 Splat4(float value) { return _mm_set1_ps(value); }
+	inline FLOAT4 Add4(FLOAT4 a, FLOAT4 b) { return _mm_add_ps(a, b); }
+	inline FLOAT4 Sub4(FLOAT4 a, FLOAT4 b) { return _mm_sub_ps(a, b); }
+	inline FLOAT4 Mul4(FLOAT4 a, FLOAT4 b) { return _mm_mul_ps(a, b); }
+	inline INT4 SplatInt4(int value) { return _mm_set1_epi32(value); }
+	inline INT4 AddInt4(INT4 a, INT4 b) { return _mm_add_epi32(a, b); }
+	inline INT4 AndInt4(INT4 a, INT4 b) { return _mm_and_si128(a, b); }
+	// round to the nearest whole number
+	inline INT4 RoundToInt4(FLOAT4 value) { return _mm_cvtps_epi32(value); }
+	inline FLOAT4 IntToFloat4(INT4 value) { return _mm_cvtepi32_ps(value); }
+	// a where the mask is not zero, b where it is
+	inline FLOAT4 Select4(INT4 mask, FLOAT4 a, FLOAT4 b)
+	{
+		FLOAT4 zeroMask = _mm_castsi128_ps(_mm_cmpeq_epi32(mask, _mm_setzero_si128()));
+		return(_mm_or_ps(_mm_and_ps(zeroMask, b), _mm_andnot_ps(zeroMask, a)));
+	}
+	// negate the lanes where bit 1 of the integer is set
+	inline FLOAT4 NegateOnBit1(FLOAT4 value, INT4 bits)
+	{
+		return(_mm_xor_ps(value, _mm_castsi128_ps(_mm_slli_epi32(bits, 30))));
+	}
+	// turn four rows of four lanes into four columns
+	inline void Transpose4(FLOAT4& a, FLOAT4& b, FLOAT4& c, FLOAT4& d)
+	{
+		_MM_TRANSPOSE4_PS(a, b, c, d);
+	}
+#elif defined(TRANSFORM_BATCH_NEON)
+	// four lanes of floats and integers
+	typedef float32x4_t FLOAT4;
+	typedef int32x4_t INT4;
+
+	inline FLOAT4 Load4(const float* pValues) { return vld1q_f32(pValues); }
+	inline void Store4(float* pValues, FLOAT4 value) { vst1q_f32(pValues, value); }
+	inline FLOAT4 Splat4(float value) { return vdupq_n_f32(value); }
+	inline FLOAT4 Add4(FLOAT4 a, FLOAT4 b) { return vaddq_f32(a, b); }
+	inline FLOAT4 Sub4(FLOAT4 a, FLOAT4 b) { return vsubq_f32(a, b); }
+	inline FLOAT4 Mul4(FLOAT4 a, FLOAT4 b) { return vmulq_f32(a, b); }
+	inline INT4 SplatInt4(int value) { return vdupq_n_s32(value); }
+	inline INT4 AddInt4(INT4 a, INT4 b) { return vaddq_s32(a, b); }
+	inline INT4 AndInt4(INT4 a, INT4 b) { return vandq_s32(a, b); }
+	// round to the nearest whole number, halves away from zero
+	inline INT4 RoundToInt4(FLOAT4 value)
+	{
+		FLOAT4 half = vbslq_f32(vcltq_f32(value, vdupq_n_f32(0.0f)), vdupq_n_f32(-0.5f), vdupq_n_f32(0.5f));
+		return(vcvtq_s32_f32(vaddq_f32(value, half)));
+	}
+	inline FLOAT4 IntToFloat4(INT4 value) { return vcvtq_f32_s32(value); }
+	// a where the mask is not zero, b where it is
+	inline FLOAT4 Select4(INT4 mask, FLOAT4 a, FLOAT4 b) { return vbslq_f32(vtstq_s32(mask, mask), a, b); }
+	// negate the lanes where bit 1 of the integer is set
+	inline FLOAT4 NegateOnBit1(FLOAT4 value, INT4 bits)
+	{
+		return(vreinterpretq_f32_u32(veorq_u32(
+			vreinterpretq_u32_f32(value),
+			vreinterpretq_u32_s32(vshlq_n_s32(bits, 30)))));
+	}
+	// turn four rows of four lanes into four columns
+	inline void Transpose4(FLOAT4& a, FLOAT4& b, FLOAT4& c, FLOAT4& d)
+	{
+		float32x4x2_t ab = vtrnq_f32(a, b);
+		float32x4x2_t cd = vtrnq_f32(c, d);
+		a = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+		b = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+		c = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+		d = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+	}
+#endif
+
+#if defined(TRANSFORM_BATCH_SSE2) || defined(TRANSFORM_BATCH_NEON)
+	/***********************************************************
+	 *  SinCos4()
+	 *
+	 *  This function is used for the sine and cosine of four
+	 *  angles in radians.  The angle is reduced by whole quarter
+	 *  turns to a remainder between -pi / 4 and pi / 4, whose
+	 *  sine and cosine come from short polynomials, and the
+	 *  quarter turns pick which of the two is the sine and
+	 *  which sign it has.
+	 ***********************************************************/
+	inline void SinCos4(FLOAT4 angle, FLOAT4& sine, FLOAT4& cosine)
+	{
+		INT4 quadrant = RoundToInt4(Mul4(angle, Splat4(g_TwoOverPi)));
+		FLOAT4 turns = IntToFloat4(quadrant);
+
+		FLOAT4 x = Sub4(angle, Mul4(turns, Splat4(g_HalfPi1)));
+		x = Sub4(x, Mul4(turns, Splat4(g_HalfPi2)));
+		x = Sub4(x, Mul4(turns, Splat4(g_HalfPi3)));
+		FLOAT4 x2 = Mul4(x, x);
+
+		FLOAT4 sinX = Add4(Mul4(Splat4(g_Sin3), x2), Splat4(g_Sin2));
+		sinX = Add4(Mul4(sinX, x2), Splat4(g_Sin1));
+		sinX = Add4(Mul4(Mul4(sinX, x2), x), x);
+
+		FLOAT4 cosX = Add4(Mul4(Splat4(g_Cos3), x2), Splat4(g_Cos2));
+		cosX = Add4(Mul4(cosX, x2), Splat4(g_Cos1));
+		cosX = Mul4(Mul4(cosX, x2), x2);
+		cosX = Add4(Sub4(cosX, Mul4(Splat4(0.5f), x2)), Splat4(1.0f));
+
+		// odd quarter turns swap the two, and the sine is negative in
+		// quarters 2 and 3 while the cosine is in quarters 1 and 2
+		INT4 bSwap = AndInt4(quadrant, SplatInt4(1));
+		sine = Select4(bSwap, cosX, sinX);
+		cosine = Select4(bSwap, sinX, cosX);
+		sine = NegateOnBit1(sine, AndInt4(quadrant, SplatInt4(2)));
+		cosine = NegateOnBit1(cosine, AndInt4(AddInt4(quadrant, SplatInt4(1)), SplatInt4(2)));
+	}
+#endif
+
+	/***********************************************************
+	 *  MultiplyMatrices()
+	 *
+	 *  This function is used for building a model matrix the
+	 *  way the scene used to, from one matrix for the scale,
+	 *  each rotation and the translation.  The benchmark
+	 *  measures against it.
+	 ***********************************************************/
+	glm::mat4 MultiplyMatrices(
+		const glm::vec3& scaleXYZ,
+		const glm::vec3& rotationDegrees,
+		const glm::vec3& positionXYZ)
+	{
+		glm::mat4 scale = glm::scale(scaleXYZ);
+		glm::mat4 rotationX = glm::rotate(glm::radians(rotationDegrees.x), glm::vec3(1.0f, 0.0f, 0.0f));
+		glm::mat4 rotationY = glm::rotate(glm::radians(rotationDegrees.y), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 rotationZ = glm::rotate(glm::radians(rotationDegrees.z), glm::vec3(0.0f, 0.0f, 1.0f));
+		glm::mat4 translation = glm::translate(positionXYZ);
+
+		return(translation * rotationZ * rotationY * rotationX * scale);
+	}
+
+	/***********************************************************
+	 *  GetLargestDifference()
+	 *
+	 *  This function is used for getting the largest difference
+	 *  between the elements of two lists of matrices.
+	 ***********************************************************/
+	float GetLargestDifference(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b)
+	{
+		float largest = 0.0f;
+
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				for (int row = 0; row < 4; row++)
+				{
+					largest = std::max(largest, std::fabs(a[i][column][row] - b[i][column][row]));
+				}
+			}
+		}
+
+		return(largest);
+	}
+}
+
+/***********************************************************
+ *  TransformBatch()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TransformBatch::TransformBatch()
+{
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all the transforms, so
+ *  the batch can be filled again without allocating.
+ ***********************************************************/
+void TransformBatch::Clear()
+{
+	m_scaleX.clear();
+	m_scaleY.clear();
+	m_scaleZ.clear();
+	m_rotationX.clear();
+	m_rotationY.clear();
+	m_rotationZ.clear();
+	m_positionX.clear();
+	m_positionY.clear();
+	m_positionZ.clear();
+}
+
+/***********************************************************
+ *  Reserve()
+ *
+ *  This method is used for making room for a number of
+ *  transforms in every stream.
+ ***********************************************************/
+void TransformBatch::Reserve(int count)
+{
+	m_scaleX.reserve(count);
+	m_scaleY.reserve(count);
+	m_scaleZ.reserve(count);
+	m_rotationX.reserve(count);
+	m_rotationY.reserve(count);
+	m_rotationZ.reserve(count);
+	m_positionX.reserve(count);
+	m_positionY.reserve(count);
+	m_positionZ.reserve(count);
+}
+
+/***********************************************************
+ *  Add()
+ *
+ *  This method is used for adding the transform of an
+ *  object to the end of the streams.
+ ***********************************************************/
+int TransformBatch::Add(const glm::vec3& scaleXYZ, const glm::vec3& rotationDegrees, const glm::vec3& positionXYZ)
+{
+	m_scaleX.push_back(scaleXYZ.x);
+	m_scaleY.push_back(scaleXYZ.y);
+	m_scaleZ.push_back(scaleXYZ.z);
+	m_rotationX.push_back(rotationDegrees.x);
+	m_rotationY.push_back(rotationDegrees.y);
+	m_rotationZ.push_back(rotationDegrees.z);
+	m_positionX.push_back(positionXYZ.x);
+	m_positionY.push_back(positionXYZ.y);
+	m_positionZ.push_back(positionXYZ.z);
+
+	return((int)m_positionX.size() - 1);
+}
+
+/***********************************************************
+ *  ComposeMatrix()
+ *
+ *  This method is used for building one model matrix.  The
+ *  columns of the rotation around z, y and x are written out
+ *  from the sines and cosines and multiplied by the scale of
+ *  their axis, and the position is the last column.
+ ***********************************************************/
+glm::mat4 TransformBatch::ComposeMatrix(
+	const glm::vec3& scaleXYZ,
+	const glm::vec3& rotationDegrees,
+	const glm::vec3& positionXYZ)
+{
+	float sinX = std::sin(rotationDegrees.x * g_DegreesToRadians);
+	float cosX = std::cos(rotationDegrees.x * g_DegreesToRadians);
+	float sinY = std::sin(rotationDegrees.y * g_DegreesToRadians);
+	float cosY = std::cos(rotationDegrees.y * g_DegreesToRadians);
+	float sinZ = std::sin(rotationDegrees.z * g_DegreesToRadians);
+	float cosZ = std::cos(rotationDegrees.z * g_DegreesToRadians);
+	float sinXsinY = sinX * sinY;
+	float cosXsinY = cosX * sinY;
+
+	glm::mat4 model;
+	model[0] = glm::vec4(
+		cosZ * cosY * scaleXYZ.x,
+		sinZ * cosY * scaleXYZ.x,
+		-sinY * scaleXYZ.x,
+		0.0f);
+	model[1] = glm::vec4(
+		(cosZ * sinXsinY - sinZ * cosX) * scaleXYZ.y,
+		(sinZ * sinXsinY + cosZ * cosX) * scaleXYZ.y,
+		sinX * cosY * scaleXYZ.y,
+		0.0f);
+	model[2] = glm::vec4(
+		(cosZ * cosXsinY + sinZ * sinX) * scaleXYZ.z,
+		(sinZ * cosXsinY - cosZ * sinX) * scaleXYZ.z,
+		cosX * cosY * scaleXYZ.z,
+		0.0f);
+	model[3] = glm::vec4(positionXYZ, 1.0f);
+
+	return(model);
+}
+
+/***********************************************************
+ *  Compute()
+ *
+ *  This method is used for building the matrices of a range
+ *  of the transforms.  With SIMD instructions every lane
+ *  holds one object, the matrix elements are built as in
+ *  ComposeMatrix() for four objects at once, and every
+ *  column is turned from four objects of one component into
+ *  one object of four components before it is stored.  The
+ *  objects left over at the end are built one at a time.
+ ***********************************************************/
+void TransformBatch::Compute(int begin, int end, glm::mat4* pMatrices) const
+{
+	int i = std::max(begin, 0);
+	end = std::min(end, GetCount());
+
+	if ((NULL == pMatrices) || (i >= end))
+	{
+		return;
+	}
+
+#if defined(TRANSFORM_BATCH_SSE2) || defined(TRANSFORM_BATCH_NEON)
+	const FLOAT4 toRadians = Splat4(g_DegreesToRadians);
+	const FLOAT4 zero = Splat4(0.0f);
+	const FLOAT4 one = Splat4(1.0f);
+
+	for (; i + g_LaneCount <= end; i += g_LaneCount)
+	{
+		FLOAT4 sinX, cosX, sinY, cosY, sinZ, cosZ;
+		SinCos4(Mul4(Load4(&m_rotationX[i]), toRadians), sinX, cosX);
+		SinCos4(Mul4(Load4(&m_rotationY[i]), toRadians), sinY, cosY);
+		SinCos4(Mul4(Load4(&m_rotationZ[i]), toRadians), sinZ, cosZ);
+		FLOAT4 scaleX = Load4(&m_scaleX[i]);
+		FLOAT4 scaleY = Load4(&m_scaleY[i]);
+		FLOAT4 scaleZ = Load4(&m_scaleZ[i]);
+		FLOAT4 sinXsinY = Mul4(sinX, sinY);
+		FLOAT4 cosXsinY = Mul4(cosX, sinY);
+
+		// columns[c][r] holds row r of column c for the four objects
+		FLOAT4 columns[4][4];
+		columns[0][0] = Mul4(Mul4(cosZ, cosY), scaleX);
+		columns[0][1] = Mul4(Mul4(sinZ, cosY), scaleX);
+		columns[0][2] = Sub4(zero, Mul4(sinY, scaleX));
+		columns[0][3] = zero;
+		columns[1][0] = Mul4(Sub4(Mul4(cosZ, sinXsinY), Mul4(sinZ, cosX)), scaleY);
+		columns[1][1] = Mul4(Add4(Mul4(sinZ, sinXsinY), Mul4(cosZ, cosX)), scaleY);
+		columns[1][2] = Mul4(Mul4(sinX, cosY), scaleY);
+		columns[1][3] = zero;
+		columns[2][0] = Mul4(Add4(Mul4(cosZ, cosXsinY), Mul4(sinZ, sinX)), scaleZ);
+		columns[2][1] = Mul4(Sub4(Mul4(sinZ, cosXsinY), Mul4(cosZ, sinX)), scaleZ);
+		columns[2][2] = Mul4(Mul4(cosX, cosY), scaleZ);
+		columns[2][3] = zero;
+		columns[3][0] = Load4(&m_positionX[i]);
+		columns[3][1] = Load4(&m_positionY[i]);
+		columns[3][2] = Load4(&m_positionZ[i]);
+		columns[3][3] = one;
+
+		// afterwards columns[c][k] holds column c of object k
+		float* pOutput = &pMatrices[i - begin][0][0];
+		for (int column = 0; column < 4; column++)
+		{
+			Transpose4(columns[column][0], columns[column][1], columns[column][2], columns[column][3]);
+			for (int lane = 0; lane < g_LaneCount; lane++)
+			{
+				Store4(pOutput + lane * 16 + column * 4, columns[column][lane]);
+			}
+		}
+	}
+#endif
+
+	for (; i < end; i++)
+	{
+		pMatrices[i - begin] = ComposeMatrix(
+			glm::vec3(m_scaleX[i], m_scaleY[i], m_scaleZ[i]),
+			glm::vec3(m_rotationX[i], m_rotationY[i], m_rotationZ[i]),
+			glm::vec3(m_positionX[i], m_positionY[i], m_positionZ[i]));
+	}
+}
+
+/***********************************************************
+ *  RunBenchmark()
+ *
+ *  This method is used for timing three ways of building
+ *  the matrices of random transforms - multiplying a matrix
+ *  for every part, composing one matrix at a time, and the
+ *  batch.  Every way runs a number of times and the fastest
+ *  run is printed, along with how far the results are from
+ *  the multiplied matrices.
+ ***********************************************************/
+bool TransformBatch::RunBenchmark(int objectCount, int iterations)
+{
+	if ((objectCount <= 0) || (iterations <= 0))
+	{
+		std::cout << "The transform benchmark needs at least one object and one run" << std::endl;
+		return(false);
+	}
+
+	// the same transforms on every run
+	std::mt19937 generator(1);
+	std::uniform_real_distribution<float> scaleRange(0.1f, 4.0f);
+	std::uniform_real_distribution<float> rotationRange(-360.0f, 360.0f);
+	std::uniform_real_distribution<float> positionRange(-100.0f, 100.0f);
+
+	std::vector<glm::vec3> scales(objectCount);
+	std::vector<glm::vec3> rotations(objectCount);
+	std::vector<glm::vec3> positions(objectCount);
+	TransformBatch batch;
+	batch.Reserve(objectCount);
+	for (int i = 0; i < objectCount; i++)
+	{
+		scales[i] = glm::vec3(scaleRange(generator), scaleRange(generator), scaleRange(generator));
+		rotations[i] = glm::vec3(rotationRange(generator), rotationRange(generator), rotationRange(generator));
+		positions[i] = glm::vec3(positionRange(generator), positionRange(generator), positionRange(generator));
+		batch.Add(scales[i], rotations[i], positions[i]);
+	}
+
+	std::vector<glm::mat4> multiplied(objectCount);
+	std::vector<glm::mat4> composed(objectCount);
+	std::vector<glm::mat4> batched(objectCount);
+	double multipliedMs = 0.0;
+	double composedMs = 0.0;
+	double batchedMs = 0.0;
+
+	for (int run = 0; run < iterations; run++)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int i = 0; i < objectCount; i++)
+		{
+			multiplied[i] = MultiplyMatrices(scales[i], rotations[i], positions[i]);
+		}
+		std::chrono::steady_clock::time_point multipliedEnd = std::chrono::steady_clock::now();
+		for (int i = 0; i < objectCount; i++)
+		{
+			composed[i] = ComposeMatrix(scales[i], rotations[i], positions[i]);
+		}
+		std::chrono::steady_clock::time_point composedEnd = std::chrono::steady_clock::now();
+		batch.Compute(0, objectCount, batched.data());
+		std::chrono::steady_clock::time_point batchedEnd = std::chrono::steady_clock::now();
+
+		double runMs[3] = {
+			std::chrono::duration<double, std::milli>(multipliedEnd - start).count(),
+			std::chrono::duration<double, std::milli>(composedEnd - multipliedEnd).count(),
+			std::chrono::duration<double, std::milli>(batchedEnd - composedEnd).count() };
+		multipliedMs = (run == 0) ? runMs[0] : std::min(multipliedMs, runMs[0]);
+		composedMs = (run == 0) ? runMs[1] : std::min(composedMs, runMs[1]);
+		batchedMs = (run == 0) ? runMs[2] : std::min(batchedMs, runMs[2]);
+	}
+
+	double toNanoseconds = 1000000.0 / (double)objectCount;
+	std::cout << "Transforms: " << objectCount << " objects, fastest of " << iterations << " runs" << std::endl;
+	std::cout << "  multiplied matrices: " << multipliedMs << " ms, "
+		<< multipliedMs * toNanoseconds << " ns per object" << std::endl;
+	std::cout << "  composed one at a time: " << composedMs << " ms, "
+		<< composedMs * toNanoseconds << " ns per object" << std::endl;
+	std::cout << "  batched with " << g_InstructionSet << ": " << batchedMs << " ms, "
+		<< batchedMs * toNanoseconds << " ns per object, "
+		<< ((batchedMs > 0.0) ? multipliedMs / batchedMs : 0.0) << "x faster" << std::endl;
+	std::cout << "  largest difference from the multiplied matrices: composed "
+		<< GetLargestDifference(multiplied, composed) << ", batched "
+		<< GetLargestDifference(multiplied, batched) << std::endl;
+
+	return(true);
+}
@@ -0,0 +1,69 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformbatch.h
+// ============
+// build the model matrices of many objects at once with SIMD instructions
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  TransformBatch
+ *
+ *  This class builds model matrices from the scale, the
+ *  rotation in degrees around x, y and z, and the position
+ *  of objects.  The values are kept as one stream per
+ *  component, so four objects are read with one load, and
+ *  the rotations, scale and translation are written straight
+ *  into the matrix without building a matrix for each of
+ *  them.  With SSE2 or NEON four matrices are built at a
+ *  time, including the sines and cosines of the angles, and
+ *  without them every matrix is built on its own.
+ *
+ *  The matrices match translate * rotateZ * rotateY *
+ *  rotateX * scale of glm.
+ ***********************************************************/
+class TransformBatch
+{
+public:
+	// constructor
+	TransformBatch();
+
+	// remove all the transforms
+	void Clear();
+	// make room for a number of transforms
+	void Reserve(int count);
+	// add the transform of an object and get its index
+	int Add(const glm::vec3& scaleXYZ, const glm::vec3& rotationDegrees, const glm::vec3& positionXYZ);
+	// number of transforms in the batch
+	int GetCount() const { return (int)m_positionX.size(); }
+
+	// build the matrices of a range of the transforms - matrix i of
+	// the range is written to pMatrices[i - begin]
+	void Compute(int begin, int end, glm::mat4* pMatrices) const;
+
+	// build one matrix without the streams
+	static glm::mat4 ComposeMatrix(
+		const glm::vec3& scaleXYZ,
+		const glm::vec3& rotationDegrees,
+		const glm::vec3& positionXYZ);
+	// time the batch against building the single matrices and
+	// multiplying them together, and print the results
+	static bool RunBenchmark(int objectCount, int iterations);
+
+private:
+	// one stream per component of the transforms
+	std::vector<float> m_scaleX;
+	std::vector<float> m_scaleY;
+	std::vector<float> m_scaleZ;
+	std::vector<float> m_rotationX;
+	std::vector<float> m_rotationY;
+	std::vector<float> m_rotationZ;
+	std::vector<float> m_positionX;
+	std::vector<float> m_positionY;
+	std::vector<float> m_positionZ;
+};
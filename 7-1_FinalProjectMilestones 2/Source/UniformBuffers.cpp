@@ -0,0 +1,379 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformbuffers.cpp
+// ============
+// std140 uniform buffer objects shared by every shader program
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "UniformBuffers.h"
+
+#include <cstring>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// block names in the shaders - same order as BLOCK_ID
+	const char* g_BlockNames[UniformBuffers::BLOCK_COUNT] =
+	{
+		"CameraBlock",
+		"LightBlock",
+		"MaterialBlock",
+		"TextureBlock",
+		"ClusterBlock",
+		"ShadowBlock"
+	};
+
+	// the C++ structures must match the std140 layout exactly
+	static_assert(sizeof(UniformBuffers::CAMERA_DATA) == 144, "CameraBlock layout mismatch");
+	static_assert(sizeof(UniformBuffers::LIGHT_DATA) == 64, "LightData layout mismatch");
+	static_assert(sizeof(UniformBuffers::MATERIAL_DATA) == 32, "MaterialData layout mismatch");
+	static_assert(sizeof(UniformBuffers::CLUSTER_DATA) == 48, "ClusterBlock layout mismatch");
+	static_assert(sizeof(UniformBuffers::SHADOW_DATA) == 288, "ShadowBlock layout mismatch");
+}
+
+/***********************************************************
+ *  UniformBuffers()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+UniformBuffers::UniformBuffers()
+{
+	memset(&m_lights, 0, sizeof(m_lights));
+	memset(m_materials, 0, sizeof(m_materials));
+	memset(m_textureHandles, 0, sizeof(m_textureHandles));
+	m_bLightsDirty = false;
+	m_bMaterialsDirty = false;
+	m_bTexturesDirty = false;
+	m_materialCount = 0;
+	m_textureCount = 0;
+}
+
+/***********************************************************
+ *  ~UniformBuffers()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+UniformBuffers::~UniformBuffers()
+{
+	for (int i = 0; i < BLOCK_COUNT; i++)
+	{
+		m_bufferIDs[i].Destroy();
+	}
+}
+
+/***********************************************************
+ *  CreateBuffers()
+ *
+ *  This method is used for creating the uniform buffers and
+ *  attaching each of them to the binding point with the
+ *  same number as its block.
+ ***********************************************************/
+bool UniformBuffers::CreateBuffers()
+{
+	GLsizeiptr blockSizes[BLOCK_COUNT] =
+	{
+		sizeof(CAMERA_DATA),
+		sizeof(LIGHTS_DATA),
+		sizeof(MATERIAL_DATA) * MAX_MATERIALS,
+		sizeof(GLuint64) * MAX_TEXTURES,
+		sizeof(CLUSTER_DATA),
+		sizeof(SHADOW_DATA)
+	};
+	CLUSTER_DATA noClusters;
+	SHADOW_DATA noShadows;
+
+	for (int i = 0; i < BLOCK_COUNT; i++)
+	{
+		if (m_bufferIDs[i].Create() == 0)
+		{
+			std::cout << "Could not create uniform buffer for " << g_BlockNames[i] << std::endl;
+			return(false);
+		}
+
+		glBindBuffer(GL_UNIFORM_BUFFER, m_bufferIDs[i]);
+		glBufferData(GL_UNIFORM_BUFFER, blockSizes[i], NULL, GL_DYNAMIC_DRAW);
+		m_bufferIDs[i].SetMemory(GpuMemory::BUFFERS, blockSizes[i]);
+		glBindBufferBase(GL_UNIFORM_BUFFER, i, m_bufferIDs[i]);
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	// no lights are clustered until the light binning runs
+	memset(&noClusters, 0, sizeof(noClusters));
+	SetClusters(noClusters);
+	// and nothing is shadowed until the shadow pass runs
+	memset(&noShadows, 0, sizeof(noShadows));
+	SetShadows(noShadows);
+
+	return(true);
+}
+
+/***********************************************************
+ *  BindProgram()
+ *
+ *  This method is used for connecting the uniform blocks
+ *  declared by the passed in program to the shared binding
+ *  points.  Blocks the program does not declare are skipped.
+ ***********************************************************/
+void UniformBuffers::BindProgram(GLuint programID)
+{
+	for (int i = 0; i < BLOCK_COUNT; i++)
+	{
+		GLuint blockIndex = glGetUniformBlockIndex(programID, g_BlockNames[i]);
+
+		if (blockIndex != GL_INVALID_INDEX)
+		{
+			glUniformBlockBinding(programID, blockIndex, i);
+		}
+	}
+}
+
+/***********************************************************
+ *  GetBlockName()
+ *
+ *  This method is used for getting the name of a block as
+ *  it is declared in the shaders.
+ ***********************************************************/
+const char* UniformBuffers::GetBlockName(BLOCK_ID block)
+{
+	return(g_BlockNames[block]);
+}
+
+/***********************************************************
+ *  SetCamera()
+ *
+ *  This method is used for uploading the camera data into
+ *  the camera block.  It is called once per frame.
+ ***********************************************************/
+void UniformBuffers::SetCamera(
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	const glm::vec3& viewPosition)
+{
+	CAMERA_DATA camera;
+
+	camera.view = view;
+	camera.projection = projection;
+	camera.viewPosition = glm::vec4(viewPosition, 1.0f);
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_bufferIDs[CAMERA_BLOCK]);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(camera), &camera);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/***********************************************************
+ *  SetDirectionalLight()
+ *
+ *  This method is used for changing the directional light.
+ *  The data is uploaded by the next call to UpdateLights().
+ ***********************************************************/
+void UniformBuffers::SetDirectionalLight(
+	const glm::vec3& direction,
+	const glm::vec3& ambient,
+	const glm::vec3& diffuse,
+	const glm::vec3& specular,
+	bool bActive)
+{
+	LIGHT_DATA& light = m_lights.directionalLight;
+
+	light.vector = glm::vec4(direction, bActive ? 1.0f : 0.0f);
+	light.ambient = glm::vec4(ambient, 0.0f);
+	light.diffuse = glm::vec4(diffuse, 0.0f);
+	light.specular = glm::vec4(specular, 0.0f);
+	m_bLightsDirty = true;
+}
+
+/***********************************************************
+ *  SetPointLight()
+ *
+ *  This method is used for changing one of the point lights.
+ *  The data is uploaded by the next call to UpdateLights().
+ ***********************************************************/
+void UniformBuffers::SetPointLight(
+	int lightIndex,
+	const glm::vec3& position,
+	const glm::vec3& ambient,
+	const glm::vec3& diffuse,
+	const glm::vec3& specular,
+	bool bActive)
+{
+	if ((lightIndex < 0) || (lightIndex >= MAX_POINT_LIGHTS))
+	{
+		return;
+	}
+
+	LIGHT_DATA& light = m_lights.pointLights[lightIndex];
+
+	light.vector = glm::vec4(position, bActive ? 1.0f : 0.0f);
+	light.ambient = glm::vec4(ambient, 0.0f);
+	light.diffuse = glm::vec4(diffuse, 0.0f);
+	light.specular = glm::vec4(specular, 0.0f);
+	m_bLightsDirty = true;
+}
+
+/***********************************************************
+ *  UpdateLights()
+ *
+ *  This method is used for uploading the light block, but
+ *  only when a light was changed since the last upload.
+ ***********************************************************/
+void UniformBuffers::UpdateLights()
+{
+	if (m_bLightsDirty == false)
+	{
+		return;
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_bufferIDs[LIGHT_BLOCK]);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(m_lights), &m_lights);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	m_bLightsDirty = false;
+}
+
+/***********************************************************
+ *  SetMaterial()
+ *
+ *  This method is used for changing an entry of the material
+ *  table.  The data is uploaded by UpdateMaterials().
+ ***********************************************************/
+bool UniformBuffers::SetMaterial(
+	int materialIndex,
+	const glm::vec3& diffuseColor,
+	const glm::vec3& specularColor,
+	float shininess)
+{
+	if ((materialIndex < 0) || (materialIndex >= MAX_MATERIALS))
+	{
+		std::cout << "Material table is full, material " << materialIndex << " is not uploaded" << std::endl;
+		return(false);
+	}
+
+	m_materials[materialIndex].diffuseColor = glm::vec4(diffuseColor, 1.0f);
+	m_materials[materialIndex].specularColor = glm::vec4(specularColor, shininess);
+	if (materialIndex >= m_materialCount)
+	{
+		m_materialCount = materialIndex + 1;
+	}
+	m_bMaterialsDirty = true;
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetMaterials()
+ *
+ *  This method is used for copying a whole material table,
+ *  such as the one of a scene file, into the material block
+ *  without converting the entries one at a time.
+ ***********************************************************/
+bool UniformBuffers::SetMaterials(const MATERIAL_DATA* pMaterials, int materialCount)
+{
+	if ((materialCount < 0) || (materialCount > MAX_MATERIALS))
+	{
+		std::cout << "Material table is full, " << materialCount << " materials are not uploaded" << std::endl;
+		return(false);
+	}
+
+	if (materialCount > 0)
+	{
+		memcpy(m_materials, pMaterials, sizeof(MATERIAL_DATA) * materialCount);
+	}
+	if (materialCount > m_materialCount)
+	{
+		m_materialCount = materialCount;
+	}
+	m_bMaterialsDirty = true;
+
+	return(true);
+}
+
+/***********************************************************
+ *  UpdateMaterials()
+ *
+ *  This method is used for uploading the used part of the
+ *  material table when it has changed.
+ ***********************************************************/
+void UniformBuffers::UpdateMaterials()
+{
+	if (m_bMaterialsDirty == false)
+	{
+		return;
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_bufferIDs[MATERIAL_BLOCK]);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(MATERIAL_DATA) * m_materialCount, m_materials);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	m_bMaterialsDirty = false;
+}
+
+/***********************************************************
+ *  SetTextureHandle()
+ *
+ *  This method is used for changing an entry of the bindless
+ *  texture handle table.  The data is uploaded by
+ *  UpdateTextureHandles().
+ ***********************************************************/
+bool UniformBuffers::SetTextureHandle(int textureIndex, GLuint64 handle)
+{
+	if ((textureIndex < 0) || (textureIndex >= MAX_TEXTURES))
+	{
+		std::cout << "Texture table is full, texture " << textureIndex << " is not uploaded" << std::endl;
+		return(false);
+	}
+
+	m_textureHandles[textureIndex] = handle;
+	if (textureIndex >= m_textureCount)
+	{
+		m_textureCount = textureIndex + 1;
+	}
+	m_bTexturesDirty = true;
+
+	return(true);
+}
+
+/***********************************************************
+ *  UpdateTextureHandles()
+ *
+ *  This method is used for uploading the used part of the
+ *  texture handle table when it has changed.
+ ***********************************************************/
+void UniformBuffers::UpdateTextureHandles()
+{
+	if (m_bTexturesDirty == false)
+	{
+		return;
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_bufferIDs[TEXTURE_BLOCK]);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(GLuint64) * m_textureCount, m_textureHandles);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	m_bTexturesDirty = false;
+}
+
+/***********************************************************
+ *  SetClusters()
+ *
+ *  This method is used for uploading the cluster grid that
+ *  the light binning used for the current frame, so the
+ *  fragment shaders find the cluster of every fragment.
+ ***********************************************************/
+void UniformBuffers::SetClusters(const CLUSTER_DATA& clusters)
+{
+	glBindBuffer(GL_UNIFORM_BUFFER, m_bufferIDs[CLUSTER_BLOCK]);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(clusters), &clusters);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/***********************************************************
+ *  SetShadows()
+ *
+ *  This method is used for uploading the matrices and split
+ *  depths of the shadow cascades, so the fragment shaders
+ *  find their place in the shadow maps.
+ ***********************************************************/
+void UniformBuffers::SetShadows(const SHADOW_DATA& shadows)
+{
+	glBindBuffer(GL_UNIFORM_BUFFER, m_bufferIDs[SHADOW_BLOCK]);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(shadows), &shadows);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
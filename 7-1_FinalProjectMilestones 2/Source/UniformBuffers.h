@@ -0,0 +1,219 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformbuffers.h
+// ============
+// std140 uniform buffer objects shared by every shader program
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GpuResources.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  UniformBuffers
+ *
+ *  This class owns the uniform buffer objects for the data
+ *  that is shared by all draws - the camera is updated once
+ *  per frame, the lights only when they change, the material
+ *  table once after the materials are defined, and the
+ *  bindless texture handles as the textures finish loading.
+ *  A program uses the buffers by declaring these blocks:
+ *
+ *    layout(std140) uniform CameraBlock
+ *    {
+ *        mat4 view;
+ *        mat4 projection;
+ *        vec4 viewPosition;
+ *    };
+ *    layout(std140) uniform LightBlock
+ *    {
+ *        LightData directionalLight;      // direction in xyz,
+ *        LightData pointLights[4];        // position in xyz, w = active
+ *    };
+ *    layout(std140) uniform MaterialBlock
+ *    {
+ *        MaterialData materials[64];      // specularColor.w = shininess
+ *    };
+ *    layout(std140) uniform TextureBlock
+ *    {
+ *        uvec4 textureHandles[512];       // two bindless handles each
+ *    };
+ *    layout(std140) uniform ClusterBlock
+ *    {
+ *        uvec4 clusterGrid;               // w = clustered light count
+ *        vec4 clusterDepth;               // near, far, scale, bias
+ *        vec4 clusterViewport;
+ *    };
+ *    layout(std140) uniform ShadowBlock
+ *    {
+ *        mat4 shadowMatrices[4];          // world to shadow map
+ *        vec4 shadowSplits;               // far view depth per cascade
+ *        vec4 shadowParams;               // x = cascade count
+ *    };
+ *
+ *  with LightData holding vec4 vector, ambient, diffuse and
+ *  specular, and MaterialData holding vec4 diffuseColor and
+ *  specularColor.  The buffers are always kept up to date,
+ *  so any number of programs can share them, while programs
+ *  without the blocks keep using the individual uniforms.
+ ***********************************************************/
+class UniformBuffers
+{
+public:
+	// maximum number of point lights in the light block
+	static const int MAX_POINT_LIGHTS = 4;
+	// maximum number of materials in the material block
+	static const int MAX_MATERIALS = 64;
+	// maximum number of bindless handles in the texture block
+	static const int MAX_TEXTURES = 1024;
+	// maximum number of shadow cascades in the shadow block
+	static const int MAX_SHADOW_CASCADES = 4;
+
+	// the shared uniform blocks
+	enum BLOCK_ID
+	{
+		CAMERA_BLOCK = 0,
+		LIGHT_BLOCK,
+		MATERIAL_BLOCK,
+		TEXTURE_BLOCK,
+		CLUSTER_BLOCK,
+		SHADOW_BLOCK,
+		BLOCK_COUNT
+	};
+
+	// std140 layout of the camera block
+	struct CAMERA_DATA
+	{
+		glm::mat4 view;
+		glm::mat4 projection;
+		glm::vec4 viewPosition;
+	};
+
+	// std140 layout of one light in the light block
+	struct LIGHT_DATA
+	{
+		// direction or position in xyz, 1.0 in w when active
+		glm::vec4 vector;
+		glm::vec4 ambient;
+		glm::vec4 diffuse;
+		glm::vec4 specular;
+	};
+
+	// std140 layout of the light block
+	struct LIGHTS_DATA
+	{
+		LIGHT_DATA directionalLight;
+		LIGHT_DATA pointLights[MAX_POINT_LIGHTS];
+	};
+
+	// std140 layout of one material in the material block
+	struct MATERIAL_DATA
+	{
+		glm::vec4 diffuseColor;
+		// shininess in w
+		glm::vec4 specularColor;
+	};
+
+	// std140 layout of the cluster block
+	struct CLUSTER_DATA
+	{
+		// clusters along x, y and z, and the number of clustered
+		// lights in w - 0 when the lights are not clustered
+		glm::uvec4 gridSize;
+		// near and far plane, then the scale and bias that turn the
+		// log of a view depth into a depth slice
+		glm::vec4 depthParams;
+		// x, y, width and height of the viewport in pixels
+		glm::vec4 viewport;
+	};
+
+	// std140 layout of the shadow block
+	struct SHADOW_DATA
+	{
+		// world space to shadow map texture coordinates and depth
+		glm::mat4 cascadeMatrices[MAX_SHADOW_CASCADES];
+		// view depth where every cascade ends
+		glm::vec4 cascadeSplits;
+		// number of cascades in x - 0 when there are no shadows -
+		// the depth bias in y and the size of a shadow map texel in z
+		glm::vec4 params;
+	};
+
+	// constructor
+	UniformBuffers();
+	// destructor
+	~UniformBuffers();
+
+	// create the buffers and attach them to their binding points
+	bool CreateBuffers();
+	// connect the blocks declared by a program to the binding points
+	void BindProgram(GLuint programID);
+	// get the name of a block as it is declared in the shaders
+	static const char* GetBlockName(BLOCK_ID block);
+
+	// upload the camera data - called once per frame
+	void SetCamera(
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		const glm::vec3& viewPosition);
+
+	// change the light data - uploaded by UpdateLights()
+	void SetDirectionalLight(
+		const glm::vec3& direction,
+		const glm::vec3& ambient,
+		const glm::vec3& diffuse,
+		const glm::vec3& specular,
+		bool bActive);
+	void SetPointLight(
+		int lightIndex,
+		const glm::vec3& position,
+		const glm::vec3& ambient,
+		const glm::vec3& diffuse,
+		const glm::vec3& specular,
+		bool bActive);
+	// upload the light data if it changed since the last upload
+	void UpdateLights();
+
+	// change an entry of the material table - uploaded by UpdateMaterials()
+	bool SetMaterial(
+		int materialIndex,
+		const glm::vec3& diffuseColor,
+		const glm::vec3& specularColor,
+		float shininess);
+	// replace the start of the material table with entries already
+	// in its layout - uploaded by UpdateMaterials()
+	bool SetMaterials(const MATERIAL_DATA* pMaterials, int materialCount);
+	// upload the material table if it changed since the last upload
+	void UpdateMaterials();
+
+	// change an entry of the texture handle table - uploaded by UpdateTextureHandles()
+	bool SetTextureHandle(int textureIndex, GLuint64 handle);
+	// upload the texture handle table if it changed since the last upload
+	void UpdateTextureHandles();
+
+	// upload the cluster grid of the frame - called by the light binning
+	void SetClusters(const CLUSTER_DATA& clusters);
+	// upload the shadow cascades - called by the shadow pass
+	void SetShadows(const SHADOW_DATA& shadows);
+
+private:
+	// uniform buffer object of every block
+	GpuBuffer m_bufferIDs[BLOCK_COUNT];
+
+	// CPU copies of the light and material blocks
+	LIGHTS_DATA m_lights;
+	MATERIAL_DATA m_materials[MAX_MATERIALS];
+	// a uvec4 array in std140 packs two handles per element, the
+	// same layout as an array of 64 bit values
+	GLuint64 m_textureHandles[MAX_TEXTURES];
+	// true when the CPU copies differ from the buffers
+	bool m_bLightsDirty;
+	bool m_bMaterialsDirty;
+	bool m_bTexturesDirty;
+	// number of materials and texture handles in use
+	int m_materialCount;
+	int m_textureCount;
+};
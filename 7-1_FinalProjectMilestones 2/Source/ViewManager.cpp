@@ -17,11 +17,15 @@
 // declaration of the global variables and defines
 namespace
 {
-	// Variables for window width and height
+	// Variables for the initial window width and height
 	const int WINDOW_WIDTH = 1000;
 	const int WINDOW_HEIGHT = 800;
-	const char* g_ViewName = "view";
-	const char* g_ProjectionName = "projection";
+
+	// size of the window framebuffer, which follows the window
+	// when it is resized and can differ from the window size on
+	// high density displays
+	int gFramebufferWidth = WINDOW_WIDTH;
+	int gFramebufferHeight = WINDOW_HEIGHT;
 
 	// camera object used for viewing and interacting with
 	// the 3D scene
@@ -32,13 +36,39 @@ namespace
 	float gLastY = WINDOW_HEIGHT / 2.0f;
 	bool gFirstMouse = true;
 
-	// time between current frame and last frame
-	float gDeltaTime = 0.0f; 
-	float gLastFrame = 0.0f;
-
 	// the following variable is false when orthographic projection
 	// is off and true when it is on
 	bool bOrthographicProjection = false;
+
+	// half of the height the orthographic main view covers
+	const float ORTHOGRAPHIC_SIZE = 10.0f;
+	// depth range of every view
+	const float NEAR_PLANE = 0.1f;
+	const float FAR_PLANE = 100.0f;
+
+	/***********************************************************
+	 *  BuildProjection()
+	 *
+	 *  This function is used to build the projection of a view
+	 *  from its field of view in degrees, or from half of the
+	 *  height it covers when it is orthographic.
+	 ***********************************************************/
+	glm::mat4 BuildProjection(bool bOrthographic, float size, float aspectRatio)
+	{
+		if (bOrthographic == true)
+		{
+			return(glm::ortho(
+				-size * aspectRatio, size * aspectRatio,
+				-size, size,
+				NEAR_PLANE, FAR_PLANE));
+		}
+
+		return(glm::perspective(
+			glm::radians(size),
+			aspectRatio,
+			NEAR_PLANE,
+			FAR_PLANE));
+	}
 }
 
 /***********************************************************
@@ -51,6 +81,8 @@ ViewManager::ViewManager(
 {
 	// initialize the member variables
 	m_pShaderManager = pShaderManager;
+	m_pShaderUniforms = NULL;
+	m_pUniformBuffers = NULL;
 	m_pWindow = NULL;
 	g_pCamera = new Camera();
 	// default camera view parameters
@@ -59,6 +91,20 @@ ViewManager::ViewManager(
 	g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
 	g_pCamera->Zoom = 80;
 	g_pCamera->MovementSpeed = 20;
+	m_previousCameraPosition = g_pCamera->Position;
+
+	// the main view covers the window and follows the camera
+	SCENE_VIEW mainView;
+	mainView.viewport = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+	mainView.position = g_pCamera->Position;
+	mainView.target = g_pCamera->Position + g_pCamera->Front;
+	mainView.size = g_pCamera->Zoom;
+	mainView.bOrthographic = false;
+	mainView.viewMatrix = glm::mat4(1.0f);
+	mainView.projectionMatrix = glm::mat4(1.0f);
+	mainView.viewPosition = g_pCamera->Position;
+	m_views.push_back(mainView);
+	m_currentView = 0;
 }
 
 /***********************************************************
@@ -70,6 +116,8 @@ ViewManager::~ViewManager()
 {
 	// free up allocated memory
 	m_pShaderManager = NULL;
+	m_pShaderUniforms = NULL;
+	m_pUniformBuffers = NULL;
 	m_pWindow = NULL;
 	if (NULL != g_pCamera)
 	{
@@ -78,15 +126,40 @@ ViewManager::~ViewManager()
 	}
 }
 
+/***********************************************************
+ *  SetShaderUniforms()
+ *
+ *  This method is used to set the cached uniform locations,
+ *  which are only available after the shaders are loaded.
+ ***********************************************************/
+void ViewManager::SetShaderUniforms(ShaderUniforms* pShaderUniforms)
+{
+	m_pShaderUniforms = pShaderUniforms;
+}
+
+/***********************************************************
+ *  SetUniformBuffers()
+ *
+ *  This method is used to set the shared uniform buffers
+ *  that receive the camera data every frame.
+ ***********************************************************/
+void ViewManager::SetUniformBuffers(UniformBuffers* pUniformBuffers)
+{
+	m_pUniformBuffers = pUniformBuffers;
+}
+
 /***********************************************************
  *  CreateDisplayWindow()
  *
  *  This method is used to create the main display window.
  ***********************************************************/
-GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
+GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle, bool bVisible)
 {
 	GLFWwindow* window = nullptr;
 
+	// a hidden window still provides the OpenGL context
+	glfwWindowHint(GLFW_VISIBLE, (bVisible == true) ? GLFW_TRUE : GLFW_FALSE);
+
 	// try to create the displayed OpenGL window
 	window = glfwCreateWindow(
 		WINDOW_WIDTH,
@@ -101,16 +174,23 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	}
 	glfwMakeContextCurrent(window);
 
-	// tell GLFW to capture all mouse events
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	// the projection follows the size of the framebuffer
+	glfwGetFramebufferSize(window, &gFramebufferWidth, &gFramebufferHeight);
+	glfwSetFramebufferSizeCallback(window, &ViewManager::Framebuffer_Size_Callback);
+
+	if (bVisible == true)
+	{
+		// tell GLFW to capture all mouse events
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
-	// this callback is used to receive mouse moving events
-	glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
-	// this callback is used to receive mouse scroll wheel events
-	glfwSetScrollCallback(window, &ViewManager::Mouse_Scroll_Wheel_Callback);
+		// this callback is used to receive mouse moving events
+		glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
+		// this callback is used to receive mouse scroll wheel events
+		glfwSetScrollCallback(window, &ViewManager::Mouse_Scroll_Wheel_Callback);
+	}
 
-	// enable blending for supporting tranparent rendering
-	glEnable(GL_BLEND);
+	// blending for tranparent rendering - the scene only enables it
+	// for its blended pass, so the opaque draws keep early depth tests
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	m_pWindow = window;
@@ -118,6 +198,57 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	return(window);
 }
 
+/***********************************************************
+ *  SetCameraPose()
+ *
+ *  This method is used to place the camera, for example when
+ *  a scripted camera path is replayed.  The yaw and pitch
+ *  are updated as well, so later mouse movement continues
+ *  from the new direction.
+ ***********************************************************/
+void ViewManager::SetCameraPose(const glm::vec3& position, const glm::vec3& target)
+{
+	glm::vec3 direction = target - position;
+	// a placed camera jumps instead of blending from the old position
+	m_previousCameraPosition = position;
+	g_pCamera->Position = position;
+	if (glm::length(direction) < 0.0001f)
+	{
+		return;
+	}
+	direction = glm::normalize(direction);
+
+	g_pCamera->Front = direction;
+	g_pCamera->Yaw = glm::degrees(atan2f(direction.z, direction.x));
+	g_pCamera->Pitch = glm::degrees(asinf(glm::clamp(direction.y, -1.0f, 1.0f)));
+	g_pCamera->Right = glm::normalize(glm::cross(direction, g_pCamera->WorldUp));
+	g_pCamera->Up = glm::normalize(glm::cross(g_pCamera->Right, direction));
+}
+
+/***********************************************************
+ *  GetCameraPose()
+ *
+ *  This method is used to get the camera position and a
+ *  point one unit in front of the camera.
+ ***********************************************************/
+void ViewManager::GetCameraPose(glm::vec3& position, glm::vec3& target) const
+{
+	position = g_pCamera->Position;
+	target = g_pCamera->Position + glm::normalize(g_pCamera->Front);
+}
+
+/***********************************************************
+ *  GetFramebufferSize()
+ *
+ *  This method is used for getting the current size of the
+ *  window framebuffer, which the scene is shown at.
+ ***********************************************************/
+void ViewManager::GetFramebufferSize(int& width, int& height) const
+{
+	width = gFramebufferWidth;
+	height = gFramebufferHeight;
+}
+
 /***********************************************************
  *  Mouse_Position_Callback()
  *
@@ -160,14 +291,34 @@ void ViewManager::Mouse_Scroll_Wheel_Callback(GLFWwindow* window, double x, doub
 	g_pCamera->ProcessMouseScroll(yScrollDistance);
 }
 
+/***********************************************************
+ *  Framebuffer_Size_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  the framebuffer of the window changes its size.  A
+ *  minimized window reports a size of zero, which keeps the
+ *  last size so the aspect ratio stays valid.
+ ***********************************************************/
+void ViewManager::Framebuffer_Size_Callback(GLFWwindow* window, int width, int height)
+{
+	if ((width <= 0) || (height <= 0))
+	{
+		return;
+	}
+
+	gFramebufferWidth = width;
+	gFramebufferHeight = height;
+}
+
 
 /***********************************************************
  *  ProcessKeyboardEvents()
  *
  *  This method is called to process any keyboard events
- *  that may be waiting in the event queue.
+ *  that may be waiting in the event queue.  The camera moves
+ *  by the passed in time step.
  ***********************************************************/
-void ViewManager::ProcessKeyboardEvents()
+void ViewManager::ProcessKeyboardEvents(float deltaTime)
 {
 	// close the window if the escape key has been pressed
 	if (glfwGetKey(m_pWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS)
@@ -178,31 +329,31 @@ void ViewManager::ProcessKeyboardEvents()
 	// process camera zooming in and out
 	if (glfwGetKey(m_pWindow, GLFW_KEY_W) == GLFW_PRESS)
 	{
-		g_pCamera->ProcessKeyboard(FORWARD, gDeltaTime);
+		g_pCamera->ProcessKeyboard(FORWARD, deltaTime);
 	}
 	if (glfwGetKey(m_pWindow, GLFW_KEY_S) == GLFW_PRESS)
 	{
-		g_pCamera->ProcessKeyboard(BACKWARD, gDeltaTime);
+		g_pCamera->ProcessKeyboard(BACKWARD, deltaTime);
 	}
 
 	// process camera panning left and right
 	if (glfwGetKey(m_pWindow, GLFW_KEY_A) == GLFW_PRESS)
 	{
-		g_pCamera->ProcessKeyboard(LEFT, gDeltaTime);
+		g_pCamera->ProcessKeyboard(LEFT, deltaTime);
 	}
 	if (glfwGetKey(m_pWindow, GLFW_KEY_D) == GLFW_PRESS)
 	{
-		g_pCamera->ProcessKeyboard(RIGHT, gDeltaTime);
+		g_pCamera->ProcessKeyboard(RIGHT, deltaTime);
 	}
 
 	//adding Q E to control upward and downward movement
 	if (glfwGetKey(m_pWindow, GLFW_KEY_Q) == GLFW_PRESS)
 	{
-		g_pCamera->ProcessKeyboard(UP, gDeltaTime);
+		g_pCamera->ProcessKeyboard(UP, deltaTime);
 	}
 	if (glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS)
 	{
-		g_pCamera->ProcessKeyboard(DOWN, gDeltaTime);
+		g_pCamera->ProcessKeyboard(DOWN, deltaTime);
 	}
 
 	// For P key to control perspective view
@@ -218,63 +369,184 @@ void ViewManager::ProcessKeyboardEvents()
 	}
 }
 
+/***********************************************************
+ *  UpdateCamera()
+ *
+ *  This method is used for advancing the camera by one fixed
+ *  time step from the keys that are held down.  The position
+ *  before the step is kept for PrepareSceneView().
+ ***********************************************************/
+void ViewManager::UpdateCamera(float deltaTime)
+{
+	m_previousCameraPosition = g_pCamera->Position;
+
+	// process any keyboard events that may be waiting in the 
+	// event queue
+	ProcessKeyboardEvents(deltaTime);
+}
+
 /***********************************************************
  *  PrepareSceneView()
  *
  *  This method is used for preparing the 3D scene by loading
  *  the shapes, textures in memory to support the 3D scene 
- *  rendering
+ *  rendering.  The camera is drawn part of the way between
+ *  its last two updates, so the motion stays smooth when the
+ *  frame rate and the update rate differ.  The mouse look
+ *  is applied as it arrives and is not interpolated.  The
+ *  other views are built for the same frame, and the main
+ *  view is put in use.
  ***********************************************************/
-void ViewManager::PrepareSceneView()
+void ViewManager::PrepareSceneView(float interpolation)
 {
 	glm::mat4 view;
 	glm::mat4 projection;
 
-	// per-frame timing
-	float currentFrame = glfwGetTime();
-	gDeltaTime = currentFrame - gLastFrame;
-	gLastFrame = currentFrame;
-
-	// process any keyboard events that may be waiting in the 
-	// event queue
-	ProcessKeyboardEvents();
-
-	// get the current view matrix from the camera
+	// get the current view matrix from the camera at the
+	// interpolated position, then restore the updated position
+	glm::vec3 updatedPosition = g_pCamera->Position;
+	glm::vec3 viewPosition = glm::mix(
+		m_previousCameraPosition,
+		updatedPosition,
+		glm::clamp(interpolation, 0.0f, 1.0f));
+	g_pCamera->Position = viewPosition;
 	view = g_pCamera->GetViewMatrix();
+	g_pCamera->Position = updatedPosition;
+
+	// the aspect ratio of the window framebuffer - a scaled
+	// render covers the same shape at fewer pixels
+	float aspectRatio = (float)gFramebufferWidth / (float)gFramebufferHeight;
 
 	// define the current projection matrix
 	//projection = glm::perspective(glm::radians(g_pCamera->Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
 
 	if (bOrthographicProjection)
 	{
-		// Orthographic projection Adjust this value to control the size of the orthographic view
-		float orthoSize = 10.0f; 
-		float aspectRatio = (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT;
-
-		// Create orthographic projection matrix
-		projection = glm::ortho(
-			-orthoSize * aspectRatio, orthoSize * aspectRatio,  
-			-orthoSize, orthoSize,                             
-			0.1f, 100.0f);                                    
+		// Orthographic projection - ORTHOGRAPHIC_SIZE controls the size of the orthographic view
+		projection = BuildProjection(true, ORTHOGRAPHIC_SIZE, aspectRatio);
 	}
 	else
 	{
 		// Perspective projection (your existing code)
-		projection = glm::perspective(
-			glm::radians(g_pCamera->Zoom),                  
-			(float)WINDOW_WIDTH / (float)WINDOW_HEIGHT,     
-			0.1f,                                          
-			100.0f);                                        
+		projection = BuildProjection(false, g_pCamera->Zoom, aspectRatio);
+	}
+
+	// keep the matrices for frustum culling of the scene objects
+	SCENE_VIEW& mainView = m_views[0];
+	mainView.position = viewPosition;
+	mainView.target = viewPosition + g_pCamera->Front;
+	mainView.size = (bOrthographicProjection == true) ? ORTHOGRAPHIC_SIZE : g_pCamera->Zoom;
+	mainView.bOrthographic = bOrthographicProjection;
+	mainView.viewMatrix = view;
+	mainView.projectionMatrix = projection;
+	mainView.viewPosition = viewPosition;
+
+	// the fixed views keep the shape of their part of the window
+	for (size_t i = 1; i < m_views.size(); i++)
+	{
+		SCENE_VIEW& sceneView = m_views[i];
+		glm::vec3 direction = glm::normalize(sceneView.target - sceneView.position);
+
+		// a view straight up or down has no up direction of its own
+		glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+		if (fabsf(direction.y) > 0.999f)
+		{
+			up = glm::vec3(0.0f, 0.0f, -1.0f);
+		}
+
+		float viewAspectRatio = (sceneView.viewport.z * gFramebufferWidth) /
+			glm::max(sceneView.viewport.w * gFramebufferHeight, 1.0f);
+		sceneView.viewMatrix = glm::lookAt(sceneView.position, sceneView.target, up);
+		sceneView.projectionMatrix = BuildProjection(sceneView.bOrthographic, sceneView.size, viewAspectRatio);
+		sceneView.viewPosition = sceneView.position;
+	}
+
+	UseView(0);
+}
+
+/***********************************************************
+ *  AddView()
+ *
+ *  This method is used for adding a view with a camera that
+ *  stays in place, for example an orthographic view from
+ *  above or an inset next to the main view.  The viewport is
+ *  the left, bottom, width and height of the part of the
+ *  window it covers, as fractions of the window size.  The
+ *  index of the new view is returned.
+ ***********************************************************/
+int ViewManager::AddView(
+	const glm::vec4& viewport,
+	const glm::vec3& position,
+	const glm::vec3& target,
+	bool bOrthographic,
+	float size)
+{
+	SCENE_VIEW sceneView;
+
+	sceneView.viewport = glm::clamp(viewport, 0.0f, 1.0f);
+	sceneView.position = position;
+	sceneView.target = target;
+	// a view cannot look from its target at itself
+	if (glm::length(target - position) < 0.0001f)
+	{
+		sceneView.target = position + glm::vec3(0.0f, 0.0f, -1.0f);
+	}
+	sceneView.size = size;
+	sceneView.bOrthographic = bOrthographic;
+	sceneView.viewMatrix = glm::mat4(1.0f);
+	sceneView.projectionMatrix = glm::mat4(1.0f);
+	sceneView.viewPosition = position;
+	m_views.push_back(sceneView);
+
+	return((int)m_views.size() - 1);
+}
+
+/***********************************************************
+ *  GetViewport()
+ *
+ *  This method is used for getting the pixels a view covers
+ *  in a target of the passed in size, which is the window or
+ *  the scaled region the scene is rendered into.
+ ***********************************************************/
+void ViewManager::GetViewport(int viewIndex, int width, int height, int& x, int& y, int& viewWidth, int& viewHeight) const
+{
+	const glm::vec4& viewport = m_views[glm::clamp(viewIndex, 0, GetViewCount() - 1)].viewport;
+
+	x = (int)(viewport.x * width);
+	y = (int)(viewport.y * height);
+	viewWidth = glm::max((int)(viewport.z * width), 1);
+	viewHeight = glm::max((int)(viewport.w * height), 1);
+}
+
+/***********************************************************
+ *  UseView()
+ *
+ *  This method is used for sharing the matrices and camera
+ *  position of a view with the shader programs, so the draws
+ *  that follow are seen from it.  PrepareSceneView() must
+ *  have built the views of the frame.
+ ***********************************************************/
+void ViewManager::UseView(int viewIndex)
+{
+	m_currentView = glm::clamp(viewIndex, 0, GetViewCount() - 1);
+
+	const SCENE_VIEW& sceneView = m_views[m_currentView];
+
+	// a single buffer update shares the camera with every program
+	if (NULL != m_pUniformBuffers)
+	{
+		m_pUniformBuffers->SetCamera(sceneView.viewMatrix, sceneView.projectionMatrix, sceneView.viewPosition);
 	}
 
-	// if the shader manager object is valid
-	if (NULL != m_pShaderManager)
+	// programs without the camera block need the individual uniforms
+	if ((NULL != m_pShaderUniforms) &&
+		(m_pShaderUniforms->HasBlock(UniformBuffers::CAMERA_BLOCK) == false))
 	{
 		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ViewName, view);
+		m_pShaderUniforms->SetMat4(ShaderUniforms::VIEW, sceneView.viewMatrix);
 		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
+		m_pShaderUniforms->SetMat4(ShaderUniforms::PROJECTION, sceneView.projectionMatrix);
 		// set the view position of the camera into the shader for proper rendering
-		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
+		m_pShaderUniforms->SetVec3(ShaderUniforms::VIEW_POSITION, sceneView.viewPosition);
 	}
-}
\ No newline at end of file
+}
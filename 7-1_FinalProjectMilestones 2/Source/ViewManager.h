@@ -10,14 +10,38 @@
 #pragma once
 
 #include "ShaderManager.h"
+#include "ShaderUniforms.h"
+#include "UniformBuffers.h"
 #include "camera.h"
 
 // GLFW library
 #include "GLFW/glfw3.h" 
 
+#include <vector>
+
 class ViewManager
 {
 public:
+	// properties for a view of the scene drawn into part of the
+	// window - view 0 is the main view, which follows the camera
+	// and covers the whole window
+	struct SCENE_VIEW
+	{
+		// left, bottom, width and height as fractions of the window
+		glm::vec4 viewport;
+		// placement of the fixed camera of the view
+		glm::vec3 position;
+		glm::vec3 target;
+		// vertical field of view in degrees, or half of the height
+		// an orthographic view covers
+		float size;
+		bool bOrthographic;
+		// matrices and camera position of the current frame
+		glm::mat4 viewMatrix;
+		glm::mat4 projectionMatrix;
+		glm::vec3 viewPosition;
+	};
+
 	// constructor
 	ViewManager(
 		ShaderManager* pShaderManager);
@@ -27,20 +51,70 @@ public:
 	// mouse position callback for mouse interaction with the 3D scene
 	static void Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos);
 	static void Mouse_Scroll_Wheel_Callback(GLFWwindow* window, double x, double yScrollDistance);
+	// framebuffer size callback for keeping the projection in step with the window
+	static void Framebuffer_Size_Callback(GLFWwindow* window, int width, int height);
 
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
+	// pointer to cached shader uniform locations
+	ShaderUniforms* m_pShaderUniforms;
+	// pointer to the shared uniform buffer objects
+	UniformBuffers* m_pUniformBuffers;
 	// active OpenGL display window
 	GLFWwindow* m_pWindow;
+	// views of the scene - the first one is the main view
+	std::vector<SCENE_VIEW> m_views;
+	// view whose matrices are in use
+	int m_currentView;
+	// camera position before the latest update, for interpolation
+	glm::vec3 m_previousCameraPosition;
 
 	// process keyboard events for interaction with the 3D scene
-	void ProcessKeyboardEvents();
+	void ProcessKeyboardEvents(float deltaTime);
 
 public:
-	// create the initial OpenGL display window
-	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
+	// set the cached uniform locations once the shaders are loaded
+	void SetShaderUniforms(ShaderUniforms* pShaderUniforms);
+	// set the shared uniform buffers once they are created
+	void SetUniformBuffers(UniformBuffers* pUniformBuffers);
+
+	// create the initial OpenGL display window - a hidden window
+	// has no mouse interaction and is used for offscreen rendering
+	GLFWwindow* CreateDisplayWindow(const char* windowTitle, bool bVisible = true);
+
+	// place the camera at a position looking at a target
+	void SetCameraPose(const glm::vec3& position, const glm::vec3& target);
+	// get the camera position and a point the camera looks at
+	void GetCameraPose(glm::vec3& position, glm::vec3& target) const;
+	// get the current size of the window framebuffer in pixels
+	void GetFramebufferSize(int& width, int& height) const;
 	
-	// prepare the conversion from 3D object display to 2D scene display
-	void PrepareSceneView();
+	// advance the camera by one fixed time step from the keyboard state
+	void UpdateCamera(float deltaTime);
+	// prepare the conversion from 3D object display to 2D scene display -
+	// interpolation blends between the previous and the latest update,
+	// and the matrices of every view are built with those of the main one
+	void PrepareSceneView(float interpolation);
+
+	// add a view with a fixed camera over part of the window and
+	// return its index
+	int AddView(
+		const glm::vec4& viewport,
+		const glm::vec3& position,
+		const glm::vec3& target,
+		bool bOrthographic,
+		float size);
+	// number of views, the main view included
+	int GetViewCount() const { return (int)m_views.size(); }
+	// get the pixels a view covers in a target of the passed in size
+	void GetViewport(int viewIndex, int width, int height, int& x, int& y, int& viewWidth, int& viewHeight) const;
+	// share the matrices of a view with the shaders for the next draws
+	void UseView(int viewIndex);
+
+	// get the combined view-projection matrix of the view in use
+	glm::mat4 GetViewProjection() const { return(GetProjectionMatrix() * GetViewMatrix()); }
+	// get the view and projection matrices of the view in use
+	const glm::mat4& GetViewMatrix() const { return(m_views[m_currentView].viewMatrix); }
+	const glm::mat4& GetProjectionMatrix() const { return(m_views[m_currentView].projectionMatrix); }
 };
\ No newline at end of file
@@ -0,0 +1,136 @@
+///////////////////////////////////////////////////////////////////////////////
+// cullcomputeshader.glsl
+// ============
+// compute shader that culls the scene objects and fills the indirect draws
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#version 430 core
+
+// one scene object per invocation - must match GpuCulling
+layout (local_size_x = 64) in;
+
+// per-instance values read by the instance shader
+struct Instance
+{
+	mat4 model;
+	vec4 color;
+	vec2 uvScale;
+	// texture index in x (-1 for a solid color), material index in y
+	ivec2 indices;
+};
+
+// a scene object with its world space bounding sphere
+struct CullObject
+{
+	Instance instance;
+	// center in xyz, radius in w
+	vec4 boundsSphere;
+	// level 0 draw command of the object's batch in x, the number
+	// of levels of its shape in y
+	uvec4 command;
+};
+
+// the layout glMultiDrawElementsIndirect reads
+struct DrawCommand
+{
+	uint count;
+	uint instanceCount;
+	uint firstIndex;
+	int baseVertex;
+	uint baseInstance;
+};
+
+layout (std430, binding = 0) readonly buffer ObjectBuffer
+{
+	CullObject objects[];
+};
+
+// the instance counts start at zero every frame
+layout (std430, binding = 1) buffer CommandBuffer
+{
+	DrawCommand commands[];
+};
+
+layout (std430, binding = 2) writeonly buffer InstanceBuffer
+{
+	Instance instances[];
+};
+
+// level of detail last chosen for every object, one run of objects per view
+layout (std430, binding = 3) buffer LodStateBuffer
+{
+	uint lodLevels[];
+};
+
+// xyz is the inward normal, w the distance
+uniform vec4 frustumPlanes[6];
+uniform uint objectCount;
+// the depth of a point is its dot product with lodView
+uniform vec4 lodView;
+// switch sizes in x and y, hysteresis in z, projection scale in w
+uniform vec4 lodSelection;
+// where the levels of the view being culled start in the state buffer
+uniform uint lodStateOffset;
+
+// pick the level for a projected size - same as the CPU selection
+uint SelectLod(float screenSize, uint currentLevel, uint levelCount)
+{
+	uint level = 0u;
+
+	while ((level + 1u) < levelCount)
+	{
+		// a switch moves away from the current level
+		float threshold = lodSelection[level];
+		if (currentLevel > level)
+		{
+			threshold *= (1.0 + lodSelection.z);
+		}
+		else
+		{
+			threshold *= (1.0 - lodSelection.z);
+		}
+
+		if (screenSize >= threshold)
+		{
+			break;
+		}
+		level++;
+	}
+
+	return(level);
+}
+
+void main()
+{
+	uint objectIndex = gl_GlobalInvocationID.x;
+	if (objectIndex >= objectCount)
+	{
+		return;
+	}
+
+	vec4 sphere = objects[objectIndex].boundsSphere;
+	for (int i = 0; i < 6; i++)
+	{
+		if ((dot(frustumPlanes[i].xyz, sphere.xyz) + frustumPlanes[i].w) < -sphere.w)
+		{
+			return;
+		}
+	}
+
+	uint level = 0u;
+	if (lodSelection.w > 0.0)
+	{
+		float depth = max(dot(lodView, vec4(sphere.xyz, 1.0)), 0.0001);
+		level = SelectLod(
+			(sphere.w * lodSelection.w) / depth,
+			lodLevels[lodStateOffset + objectIndex],
+			objects[objectIndex].command.y);
+	}
+	lodLevels[lodStateOffset + objectIndex] = level;
+
+	// the visible objects of a batch level are packed from its base instance
+	uint commandIndex = objects[objectIndex].command.x + level;
+	uint slot = atomicAdd(commands[commandIndex].instanceCount, 1u);
+	instances[commands[commandIndex].baseInstance + slot] = objects[objectIndex].instance;
+}
@@ -0,0 +1,31 @@
+///////////////////////////////////////////////////////////////////////////////
+// depthvertexshader.glsl
+// ============
+// depth-only vertex shader for the depth pre-pass of the instanced draws
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#version 420 core
+
+// the same attribute locations as the instance shader
+layout (location = 0) in vec3 inVertexPosition;
+// the model matrix uses locations 3 to 6
+layout (location = 3) in mat4 inInstanceModel;
+
+// camera values shared by all the programs
+layout (std140) uniform CameraBlock
+{
+	mat4 view;
+	mat4 projection;
+	vec4 viewPosition;
+};
+
+// the instance shader must write the very same depth
+invariant gl_Position;
+
+void main()
+{
+	vec4 worldPosition = inInstanceModel * vec4(inVertexPosition, 1.0);
+
+	gl_Position = projection * view * worldPosition;
+}
@@ -0,0 +1,292 @@
+///////////////////////////////////////////////////////////////////////////////
+// instancedfragmentshader.glsl
+// ============
+// fragment shader for the instanced draws of the basic 3D shapes
+//
+// the lighting follows the scene shader's phong model but is not the
+// same - there is no bUseLighting toggle, so turning the lighting off
+// leaves these draws lit, and each light adds its own ambient term, on
+// top of the block materials, shadows and clustered lights that the
+// scene shader does not have
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#version 420 core
+// the texture block is only declared when the driver has bindless
+// textures - the program then samples through the handles
+#extension GL_ARB_bindless_texture : enable
+// the material buffer and the clustered point lights are only read
+// when the driver has storage buffers
+#extension GL_ARB_shader_storage_buffer_object : enable
+
+#define MAX_POINT_LIGHTS 4
+#define MAX_MATERIALS 64
+#define MAX_TEXTURES 1024
+#define CLUSTER_COUNT (16 * 9 * 24)
+#define MAX_LIGHTS_PER_CLUSTER 64
+#define MAX_SHADOW_CASCADES 4
+
+// direction or position in xyz, 1.0 in w when the light is active
+struct LightData
+{
+	vec4 vector;
+	vec4 ambient;
+	vec4 diffuse;
+	vec4 specular;
+};
+
+// shininess in specularColor.w
+struct MaterialData
+{
+	vec4 diffuseColor;
+	vec4 specularColor;
+};
+
+// values shared by all the programs
+layout (std140) uniform CameraBlock
+{
+	mat4 view;
+	mat4 projection;
+	vec4 viewPosition;
+};
+
+layout (std140) uniform LightBlock
+{
+	LightData directionalLight;
+	LightData pointLights[MAX_POINT_LIGHTS];
+};
+
+#ifdef GL_ARB_shader_storage_buffer_object
+// roughness, metallic, emission and opacity in surface, and the
+// texture index of the base color, normal, roughness and metallic,
+// and emission maps in textureIndices - -1 for none
+struct MaterialEntry
+{
+	vec4 diffuseColor;
+	vec4 specularColor;
+	vec4 surface;
+	ivec4 textureIndices;
+};
+
+// every material of the scene, whatever their number
+layout (std430, binding = 6) readonly buffer MaterialBuffer
+{
+	MaterialEntry materialEntries[];
+};
+#else
+layout (std140) uniform MaterialBlock
+{
+	MaterialData materials[MAX_MATERIALS];
+};
+#endif
+
+#ifdef GL_ARB_bindless_texture
+// two 64 bit texture handles in every element
+layout (std140) uniform TextureBlock
+{
+	uvec4 textureHandles[MAX_TEXTURES / 2];
+};
+#else
+// every draw binds the texture of all of its instances
+uniform sampler2D objectTexture;
+#endif
+
+// the cluster grid - clusterGrid.w is 0 when the lights are not clustered
+layout (std140) uniform ClusterBlock
+{
+	uvec4 clusterGrid;
+	vec4 clusterDepth;
+	vec4 clusterViewport;
+};
+
+// the shadow cascades of the directional light - shadowParams.x is
+// the number of cascades, 0 when there are no shadows
+layout (std140) uniform ShadowBlock
+{
+	mat4 shadowMatrices[MAX_SHADOW_CASCADES];
+	vec4 shadowSplits;
+	vec4 shadowParams;
+};
+
+// a layer per cascade, compared against by the hardware
+uniform sampler2DArrayShadow shadowMap;
+
+#ifdef GL_ARB_shader_storage_buffer_object
+// world position in xyz, range in w
+struct PointLight
+{
+	vec4 positionRange;
+	vec4 ambient;
+	vec4 diffuse;
+	vec4 specular;
+};
+
+layout (std430, binding = 4) readonly buffer PointLightBuffer
+{
+	PointLight clusteredLights[];
+};
+
+// MAX_LIGHTS_PER_CLUSTER entries of the index list for each cluster
+layout (std430, binding = 5) readonly buffer ClusterLightBuffer
+{
+	uint clusterLightCounts[CLUSTER_COUNT];
+	uint clusterLightIndices[];
+};
+#endif
+
+in vec3 fragmentPosition;
+in vec3 fragmentVertexNormal;
+in vec2 fragmentTextureCoordinate;
+flat in vec4 fragmentColor;
+flat in int fragmentTextureIndex;
+flat in int fragmentMaterialIndex;
+
+out vec4 outFragmentColor;
+
+// phong lighting for one light arriving from lightDirection - the
+// shadow only darkens the diffuse and specular parts
+vec3 CalculateLight(LightData light, vec3 lightDirection, vec3 normal, vec3 viewDirection, MaterialData material, float shadow)
+{
+	float diffuseImpact = max(dot(normal, lightDirection), 0.0);
+	vec3 reflectDirection = reflect(-lightDirection, normal);
+	float specularImpact = pow(max(dot(viewDirection, reflectDirection), 0.0), max(material.specularColor.w, 1.0));
+
+	vec3 ambient = light.ambient.rgb * material.diffuseColor.rgb;
+	vec3 diffuse = light.diffuse.rgb * diffuseImpact * material.diffuseColor.rgb;
+	vec3 specular = light.specular.rgb * specularImpact * material.specularColor.rgb;
+
+	return(ambient + ((diffuse + specular) * shadow));
+}
+
+// fraction of the directional light reaching this fragment
+float CalculateShadow(float viewDepth)
+{
+	int cascadeCount = int(shadowParams.x);
+	int cascade = 0;
+	while ((cascade < cascadeCount) && (viewDepth > shadowSplits[cascade]))
+	{
+		cascade++;
+	}
+	// past the last cascade nothing is shadowed
+	if (cascade >= cascadeCount)
+	{
+		return(1.0);
+	}
+
+	vec4 shadowPosition = shadowMatrices[cascade] * vec4(fragmentPosition, 1.0);
+	float depth = shadowPosition.z - shadowParams.y;
+	float texel = shadowParams.z;
+
+	// four filtered taps are a soft 3 x 3 texel edge
+	float shadow = 0.0;
+	shadow += texture(shadowMap, vec4(shadowPosition.xy + vec2(-0.5, -0.5) * texel, float(cascade), depth));
+	shadow += texture(shadowMap, vec4(shadowPosition.xy + vec2(0.5, -0.5) * texel, float(cascade), depth));
+	shadow += texture(shadowMap, vec4(shadowPosition.xy + vec2(-0.5, 0.5) * texel, float(cascade), depth));
+	shadow += texture(shadowMap, vec4(shadowPosition.xy + vec2(0.5, 0.5) * texel, float(cascade), depth));
+
+	return(shadow * 0.25);
+}
+
+#ifdef GL_ARB_shader_storage_buffer_object
+// lighting of the clustered point lights listed for this fragment
+vec3 CalculateClusteredLights(vec3 normal, vec3 viewDirection, MaterialData material)
+{
+	vec3 lighting = vec3(0.0);
+
+	// the depth slice goes by the log of the view depth
+	float depth = -(view * vec4(fragmentPosition, 1.0)).z;
+	vec2 tile = (gl_FragCoord.xy - clusterViewport.xy) / clusterViewport.zw;
+	uvec3 cluster = uvec3(
+		clamp(tile * vec2(clusterGrid.xy), vec2(0.0), vec2(clusterGrid.xy) - 1.0),
+		clamp(log(max(depth, clusterDepth.x)) * clusterDepth.z - clusterDepth.w, 0.0, float(clusterGrid.z) - 1.0));
+	uint clusterIndex = cluster.x + (cluster.y * clusterGrid.x) + (cluster.z * clusterGrid.x * clusterGrid.y);
+
+	uint listStart = clusterIndex * MAX_LIGHTS_PER_CLUSTER;
+	uint lightCount = clusterLightCounts[clusterIndex];
+	for (uint i = 0u; i < lightCount; i++)
+	{
+		PointLight pointLight = clusteredLights[clusterLightIndices[listStart + i]];
+		vec3 toLight = pointLight.positionRange.xyz - fragmentPosition;
+		float distance = length(toLight);
+
+		// fades smoothly to nothing at the range of the light
+		float ratio = distance / pointLight.positionRange.w;
+		float falloff = clamp(1.0 - (ratio * ratio * ratio * ratio), 0.0, 1.0);
+		float attenuation = (falloff * falloff) / ((distance * distance) + 1.0);
+
+		LightData light;
+		light.vector = pointLight.positionRange;
+		light.ambient = pointLight.ambient;
+		light.diffuse = pointLight.diffuse;
+		light.specular = pointLight.specular;
+		lighting += attenuation * CalculateLight(light, toLight / max(distance, 0.0001), normal, viewDirection, material, 1.0);
+	}
+
+	return(lighting);
+}
+#endif
+
+void main()
+{
+	int textureIndex = fragmentTextureIndex;
+
+#ifdef GL_ARB_shader_storage_buffer_object
+	MaterialEntry entry = materialEntries[max(fragmentMaterialIndex, 0)];
+	MaterialData material;
+	material.diffuseColor = entry.diffuseColor;
+	material.specularColor = entry.specularColor;
+#ifdef GL_ARB_bindless_texture
+	// an object without a texture shows the base color map of its material
+	if (textureIndex < 0)
+	{
+		textureIndex = entry.textureIndices.x;
+	}
+#endif
+#else
+	MaterialData material = materials[clamp(fragmentMaterialIndex, 0, MAX_MATERIALS - 1)];
+#endif
+
+	vec4 baseColor = fragmentColor;
+	if (textureIndex >= 0)
+	{
+#ifdef GL_ARB_bindless_texture
+		uvec4 handles = textureHandles[textureIndex / 2];
+		uvec2 handle = ((textureIndex % 2) == 0) ? handles.xy : handles.zw;
+		baseColor = texture(sampler2D(handle), fragmentTextureCoordinate);
+#else
+		baseColor = texture(objectTexture, fragmentTextureCoordinate);
+#endif
+	}
+
+	vec3 normal = normalize(fragmentVertexNormal);
+	vec3 viewDirection = normalize(viewPosition.xyz - fragmentPosition);
+	vec3 lighting = vec3(0.0);
+
+	if (directionalLight.vector.w > 0.0)
+	{
+		float shadow = 1.0;
+		if (shadowParams.x > 0.0)
+		{
+			shadow = CalculateShadow(-(view * vec4(fragmentPosition, 1.0)).z);
+		}
+		lighting += CalculateLight(directionalLight, normalize(-directionalLight.vector.xyz), normal, viewDirection, material, shadow);
+	}
+
+	for (int i = 0; i < MAX_POINT_LIGHTS; i++)
+	{
+		if (pointLights[i].vector.w > 0.0)
+		{
+			vec3 lightDirection = normalize(pointLights[i].vector.xyz - fragmentPosition);
+			lighting += CalculateLight(pointLights[i], lightDirection, normal, viewDirection, material, 1.0);
+		}
+	}
+
+#ifdef GL_ARB_shader_storage_buffer_object
+	if (clusterGrid.w > 0u)
+	{
+		lighting += CalculateClusteredLights(normal, viewDirection, material);
+	}
+#endif
+
+	outFragmentColor = vec4(lighting * baseColor.rgb, baseColor.a);
+}
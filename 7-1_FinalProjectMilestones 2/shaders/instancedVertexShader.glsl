@@ -0,0 +1,52 @@
+///////////////////////////////////////////////////////////////////////////////
+// instancedvertexshader.glsl
+// ============
+// vertex shader for the instanced draws of the basic 3D shapes
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#version 420 core
+
+// per-vertex attributes
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 1) in vec3 inVertexNormal;
+layout (location = 2) in vec2 inTextureCoordinate;
+
+// per-instance attributes - the model matrix uses locations 3 to 6
+layout (location = 3) in mat4 inInstanceModel;
+layout (location = 7) in vec4 inInstanceColor;
+layout (location = 8) in vec2 inInstanceUVscale;
+// texture index in x (-1 for a solid color), material index in y
+layout (location = 9) in ivec2 inInstanceIndices;
+
+// camera values shared by all the programs
+layout (std140) uniform CameraBlock
+{
+	mat4 view;
+	mat4 projection;
+	vec4 viewPosition;
+};
+
+out vec3 fragmentPosition;
+out vec3 fragmentVertexNormal;
+out vec2 fragmentTextureCoordinate;
+flat out vec4 fragmentColor;
+flat out int fragmentTextureIndex;
+flat out int fragmentMaterialIndex;
+
+// the depth pre-pass writes the very same depth
+invariant gl_Position;
+
+void main()
+{
+	vec4 worldPosition = inInstanceModel * vec4(inVertexPosition, 1.0);
+
+	gl_Position = projection * view * worldPosition;
+
+	fragmentPosition = worldPosition.xyz;
+	fragmentVertexNormal = mat3(transpose(inverse(inInstanceModel))) * inVertexNormal;
+	fragmentTextureCoordinate = inTextureCoordinate * inInstanceUVscale;
+	fragmentColor = inInstanceColor;
+	fragmentTextureIndex = inInstanceIndices.x;
+	fragmentMaterialIndex = inInstanceIndices.y;
+}
@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightclustercomputeshader.glsl
+// ============
+// compute shader that lists the point lights reaching into each cluster
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#version 430 core
+
+// one cluster per invocation - must match ClusteredLights
+layout (local_size_x = 64) in;
+
+#define CLUSTER_COUNT (16 * 9 * 24)
+#define MAX_LIGHTS_PER_CLUSTER 64
+
+// world position in xyz, range in w
+struct PointLight
+{
+	vec4 positionRange;
+	vec4 ambient;
+	vec4 diffuse;
+	vec4 specular;
+};
+
+layout (std140) uniform ClusterBlock
+{
+	uvec4 clusterGrid;
+	vec4 clusterDepth;
+	vec4 clusterViewport;
+};
+
+layout (std430, binding = 4) readonly buffer PointLightBuffer
+{
+	PointLight clusteredLights[];
+};
+
+// MAX_LIGHTS_PER_CLUSTER entries of the index list for each cluster
+layout (std430, binding = 5) writeonly buffer ClusterLightBuffer
+{
+	uint clusterLightCounts[CLUSTER_COUNT];
+	uint clusterLightIndices[];
+};
+
+uniform mat4 view;
+uniform mat4 inverseProjection;
+
+// view space point on the near or far plane below a point of the screen
+vec3 UnprojectPoint(vec2 ndc, float depth)
+{
+	vec4 point = inverseProjection * vec4(ndc, depth, 1.0);
+	return(point.xyz / point.w);
+}
+
+// the point of the line from nearPoint to farPoint at a view depth
+vec3 PointAtDepth(vec3 nearPoint, vec3 farPoint, float depth)
+{
+	float t = (-depth - nearPoint.z) / (farPoint.z - nearPoint.z);
+	return(mix(nearPoint, farPoint, t));
+}
+
+void main()
+{
+	uint clusterIndex = gl_GlobalInvocationID.x;
+	if (clusterIndex >= CLUSTER_COUNT)
+	{
+		return;
+	}
+
+	uvec3 cluster = uvec3(
+		clusterIndex % clusterGrid.x,
+		(clusterIndex / clusterGrid.x) % clusterGrid.y,
+		clusterIndex / (clusterGrid.x * clusterGrid.y));
+
+	// the depth slices are spaced evenly in the log of the depth
+	float nearDepth = clusterDepth.x * pow(clusterDepth.y / clusterDepth.x, float(cluster.z) / float(clusterGrid.z));
+	float farDepth = clusterDepth.x * pow(clusterDepth.y / clusterDepth.x, float(cluster.z + 1u) / float(clusterGrid.z));
+
+	// view space box around the part of the tile between the two slices
+	vec2 tileMin = (vec2(cluster.xy) / vec2(clusterGrid.xy)) * 2.0 - 1.0;
+	vec2 tileMax = (vec2(cluster.xy + 1u) / vec2(clusterGrid.xy)) * 2.0 - 1.0;
+	vec3 boxMin = vec3(1.0e30);
+	vec3 boxMax = vec3(-1.0e30);
+	for (int corner = 0; corner < 4; corner++)
+	{
+		vec2 ndc = vec2(((corner & 1) == 0) ? tileMin.x : tileMax.x, ((corner & 2) == 0) ? tileMin.y : tileMax.y);
+		vec3 nearPoint = UnprojectPoint(ndc, -1.0);
+		vec3 farPoint = UnprojectPoint(ndc, 1.0);
+		vec3 front = PointAtDepth(nearPoint, farPoint, nearDepth);
+		vec3 back = PointAtDepth(nearPoint, farPoint, farDepth);
+
+		boxMin = min(boxMin, min(front, back));
+		boxMax = max(boxMax, max(front, back));
+	}
+
+	uint listStart = clusterIndex * MAX_LIGHTS_PER_CLUSTER;
+	uint lightCount = 0u;
+	for (uint i = 0u; (i < clusterGrid.w) && (lightCount < MAX_LIGHTS_PER_CLUSTER); i++)
+	{
+		vec4 positionRange = clusteredLights[i].positionRange;
+		vec3 center = (view * vec4(positionRange.xyz, 1.0)).xyz;
+		vec3 offset = center - clamp(center, boxMin, boxMax);
+
+		if (dot(offset, offset) <= (positionRange.w * positionRange.w))
+		{
+			clusterLightIndices[listStart + lightCount] = i;
+			lightCount++;
+		}
+	}
+
+	clusterLightCounts[clusterIndex] = lightCount;
+}
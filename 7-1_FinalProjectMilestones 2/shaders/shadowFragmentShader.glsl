@@ -0,0 +1,13 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowfragmentshader.glsl
+// ============
+// depth-only fragment shader for the shadow maps and the depth pre-pass
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#version 420 core
+
+// only the depth is written
+void main()
+{
+}
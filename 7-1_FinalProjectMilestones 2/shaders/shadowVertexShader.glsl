@@ -0,0 +1,21 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowvertexshader.glsl
+// ============
+// depth-only vertex shader for drawing the shapes into the shadow maps
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#version 420 core
+
+// the same attribute locations as the instance shader
+layout (location = 0) in vec3 inVertexPosition;
+// the model matrix uses locations 3 to 6
+layout (location = 3) in mat4 inInstanceModel;
+
+// world space to the clip space of the cascade being drawn
+uniform mat4 lightViewProjection;
+
+void main()
+{
+	gl_Position = lightViewProjection * inInstanceModel * vec4(inVertexPosition, 1.0);
+}
@@ -0,0 +1,20 @@
+///////////////////////////////////////////////////////////////////////////////
+// skyboxfragmentshader.glsl
+// ============
+// fragment shader for the environment cubemap around the scene
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#version 330 core
+
+in vec3 fragmentDirection;
+
+out vec4 outFragmentColor;
+
+uniform samplerCube environmentMap;
+
+// the sky is not lit
+void main()
+{
+	outFragmentColor = vec4(texture(environmentMap, fragmentDirection).rgb, 1.0);
+}
@@ -0,0 +1,32 @@
+///////////////////////////////////////////////////////////////////////////////
+// skyboxvertexshader.glsl
+// ============
+// vertex shader for the environment cubemap around the scene
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#version 330 core
+
+// corner of the unit cube around the camera
+layout (location = 0) in vec3 inVertexPosition;
+
+// camera values shared by all the programs
+layout (std140) uniform CameraBlock
+{
+	mat4 view;
+	mat4 projection;
+	vec4 viewPosition;
+};
+
+out vec3 fragmentDirection;
+
+void main()
+{
+	fragmentDirection = inVertexPosition;
+
+	// only the rotation of the view, so the sky never comes closer
+	vec4 position = projection * vec4(mat3(view) * inVertexPosition, 1.0);
+
+	// a depth of w puts the sky on the far plane
+	gl_Position = position.xyww;
+}